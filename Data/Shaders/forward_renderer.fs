@@ -1,4 +1,7 @@
-#version 330 core
+#version 430 core
+#ifdef ENABLE_BINDLESS_TEXTURES
+#extension GL_ARB_bindless_texture : require
+#endif
 out vec4 FragColor;
 
 in VS_OUT {
@@ -6,6 +9,7 @@ in VS_OUT {
     vec3 Normal;
     vec2 TexCoords;
     vec4 FragPosLightSpace;
+    float AmbientOcclusion;
 } fs_in;
 
 struct PointLight {
@@ -20,7 +24,6 @@ struct PointLight {
     vec3 specular;
 };
 
-uniform sampler2D diffuseTexture;
 uniform sampler2D shadowMap;
 
 uniform vec3 directionalLightDirection;
@@ -32,6 +35,12 @@ uniform vec3 ambient;
 
 #define NR_POINT_LIGHTS 1
 
+#include "material.glsl"
+
+#ifdef ENABLE_IRRADIANCE_VOLUME
+#include "irradiance_volume.glsl"
+#endif
+
 uniform PointLight pointLights[NR_POINT_LIGHTS];
 
 float ShadowCalculation(vec4 fragPosLightSpace)
@@ -93,14 +102,18 @@ vec3 CalculatePointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewD
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(diffuseTexture, fs_in.TexCoords));
+    vec3 ambient = light.ambient * SampleMaterial(MATERIAL_ALBEDO, fs_in.TexCoords).rgb;
 
     return ambient;
 }
 
 void main()
 {
-    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+#ifdef ENABLE_TEXTURES
+    vec3 color = SampleMaterial(MATERIAL_ALBEDO, fs_in.TexCoords).rgb;
+#else
+    vec3 color = vec3(0.95);
+#endif
     vec3 normal = normalize(fs_in.Normal);
     
     //vec3 directionalLightDir = normalize(-directionalLightDirection);
@@ -119,8 +132,17 @@ void main()
     spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
     vec3 specular = spec * directionalLightColor;    
     // calculate shadow
-    float shadow = ShadowCalculation(fs_in.FragPosLightSpace);                      
-    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;    
+#ifdef ENABLE_SHADOWS
+    float shadow = ShadowCalculation(fs_in.FragPosLightSpace);
+#else
+    float shadow = 0.0;
+#endif                      
+#ifdef ENABLE_IRRADIANCE_VOLUME
+    vec3 indirect = SampleIrradianceVolume(fs_in.FragPos, normal);
+#else
+    vec3 indirect = ambient;
+#endif
+    vec3 lighting = (indirect * fs_in.AmbientOcclusion + (1.0 - shadow) * (diffuse + specular)) * color;    
     
     FragColor = vec4(pow(lighting, vec3(1.0/2.2)), 1.0);
 }
\ No newline at end of file
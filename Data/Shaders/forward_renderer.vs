@@ -2,6 +2,8 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 2) in vec3 aNormal;
 layout (location = 1) in vec2 aTexCoords;
+// Baked per-vertex AO, 1.0 for meshes without it
+layout (location = 4) in float aAmbientOcclusion;
 
 out vec2 TexCoords;
 
@@ -10,6 +12,7 @@ out VS_OUT {
     vec3 Normal;
     vec2 TexCoords;
     vec4 FragPosLightSpace;
+    float AmbientOcclusion;
 } vs_out;
 
 uniform mat4 projection;
@@ -23,5 +26,6 @@ void main()
     vs_out.Normal = transpose(inverse(mat3(model))) * aNormal;
     vs_out.TexCoords = aTexCoords;
     vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
+    vs_out.AmbientOcclusion = aAmbientOcclusion;
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
\ No newline at end of file
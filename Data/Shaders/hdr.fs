@@ -4,26 +4,22 @@ out vec4 FragColor;
 in vec2 TexCoords;
 
 uniform sampler2D hdrBuffer;
-uniform bool EnableHDR;
 uniform float Exposure;
 
 void main()
 {             
     const float gamma = 2.2;
     vec3 hdrColor = texture(hdrBuffer, TexCoords).rgb;
-    if(EnableHDR)
-    {
-        // reinhard
-        // vec3 result = hdrColor / (hdrColor + vec3(1.0));
-        // exposure
-        vec3 result = vec3(1.0) - exp(-hdrColor * Exposure);
-        // also gamma correct while we're at it       
-        //result = pow(result, vec3(1.0 / gamma));
-        FragColor = vec4(result, 1.0);
-    }
-    else
-    {
-        vec3 result = pow(hdrColor, vec3(1.0 / gamma));
-        FragColor = vec4(result, 1.0);
-    }
+#ifdef ENABLE_HDR
+    // reinhard
+    // vec3 result = hdrColor / (hdrColor + vec3(1.0));
+    // exposure
+    vec3 result = vec3(1.0) - exp(-hdrColor * Exposure);
+    // also gamma correct while we're at it       
+    //result = pow(result, vec3(1.0 / gamma));
+    FragColor = vec4(result, 1.0);
+#else
+    vec3 result = pow(hdrColor, vec3(1.0 / gamma));
+    FragColor = vec4(result, 1.0);
+#endif
 }
\ No newline at end of file
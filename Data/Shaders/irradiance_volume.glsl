@@ -0,0 +1,39 @@
+#pragma once
+// Diffuse irradiance (divided by pi) from the probe grid baked by IrradianceVolume. Each probe stores 9 L2
+// spherical harmonics coefficients in 7 RGBA slabs stacked along z; every slab is fetched with hardware
+// trilinear filtering at the same position.
+
+uniform sampler3D irradianceVolume;
+uniform vec3 irradianceVolumeMin;
+uniform vec3 irradianceVolumeMax;
+uniform vec3 irradianceVolumeResolution;
+
+vec3 SampleIrradianceVolume(vec3 position, vec3 n)
+{
+    const float numSlabs = 7.0;
+
+    vec3 extent = max(irradianceVolumeMax - irradianceVolumeMin, vec3(1e-5));
+    vec3 cell = clamp((position - irradianceVolumeMin) / extent, 0.0, 1.0) * (irradianceVolumeResolution - 1.0) + 0.5;
+    vec2 uv = cell.xy / irradianceVolumeResolution.xy;
+    float depth = irradianceVolumeResolution.z * numSlabs;
+
+    vec4 s0 = texture(irradianceVolume, vec3(uv, cell.z / depth));
+    vec4 s1 = texture(irradianceVolume, vec3(uv, (cell.z + irradianceVolumeResolution.z) / depth));
+    vec4 s2 = texture(irradianceVolume, vec3(uv, (cell.z + 2.0 * irradianceVolumeResolution.z) / depth));
+    vec4 s3 = texture(irradianceVolume, vec3(uv, (cell.z + 3.0 * irradianceVolumeResolution.z) / depth));
+    vec4 s4 = texture(irradianceVolume, vec3(uv, (cell.z + 4.0 * irradianceVolumeResolution.z) / depth));
+    vec4 s5 = texture(irradianceVolume, vec3(uv, (cell.z + 5.0 * irradianceVolumeResolution.z) / depth));
+    vec4 s6 = texture(irradianceVolume, vec3(uv, (cell.z + 6.0 * irradianceVolumeResolution.z) / depth));
+
+    vec3 irradiance = s0.rgb * 0.282095
+        + vec3(s0.a, s1.rg) * (0.488603 * n.y)
+        + vec3(s1.ba, s2.r) * (0.488603 * n.z)
+        + s2.gba * (0.488603 * n.x)
+        + s3.rgb * (1.092548 * n.x * n.y)
+        + vec3(s3.a, s4.rg) * (1.092548 * n.y * n.z)
+        + vec3(s4.ba, s5.r) * (0.315392 * (3.0 * n.z * n.z - 1.0))
+        + s5.gba * (1.092548 * n.x * n.z)
+        + s6.rgb * (0.546274 * (n.x * n.x - n.y * n.y));
+
+    return max(irradiance, vec3(0.0));
+}
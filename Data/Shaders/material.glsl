@@ -0,0 +1,41 @@
+#pragma once
+// Parameters of every material of the scene, written by MaterialTable and indexed by the draw's materialIndex.
+// A parameter's texture is a layer of one of the arrays bound from unit 3 on, or a bindless handle with
+// ENABLE_BINDLESS_TEXTURES (which needs #extension GL_ARB_bindless_texture in the including shader).
+
+#define MATERIAL_ALBEDO 0
+#define MATERIAL_AO 1
+#define MATERIAL_METALLIC 2
+#define MATERIAL_NORMAL 3
+#define MATERIAL_ROUGHNESS 4
+
+struct Material {
+    vec4 colors[5];
+    // Array index + 1 and layer, or a bindless handle; 0 for none
+    uvec2 textures[5];
+    float alpha;
+};
+
+layout (std430, binding = 0) readonly buffer Materials {
+    Material materials[];
+};
+
+uniform int materialIndex;
+
+#ifndef ENABLE_BINDLESS_TEXTURES
+uniform sampler2DArray materialTextures[8];
+#endif
+
+// The texture of a parameter of the draw's material, its constant color if it has none
+vec4 SampleMaterial(int parameter, vec2 uv)
+{
+    uvec2 location = materials[materialIndex].textures[parameter];
+#ifdef ENABLE_BINDLESS_TEXTURES
+    if (location != uvec2(0u))
+        return texture(sampler2D(location), uv);
+#else
+    if (location.x != 0u)
+        return texture(materialTextures[location.x - 1u], vec3(uv, float(location.y)));
+#endif
+    return materials[materialIndex].colors[parameter];
+}
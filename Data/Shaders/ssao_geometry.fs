@@ -9,7 +9,6 @@ in vec3 Normal;
 
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
-uniform bool EnableTextures;
 void main()
 {    
     // store the fragment position vector in the first gbuffer texture
@@ -17,11 +16,10 @@ void main()
     // also store the per-fragment normals into the gbuffer
     gNormal = normalize(Normal);
     // and the diffuse per-fragment color
-    if (EnableTextures) {
-        gAlbedo.rgb = texture(texture_diffuse1, TexCoords).rgb;
-        //gAlbedo.a = texture(texture_specular1, TexCoords).r;
-    }
-        
-    else
-        gAlbedo.rgb = vec3(0.95);
+#ifdef ENABLE_TEXTURES
+    gAlbedo.rgb = texture(texture_diffuse1, TexCoords).rgb;
+    //gAlbedo.a = texture(texture_specular1, TexCoords).r;
+#else
+    gAlbedo.rgb = vec3(0.95);
+#endif
 }
\ No newline at end of file
@@ -20,13 +20,11 @@ struct Light {
 
 uniform int NR_LIGHTS;
 uniform Light lights[100];
-uniform bool EnableHDR;
 uniform float Exposure;
 
 // Shadows
 uniform vec3 cameraPosition;
 uniform float far_plane;
-uniform bool EnableShadows;
 
 // array of offset direction for sampling
 vec3 sampleOffsetDirections[20] = vec3[]
@@ -93,10 +91,10 @@ void main()
 
             float viewDistance = length(cameraPosition - FragPos);
 
-            if (EnableShadows) {
-                vec3 fragToLight = FragPos - lights[i].Position;
-                shadow = ShadowCalculation(fragToLight, viewDistance);
-            }
+#ifdef ENABLE_SHADOWS
+            vec3 fragToLight = FragPos - lights[i].Position;
+            shadow = ShadowCalculation(fragToLight, viewDistance);
+#endif
                 
 
             lighting += diffuse + specular;
@@ -107,17 +105,14 @@ void main()
     //vec3 color = vec3(0.03) * ambient;
     vec3 color = ambient * lighting;
 
-    if (EnableHDR)
-    {
-        // reinhard tonemapping
-        vec3 rein = color / (color + vec3(1.0));
-        vec3 result = vec3(1.0) - exp(-rein * Exposure);
-        result = pow(result, vec3(1.0 / gamma));
-        FragColor = vec4(result, 1.0);
-    }
-    else
-    {
-        vec3 result = pow(color, vec3(1.0 / gamma));
-        FragColor = vec4(result, 1.0);
-    }
+#ifdef ENABLE_HDR
+    // reinhard tonemapping
+    vec3 rein = color / (color + vec3(1.0));
+    vec3 result = vec3(1.0) - exp(-rein * Exposure);
+    result = pow(result, vec3(1.0 / gamma));
+    FragColor = vec4(result, 1.0);
+#else
+    vec3 result = pow(color, vec3(1.0 / gamma));
+    FragColor = vec4(result, 1.0);
+#endif
 }
\ No newline at end of file
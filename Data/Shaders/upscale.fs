@@ -0,0 +1,26 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// Scene rendered at renderScale of the output resolution per axis
+uniform sampler2D sceneColor;
+uniform float renderScale;
+uniform float sharpness;
+
+void main()
+{
+    // Bilinear filtering does the upscale
+    vec3 color = texture(sceneColor, TexCoords).rgb;
+
+    // Unsharp mask against the neighbouring source texels to win back some of the detail lost to the blur,
+    // stronger the further the scene is from full resolution
+    vec2 texel = 1.0 / vec2(textureSize(sceneColor, 0));
+    vec3 blurred = (texture(sceneColor, TexCoords + vec2(texel.x, 0.0)).rgb
+        + texture(sceneColor, TexCoords - vec2(texel.x, 0.0)).rgb
+        + texture(sceneColor, TexCoords + vec2(0.0, texel.y)).rgb
+        + texture(sceneColor, TexCoords - vec2(0.0, texel.y)).rgb) * 0.25;
+    float amount = sharpness * clamp((1.0 - renderScale) * 2.0, 0.0, 1.0);
+
+    FragColor = vec4(clamp(color + (color - blurred) * amount, 0.0, 1.0), 1.0);
+}
@@ -1,4 +1,4 @@
-#ifdef _DEBUG
+#if defined(_MSC_VER) && defined(_DEBUG)
 // CRT Memory Leak detection
 #define _CRTDBG_MAP_ALLOC  
 #include <stdlib.h>  
@@ -7,13 +7,20 @@
 
 #include "src/Engine.h"
 #include "src/Demos/Demo.h"
+#include "src/Tools/Tools.h"
 
-int main()
+int main(int argc, char** argv)
 {
-#ifdef _DEBUG
+#if defined(_MSC_VER) && defined(_DEBUG)
     // Detects memory leaks upon program exit
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
+    // Offline tools and benchmarks run without creating a window.
+    if (const auto result = Tools::Run(argc, argv); result)
+    {
+        return *result;
+    }
+
     Engine engine("Data/config.xml");
     
     const auto scene = std::make_shared<Demo>();
@@ -22,7 +29,5 @@ int main()
     engine.AddScene(std::static_pointer_cast<SceneBase, Demo>(scene));
     engine.SetActiveScene("Demo");
 
-    engine.Execute();
-
-    return 0;
+    return engine.Execute();
 }
\ No newline at end of file
@@ -0,0 +1,425 @@
+#include "AmbientOcclusion.h"
+
+#include "BVH.h"
+#include "Hash.h"
+#include "core/ThreadPool.h"
+#include "Platform/SIMD.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+	// Bump when the sampling or the file layout changes so stale cache entries get rebuilt.
+	constexpr std::uint64_t BAKER_VERSION{ 1 };
+
+	constexpr char FileMagic[8]{ 'G', 'E', 'A', 'O', '\0', '\0', '\0', '\0' };
+
+	struct FileHeader {
+		char Magic[8];
+		std::uint64_t NumValues;
+	};
+
+	// Vertices handed to a worker at a time
+	constexpr std::size_t VERTEX_GRAIN{ 64 };
+
+	/***********************************************************************************/
+	// Up to four triangles in structure of arrays layout, [component][lane]. Unused lanes are all zero, which the
+	// intersection test rejects as degenerate.
+	struct alignas(16) TrianglePacket {
+		float V0[3][4];
+		float Edge1[3][4];
+		float Edge2[3][4];
+	};
+
+#ifdef GE_SSE2
+	/***********************************************************************************/
+	// Möller-Trumbore against all four triangles at once.
+	bool intersectPacketSSE(const Ray& ray, const TrianglePacket& packet, const float tMax) noexcept
+	{
+		const auto cross = [](const __m128 ax, const __m128 ay, const __m128 az, const __m128 bx, const __m128 by, const __m128 bz, __m128& x, __m128& y, __m128& z) {
+			x = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+			y = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+			z = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+		};
+		const auto dot = [](const __m128 ax, const __m128 ay, const __m128 az, const __m128 bx, const __m128 by, const __m128 bz) {
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+		};
+
+		const auto dx{ _mm_set1_ps(ray.Direction.x) };
+		const auto dy{ _mm_set1_ps(ray.Direction.y) };
+		const auto dz{ _mm_set1_ps(ray.Direction.z) };
+
+		const auto e1x{ _mm_load_ps(packet.Edge1[0]) };
+		const auto e1y{ _mm_load_ps(packet.Edge1[1]) };
+		const auto e1z{ _mm_load_ps(packet.Edge1[2]) };
+		const auto e2x{ _mm_load_ps(packet.Edge2[0]) };
+		const auto e2y{ _mm_load_ps(packet.Edge2[1]) };
+		const auto e2z{ _mm_load_ps(packet.Edge2[2]) };
+
+		__m128 px, py, pz;
+		cross(dx, dy, dz, e2x, e2y, e2z, px, py, pz);
+		const auto determinant{ dot(e1x, e1y, e1z, px, py, pz) };
+		const auto invDeterminant{ _mm_div_ps(_mm_set1_ps(1.0f), determinant) };
+
+		const auto sx{ _mm_sub_ps(_mm_set1_ps(ray.Origin.x), _mm_load_ps(packet.V0[0])) };
+		const auto sy{ _mm_sub_ps(_mm_set1_ps(ray.Origin.y), _mm_load_ps(packet.V0[1])) };
+		const auto sz{ _mm_sub_ps(_mm_set1_ps(ray.Origin.z), _mm_load_ps(packet.V0[2])) };
+		const auto u{ _mm_mul_ps(dot(sx, sy, sz, px, py, pz), invDeterminant) };
+
+		__m128 qx, qy, qz;
+		cross(sx, sy, sz, e1x, e1y, e1z, qx, qy, qz);
+		const auto v{ _mm_mul_ps(dot(dx, dy, dz, qx, qy, qz), invDeterminant) };
+		const auto t{ _mm_mul_ps(dot(e2x, e2y, e2z, qx, qy, qz), invDeterminant) };
+
+		const auto zero{ _mm_setzero_ps() };
+		const auto absDeterminant{ _mm_andnot_ps(_mm_set1_ps(-0.0f), determinant) };
+
+		auto mask{ _mm_cmpgt_ps(absDeterminant, _mm_set1_ps(1e-8f)) };
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+		mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, zero));
+		mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(tMax)));
+
+		return _mm_movemask_ps(mask) != 0;
+	}
+#endif
+
+	/***********************************************************************************/
+	bool intersectPacketScalar(const Ray& ray, const TrianglePacket& packet, const float tMax) noexcept
+	{
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const glm::vec3 v0(packet.V0[0][lane], packet.V0[1][lane], packet.V0[2][lane]);
+			const glm::vec3 edge1(packet.Edge1[0][lane], packet.Edge1[1][lane], packet.Edge1[2][lane]);
+			const glm::vec3 edge2(packet.Edge2[0][lane], packet.Edge2[1][lane], packet.Edge2[2][lane]);
+
+			auto t{ tMax };
+			if (IntersectRayTriangle(ray, v0, edge1, edge2, t))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/***********************************************************************************/
+	// BVH over the triangles of every mesh, with the triangles of each leaf packed for SIMD tests.
+	class OcclusionScene {
+	public:
+		explicit OcclusionScene(const std::vector<AmbientOcclusion::MeshInput>& meshes)
+		{
+			std::vector<AABB> bounds;
+			for (const auto& mesh : meshes)
+			{
+				for (std::size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+				{
+					const auto& v0{ mesh.Positions[mesh.Indices[i]] };
+					const auto& v1{ mesh.Positions[mesh.Indices[i + 1]] };
+					const auto& v2{ mesh.Positions[mesh.Indices[i + 2]] };
+
+					m_triangles.push_back({ v0, v1 - v0, v2 - v0 });
+
+					AABB box(v0, v1);
+					box.extend(v2);
+					bounds.push_back(box);
+				}
+			}
+
+			m_bvh.Build(bounds);
+
+			// Leaves hold at most MaxLeafSize triangles unless the depth limit was hit, so most take one packet
+			const auto& nodes{ m_bvh.GetNodes() };
+			const auto& primitives{ m_bvh.GetPrimitiveIndices() };
+			m_packetOffsets.resize(nodes.size() + 1);
+			m_packets.reserve(m_triangles.size() / 2);
+
+			for (std::size_t i = 0; i < nodes.size(); ++i)
+			{
+				m_packetOffsets[i] = static_cast<std::uint32_t>(m_packets.size());
+
+				for (std::uint32_t first = 0; first < nodes[i].Count; first += 4)
+				{
+					TrianglePacket packet{};
+					for (std::uint32_t lane = 0; lane < 4 && first + lane < nodes[i].Count; ++lane)
+					{
+						const auto& triangle{ m_triangles[primitives[nodes[i].LeftOrFirst + first + lane]] };
+						for (int axis = 0; axis < 3; ++axis)
+						{
+							packet.V0[axis][lane] = triangle.V0[axis];
+							packet.Edge1[axis][lane] = triangle.Edge1[axis];
+							packet.Edge2[axis][lane] = triangle.Edge2[axis];
+						}
+					}
+					m_packets.push_back(packet);
+				}
+			}
+			m_packetOffsets.back() = static_cast<std::uint32_t>(m_packets.size());
+		}
+
+		// True if anything lies on the ray closer than tMax.
+		bool Occluded(const Ray& ray, const float tMax, const bool allowSIMD) const
+		{
+			return m_bvh.TraverseAny(ray, tMax, [&](const std::uint32_t leaf) {
+				for (auto i = m_packetOffsets[leaf]; i < m_packetOffsets[leaf + 1]; ++i)
+				{
+#ifdef GE_SSE2
+					if (allowSIMD ? intersectPacketSSE(ray, m_packets[i], tMax) : intersectPacketScalar(ray, m_packets[i], tMax))
+#else
+					if (intersectPacketScalar(ray, m_packets[i], tMax))
+#endif
+					{
+						return true;
+					}
+				}
+				return false;
+			});
+		}
+
+	private:
+		std::vector<TriangleBVH::Triangle> m_triangles;
+		BVH m_bvh;
+		// Packets of node i are [m_packetOffsets[i], m_packetOffsets[i + 1]), empty for interior nodes
+		std::vector<std::uint32_t> m_packetOffsets;
+		std::vector<TrianglePacket> m_packets;
+	};
+
+	/***********************************************************************************/
+	float radicalInverse(std::uint32_t bits) noexcept
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return static_cast<float>(bits) * 2.3283064365386963e-10f;
+	}
+
+	/***********************************************************************************/
+	// Cosine-distributed Hammersley points on the hemisphere around +z, as (radius, angle, height). Averaging
+	// unweighted hits over them gives cosine-weighted occlusion.
+	std::vector<glm::vec3> makeHemisphereSamples(const std::uint32_t numRays)
+	{
+		constexpr float twoPi{ 6.28318530718f };
+
+		std::vector<glm::vec3> samples(numRays);
+		for (std::uint32_t i = 0; i < numRays; ++i)
+		{
+			const auto u{ (i + 0.5f) / numRays };
+			samples[i] = { std::sqrt(u), twoPi * radicalInverse(i), std::sqrt(1.0f - u) };
+		}
+		return samples;
+	}
+
+	/***********************************************************************************/
+	// Orthonormal basis around a unit vector without a branch on its direction (Duff et al. 2017).
+	void makeBasis(const glm::vec3& n, glm::vec3& tangent, glm::vec3& bitangent) noexcept
+	{
+		const auto sign{ std::copysign(1.0f, n.z) };
+		const auto a{ -1.0f / (sign + n.z) };
+		const auto b{ n.x * n.y * a };
+		tangent = { 1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x };
+		bitangent = { b, sign + n.y * n.y * a, -n.y };
+	}
+
+	/***********************************************************************************/
+	// Per-vertex rotation of the sample pattern in [0, 2 pi), so neighbouring vertices do not band.
+	float rotationFor(std::uint32_t index) noexcept
+	{
+		index ^= index >> 16;
+		index *= 0x7feb352du;
+		index ^= index >> 15;
+		index *= 0x846ca68bu;
+		index ^= index >> 16;
+		return static_cast<float>(index) * 1.4629180792671596e-9f;
+	}
+}
+
+namespace AmbientOcclusion
+{
+	/***********************************************************************************/
+	Result Bake(const std::vector<MeshInput>& meshes, const Settings& settings)
+	{
+		Result result(meshes.size());
+
+		// Flatten (mesh, vertex) so threads split the work evenly across meshes
+		std::vector<std::size_t> firstVertex(meshes.size() + 1, 0);
+		auto sceneMin{ glm::vec3(std::numeric_limits<float>::max()) };
+		auto sceneMax{ glm::vec3(std::numeric_limits<float>::lowest()) };
+		for (std::size_t i = 0; i < meshes.size(); ++i)
+		{
+			result[i].assign(meshes[i].Positions.size(), 1.0f);
+			firstVertex[i + 1] = firstVertex[i] + meshes[i].Positions.size();
+
+			for (const auto& position : meshes[i].Positions)
+			{
+				sceneMin = glm::min(sceneMin, position);
+				sceneMax = glm::max(sceneMax, position);
+			}
+		}
+
+		const auto numVertices{ firstVertex.back() };
+		if (numVertices == 0 || settings.NumRays == 0)
+		{
+			return result;
+		}
+
+		const OcclusionScene scene(meshes);
+		const auto samples{ makeHemisphereSamples(settings.NumRays) };
+
+		const auto diagonal{ glm::length(sceneMax - sceneMin) };
+		const auto maxDistance{ settings.Radius * diagonal };
+		// Rays start slightly above the surface so they do not hit the triangles around their own vertex
+		const auto bias{ 1e-4f * diagonal };
+
+		ThreadPool::GetInstance().ParallelFor(numVertices, VERTEX_GRAIN, [&](const std::size_t begin, const std::size_t end) {
+			auto mesh{ static_cast<std::size_t>(std::upper_bound(firstVertex.cbegin(), firstVertex.cend(), begin) - firstVertex.cbegin() - 1) };
+
+			for (auto i = begin; i < end; ++i)
+			{
+				while (i >= firstVertex[mesh + 1])
+				{
+					++mesh;
+				}
+				const auto vertex{ i - firstVertex[mesh] };
+
+				const auto& normal{ meshes[mesh].Normals.size() > vertex ? meshes[mesh].Normals[vertex] : glm::vec3(0.0f) };
+				const auto length{ glm::length(normal) };
+				if (!(length > 0.0f))
+				{
+					continue;
+				}
+
+				const auto n{ normal / length };
+				glm::vec3 tangent, bitangent;
+				makeBasis(n, tangent, bitangent);
+
+				const auto origin{ meshes[mesh].Positions[vertex] + n * bias };
+				const auto rotation{ rotationFor(static_cast<std::uint32_t>(i)) };
+
+				std::uint32_t numOccluded{ 0 };
+				for (const auto& sample : samples)
+				{
+					const auto phi{ sample.y + rotation };
+					const auto direction{ tangent * (sample.x * std::cos(phi)) + bitangent * (sample.x * std::sin(phi)) + n * sample.z };
+
+					if (scene.Occluded(Ray(origin, direction), maxDistance, settings.AllowSIMD))
+					{
+						++numOccluded;
+					}
+				}
+
+				result[mesh][vertex] = 1.0f - static_cast<float>(numOccluded) / settings.NumRays;
+			}
+		}, settings.MaxThreads);
+
+		return result;
+	}
+
+	/***********************************************************************************/
+	std::filesystem::path GetCacheDirectory()
+	{
+		return std::filesystem::current_path() / "Data/cache/ao";
+	}
+
+	/***********************************************************************************/
+	std::filesystem::path BuildCachePath(const std::vector<MeshInput>& meshes, const Settings& settings)
+	{
+		auto hash{ BAKER_VERSION };
+		for (const auto& mesh : meshes)
+		{
+			hash = Hash::Combine(hash, Hash::Hash64(mesh.Positions.data(), mesh.Positions.size() * sizeof(glm::vec3)));
+			hash = Hash::Combine(hash, Hash::Hash64(mesh.Normals.data(), mesh.Normals.size() * sizeof(glm::vec3)));
+			hash = Hash::Combine(hash, Hash::Hash64(mesh.Indices.data(), mesh.Indices.size() * sizeof(std::uint32_t)));
+		}
+
+		std::uint32_t radiusBits;
+		std::memcpy(&radiusBits, &settings.Radius, sizeof(radiusBits));
+		hash = Hash::Combine(hash, settings.NumRays);
+		hash = Hash::Combine(hash, radiusBits);
+
+		return GetCacheDirectory() / (Hash::ToHex(hash) + ".ao");
+	}
+
+	/***********************************************************************************/
+	Result LoadOrBake(const std::vector<MeshInput>& meshes, const Settings& settings)
+	{
+		const auto path{ BuildCachePath(meshes, settings) };
+
+		const auto numValues{ std::accumulate(meshes.cbegin(), meshes.cend(), std::size_t{ 0 }, [](const std::size_t sum, const MeshInput& mesh) {
+			return sum + mesh.Positions.size();
+		}) };
+
+		if (std::ifstream in(path, std::ios::binary); in)
+		{
+			FileHeader header{};
+			in.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+			if (in && std::memcmp(header.Magic, FileMagic, sizeof(FileMagic)) == 0 && header.NumValues == numValues)
+			{
+				Result result(meshes.size());
+				for (std::size_t i = 0; i < meshes.size(); ++i)
+				{
+					result[i].resize(meshes[i].Positions.size());
+					in.read(reinterpret_cast<char*>(result[i].data()), static_cast<std::streamsize>(result[i].size() * sizeof(float)));
+				}
+
+				if (in)
+				{
+					return result;
+				}
+			}
+
+			std::cerr << "Ambient Occlusion: Ignoring invalid cache entry " << path << '\n';
+		}
+
+		const auto start{ std::chrono::steady_clock::now() };
+		auto result{ Bake(meshes, settings) };
+
+		std::cout << "Ambient Occlusion: Baked " << numValues << " vertices with " << settings.NumRays << " rays each in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+
+		std::error_code error;
+		std::filesystem::create_directories(path.parent_path(), error);
+
+		// Written next to the target and renamed, so a crash never leaves a truncated entry behind
+		auto tempPath{ path };
+		tempPath += ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary);
+			if (!out)
+			{
+				std::cerr << "Ambient Occlusion: Failed to write " << path << '\n';
+				return result;
+			}
+
+			FileHeader header{};
+			std::memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+			header.NumValues = numValues;
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			for (const auto& values : result)
+			{
+				out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(float)));
+			}
+		}
+
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Offline per-vertex ambient occlusion for static geometry. Every vertex shoots cosine-distributed rays over the
+// hemisphere around its normal against a BVH of all triangles passed in; the fraction that escapes is its AO.
+namespace AmbientOcclusion
+{
+	struct Settings {
+		std::uint32_t NumRays{ 64 };
+		// Occluders further away than this fraction of the bounding box diagonal are ignored
+		float Radius{ 0.05f };
+		// Test four triangles per instruction (SSE2), otherwise one at a time
+		bool AllowSIMD{ true };
+		// Threads taking part in the bake (0 = all)
+		std::size_t MaxThreads{ 0 };
+	};
+
+	// Model space geometry of one mesh. All meshes of a bake occlude each other.
+	struct MeshInput {
+		std::vector<glm::vec3> Positions;
+		std::vector<glm::vec3> Normals;
+		std::vector<std::uint32_t> Indices;
+	};
+
+	// One value per vertex and mesh, 1 = unoccluded.
+	using Result = std::vector<std::vector<float>>;
+
+	Result Bake(const std::vector<MeshInput>& meshes, const Settings& settings);
+
+	// Directory that holds baked AO.
+	std::filesystem::path GetCacheDirectory();
+	// Data/cache/ao/<hash>.ao, where the hash covers the geometry, the settings that change the result and the
+	// baker version.
+	std::filesystem::path BuildCachePath(const std::vector<MeshInput>& meshes, const Settings& settings);
+
+	// Reads the result from the cache or bakes and stores it.
+	Result LoadOrBake(const std::vector<MeshInput>& meshes, const Settings& settings);
+}
@@ -0,0 +1,298 @@
+#include "BVH.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+	/***********************************************************************************/
+	float surfaceArea(const glm::vec3& min, const glm::vec3& max) noexcept
+	{
+		const auto extent{ glm::max(max - min, glm::vec3(0.0f)) };
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+	/***********************************************************************************/
+	float safeInverse(const float x) noexcept
+	{
+		constexpr float tiny{ 1e-20f };
+		return 1.0f / (std::abs(x) > tiny ? x : std::copysign(tiny, x));
+	}
+}
+
+/***********************************************************************************/
+Ray::Ray(const glm::vec3& origin, const glm::vec3& direction) noexcept :
+	Origin{ origin },
+	Direction{ direction },
+	InvDirection{ safeInverse(direction.x), safeInverse(direction.y), safeInverse(direction.z) }
+{
+}
+
+/***********************************************************************************/
+bool IntersectRayAABB(const Ray& ray, const glm::vec3& min, const glm::vec3& max, const float tMax, float& tEntry) noexcept
+{
+	const auto t0{ (min - ray.Origin) * ray.InvDirection };
+	const auto t1{ (max - ray.Origin) * ray.InvDirection };
+
+	const auto tNear{ glm::min(t0, t1) };
+	const auto tFar{ glm::max(t0, t1) };
+
+	const auto enter{ std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f)) };
+	const auto exit{ std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax)) };
+
+	tEntry = enter;
+	return enter <= exit;
+}
+
+/***********************************************************************************/
+bool IntersectRayTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& edge1, const glm::vec3& edge2, float& tMax) noexcept
+{
+	constexpr float epsilon{ 1e-8f };
+
+	const auto p{ glm::cross(ray.Direction, edge2) };
+	const auto determinant{ glm::dot(edge1, p) };
+	if (std::abs(determinant) < epsilon)
+	{
+		return false;
+	}
+
+	const auto invDeterminant{ 1.0f / determinant };
+	const auto s{ ray.Origin - v0 };
+	const auto u{ glm::dot(s, p) * invDeterminant };
+	if (u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+
+	const auto q{ glm::cross(s, edge1) };
+	const auto v{ glm::dot(ray.Direction, q) * invDeterminant };
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+
+	const auto t{ glm::dot(edge2, q) * invDeterminant };
+	if (t <= 0.0f || t >= tMax)
+	{
+		return false;
+	}
+
+	tMax = t;
+	return true;
+}
+
+/***********************************************************************************/
+void BVH::Build(const std::vector<AABB>& bounds)
+{
+	Clear();
+	if (bounds.empty())
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> centroids(bounds.size());
+	for (std::size_t i = 0; i < bounds.size(); ++i)
+	{
+		centroids[i] = (bounds[i].getMin() + bounds[i].getMax()) * 0.5f;
+	}
+
+	m_indices.resize(bounds.size());
+	std::iota(m_indices.begin(), m_indices.end(), 0u);
+
+	// A binary tree with at least one primitive per leaf never has more than 2n - 1 nodes
+	m_nodes.reserve(bounds.size() * 2);
+	m_nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<std::uint32_t>(bounds.size()) });
+
+	subdivide(0, centroids, bounds, 1);
+}
+
+/***********************************************************************************/
+void BVH::Refit(const std::vector<AABB>& bounds)
+{
+	// Children are always stored after their parent
+	for (auto i = m_nodes.size(); i-- > 0;)
+	{
+		auto& node{ m_nodes[i] };
+		if (node.Count != 0)
+		{
+			updateBounds(node, bounds);
+		} else
+		{
+			const auto& left{ m_nodes[node.LeftOrFirst] };
+			const auto& right{ m_nodes[node.LeftOrFirst + 1] };
+			node.Min = glm::min(left.Min, right.Min);
+			node.Max = glm::max(left.Max, right.Max);
+		}
+	}
+}
+
+/***********************************************************************************/
+void BVH::Clear() noexcept
+{
+	m_nodes.clear();
+	m_indices.clear();
+}
+
+/***********************************************************************************/
+void BVH::updateBounds(Node& node, const std::vector<AABB>& bounds) const
+{
+	node.Min = glm::vec3(std::numeric_limits<float>::max());
+	node.Max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	for (std::uint32_t i = 0; i < node.Count; ++i)
+	{
+		const auto& box{ bounds[m_indices[node.LeftOrFirst + i]] };
+		node.Min = glm::min(node.Min, box.getMin());
+		node.Max = glm::max(node.Max, box.getMax());
+	}
+}
+
+/***********************************************************************************/
+void BVH::subdivide(const std::uint32_t nodeIndex, const std::vector<glm::vec3>& centroids, const std::vector<AABB>& bounds, const std::size_t depth)
+{
+	updateBounds(m_nodes[nodeIndex], bounds);
+
+	const auto first{ m_nodes[nodeIndex].LeftOrFirst };
+	const auto count{ m_nodes[nodeIndex].Count };
+	if (count <= MaxLeafSize || depth >= MaxDepth)
+	{
+		return;
+	}
+
+	// Split along the axis and bin boundary with the lowest surface area heuristic cost
+	auto centroidMin{ glm::vec3(std::numeric_limits<float>::max()) };
+	auto centroidMax{ glm::vec3(std::numeric_limits<float>::lowest()) };
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		centroidMin = glm::min(centroidMin, centroids[m_indices[first + i]]);
+		centroidMax = glm::max(centroidMax, centroids[m_indices[first + i]]);
+	}
+
+	struct Bin {
+		glm::vec3 Min{ std::numeric_limits<float>::max() };
+		glm::vec3 Max{ std::numeric_limits<float>::lowest() };
+		std::uint32_t Count{ 0 };
+	};
+
+	auto bestCost{ std::numeric_limits<float>::max() };
+	auto bestAxis{ -1 };
+	std::size_t bestSplit{ 0 };
+
+	for (auto axis = 0; axis < 3; ++axis)
+	{
+		const auto extent{ centroidMax[axis] - centroidMin[axis] };
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		std::array<Bin, NumBins> bins;
+		const auto scale{ NumBins / extent };
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			const auto primitive{ m_indices[first + i] };
+			const auto bin{ std::min(static_cast<std::size_t>((centroids[primitive][axis] - centroidMin[axis]) * scale), NumBins - 1) };
+			bins[bin].Min = glm::min(bins[bin].Min, bounds[primitive].getMin());
+			bins[bin].Max = glm::max(bins[bin].Max, bounds[primitive].getMax());
+			++bins[bin].Count;
+		}
+
+		// Sweep from the right to get the cost of every right side, then from the left
+		std::array<float, NumBins - 1> rightCosts;
+		Bin right;
+		for (auto i = NumBins - 1; i > 0; --i)
+		{
+			right.Min = glm::min(right.Min, bins[i].Min);
+			right.Max = glm::max(right.Max, bins[i].Max);
+			right.Count += bins[i].Count;
+			rightCosts[i - 1] = right.Count * surfaceArea(right.Min, right.Max);
+		}
+
+		Bin left;
+		for (std::size_t i = 0; i < NumBins - 1; ++i)
+		{
+			left.Min = glm::min(left.Min, bins[i].Min);
+			left.Max = glm::max(left.Max, bins[i].Max);
+			left.Count += bins[i].Count;
+
+			const auto cost{ left.Count * surfaceArea(left.Min, left.Max) + rightCosts[i] };
+			if (left.Count != 0 && left.Count != count && cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	std::uint32_t leftCount{ 0 };
+	if (bestAxis != -1)
+	{
+		const auto scale{ NumBins / (centroidMax[bestAxis] - centroidMin[bestAxis]) };
+		const auto middle{ std::partition(m_indices.begin() + first, m_indices.begin() + first + count, [&](const auto primitive) {
+			return std::min(static_cast<std::size_t>((centroids[primitive][bestAxis] - centroidMin[bestAxis]) * scale), NumBins - 1) <= bestSplit;
+		}) };
+		leftCount = static_cast<std::uint32_t>(middle - (m_indices.begin() + first));
+	}
+
+	// All centroids in one spot: split in the middle of the list
+	if (leftCount == 0 || leftCount == count)
+	{
+		leftCount = count / 2;
+	}
+
+	const auto leftIndex{ static_cast<std::uint32_t>(m_nodes.size()) };
+	m_nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), leftCount });
+	m_nodes.push_back({ glm::vec3(0.0f), first + leftCount, glm::vec3(0.0f), count - leftCount });
+
+	m_nodes[nodeIndex].LeftOrFirst = leftIndex;
+	m_nodes[nodeIndex].Count = 0;
+
+	subdivide(leftIndex, centroids, bounds, depth + 1);
+	subdivide(leftIndex + 1, centroids, bounds, depth + 1);
+}
+
+/***********************************************************************************/
+TriangleBVH::TriangleBVH(const std::vector<glm::vec3>& positions, const std::vector<std::uint32_t>& indices)
+{
+	const auto numTriangles{ indices.size() / 3 };
+	m_triangles.reserve(numTriangles);
+
+	std::vector<AABB> bounds;
+	bounds.reserve(numTriangles);
+
+	for (std::size_t i = 0; i < numTriangles; ++i)
+	{
+		const auto& v0{ positions[indices[i * 3]] };
+		const auto& v1{ positions[indices[i * 3 + 1]] };
+		const auto& v2{ positions[indices[i * 3 + 2]] };
+
+		m_triangles.push_back({ v0, v1 - v0, v2 - v0 });
+
+		AABB box(v0, v1);
+		box.extend(v2);
+		bounds.push_back(box);
+	}
+
+	m_bvh.Build(bounds);
+}
+
+/***********************************************************************************/
+bool TriangleBVH::Intersect(const Ray& ray, float& tMax, std::uint32_t& triangle) const
+{
+	auto hit{ false };
+	m_bvh.Traverse(ray, tMax, [&](const std::uint32_t primitive, float& t) {
+		const auto& tri{ m_triangles[primitive] };
+		if (IntersectRayTriangle(ray, tri.V0, tri.Edge1, tri.Edge2, t))
+		{
+			triangle = primitive;
+			hit = true;
+		}
+	});
+
+	return hit;
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "AABB.h"
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/***********************************************************************************/
+struct Ray {
+	Ray() noexcept = default;
+	Ray(const glm::vec3& origin, const glm::vec3& direction) noexcept;
+
+	glm::vec3 Origin{ 0.0f };
+	glm::vec3 Direction{ 0.0f, 0.0f, -1.0f };
+	// Components of axis-aligned directions are replaced by a tiny value of the same sign before inverting,
+	// so slab tests never compute 0 * inf.
+	glm::vec3 InvDirection{ 0.0f };
+};
+
+// Slab test against [min, max]. On a hit closer than tMax, tEntry is where the ray enters the box (0 if the
+// origin is inside).
+bool IntersectRayAABB(const Ray& ray, const glm::vec3& min, const glm::vec3& max, const float tMax, float& tEntry) noexcept;
+
+// Möller-Trumbore, with the triangle given as v0 and the edges v1 - v0 and v2 - v0. Hits closer than tMax
+// update it; back faces count as hits.
+bool IntersectRayTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& edge1, const glm::vec3& edge2, float& tMax) noexcept;
+
+/***********************************************************************************/
+// Bounding volume hierarchy over boxes, built with binned SAH. It only stores indices of the boxes it was
+// built from; the caller tests the primitives in the leaves.
+class BVH {
+public:
+	static constexpr std::uint32_t MaxLeafSize{ 4 };
+
+	struct Node {
+		glm::vec3 Min;
+		// Left child (the right one follows it) or, in a leaf, the first entry of GetPrimitiveIndices
+		std::uint32_t LeftOrFirst;
+		glm::vec3 Max;
+		// Number of primitives, 0 for interior nodes
+		std::uint32_t Count;
+	};
+
+	void Build(const std::vector<AABB>& bounds);
+	// Updates the node bounds after primitives moved, keeping the tree. Cheaper than Build but the tree
+	// degrades if the primitives move far.
+	void Refit(const std::vector<AABB>& bounds);
+	void Clear() noexcept;
+
+	bool IsEmpty() const noexcept { return m_nodes.empty(); }
+	const auto& GetNodes() const noexcept { return m_nodes; }
+	const auto& GetPrimitiveIndices() const noexcept { return m_indices; }
+
+	// Visits the leaves the ray passes through, nearest first, skipping everything behind tMax.
+	// leafTest(primitive, tMax) tests one primitive and lowers tMax on a closer hit.
+	template<typename LeafTest>
+	void Traverse(const Ray& ray, float& tMax, LeafTest&& leafTest) const
+	{
+		float tEntry;
+		if (m_nodes.empty() || !IntersectRayAABB(ray, m_nodes[0].Min, m_nodes[0].Max, tMax, tEntry))
+		{
+			return;
+		}
+
+		struct Entry {
+			std::uint32_t Node;
+			float T;
+		};
+		std::array<Entry, MaxDepth> stack;
+		std::size_t stackSize{ 0 };
+
+		std::uint32_t nodeIndex{ 0 };
+		for (;;)
+		{
+			const auto& node{ m_nodes[nodeIndex] };
+			if (node.Count != 0)
+			{
+				for (std::uint32_t i = 0; i < node.Count; ++i)
+				{
+					leafTest(m_indices[node.LeftOrFirst + i], tMax);
+				}
+			} else
+			{
+				float tLeft, tRight;
+				const auto hitLeft{ IntersectRayAABB(ray, m_nodes[node.LeftOrFirst].Min, m_nodes[node.LeftOrFirst].Max, tMax, tLeft) };
+				const auto hitRight{ IntersectRayAABB(ray, m_nodes[node.LeftOrFirst + 1].Min, m_nodes[node.LeftOrFirst + 1].Max, tMax, tRight) };
+
+				if (hitLeft && hitRight)
+				{
+					const auto leftFirst{ tLeft <= tRight };
+					stack[stackSize++] = leftFirst ? Entry{ node.LeftOrFirst + 1, tRight } : Entry{ node.LeftOrFirst, tLeft };
+					nodeIndex = leftFirst ? node.LeftOrFirst : node.LeftOrFirst + 1;
+					continue;
+				}
+				if (hitLeft || hitRight)
+				{
+					nodeIndex = hitLeft ? node.LeftOrFirst : node.LeftOrFirst + 1;
+					continue;
+				}
+			}
+
+			// Pop the next node that may still hold something closer than the best hit so far
+			do
+			{
+				if (stackSize == 0)
+				{
+					return;
+				}
+				--stackSize;
+			} while (stack[stackSize].T >= tMax);
+
+			nodeIndex = stack[stackSize].Node;
+		}
+	}
+
+	// Visibility query: visits the leaves the ray passes through before tMax in no particular order and stops as
+	// soon as leafTest(leafNodeIndex) returns true. Returns whether it did.
+	template<typename LeafTest>
+	bool TraverseAny(const Ray& ray, const float tMax, LeafTest&& leafTest) const
+	{
+		float tEntry;
+		if (m_nodes.empty() || !IntersectRayAABB(ray, m_nodes[0].Min, m_nodes[0].Max, tMax, tEntry))
+		{
+			return false;
+		}
+
+		std::array<std::uint32_t, MaxDepth> stack;
+		std::size_t stackSize{ 0 };
+
+		std::uint32_t nodeIndex{ 0 };
+		for (;;)
+		{
+			const auto& node{ m_nodes[nodeIndex] };
+			if (node.Count != 0)
+			{
+				if (leafTest(nodeIndex))
+				{
+					return true;
+				}
+			} else
+			{
+				const auto hitLeft{ IntersectRayAABB(ray, m_nodes[node.LeftOrFirst].Min, m_nodes[node.LeftOrFirst].Max, tMax, tEntry) };
+				const auto hitRight{ IntersectRayAABB(ray, m_nodes[node.LeftOrFirst + 1].Min, m_nodes[node.LeftOrFirst + 1].Max, tMax, tEntry) };
+
+				if (hitLeft || hitRight)
+				{
+					if (hitLeft && hitRight)
+					{
+						stack[stackSize++] = node.LeftOrFirst + 1;
+					}
+					nodeIndex = hitLeft ? node.LeftOrFirst : node.LeftOrFirst + 1;
+					continue;
+				}
+			}
+
+			if (stackSize == 0)
+			{
+				return false;
+			}
+			nodeIndex = stack[--stackSize];
+		}
+	}
+
+private:
+	// Build falls back to median splits, so the depth stays logarithmic
+	static constexpr std::size_t MaxDepth{ 64 };
+	static constexpr std::size_t NumBins{ 12 };
+
+	void subdivide(const std::uint32_t nodeIndex, const std::vector<glm::vec3>& centroids, const std::vector<AABB>& bounds, const std::size_t depth);
+	void updateBounds(Node& node, const std::vector<AABB>& bounds) const;
+
+	std::vector<Node> m_nodes;
+	std::vector<std::uint32_t> m_indices;
+};
+
+/***********************************************************************************/
+// BVH over the triangles of an indexed mesh, for exact ray hits.
+class TriangleBVH {
+public:
+	TriangleBVH(const std::vector<glm::vec3>& positions, const std::vector<std::uint32_t>& indices);
+
+	// Nearest triangle closer than tMax. On a hit tMax becomes its distance and triangle its index in the
+	// index buffer (divided by 3).
+	bool Intersect(const Ray& ray, float& tMax, std::uint32_t& triangle) const;
+
+	auto GetNumTriangles() const noexcept { return m_triangles.size(); }
+	const auto& GetBVH() const noexcept { return m_bvh; }
+
+	struct Triangle {
+		glm::vec3 V0, Edge1, Edge2;
+	};
+	const auto& GetTriangles() const noexcept { return m_triangles; }
+
+private:
+	std::vector<Triangle> m_triangles;
+	BVH m_bvh;
+};
@@ -54,6 +54,24 @@ void Camera::Update(const double deltaTime)
 	}
 }
 
+/***********************************************************************************/
+void Camera::SetLookAt(const glm::vec3& position, const glm::vec3& target)
+{
+	m_position = position;
+
+	const auto direction{ target - position };
+	if (glm::dot(direction, direction) < 1e-12f)
+	{
+		return;
+	}
+
+	const auto front{ glm::normalize(direction) };
+	m_yaw = glm::degrees(std::atan2(front.z, front.x));
+	m_pitch = glm::clamp(glm::degrees(std::asin(front.y)), -89.0f, 89.0f);
+
+	updateVectors();
+}
+
 /***********************************************************************************/
 void Camera::processKeyboard(const Direction direction, const double deltaTime) noexcept
 {
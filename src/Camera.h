@@ -13,6 +13,9 @@ public:
 
 	void Update(const double deltaTime);
 
+	// Places the camera at position looking towards target, e.g. when following a camera path.
+	void SetLookAt(const glm::vec3& position, const glm::vec3& target);
+
 	auto GetViewMatrix() const { return lookAt(m_position, m_position + m_front, m_up); }
 	// TODO: optimize projection matrix calculation
 	auto GetProjMatrix(const float width, const float height) const { return glm::perspective(m_FOV, width / height, m_near, m_far); }
@@ -0,0 +1,108 @@
+#include "CameraPath.h"
+
+#include "resourceManager.h"
+
+#include <pugixml.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	/***********************************************************************************/
+	glm::vec3 readVec3(const pugi::xml_node& node, const std::string& prefix)
+	{
+		return {
+			node.attribute((prefix + "_X").c_str()).as_float(),
+			node.attribute((prefix + "_Y").c_str()).as_float(),
+			node.attribute((prefix + "_Z").c_str()).as_float()
+		};
+	}
+
+	/***********************************************************************************/
+	// Uniform Catmull-Rom segment between p1 and p2, t in [0, 1]
+	glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const float t)
+	{
+		const auto t2{ t * t };
+		const auto t3{ t2 * t };
+
+		return 0.5f * ((2.0f * p1) +
+			(-p0 + p2) * t +
+			(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+			(-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+	}
+}
+
+/***********************************************************************************/
+bool CameraPath::Load(const std::filesystem::path& path)
+{
+	m_keys.clear();
+
+	pugi::xml_document doc;
+	const auto& result{ doc.load_string(ResourceManager::GetInstance().LoadTextFile(path).data()) };
+	if (!result)
+	{
+		std::cerr << "CameraPath Error: Failed to parse " << path.string() << ": " << result.description() << std::endl;
+		return false;
+	}
+
+	const auto& pathNode{ doc.child("CameraPath") };
+	m_name = pathNode.attribute("Name").as_string(path.stem().string().c_str());
+	m_loop = pathNode.attribute("Loop").as_bool(false);
+
+	for (const auto& keyNode : pathNode.children("Key"))
+	{
+		m_keys.push_back({ keyNode.attribute("Time").as_float(), readVec3(keyNode, "Position"), readVec3(keyNode, "Target") });
+	}
+
+	std::stable_sort(m_keys.begin(), m_keys.end(), [](const auto& a, const auto& b) { return a.Time < b.Time; });
+
+	if (m_keys.size() < 2)
+	{
+		std::cerr << "CameraPath Error: " << path.string() << " needs at least two keys" << std::endl;
+		m_keys.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************************************/
+CameraPath::Pose CameraPath::Evaluate(const double time) const
+{
+	if (m_keys.empty())
+	{
+		return {};
+	}
+
+	const auto duration{ GetDuration() };
+	auto t{ static_cast<float>(time) };
+	if (m_loop && duration > 0.0f)
+	{
+		t = std::fmod(t, duration);
+		if (t < 0.0f)
+		{
+			t += duration;
+		}
+	}
+	t = std::clamp(t, m_keys.front().Time, duration);
+
+	// Segment [i, i + 1] containing t
+	const auto next{ std::upper_bound(m_keys.cbegin(), m_keys.cend(), t, [](const float value, const auto& key) { return value < key.Time; }) };
+	const auto i{ static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(next - m_keys.cbegin() - 1, 0, static_cast<std::ptrdiff_t>(m_keys.size()) - 2)) };
+
+	const auto& k1{ m_keys[i] };
+	const auto& k2{ m_keys[i + 1] };
+	// End points are repeated, looping paths wrap around instead
+	const auto& k0{ i > 0 ? m_keys[i - 1] : (m_loop ? m_keys[m_keys.size() - 2] : k1) };
+	const auto& k3{ i + 2 < m_keys.size() ? m_keys[i + 2] : (m_loop ? m_keys[1] : k2) };
+
+	const auto segmentLength{ k2.Time - k1.Time };
+	const auto u{ segmentLength > 0.0f ? (t - k1.Time) / segmentLength : 0.0f };
+
+	return {
+		catmullRom(k0.Position, k1.Position, k2.Position, k3.Position, u),
+		catmullRom(k0.Target, k1.Target, k2.Target, k3.Target, u)
+	};
+}
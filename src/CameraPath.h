@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Camera flythrough defined by timed keys in XML. Position and look-at target are interpolated with
+// Catmull-Rom splines, so the camera moves smoothly through every key. Looping paths end with a copy
+// of their first key.
+//
+//	<CameraPath Name="Sponza" Loop="false">
+//		<Key Time="0" Position_X="-10" Position_Y="2" Position_Z="0" Target_X="0" Target_Y="2" Target_Z="0" />
+//		...
+//	</CameraPath>
+class CameraPath {
+public:
+	struct Key {
+		float Time{ 0.0f };
+		glm::vec3 Position{ 0.0f };
+		glm::vec3 Target{ 0.0f };
+	};
+
+	struct Pose {
+		glm::vec3 Position;
+		glm::vec3 Target;
+	};
+
+	bool Load(const std::filesystem::path& path);
+
+	// Pose at time seconds. Clamped to the last key, or wrapped when the path loops.
+	Pose Evaluate(const double time) const;
+
+	auto GetDuration() const noexcept { return m_keys.empty() ? 0.0f : m_keys.back().Time; }
+	auto IsLooping() const noexcept { return m_loop; }
+	const auto& GetName() const noexcept { return m_name; }
+	const auto& GetKeys() const noexcept { return m_keys; }
+
+private:
+	std::string m_name;
+	std::vector<Key> m_keys;
+	bool m_loop{ false };
+};
@@ -1,7 +1,6 @@
 #include "Demo.h"
 
-#include "../ResourceManager.h"
-#include <fileapi.h>
+#include "../resourceManager.h"
 
 Demo::Demo()
 {
@@ -3,17 +3,23 @@
 #include "Timer.h"
 #include "Input.h"
 #include "ViewFrustum.h"
-#include "ResourceManager.h"
+#include "resourceManager.h"
 #include "SceneBase.h"
 #include "FrameStats.h"
 #include "Platform/Platform.h"
+#include "core/Profiler.h"
+#include "core/AllocationCounter.h"
+#include "graphics/GPUMemory.h"
 
 #include <GLFW/glfw3.h>
 #include <pugixml.hpp>
+#include <fmt/core.h>
+#include <stb_image_write.h>
 
 #include <iostream>
+#include <fstream>
 #include <algorithm>
-#include <execution>
+#include <chrono>
 #include <thread>
 
 /***********************************************************************************/
@@ -52,6 +58,64 @@ void connectWindowInstanceToInput(GLFWwindow* window)
 
 
 
+/***********************************************************************************/
+// Timing samples of one render pass over a headless run
+struct PassSamples {
+	std::string_view Name;
+	std::vector<double> CPUMilliseconds;
+	std::vector<double> GPUMilliseconds;
+};
+
+struct SampleStats {
+	double Mean{ 0.0 }, Min{ 0.0 }, Max{ 0.0 };
+};
+
+/***********************************************************************************/
+SampleStats computeSampleStats(const std::vector<double>& samples)
+{
+	if (samples.empty())
+	{
+		return {};
+	}
+
+	const auto [min, max] { std::minmax_element(samples.cbegin(), samples.cend()) };
+	double sum{ 0.0 };
+	for (const auto sample : samples)
+	{
+		sum += sample;
+	}
+
+	return { sum / static_cast<double>(samples.size()), *min, *max };
+}
+
+/***********************************************************************************/
+bool writePassReport(const std::filesystem::path& path, const std::vector<PassSamples>& passes)
+{
+	std::error_code ec;
+	if (path.has_parent_path())
+	{
+		std::filesystem::create_directories(path.parent_path(), ec);
+	}
+
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cerr << "Engine Error: Failed to write " << path.string() << std::endl;
+		return false;
+	}
+
+	out << "pass,samples,cpu_avg_ms,cpu_min_ms,cpu_max_ms,gpu_avg_ms,gpu_min_ms,gpu_max_ms\n";
+	for (const auto& pass : passes)
+	{
+		const auto cpu{ computeSampleStats(pass.CPUMilliseconds) };
+		const auto gpu{ computeSampleStats(pass.GPUMilliseconds) };
+		out << fmt::format("{},{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f}\n",
+			pass.Name, pass.CPUMilliseconds.size(), cpu.Mean, cpu.Min, cpu.Max, gpu.Mean, gpu.Min, gpu.Max);
+	}
+
+	return true;
+}
+
 /***********************************************************************************/
 double frameTimeMilliseconds(const unsigned int numFramesRendered)
 {
@@ -64,6 +128,80 @@ double framesPerSecond(const double frameTimeMilliseconds)
 	return 1.0 / (frameTimeMilliseconds / 1000.0);
 }
 
+/***********************************************************************************/
+HeadlessSettings readHeadlessSettings(const pugi::xml_node& headlessNode)
+{
+	HeadlessSettings settings;
+	settings.Enabled = headlessNode.attribute("enabled").as_bool(false);
+	settings.Frames = headlessNode.attribute("frames").as_uint(settings.Frames);
+	settings.WarmupFrames = headlessNode.attribute("warmupFrames").as_uint(settings.WarmupFrames);
+	settings.Screenshot = headlessNode.attribute("screenshot").as_string();
+	settings.Report = headlessNode.attribute("report").as_string();
+	settings.Trace = headlessNode.attribute("trace").as_string();
+	settings.CheckAllocations = headlessNode.attribute("checkAllocations").as_bool(settings.CheckAllocations);
+
+	return settings;
+}
+
+/***********************************************************************************/
+BenchmarkSettings readBenchmarkSettings(const pugi::xml_node& benchmarkNode)
+{
+	BenchmarkSettings settings;
+
+	const std::string_view mode{ benchmarkNode.attribute("mode").as_string("none") };
+	if (mode == "record")
+	{
+		settings.Mode = BenchmarkSettings::Type::Record;
+	} else if (mode == "replay")
+	{
+		settings.Mode = BenchmarkSettings::Type::Replay;
+	} else if (mode == "flythrough")
+	{
+		settings.Mode = BenchmarkSettings::Type::Flythrough;
+	} else if (mode != "none")
+	{
+		std::cerr << "Engine Error: Unknown benchmark mode: " << mode << std::endl;
+	}
+
+	settings.Input = benchmarkNode.attribute("input").as_string();
+	settings.CameraPath = benchmarkNode.attribute("cameraPath").as_string();
+	settings.Timestep = benchmarkNode.attribute("timestep").as_double(settings.Timestep);
+	settings.Report = benchmarkNode.attribute("report").as_string();
+
+	return settings;
+}
+
+/***********************************************************************************/
+FrameHistory::Settings readFrameHistorySettings(const pugi::xml_node& frameHistoryNode)
+{
+	FrameHistory::Settings settings;
+	settings.Capacity = frameHistoryNode.attribute("capacity").as_uint(static_cast<unsigned int>(settings.Capacity));
+	settings.SpikeFactor = frameHistoryNode.attribute("spikeFactor").as_float(settings.SpikeFactor);
+	settings.SpikeMinMilliseconds = frameHistoryNode.attribute("spikeMinMs").as_float(settings.SpikeMinMilliseconds);
+
+	return settings;
+}
+
+/***********************************************************************************/
+AmbientOcclusion::Settings readAmbientOcclusionSettings(const pugi::xml_node& ambientOcclusionNode)
+{
+	AmbientOcclusion::Settings settings;
+	settings.NumRays = ambientOcclusionNode.attribute("rays").as_uint(settings.NumRays);
+	settings.Radius = ambientOcclusionNode.attribute("radius").as_float(settings.Radius);
+
+	return settings;
+}
+
+/***********************************************************************************/
+SimulationSettings readSimulationSettings(const pugi::xml_node& simulationNode)
+{
+	SimulationSettings settings;
+	settings.Threaded = simulationNode.attribute("threaded").as_bool(settings.Threaded);
+	settings.TickRate = simulationNode.attribute("tickRate").as_double(settings.TickRate);
+
+	return settings;
+}
+
 /***********************************************************************************/
 Engine::Engine(const std::filesystem::path& configPath)
 {
@@ -84,6 +222,62 @@ Engine::Engine(const std::filesystem::path& configPath)
 
 	const auto& engineNode{ doc.child("Engine") };
 
+	const auto& frameHistoryNode{ engineNode.child("FrameHistory") };
+	m_frameHistory.SetSettings(readFrameHistorySettings(frameHistoryNode));
+	m_frameHistoryExport = frameHistoryNode.attribute("export").as_string();
+	m_gpuMemoryReport = engineNode.child("GPUMemory").attribute("report").as_string();
+	m_gpuMemoryReportOnExit = engineNode.child("GPUMemory").attribute("exportOnExit").as_bool();
+	m_guiSystem.SetGPUMemoryReportPath(m_gpuMemoryReport);
+
+	m_benchmark = readBenchmarkSettings(engineNode.child("Benchmark"));
+	m_simulationSettings = readSimulationSettings(engineNode.child("Simulation"));
+
+	// Models loaded from here on get baked ambient occlusion
+	const auto& ambientOcclusionNode{ engineNode.child("AmbientOcclusion") };
+	Model::SetBakeAmbientOcclusion(ambientOcclusionNode.attribute("bake").as_bool(), readAmbientOcclusionSettings(ambientOcclusionNode));
+
+	// glTF and OBJ models loaded from here on skip Assimp
+	const auto modelsNode{ engineNode.child("Models") };
+	Model::SetNativeGLTF(modelsNode.attribute("nativeGLTF").as_bool(true));
+	Model::SetNativeOBJ(modelsNode.attribute("nativeOBJ").as_bool(true));
+
+	// Meshes loaded from here on are split into meshlets, which the camera view culls by frustum and facing
+	const auto meshletsNode{ engineNode.child("Meshlets") };
+	Graphics::MeshletBuildOptions meshletOptions;
+	meshletOptions.MaxVertices = std::clamp(meshletsNode.attribute("maxVertices").as_uint(64), 3u, 256u);
+	meshletOptions.MaxTriangles = std::clamp(meshletsNode.attribute("maxTriangles").as_uint(126), 1u, 512u);
+	Mesh::SetBuildMeshlets(meshletsNode.attribute("build").as_bool(), meshletOptions);
+	m_meshletCulling = meshletsNode.attribute("build").as_bool() && meshletsNode.attribute("culling").as_bool(true);
+	m_meshletCullSettings.ConeCulling = meshletsNode.attribute("coneCulling").as_bool();
+
+	// Meshes loaded from here on keep their triangles for exact picking and for tracing irradiance probes
+	Mesh::SetBuildTriangleBVH(engineNode.child("Picking").attribute("trianglePrecise").as_bool() ||
+		engineNode.child("Renderer").child("IrradianceVolume").attribute("enabled").as_bool());
+
+	m_headless = readHeadlessSettings(engineNode.child("Headless"));
+	if (m_headless.Enabled)
+	{
+		if (m_benchmark.Mode == BenchmarkSettings::Type::Record)
+		{
+			std::cerr << "Engine Error: Input can not be recorded headless, benchmark disabled." << std::endl;
+			m_benchmark.Mode = BenchmarkSettings::Type::None;
+		}
+
+		std::cout << "**************************************************\n";
+		std::cout << "Initializing headless OpenGL context...\n";
+		if (!m_headlessContext.Init(engineNode.child("Window")))
+		{
+			std::cerr << "Engine Error: Failed to create a headless OpenGL context." << std::endl;
+			std::abort();
+		}
+
+		std::cout << "**************************************************\n";
+		std::cout << "Initializing OpenGL Renderer (offscreen)...\n";
+		m_renderer.Init(engineNode.child("Renderer"), HeadlessContext::GetProcAddress, true);
+
+		return;
+	}
+
 	std::cout << "**************************************************\n";
 	std::cout << "Initializing Window...\n";
 	auto* window{ m_window.Init(engineNode.child("Window")) };
@@ -91,9 +285,10 @@ Engine::Engine(const std::filesystem::path& configPath)
 
 	std::cout << "**************************************************\n";
 	std::cout << "Initializing OpenGL Renderer...\n";
-	m_renderer.Init(engineNode.child("Renderer"));
+	m_renderer.Init(engineNode.child("Renderer"), reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 
 	m_guiSystem.Init(m_window.m_window);
+
 }
 
 /***********************************************************************************/
@@ -113,43 +308,34 @@ void Engine::SetActiveScene(const std::string_view sceneName)
 		return;
 	}
 
-	m_activeScene = scene->second.get();
-	m_renderer.UpdateView(m_camera);
-}
-
-bool rayIntersectsBoundingBox(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, const AABB& aabb)
-{
-	float tmin = (aabb.getMin().x - rayOrigin.x) / rayDirection.x;
-	float tmax = (aabb.getMax().x - rayOrigin.x) / rayDirection.x;
+	// The simulation thread must not step a scene that is being replaced or read below
+	const auto simulationRunning{ m_simulation.IsRunning() };
+	m_simulation.Stop();
 
-	if (tmin > tmax) std::swap(tmin, tmax);
-
-	float tymin = (aabb.getMin().y - rayOrigin.y) / rayDirection.y;
-	float tymax = (aabb.getMax().y - rayOrigin.y) / rayDirection.y;
-
-	if (tymin > tymax) std::swap(tymin, tymax);
-
-	if ((tmin > tymax) || (tymin > tmax))
-		return false;
-
-	if (tymin > tmin)
-		tmin = tymin;
-	if (tymax < tmax)
-		tmax = tymax;
-
-	float tzmin = (aabb.getMin().z - rayOrigin.z) / rayDirection.z;
-	float tzmax = (aabb.getMax().z - rayOrigin.z) / rayDirection.z;
+	m_activeScene = scene->second.get();
+	m_activeScene->CaptureSnapshot(m_sceneState);
 
-	if (tzmin > tzmax) std::swap(tzmin, tzmax);
+	m_renderScene.Clear();
+	m_renderModels.clear();
+	for (const auto& model : m_activeScene->m_sceneModels)
+	{
+		m_renderModels.push_back(m_renderScene.AddModel(*model));
+	}
+	m_renderer.BuildMaterialTable(m_renderScene);
+	m_renderer.UpdateView(m_camera);
 
-	if ((tmin > tzmax) || (tzmin > tmax))
-		return false;
+	// Build the picking BVH now rather than on the first click, the irradiance probes trace through it
+	m_picking.Update(m_activeScene->m_sceneModels);
+	m_renderer.BuildIrradianceVolume(*m_activeScene, m_picking);
 
-	return true;
+	if (simulationRunning)
+	{
+		m_simulation.Start(*m_activeScene, m_simulationSettings.TickRate);
+	}
 }
 
 /***********************************************************************************/
-void Engine::Execute()
+int Engine::Execute()
 {
 
 	if (m_activeScene == nullptr)
@@ -162,17 +348,47 @@ void Engine::Execute()
 	std::cout << "Engine initialization complete!\n";
 	std::cout << "**************************************************\n";
 
+	if (m_headless.Enabled)
+	{
+		// Nothing to present, the image stays in the offscreen target
+		m_renderer.StartRenderThread([this]() { m_headlessContext.MakeContextCurrent(); }, {}, [this]() { m_headlessContext.ReleaseContext(); });
+		const auto passed{ executeHeadless() };
+		shutdown();
+		return passed ? 0 : 1;
+	}
+
 	bool hasOneSecondPassed{ false };
 	Timer timer(1.0, [&]() {
 		hasOneSecondPassed = true;
 		});
 
+	m_renderer.SetPassTimingCallback([&](const std::vector<PassTiming>& passes) {
+		m_frameHistory.AddGPUFrame(passes);
+	});
+
+	beginBenchmark();
+
+	// Frames are replayed by a render thread owning the context from here on, if the config enables it
+	m_renderer.StartRenderThread([this]() { m_window.MakeContextCurrent(); }, [this]() { m_window.SwapBuffers(); }, [this]() { m_window.ReleaseContext(); });
+
+	// Replays and flythroughs feed the scene their own time step
+	if (m_simulationSettings.Threaded && (m_benchmark.Mode == BenchmarkSettings::Type::None || m_benchmark.Mode == BenchmarkSettings::Type::Record))
+	{
+		m_simulation.Start(*m_activeScene, m_simulationSettings.TickRate);
+	}
+
 	// Main loop
 	unsigned int numFramesRendered{ 0 };
 	FrameStats frameStats;
 	bool showFrameStats{ true };
+	PROFILE_THREAD_NAME("Main");
 	while (!m_window.ShouldClose())
 	{
+		PROFILE_NEW_FRAME();
+		PROFILE_SCOPE("Frame");
+		m_frameHistory.BeginFrame();
+		m_frameArena.Reset();
+
 		timer.Update(glfwGetTime());
 
 		if (hasOneSecondPassed)
@@ -180,122 +396,670 @@ void Engine::Execute()
 			const auto frameTime{ frameTimeMilliseconds(numFramesRendered) };
 			frameStats.frameTimeMilliseconds = frameTime;
 			frameStats.videoMemoryUsageKB = m_renderer.GetVideoMemUsageKB();
+			frameStats.trackedVideoMemoryKB = Graphics::GPUMemoryTracker::GetInstance().GetTotals().Bytes / 1024;
 			frameStats.ramUsageKB = Platform::maxRSSKb();
 
+			const auto renderGraph{ m_renderer.GetRenderGraphStats() };
+			frameStats.renderPasses = renderGraph.Passes;
+			frameStats.culledRenderPasses = renderGraph.CulledPasses;
+			frameStats.transientTextureKB = renderGraph.AllocatedBytes / 1024;
+			frameStats.aliasingSavedKB = renderGraph.GetSavedBytes() / 1024;
+
+			const auto simulation{ m_simulation.GetStats() };
+			frameStats.threadedSimulation = m_simulation.IsRunning();
+			frameStats.simulationTickRate = 1.0 / m_simulation.GetTickSeconds();
+			frameStats.simulationTickMilliseconds = simulation.TickMilliseconds;
+			frameStats.droppedSimulationTicks = simulation.DroppedTicks;
+
 			numFramesRendered = 0;
 			hasOneSecondPassed = false;
 		}
 
-		const auto dt{ timer.GetDelta() };
-
+		// The controller reacts within frames, so its state is shown live
+		const auto& dynamicResolution{ m_renderer.GetDynamicResolution() };
+		const auto& controller{ dynamicResolution.GetState() };
+		frameStats.dynamicResolution = dynamicResolution.IsEnabled();
+		frameStats.renderScale = dynamicResolution.GetScale();
+		frameStats.scaleError = controller.Error;
+		frameStats.scaleProportional = controller.Proportional;
+		frameStats.scaleIntegral = controller.Integral;
+		frameStats.scaleDerivative = controller.Derivative;
+		frameStats.gpuFrameMilliseconds = controller.SmoothedMilliseconds;
+		frameStats.targetFrameMilliseconds = dynamicResolution.GetSettings().TargetMilliseconds;
+
+		// Of the previous frame's view
+		frameStats.meshletCulling = m_meshletCulling;
+		frameStats.meshlets = m_meshletCullCounts.Meshlets;
+		frameStats.frustumCulledMeshlets = m_meshletCullCounts.FrustumCulled;
+		frameStats.coneCulledMeshlets = m_meshletCullCounts.ConeCulled;
+		frameStats.trianglesBeforeMeshletCulling = m_meshletCullCounts.TrianglesBefore;
+		frameStats.trianglesAfterMeshletCulling = m_meshletCullCounts.TrianglesAfter;
+
+		auto dt{ timer.GetDelta() };
 
+		{
+			PROFILE_SCOPE("Input");
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Input) };
+			Input::GetInstance().Update();
 
-		Input::GetInstance().Update();
+			m_window.Update();
+		}
 
-		m_window.Update();
+		if (!advanceBenchmark(dt))
+		{
+			break;
+		}
 
 		const auto& [width, height] = m_window.GetFramebufferDims();
 
-		m_camera.Update(dt);
+		{
+			PROFILE_SCOPE("Camera");
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Camera) };
+			m_camera.Update(dt);
+		}
 
-		m_activeScene->Update(dt);
+		{
+			PROFILE_SCOPE("Scene::Update");
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::SceneUpdate) };
+			updateScene(dt);
+		}
 
-		m_renderer.Update(m_camera);
+		{
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::RenderUpdate) };
+			m_renderer.Update(m_camera);
+		}
 
-		const auto& renderList{ cullViewFrustum() };
-		m_renderer.Render(m_camera, renderList.cbegin(), renderList.cend(), *m_activeScene, false);
+		RenderList renderList{ ArenaAllocator<std::uint32_t>(m_frameArena) };
+		Graphics::MeshletDrawList meshletDraws{ m_frameArena };
+		const Graphics::MeshletDrawList* visibleMeshlets;
+		{
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Culling) };
+			visibleMeshlets = cullViewFrustum(renderList, meshletDraws);
+		}
 
-		m_guiSystem.Update(&m_renderer, m_activeScene);
-		m_guiSystem.Render(width, height, frameStats, m_activeScene);
+		{
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Render) };
+			m_renderer.Render(m_camera, m_renderScene, renderList.cbegin(), renderList.cend(), m_sceneState, false, visibleMeshlets);
+		}
+
+		{
+			PROFILE_SCOPE("GUI");
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::GUI) };
+			// The render thread draws the previous frame's widgets until it replayed that frame
+			m_renderer.WaitForReplay();
+			m_guiSystem.Update(&m_renderer, m_activeScene);
+			m_guiSystem.Render(width, height, frameStats, m_frameHistory, m_activeScene);
+			m_renderer.Overlay([this]() { m_guiSystem.Draw(); });
+		}
 
 		if (Input::GetInstance().IsMousePressed(GLFW_MOUSE_BUTTON_1))
 		{
 			if (!Input::GetInstance().GetGuiHit())
 			{
+				PROFILE_SCOPE("Picking");
+				const auto phase{ m_frameHistory.TimePhase(FramePhase::Picking) };
 
+				const auto& [framebufferWidth, framebufferHeight] = m_window.GetFramebufferDims();
+				const auto ray{ PickingService::GetScreenRay(
+					glm::vec2(Input::GetInstance().GetMouseX(), Input::GetInstance().GetMouseY()),
+					m_camera.GetViewMatrix(),
+					m_camera.GetProjMatrix(framebufferWidth, framebufferHeight),
+					glm::vec2(framebufferWidth, framebufferHeight)) };
 
+				m_picking.Update(m_activeScene->m_sceneModels);
 
-				double mouseX, mouseY;
-				mouseX = Input::GetInstance().GetMouseX();
-				mouseY = Input::GetInstance().GetMouseY();
-
-				glm::vec3 rayOrigin, rayDirection;
-
-				rayOrigin = glm::unProject(glm::vec3(mouseX, m_window.GetFramebufferDims().second - mouseY, 0.0),
-					m_camera.GetViewMatrix(),
-					m_camera.GetProjMatrix(m_window.GetFramebufferDims().first, m_window.GetFramebufferDims().second),
-					glm::vec4(0, 0, m_window.GetFramebufferDims().first, m_window.GetFramebufferDims().second));
-				rayDirection = glm::normalize(glm::unProject(glm::vec3(mouseX, m_window.GetFramebufferDims().second - mouseY, 1.0),
-					m_camera.GetViewMatrix(),
-					m_camera.GetProjMatrix(m_window.GetFramebufferDims().first, m_window.GetFramebufferDims().second),
-					glm::vec4(0, 0, m_window.GetFramebufferDims().first, m_window.GetFramebufferDims().second)) - rayOrigin);
+				if (m_selectedModel)
+				{
+					m_selectedModel->SetSelected(false);
+					m_renderScene.SetSelected(findRenderModel(*m_selectedModel), false);
+					m_selectedModel.reset();
+				}
 
-				for (const auto& model : m_activeScene->m_sceneModels)
+				if (const auto hit{ m_picking.Pick(ray) })
 				{
-					model->SetSelected(false);
+					m_selectedModel = hit->Model;
+					m_selectedModel->SetSelected(true);
+					m_renderScene.SetSelected(findRenderModel(*m_selectedModel), true);
 
-					if (rayIntersectsBoundingBox(rayOrigin, rayDirection, model->GetBoundingBox()))
+					std::cout << "Clicked model with ID: " << m_selectedModel->GetModelName() << " at distance " << hit->Distance;
+					if (hit->Triangle != PickingService::NoTriangle)
 					{
-						model->SetSelected(true);
-						std::cout << "Clicked model with ID: " << model->GetModelName() << std::endl;
-						break;
+						std::cout << " (mesh " << hit->Mesh << ", triangle " << hit->Triangle << ')';
 					}
+					std::cout << std::endl;
 				}
 			}
 		}
 
-		m_window.SwapBuffers();
+		{
+			PROFILE_SCOPE("Present");
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Present) };
+			// The render thread presents once it replayed the frame
+			m_renderer.Submit();
+			if (!m_renderer.HasRenderThread())
+			{
+				m_window.SwapBuffers();
+			}
+		}
 
+		m_frameHistory.EndFrame();
 		++numFramesRendered;
 	}
 
+	m_simulation.Stop();
+	m_renderer.StopRenderThread();
+
+	m_renderer.FlushPassTimings();
+	m_renderer.SetPassTimingCallback(nullptr);
+
+	endBenchmark();
+
 	shutdown();
+
+	return 0;
+}
+
+/***********************************************************************************/
+bool Engine::executeHeadless()
+{
+	// A replay or flythrough decides the length of the run
+	const auto benchmarkFrames{ beginBenchmark() };
+	const auto numMeasuredFrames{ benchmarkFrames > 0 ? static_cast<unsigned int>(benchmarkFrames) : m_headless.Frames };
+
+	std::cout << "Rendering " << numMeasuredFrames << " frames headless (" << m_headless.WarmupFrames << " warm-up)...\n";
+
+	// Timings arrive a few frames late, the first WarmupFrames resolved frames are dropped. They still create
+	// the sample lists, sized for the whole run, so recording the measured frames does not allocate.
+	std::vector<PassSamples> passSamples;
+	passSamples.reserve(16);
+	std::vector<double> frameGPUTimes;
+	frameGPUTimes.reserve(numMeasuredFrames);
+	unsigned int numResolvedFrames{ 0 };
+	m_renderer.SetPassTimingCallback([&](const std::vector<PassTiming>& passes) {
+		m_frameHistory.AddGPUFrame(passes);
+		const auto warmup{ numResolvedFrames++ < m_headless.WarmupFrames };
+
+		auto frameGPUTime{ 0.0 };
+		for (const auto& pass : passes)
+		{
+			auto samples{ std::find_if(passSamples.begin(), passSamples.end(), [&](const auto& s) { return s.Name == pass.Name; }) };
+			if (samples == passSamples.end())
+			{
+				samples = passSamples.emplace(passSamples.end());
+				samples->Name = pass.Name;
+				samples->CPUMilliseconds.reserve(numMeasuredFrames);
+				samples->GPUMilliseconds.reserve(numMeasuredFrames);
+			}
+
+			if (!warmup)
+			{
+				samples->CPUMilliseconds.push_back(pass.CPUMilliseconds);
+				samples->GPUMilliseconds.push_back(pass.GPUMilliseconds);
+				frameGPUTime += pass.GPUMilliseconds;
+			}
+		}
+
+		if (!warmup)
+		{
+			frameGPUTimes.push_back(frameGPUTime);
+		}
+	});
+
+	std::vector<double> frameCPUTimes;
+	frameCPUTimes.reserve(numMeasuredFrames);
+
+	// Heap allocations of the measured frames, on any thread
+	std::uint64_t numAllocations{ 0 }, maxFrameAllocations{ 0 };
+	unsigned int numAllocatingFrames{ 0 };
+
+	// Meshlet culling of the measured frames' views
+	Graphics::MeshletCullCounts meshletCullTotals;
+
+	const auto numFrames{ m_headless.WarmupFrames + numMeasuredFrames };
+	auto runStart{ std::chrono::steady_clock::now() };
+	PROFILE_THREAD_NAME("Main");
+	for (unsigned int frame = 0; frame < numFrames; ++frame)
+	{
+		PROFILE_NEW_FRAME();
+		PROFILE_SCOPE("Frame");
+
+		if (frame == m_headless.WarmupFrames)
+		{
+			m_renderer.Finish();
+			runStart = std::chrono::steady_clock::now();
+			m_frameHistory.Clear();
+		}
+		const auto frameStart{ std::chrono::steady_clock::now() };
+		const auto frameStartAllocations{ AllocationCounter::GetNumAllocations() };
+		m_frameHistory.BeginFrame();
+		m_frameArena.Reset();
+
+		// Fixed time step so every run simulates exactly the same frames
+		auto dt{ 1.0 / 60.0 };
+
+		{
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Input) };
+			Input::GetInstance().Update();
+		}
+
+		// Warm-up frames keep the camera at the start of the benchmark
+		if (frame >= m_headless.WarmupFrames && !advanceBenchmark(dt))
+		{
+			break;
+		}
+
+		{
+			PROFILE_SCOPE("Camera");
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Camera) };
+			m_camera.Update(dt);
+		}
+
+		{
+			PROFILE_SCOPE("Scene::Update");
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::SceneUpdate) };
+			updateScene(dt);
+		}
+
+		{
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::RenderUpdate) };
+			m_renderer.Update(m_camera);
+		}
+
+		RenderList renderList{ ArenaAllocator<std::uint32_t>(m_frameArena) };
+		Graphics::MeshletDrawList meshletDraws{ m_frameArena };
+		const Graphics::MeshletDrawList* visibleMeshlets;
+		{
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Culling) };
+			visibleMeshlets = cullViewFrustum(renderList, meshletDraws);
+		}
+
+		{
+			const auto phase{ m_frameHistory.TimePhase(FramePhase::Render) };
+			m_renderer.Render(m_camera, m_renderScene, renderList.cbegin(), renderList.cend(), m_sceneState, false, visibleMeshlets);
+			m_renderer.Submit();
+		}
+
+		m_frameHistory.EndFrame();
+
+		if (frame >= m_headless.WarmupFrames)
+		{
+			frameCPUTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+
+			const auto frameAllocations{ AllocationCounter::GetNumAllocations() - frameStartAllocations };
+			numAllocations += frameAllocations;
+			maxFrameAllocations = std::max(maxFrameAllocations, frameAllocations);
+			numAllocatingFrames += frameAllocations > 0 ? 1 : 0;
+
+			if (visibleMeshlets != nullptr)
+			{
+				meshletCullTotals += m_meshletCullCounts;
+			}
+		}
+	}
+
+	// Wall time includes replaying the last frames and waiting for the GPU to drain
+	const auto renderThreaded{ m_renderer.HasRenderThread() };
+	m_renderer.StopRenderThread();
+	glFinish();
+	const auto runTime{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count() };
+
+	m_renderer.FlushPassTimings();
+	m_renderer.SetPassTimingCallback(nullptr);
+
+	endBenchmark();
+
+#ifdef GE_ENABLE_PROFILER
+	if (!m_headless.Trace.empty())
+	{
+		// Close the last frame so its GPU zones are read back
+		PROFILE_NEW_FRAME();
+		PROFILE_NEW_GPU_FRAME();
+		Profiler::GetInstance().ExportChromeTrace(m_headless.Trace);
+	}
+#endif
+
+	std::cout << "**************************************************\n";
+	std::cout << fmt::format("Headless run: {} frames in {:.1f} ms, {:.2f} ms/frame ({:.1f} FPS)\n",
+		numMeasuredFrames, runTime, runTime / std::max(numMeasuredFrames, 1u), 1000.0 * numMeasuredFrames / std::max(runTime, 1e-3));
+	if (renderThreaded)
+	{
+		// Over the whole run, warm-up included
+		const auto renderThread{ m_renderer.GetRenderThreadStats() };
+		const auto perFrame = [&renderThread](const double milliseconds) { return milliseconds / std::max<std::uint64_t>(renderThread.Frames, 1); };
+		std::cout << fmt::format("Render thread: {} frames, replay {:.3f} ms/frame, waiting on fences {:.3f} ms/frame, main thread paced {:.3f} ms/frame\n",
+			renderThread.Frames, perFrame(renderThread.ReplayMilliseconds), perFrame(renderThread.FenceMilliseconds), perFrame(renderThread.PacingMilliseconds));
+	}
+	if (AllocationCounter::IsEnabled())
+	{
+		std::cout << fmt::format("Heap allocations: {} in {} frames, {} frames allocated, at most {} in one\n",
+			numAllocations, numMeasuredFrames, numAllocatingFrames, maxFrameAllocations);
+	}
+	if (m_meshletCulling && numMeasuredFrames > 0)
+	{
+		const auto perView = [numMeasuredFrames](const std::size_t total) { return static_cast<double>(total) / numMeasuredFrames; };
+		std::cout << fmt::format("Meshlet culling per view: {:.0f} triangles -> {:.0f} ({:.1f}%), {:.0f} meshlets, {:.0f} outside, {:.0f} back facing\n",
+			perView(meshletCullTotals.TrianglesBefore), perView(meshletCullTotals.TrianglesAfter),
+			100.0 * meshletCullTotals.TrianglesAfter / std::max<std::size_t>(meshletCullTotals.TrianglesBefore, 1),
+			perView(meshletCullTotals.Meshlets), perView(meshletCullTotals.FrustumCulled), perView(meshletCullTotals.ConeCulled));
+	}
+
+	passSamples.push_back({ "Frame", std::move(frameCPUTimes), std::move(frameGPUTimes) });
+
+	std::cout << fmt::format("{:<16}{:>10}{:>10}{:>10}{:>10}{:>10}{:>10}\n", "Pass [ms]", "CPU avg", "CPU min", "CPU max", "GPU avg", "GPU min", "GPU max");
+	for (const auto& pass : passSamples)
+	{
+		const auto cpu{ computeSampleStats(pass.CPUMilliseconds) };
+		const auto gpu{ computeSampleStats(pass.GPUMilliseconds) };
+		std::cout << fmt::format("{:<16}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}\n", pass.Name, cpu.Mean, cpu.Min, cpu.Max, gpu.Mean, gpu.Min, gpu.Max);
+	}
+
+	if (!m_headless.Report.empty())
+	{
+		if (writePassReport(m_headless.Report, passSamples))
+		{
+			std::cout << "Pass timings written to " << m_headless.Report.string() << '\n';
+		}
+	}
+
+	if (!m_headless.Screenshot.empty())
+	{
+		const auto [width, height] { getFramebufferDims() };
+		const auto pixels{ m_renderer.ReadFramebuffer() };
+
+		std::error_code ec;
+		if (m_headless.Screenshot.has_parent_path())
+		{
+			std::filesystem::create_directories(m_headless.Screenshot.parent_path(), ec);
+		}
+
+		if (stbi_write_png(m_headless.Screenshot.string().c_str(), width, height, 4, pixels.data(), width * 4))
+		{
+			std::cout << "Final frame written to " << m_headless.Screenshot.string() << '\n';
+		} else
+		{
+			std::cerr << "Engine Error: Failed to write " << m_headless.Screenshot.string() << std::endl;
+		}
+	}
+
+	if (!m_headless.CheckAllocations)
+	{
+		return true;
+	}
+	if (!AllocationCounter::IsEnabled())
+	{
+		std::cerr << "Engine Error: checkAllocations needs a build with GE_COUNT_ALLOCATIONS defined." << std::endl;
+		return false;
+	}
+	if (numAllocations > 0)
+	{
+		std::cerr << fmt::format("Engine Error: Steady state frames allocated {} times (at most {} in one frame), expected none.", numAllocations, maxFrameAllocations) << std::endl;
+		return false;
+	}
+
+	std::cout << "Allocation check passed, no heap allocations after warm-up\n";
+	return true;
+}
+
+/***********************************************************************************/
+std::size_t Engine::beginBenchmark()
+{
+	m_benchmarkFrame = 0;
+	m_benchmarkTime = 0.0;
+
+	std::size_t numFrames{ 0 };
+	switch (m_benchmark.Mode)
+	{
+	case BenchmarkSettings::Type::Record:
+		m_inputRecording.Clear();
+		std::cout << "Recording input to " << m_benchmark.Input.string() << '\n';
+		break;
+
+	case BenchmarkSettings::Type::Replay:
+		if (!m_inputRecording.Load(m_benchmark.Input))
+		{
+			std::cerr << "Engine Error: Failed to load input recording, benchmark disabled." << std::endl;
+			m_benchmark.Mode = BenchmarkSettings::Type::None;
+			break;
+		}
+
+		numFrames = m_inputRecording.GetNumFrames();
+		std::cout << fmt::format("Replaying {} frames ({:.1f} s) from {}\n", numFrames, m_inputRecording.GetDuration(), m_benchmark.Input.string());
+		break;
+
+	case BenchmarkSettings::Type::Flythrough:
+	{
+		if (!m_cameraPath.Load(m_benchmark.CameraPath))
+		{
+			std::cerr << "Engine Error: Failed to load camera path, benchmark disabled." << std::endl;
+			m_benchmark.Mode = BenchmarkSettings::Type::None;
+			break;
+		}
+
+		if (m_benchmark.Timestep <= 0.0)
+		{
+			m_benchmark.Timestep = 1.0 / 60.0;
+		}
+
+		numFrames = static_cast<std::size_t>(m_cameraPath.GetDuration() / m_benchmark.Timestep) + 1;
+		std::cout << fmt::format("Flythrough '{}': {:.1f} s, {} frames\n", m_cameraPath.GetName(), m_cameraPath.GetDuration(), numFrames);
+
+		const auto pose{ m_cameraPath.Evaluate(0.0) };
+		m_camera.SetLookAt(pose.Position, pose.Target);
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	// Keep every frame of the run for the report
+	if (numFrames > m_frameHistory.GetSettings().Capacity)
+	{
+		auto settings{ m_frameHistory.GetSettings() };
+		settings.Capacity = numFrames;
+		m_frameHistory.SetSettings(settings);
+	}
+
+	return numFrames;
+}
+
+/***********************************************************************************/
+bool Engine::advanceBenchmark(double& dt)
+{
+	switch (m_benchmark.Mode)
+	{
+	case BenchmarkSettings::Type::Record:
+		m_inputRecording.AddFrame(dt, Input::GetInstance().GetState());
+		break;
+
+	case BenchmarkSettings::Type::Replay:
+	{
+		if (m_benchmarkFrame == m_inputRecording.GetNumFrames())
+		{
+			return false;
+		}
+
+		const auto& frame{ m_inputRecording.GetFrame(m_benchmarkFrame) };
+		Input::GetInstance().SetState(frame.State);
+		dt = m_benchmark.Timestep > 0.0 ? m_benchmark.Timestep : frame.DeltaTime;
+		break;
+	}
+
+	case BenchmarkSettings::Type::Flythrough:
+	{
+		dt = m_benchmark.Timestep;
+		if (m_benchmarkTime > m_cameraPath.GetDuration() + 0.5 * dt)
+		{
+			return false;
+		}
+
+		// Live input must not move the camera off the path
+		Input::GetInstance().SetState({});
+
+		const auto pose{ m_cameraPath.Evaluate(m_benchmarkTime) };
+		m_camera.SetLookAt(pose.Position, pose.Target);
+		break;
+	}
+
+	default:
+		return true;
+	}
+
+	++m_benchmarkFrame;
+	m_benchmarkTime += dt;
+
+	return true;
+}
+
+/***********************************************************************************/
+void Engine::endBenchmark()
+{
+	switch (m_benchmark.Mode)
+	{
+	case BenchmarkSettings::Type::Record:
+		if (m_inputRecording.Save(m_benchmark.Input))
+		{
+			std::cout << fmt::format("Recorded {} frames ({:.1f} s) to {}\n", m_inputRecording.GetNumFrames(), m_inputRecording.GetDuration(), m_benchmark.Input.string());
+		}
+		break;
+
+	case BenchmarkSettings::Type::Replay:
+	case BenchmarkSettings::Type::Flythrough:
+	{
+		const auto name{ m_benchmark.Mode == BenchmarkSettings::Type::Replay ? m_benchmark.Input.stem().string() : m_cameraPath.GetName() };
+		const auto cpu{ m_frameHistory.GetCPUPercentiles() };
+		const auto gpu{ m_frameHistory.GetGPUPercentiles() };
+
+		std::cout << "**************************************************\n";
+		std::cout << fmt::format("Benchmark '{}': {} frames, {:.2f} s simulated\n", name, m_benchmarkFrame, m_benchmarkTime);
+		std::cout << fmt::format("{:<16}{:>10}{:>10}{:>10}{:>10}\n", "Frame [ms]", "p50", "p95", "p99", "max");
+		std::cout << fmt::format("{:<16}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}\n", "CPU", cpu.P50, cpu.P95, cpu.P99, cpu.Max);
+		std::cout << fmt::format("{:<16}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}\n", "GPU", gpu.P50, gpu.P95, gpu.P99, gpu.Max);
+		std::cout << fmt::format("Spikes: {}\n", m_frameHistory.GetTotalSpikes());
+
+		if (!m_benchmark.Report.empty())
+		{
+			m_frameHistory.Export(m_benchmark.Report);
+		}
+		break;
+	}
+
+	default:
+		break;
+	}
+}
+
+/***********************************************************************************/
+std::pair<int, int> Engine::getFramebufferDims() const
+{
+	if (m_headless.Enabled)
+	{
+		return { static_cast<int>(m_renderer.GetWidth()), static_cast<int>(m_renderer.GetHeight()) };
+	}
+
+	return m_window.GetFramebufferDims();
 }
 
 /***********************************************************************************/
-void Engine::shutdown() const
+void Engine::shutdown()
 {
-	m_guiSystem.Shutdown();
+	if (m_frameHistory.GetNumFrames() > 0)
+	{
+		const auto cpu{ m_frameHistory.GetCPUPercentiles() };
+		const auto gpu{ m_frameHistory.GetGPUPercentiles() };
+		std::cout << "**************************************************\n";
+		std::cout << fmt::format("Frame time over the last {} frames [ms]: CPU p50 {:.2f} p95 {:.2f} p99 {:.2f} max {:.2f}, GPU p50 {:.2f} p95 {:.2f} p99 {:.2f} max {:.2f}, {} spikes\n",
+			m_frameHistory.GetNumFrames(), cpu.P50, cpu.P95, cpu.P99, cpu.Max, gpu.P50, gpu.P95, gpu.P99, gpu.Max, m_frameHistory.GetTotalSpikes());
+
+		if (!m_frameHistoryExport.empty())
+		{
+			m_frameHistory.Export(m_frameHistoryExport);
+		}
+	}
+
+	// Before the renderer and resource manager free everything
+	const auto gpuMemory{ Graphics::GPUMemoryTracker::GetInstance().GetTotals() };
+	std::cout << fmt::format("GPU memory: {:.1f} MB in {} objects", gpuMemory.Bytes / (1024.0 * 1024.0), gpuMemory.Count);
+	for (std::size_t i = 0; i < static_cast<std::size_t>(Graphics::GPUMemoryCategory::Count); ++i)
+	{
+		const auto category{ static_cast<Graphics::GPUMemoryCategory>(i) };
+		std::cout << fmt::format(", {} {:.1f} MB", Graphics::GetGPUMemoryCategoryName(category),
+			Graphics::GPUMemoryTracker::GetInstance().GetTotals(category).Bytes / (1024.0 * 1024.0));
+	}
+	std::cout << '\n';
+	if (m_gpuMemoryReportOnExit && !m_gpuMemoryReport.empty())
+	{
+		Graphics::GPUMemoryTracker::GetInstance().ExportReport(m_gpuMemoryReport);
+	}
+
+	if (!m_headless.Enabled)
+	{
+		m_guiSystem.Shutdown();
+	}
 	m_renderer.Shutdown();
 	ResourceManager::GetInstance().ReleaseAllResources();
-	m_window.Shutdown();
+	if (m_headless.Enabled)
+	{
+		m_headlessContext.Shutdown();
+	} else
+	{
+		m_window.Shutdown();
+	}
 }
 
 /***********************************************************************************/
-std::vector<ModelPtr> Engine::cullViewFrustum() const
+void Engine::updateScene(const double dt)
 {
-	std::vector<ModelPtr> renderList;
-	renderList.clear();
-	const auto& dims{ m_window.GetFramebufferDims() };
+	if (m_simulation.IsRunning())
+	{
+		m_simulation.Interpolate(m_sceneState);
+	} else
+	{
+		m_activeScene->Simulate(dt);
+		m_activeScene->CaptureSnapshot(m_sceneState);
+	}
+
+	// Culling, picking and drawing read the models, which only the main thread writes
+	const auto& models{ m_activeScene->m_sceneModels };
+	for (std::size_t i = 0; i < models.size() && i < m_sceneState.ModelPositions.size(); ++i)
+	{
+		if (models[i]->GetPosition() != m_sceneState.ModelPositions[i])
+		{
+			models[i]->SetPosition(m_sceneState.ModelPositions[i]);
+			if (i < m_renderModels.size())
+			{
+				m_renderScene.UpdateModel(m_renderModels[i], *models[i]);
+			}
+		}
+	}
+}
+
+/***********************************************************************************/
+const Graphics::MeshletDrawList* Engine::cullViewFrustum(RenderList& renderList, Graphics::MeshletDrawList& meshletDraws)
+{
+	PROFILE_SCOPE("Culling");
+	const auto& dims{ getFramebufferDims() };
 	const ViewFrustum viewFrustum(m_camera.GetViewMatrix(), m_camera.GetProjMatrix((float)dims.first, (float)dims.second));
 
-	for (auto& model : m_activeScene->m_sceneModels)
-	{
-		const auto result = viewFrustum.TestIntersection(model->GetBoundingBox());
-
-		if (result == BoundingVolume::TestResult::INSIDE || result == BoundingVolume::TestResult::INTERSECT)
-			renderList.push_back(model);
-	}
-	//std::for_each(std::execution::par_unseq, m_activeScene->m_sceneModels.cbegin(), m_activeScene->m_sceneModels.cend(),
-	//	[&](const auto& model) {
-	//		
-	//		const auto result{ viewFrustum.TestIntersection(model->GetBoundingBox()) };
-	//		//std::cout << "Test intersection \n";
-	//		if (result == BoundingVolume::TestResult::INSIDE || result == BoundingVolume::TestResult::INTERSECT)
-	//		{ 
-	//			try
-	//			{
-	//				//std::cout << "Item is intersecting \n";
-	//				renderList.clear();
-	//				renderList.push_back(model);
-	//			} catch (const std::exception& e)
-	//			{
-	//				//std::cout << "Fail intersect \n";
-	//				std::cout << "Exception: " << e.what() << "\n";
-	//			}
-	//			
-	//		}
-	//	});
-
-	return renderList;
+	renderList.clear();
+	m_renderScene.Cull(viewFrustum, renderList);
+
+	if (!m_meshletCulling)
+	{
+		return nullptr;
+	}
+
+	PROFILE_SCOPE("MeshletCulling");
+	m_meshletCullCounts = m_renderScene.CullMeshlets(viewFrustum, m_camera.GetPosition(), renderList, meshletDraws, m_meshletCullSettings);
+	return &meshletDraws;
+}
+
+/***********************************************************************************/
+Graphics::ModelHandle Engine::findRenderModel(const Model& model) const
+{
+	const auto& models{ m_activeScene->m_sceneModels };
+	const auto it{ std::find_if(models.cbegin(), models.cend(), [&model](const ModelPtr& sceneModel) { return sceneModel.get() == &model; }) };
+
+	const auto index{ static_cast<std::size_t>(std::distance(models.cbegin(), it)) };
+	return index < m_renderModels.size() ? m_renderModels[index] : Graphics::ModelHandle{};
 }
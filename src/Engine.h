@@ -1,13 +1,66 @@
 #pragma once
 #include "Camera.h"
+#include "CameraPath.h"
+#include "InputRecording.h"
+#include "Picking.h"
 
-#include "Core/WindowSystem.h"
-#include "Core/RenderSystem.h"
-#include "Core/GUISystem.h"
+#include "core/WindowSystem.h"
+#include "core/RenderSystem.h"
+#include "core/GUISystem.h"
+#include "core/HeadlessContext.h"
+#include "core/FrameHistory.h"
+#include "core/SimulationThread.h"
 
 #include <unordered_map>
 #include <filesystem>
 
+// <Headless> node of the engine config. Renders a fixed number of frames offscreen without a window
+// or GUI, then reports per-pass timings and optionally saves the last frame.
+struct HeadlessSettings {
+	bool Enabled{ false };
+	unsigned int Frames{ 300 };
+	// Frames rendered before timings are recorded (shader warm-up, texture uploads)
+	unsigned int WarmupFrames{ 10 };
+	// PNG of the final frame, skipped if empty
+	std::filesystem::path Screenshot;
+	// CSV with per-pass CPU/GPU statistics, skipped if empty
+	std::filesystem::path Report;
+	// Chrome trace of the run (profiler builds only), skipped if empty
+	std::filesystem::path Trace;
+	// Fail the run if a frame after warm-up allocates from the heap (builds with GE_COUNT_ALLOCATIONS only)
+	bool CheckAllocations{ false };
+};
+
+// <Benchmark> node of the engine config. Records the input of a session, or drives the camera from a
+// recording or camera path instead of live input, so two builds can be compared on the same frames.
+struct BenchmarkSettings {
+	enum class Type {
+		None,
+		// Save per-frame input and frame time to Input on exit
+		Record,
+		// Play back Input, then exit
+		Replay,
+		// Follow CameraPath once, then exit
+		Flythrough
+	};
+
+	Type Mode{ Type::None };
+	std::filesystem::path Input;
+	std::filesystem::path CameraPath;
+	// Simulation time step in seconds. 0 replays the recorded frame times; flythroughs default to 1/60.
+	double Timestep{ 0.0 };
+	// Frame history of the run (<path>.csv/.json), skipped if empty
+	std::filesystem::path Report;
+};
+
+// <Simulation> node of the engine config. With threaded set the scene is stepped tickRate times a second on
+// its own thread and the renderer interpolates between the published states. Headless runs and benchmark
+// replays or flythroughs step it once per frame on the main thread instead, so they stay deterministic.
+struct SimulationSettings {
+	bool Threaded{ true };
+	double TickRate{ 60.0 };
+};
+
 class Engine {
 public:
 	// Initializes engine from an XML config file
@@ -16,15 +69,37 @@ public:
 	void AddScene(const std::shared_ptr<SceneBase>& scene);
 	void SetActiveScene(const std::string_view sceneName);
 
-	// Load scene and run update loop
-	void Execute();
+	// Load scene and run update loop. Returns the exit code, non-zero if a headless run failed its checks.
+	int Execute();
 
 private:
-	void shutdown() const;
+	void shutdown();
+
+	// Main loop of headless mode. False if the run failed the allocation check.
+	bool executeHeadless();
+
+	// Loads the recording or camera path of the benchmark mode and moves the camera to its start.
+	// Returns the number of frames the benchmark runs for, 0 if it is not limited.
+	std::size_t beginBenchmark();
+	// Applies the benchmark to the frame about to be simulated: records or replays input and sets
+	// the camera pose. dt is replaced by the benchmark time step. False once the benchmark is over.
+	bool advanceBenchmark(double& dt);
+	// Saves the recording, or reports the frame statistics of a replay or flythrough.
+	void endBenchmark();
+
+	// Brings m_sceneState to the current frame, from the simulation thread or by stepping the scene by dt,
+	// and moves the models (and their copies in m_renderScene) to the positions in it.
+	void updateScene(const double dt);
+
+	// Framebuffer size of the window, or the render resolution when headless.
+	std::pair<int, int> getFramebufferDims() const;
 
 	// Performs view-frustum culling.
-	// Returns meshes visible by the camera.
-	std::vector<ModelPtr> cullViewFrustum() const;
+	// Fills renderList, a list in the frame arena, with the meshes of m_renderScene visible by the camera. With
+	// meshlet culling on, meshletDraws gets the parts of them to draw and is returned, else nullptr.
+	const Graphics::MeshletDrawList* cullViewFrustum(RenderList& renderList, Graphics::MeshletDrawList& meshletDraws);
+	// Handle of model's copy in m_renderScene, invalid if model is not part of the active scene.
+	Graphics::ModelHandle findRenderModel(const Model& model) const;
 
 	Camera m_camera;
 
@@ -33,6 +108,43 @@ private:
 	RenderSystem m_renderer;
 	GUISystem m_guiSystem;
 
+	HeadlessSettings m_headless;
+	HeadlessContext m_headlessContext;
+
+	BenchmarkSettings m_benchmark;
+	InputRecording m_inputRecording;
+	CameraPath m_cameraPath;
+	// Frames and seconds of the benchmark simulated so far
+	std::size_t m_benchmarkFrame{ 0 };
+	double m_benchmarkTime{ 0.0 };
+
+	SimulationSettings m_simulationSettings;
+	SimulationThread m_simulation;
+	// State of the active scene the current frame shows
+	SceneSnapshot m_sceneState;
+
+	// Per-frame bump allocator for lists that live until the end of the frame, reset when a frame begins.
+	// Its memory is kept, so steady state frames do not touch the heap.
+	LinearArena m_frameArena;
+
+	// Draw data of the active scene's models. m_renderModels[i] is the handle of m_activeScene->m_sceneModels[i].
+	Graphics::RenderScene m_renderScene;
+	std::vector<Graphics::ModelHandle> m_renderModels;
+	// Culling of the meshlets of the visible meshes, and its counts for the last frame
+	bool m_meshletCulling{ false };
+	Graphics::MeshletCullSettings m_meshletCullSettings;
+	Graphics::MeshletCullCounts m_meshletCullCounts;
+
+	PickingService m_picking;
+	ModelPtr m_selectedModel;
+
+	FrameHistory m_frameHistory;
+	// Base path of the CSV/JSON written on exit, skipped if empty
+	std::filesystem::path m_frameHistoryExport;
+	// Base path of the GPU memory report, exported from the GUI and, with m_gpuMemoryReportOnExit, on exit
+	std::filesystem::path m_gpuMemoryReport;
+	bool m_gpuMemoryReportOnExit{ false };
+
 	// All loaded scenes stored in memory
 	std::unordered_map<std::string, std::shared_ptr<SceneBase>> m_scenes;
 	// Current scene being processed by renderer
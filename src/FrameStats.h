@@ -1,7 +1,28 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 struct FrameStats {
 	double frameTimeMilliseconds{ 0.0 };
+	// Driver reported (NVIDIA only, else 0) and the engine's own tracked allocations
 	int videoMemoryUsageKB{ 0 };
+	std::size_t trackedVideoMemoryKB{ 0 };
 	long ramUsageKB{ 0 };
+	// Render graph of the last frame
+	std::size_t renderPasses{ 0 }, culledRenderPasses{ 0 };
+	std::size_t transientTextureKB{ 0 }, aliasingSavedKB{ 0 };
+	// Dynamic resolution controller
+	bool dynamicResolution{ false };
+	float renderScale{ 1.0f }, scaleError{ 0.0f };
+	float scaleProportional{ 0.0f }, scaleIntegral{ 0.0f }, scaleDerivative{ 0.0f };
+	double gpuFrameMilliseconds{ 0.0 }, targetFrameMilliseconds{ 0.0 };
+	// Fixed-rate simulation thread, off when the scene is stepped once per frame
+	bool threadedSimulation{ false };
+	double simulationTickRate{ 0.0 }, simulationTickMilliseconds{ 0.0 };
+	std::uint64_t droppedSimulationTicks{ 0 };
+	// Meshlet culling of the camera view, triangles of the meshes left by per-model culling and of the kept meshlets
+	bool meshletCulling{ false };
+	std::size_t meshlets{ 0 }, frustumCulledMeshlets{ 0 }, coneCulledMeshlets{ 0 };
+	std::size_t trianglesBeforeMeshletCulling{ 0 }, trianglesAfterMeshletCulling{ 0 };
 };
\ No newline at end of file
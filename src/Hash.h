@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Fast non-cryptographic hashing for cache keys.
+namespace Hash
+{
+	// MurmurHash64A
+	inline std::uint64_t Hash64(const void* data, const std::size_t size, const std::uint64_t seed = 0) noexcept
+	{
+		constexpr std::uint64_t m{ 0xc6a4a7935bd1e995ull };
+		constexpr int r{ 47 };
+
+		const auto* bytes{ static_cast<const std::uint8_t*>(data) };
+		auto h{ seed ^ (size * m) };
+
+		const auto numBlocks{ size / 8 };
+		for (std::size_t i = 0; i < numBlocks; ++i)
+		{
+			std::uint64_t k;
+			std::memcpy(&k, bytes + i * 8, sizeof(k));
+
+			k *= m;
+			k ^= k >> r;
+			k *= m;
+
+			h ^= k;
+			h *= m;
+		}
+
+		const auto* tail{ bytes + numBlocks * 8 };
+		switch (size & 7)
+		{
+		case 7: h ^= static_cast<std::uint64_t>(tail[6]) << 48; [[fallthrough]];
+		case 6: h ^= static_cast<std::uint64_t>(tail[5]) << 40; [[fallthrough]];
+		case 5: h ^= static_cast<std::uint64_t>(tail[4]) << 32; [[fallthrough]];
+		case 4: h ^= static_cast<std::uint64_t>(tail[3]) << 24; [[fallthrough]];
+		case 3: h ^= static_cast<std::uint64_t>(tail[2]) << 16; [[fallthrough]];
+		case 2: h ^= static_cast<std::uint64_t>(tail[1]) << 8; [[fallthrough]];
+		case 1: h ^= static_cast<std::uint64_t>(tail[0]);
+			h *= m;
+		}
+
+		h ^= h >> r;
+		h *= m;
+		h ^= h >> r;
+
+		return h;
+	}
+
+	inline std::uint64_t Hash64(const std::string_view str, const std::uint64_t seed = 0) noexcept
+	{
+		return Hash64(str.data(), str.size(), seed);
+	}
+
+	// Order dependent combination of two hashes.
+	inline std::uint64_t Combine(const std::uint64_t a, const std::uint64_t b) noexcept
+	{
+		return a ^ (b + 0x9e3779b97f4a7c15ull + (a << 6) + (a >> 2));
+	}
+
+	// 16 lowercase hex digits, usable as a file name.
+	inline std::string ToHex(const std::uint64_t hash)
+	{
+		constexpr char digits[]{ "0123456789abcdef" };
+
+		std::string hex(16, '0');
+		for (int i = 0; i < 16; ++i)
+		{
+			hex[15 - i] = digits[(hash >> (i * 4)) & 0xF];
+		}
+		return hex;
+	}
+}
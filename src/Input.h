@@ -8,11 +8,24 @@
 #include <cassert>
 #endif
 
+// Complete input state of one frame, used to record and replay input.
+struct InputState {
+	std::array<bool, 1024> Keys{};
+	std::array<bool, 8> MouseButtons{};
+	bool MouseMoved{ false };
+	double MouseX{ 0.0 }, MouseY{ 0.0 };
+	double ScrollXOffset{ 0.0 }, ScrollYOffset{ 0.0 };
+	bool Resized{ false };
+	std::size_t Width{ 0 }, Height{ 0 };
+};
+
 class Input {
 	Input()
 	{
 		std::fill(m_keys.begin(), m_keys.end(), false);
 		std::fill(m_prevKeys.begin(), m_prevKeys.end(), false);
+		std::fill(m_mouseButtons.begin(), m_mouseButtons.end(), false);
+		std::fill(m_prevMouseButtons.begin(), m_prevMouseButtons.end(), false);
 	};
 	~Input() = default;
 
@@ -41,6 +54,27 @@ public:
 		std::copy(m_mouseButtons.cbegin(), m_mouseButtons.cend(), m_prevMouseButtons.begin());
 	}
 
+	// State of the current frame, after events have been polled
+	InputState GetState() const noexcept
+	{
+		return { m_keys, m_mouseButtons, m_mouseMoved, m_xPos, m_yPos, m_xOffset, m_yOffset, m_shouldResize, m_width, m_height };
+	}
+
+	// Replaces the state of the current frame. The previous frame is kept, so presses are still detected.
+	void SetState(const InputState& state) noexcept
+	{
+		m_keys = state.Keys;
+		m_mouseButtons = state.MouseButtons;
+		m_mouseMoved = state.MouseMoved;
+		m_xPos = state.MouseX;
+		m_yPos = state.MouseY;
+		m_xOffset = state.ScrollXOffset;
+		m_yOffset = state.ScrollYOffset;
+		m_shouldResize = state.Resized;
+		m_width = state.Width;
+		m_height = state.Height;
+	}
+
 	// Getters
 	// Keyboard
 
@@ -161,10 +195,10 @@ private:
 	std::array<bool, 8> m_prevMouseButtons;
 	bool m_mouseMoved = false;
 	bool m_mouseGuiHit = false;
-	double m_xPos, m_yPos;
-	double m_xOffset, m_yOffset;
+	double m_xPos{ 0.0 }, m_yPos{ 0.0 };
+	double m_xOffset{ 0.0 }, m_yOffset{ 0.0 };
 
 	// Resize
 	bool m_shouldResize = false;
-	std::size_t m_width, m_height;
+	std::size_t m_width{ 0 }, m_height{ 0 };
 };
\ No newline at end of file
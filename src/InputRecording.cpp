@@ -0,0 +1,162 @@
+#include "InputRecording.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	constexpr char FileMagic[8]{ 'G', 'E', 'I', 'N', 'P', 'U', 'T', '\0' };
+	constexpr std::uint32_t FileVersion{ 1 };
+
+	constexpr std::size_t NumKeyBytes{ std::tuple_size_v<decltype(InputState::Keys)> / 8 };
+
+	enum FrameFlags : std::uint8_t {
+		MouseMoved = 1 << 0,
+		Resized = 1 << 1
+	};
+
+	// On-disk layout of one frame
+	struct FrameRecord {
+		double DeltaTime;
+		double MouseX, MouseY;
+		double ScrollXOffset, ScrollYOffset;
+		std::uint32_t Width, Height;
+		std::uint8_t Keys[NumKeyBytes];
+		std::uint8_t MouseButtons;
+		std::uint8_t Flags;
+	};
+
+	/***********************************************************************************/
+	template<typename T>
+	void write(std::ofstream& out, const T& value)
+	{
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	/***********************************************************************************/
+	template<typename T>
+	bool read(std::ifstream& in, T& value)
+	{
+		return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+}
+
+/***********************************************************************************/
+double InputRecording::GetDuration() const noexcept
+{
+	auto duration{ 0.0 };
+	for (const auto& frame : m_frames)
+	{
+		duration += frame.DeltaTime;
+	}
+
+	return duration;
+}
+
+/***********************************************************************************/
+bool InputRecording::Save(const std::filesystem::path& path) const
+{
+	std::error_code ec;
+	if (path.has_parent_path())
+	{
+		std::filesystem::create_directories(path.parent_path(), ec);
+	}
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+	{
+		std::cerr << "InputRecording Error: Failed to write " << path.string() << std::endl;
+		return false;
+	}
+
+	out.write(FileMagic, sizeof(FileMagic));
+	write(out, FileVersion);
+	write(out, static_cast<std::uint64_t>(m_frames.size()));
+
+	for (const auto& frame : m_frames)
+	{
+		const auto& state{ frame.State };
+
+		FrameRecord record{};
+		record.DeltaTime = frame.DeltaTime;
+		record.MouseX = state.MouseX;
+		record.MouseY = state.MouseY;
+		record.ScrollXOffset = state.ScrollXOffset;
+		record.ScrollYOffset = state.ScrollYOffset;
+		record.Width = static_cast<std::uint32_t>(state.Width);
+		record.Height = static_cast<std::uint32_t>(state.Height);
+		for (std::size_t key = 0; key < state.Keys.size(); ++key)
+		{
+			record.Keys[key / 8] |= static_cast<std::uint8_t>(state.Keys[key] << (key % 8));
+		}
+		for (std::size_t button = 0; button < state.MouseButtons.size(); ++button)
+		{
+			record.MouseButtons |= static_cast<std::uint8_t>(state.MouseButtons[button] << button);
+		}
+		record.Flags = (state.MouseMoved ? MouseMoved : 0) | (state.Resized ? Resized : 0);
+
+		write(out, record);
+	}
+
+	return static_cast<bool>(out);
+}
+
+/***********************************************************************************/
+bool InputRecording::Load(const std::filesystem::path& path)
+{
+	m_frames.clear();
+
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+	{
+		std::cerr << "InputRecording Error: Failed to open " << path.string() << std::endl;
+		return false;
+	}
+
+	char magic[sizeof(FileMagic)];
+	std::uint32_t version{ 0 };
+	std::uint64_t numFrames{ 0 };
+	if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, FileMagic, sizeof(FileMagic)) != 0 ||
+		!read(in, version) || version != FileVersion || !read(in, numFrames))
+	{
+		std::cerr << "InputRecording Error: " << path.string() << " is not a version " << FileVersion << " input recording" << std::endl;
+		return false;
+	}
+
+	m_frames.reserve(static_cast<std::size_t>(numFrames));
+	for (std::uint64_t i = 0; i < numFrames; ++i)
+	{
+		FrameRecord record;
+		if (!read(in, record))
+		{
+			std::cerr << "InputRecording Error: " << path.string() << " is truncated after " << i << " frames" << std::endl;
+			break;
+		}
+
+		Frame frame;
+		frame.DeltaTime = record.DeltaTime;
+
+		auto& state{ frame.State };
+		state.MouseX = record.MouseX;
+		state.MouseY = record.MouseY;
+		state.ScrollXOffset = record.ScrollXOffset;
+		state.ScrollYOffset = record.ScrollYOffset;
+		state.Width = record.Width;
+		state.Height = record.Height;
+		for (std::size_t key = 0; key < state.Keys.size(); ++key)
+		{
+			state.Keys[key] = (record.Keys[key / 8] >> (key % 8)) & 1;
+		}
+		for (std::size_t button = 0; button < state.MouseButtons.size(); ++button)
+		{
+			state.MouseButtons[button] = (record.MouseButtons >> button) & 1;
+		}
+		state.MouseMoved = record.Flags & MouseMoved;
+		state.Resized = record.Flags & Resized;
+
+		m_frames.push_back(frame);
+	}
+
+	return !m_frames.empty();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Input.h"
+
+#include <filesystem>
+#include <vector>
+
+// Per-frame input state and frame time of a session. Replaying it feeds Input and the simulation the
+// exact same frames, so benchmark runs become reproducible.
+class InputRecording {
+public:
+	struct Frame {
+		double DeltaTime{ 0.0 };
+		InputState State;
+	};
+
+	void Clear() noexcept { m_frames.clear(); }
+	void AddFrame(const double deltaTime, const InputState& state) { m_frames.push_back({ deltaTime, state }); }
+
+	auto GetNumFrames() const noexcept { return m_frames.size(); }
+	const auto& GetFrame(const std::size_t i) const noexcept { return m_frames[i]; }
+	// Sum of all recorded frame times in seconds
+	double GetDuration() const noexcept;
+
+	// Binary file in native byte order, keys and mouse buttons packed into bits.
+	bool Save(const std::filesystem::path& path) const;
+	bool Load(const std::filesystem::path& path);
+
+private:
+	std::vector<Frame> m_frames;
+};
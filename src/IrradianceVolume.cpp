@@ -0,0 +1,424 @@
+#include "IrradianceVolume.h"
+
+#include "Hash.h"
+#include "core/ThreadPool.h"
+#include "graphics/GPUMemory.h"
+#include "graphics/GLShaderProgram.h"
+
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	// Bump when the bake or the file layout changes so stale cache entries get rebuilt.
+	constexpr std::uint64_t BAKER_VERSION{ 1 };
+
+	constexpr char FileMagic[8]{ 'G', 'E', 'P', 'R', 'O', 'B', 'E', '\0' };
+
+	struct FileHeader {
+		char Magic[8];
+		std::uint32_t Resolution[3];
+		float Min[3];
+		float Max[3];
+	};
+
+	// RGBA texels needed for the 27 floats of a probe
+	constexpr std::size_t NUM_SLABS{ (IrradianceVolume::NumCoefficients * 3 + 3) / 4 };
+
+	constexpr float PI{ 3.14159265359f };
+
+	/***********************************************************************************/
+	// Real L2 spherical harmonics basis, in the order the shaders evaluate it.
+	std::array<float, IrradianceVolume::NumCoefficients> evaluateBasis(const glm::vec3& d) noexcept
+	{
+		return { {
+			0.282095f,
+			0.488603f * d.y,
+			0.488603f * d.z,
+			0.488603f * d.x,
+			1.092548f * d.x * d.y,
+			1.092548f * d.y * d.z,
+			0.315392f * (3.0f * d.z * d.z - 1.0f),
+			1.092548f * d.x * d.z,
+			0.546274f * (d.x * d.x - d.y * d.y)
+		} };
+	}
+
+	/***********************************************************************************/
+	// Evenly spread directions on the unit sphere (spherical Fibonacci).
+	std::vector<glm::vec3> makeSphereDirections(const std::uint32_t count)
+	{
+		constexpr float goldenAngle{ 2.39996322973f };
+
+		std::vector<glm::vec3> directions(count);
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			const auto z{ 1.0f - (2.0f * i + 1.0f) / count };
+			const auto r{ std::sqrt(std::max(0.0f, 1.0f - z * z)) };
+			const auto phi{ goldenAngle * i };
+			directions[i] = { r * std::cos(phi), r * std::sin(phi), z };
+		}
+		return directions;
+	}
+
+	/***********************************************************************************/
+	// Equirectangular HDR environment, or a constant color if it could not be loaded.
+	class Sky {
+	public:
+		Sky(const std::filesystem::path& path, const IrradianceVolume::Settings& settings) :
+			m_color{ settings.SkyColor * settings.SkyIntensity },
+			m_intensity{ settings.SkyIntensity }
+		{
+			int width = 0, height = 0, nrComponents = 0;
+			auto* data{ path.empty() ? nullptr : stbi_loadf(path.string().c_str(), &width, &height, &nrComponents, 3) };
+			if (!data)
+			{
+				std::cerr << "Irradiance Volume: No HDR sky at " << path << ", using a constant sky color\n";
+				return;
+			}
+
+			m_width = width;
+			m_height = height;
+			m_pixels.assign(data, data + static_cast<std::size_t>(width) * height * 3);
+			stbi_image_free(data);
+		}
+
+		glm::vec3 Sample(const glm::vec3& direction) const noexcept
+		{
+			if (m_pixels.empty())
+			{
+				return m_color;
+			}
+
+			// Rows are stored top first because HDRIs are not flipped on load
+			const auto u{ std::atan2(direction.z, direction.x) / (2.0f * PI) + 0.5f };
+			const auto v{ 0.5f - std::asin(std::clamp(direction.y, -1.0f, 1.0f)) / PI };
+
+			const auto x{ std::min(static_cast<int>(u * m_width), m_width - 1) };
+			const auto y{ std::min(static_cast<int>(v * m_height), m_height - 1) };
+			const auto* pixel{ &m_pixels[(static_cast<std::size_t>(y) * m_width + x) * 3] };
+
+			return glm::vec3(pixel[0], pixel[1], pixel[2]) * m_intensity;
+		}
+
+	private:
+		std::vector<float> m_pixels;
+		int m_width{ 0 }, m_height{ 0 };
+		glm::vec3 m_color;
+		float m_intensity;
+	};
+
+	/***********************************************************************************/
+	// Geometric normal of a hit, facing against the ray. Bounding box hits have no triangle and face the ray.
+	glm::vec3 getHitNormal(const PickingService::Hit& hit, const glm::vec3& direction)
+	{
+		if (hit.Triangle == PickingService::NoTriangle)
+		{
+			return -direction;
+		}
+
+		const auto& meshes{ hit.Model->GetMeshes() };
+		const auto& triangle{ meshes[hit.Mesh].Triangles->GetTriangles()[hit.Triangle] };
+		const auto normalMatrix{ glm::transpose(glm::inverse(glm::mat3(hit.Model->GetModelMatrix()))) };
+
+		auto normal{ normalMatrix * glm::cross(triangle.Edge1, triangle.Edge2) };
+		const auto length{ glm::length(normal) };
+		if (!(length > 0.0f))
+		{
+			return -direction;
+		}
+
+		normal /= length;
+		return glm::dot(normal, direction) > 0.0f ? -normal : normal;
+	}
+
+	/***********************************************************************************/
+	std::filesystem::path buildCachePath(const std::vector<ModelPtr>& models, const std::vector<StaticDirectionalLight>& lights,
+		const std::filesystem::path& sky, const IrradianceVolume::Settings& settings)
+	{
+		const auto combineFloats = [](std::uint64_t hash, const float* values, const std::size_t count) {
+			return Hash::Combine(hash, Hash::Hash64(values, count * sizeof(float)));
+		};
+
+		auto hash{ BAKER_VERSION };
+		for (const auto& model : models)
+		{
+			hash = Hash::Combine(hash, Hash::Hash64(model->GetModelFullPath()));
+			hash = Hash::Combine(hash, Hash::Hash64(model->GetModelName()));
+
+			const auto position{ model->GetPosition() };
+			const auto scale{ model->GetScale() };
+			hash = combineFloats(hash, &position.x, 3);
+			hash = combineFloats(hash, &scale.x, 3);
+
+			for (const auto& mesh : model->GetMeshes())
+			{
+				hash = Hash::Combine(hash, mesh.GetTriangleCount());
+				hash = Hash::Combine(hash, mesh.Triangles != nullptr);
+			}
+		}
+
+		for (const auto& light : lights)
+		{
+			hash = combineFloats(hash, &light.Color.x, 3);
+			hash = combineFloats(hash, &light.Direction.x, 3);
+		}
+
+		hash = Hash::Combine(hash, Hash::Hash64(sky.generic_string()));
+		std::error_code error;
+		if (const auto modifiedTime{ std::filesystem::last_write_time(sky, error) }; !error)
+		{
+			hash = Hash::Combine(hash, static_cast<std::uint64_t>(modifiedTime.time_since_epoch().count()));
+		}
+
+		hash = Hash::Combine(hash, settings.Resolution.x);
+		hash = Hash::Combine(hash, settings.Resolution.y);
+		hash = Hash::Combine(hash, settings.Resolution.z);
+		hash = Hash::Combine(hash, settings.NumRays);
+		hash = combineFloats(hash, &settings.Albedo, 1);
+		hash = combineFloats(hash, &settings.SkyColor.x, 3);
+		hash = combineFloats(hash, &settings.SkyIntensity, 1);
+
+		return std::filesystem::current_path() / "Data/cache/irradiance" / (Hash::ToHex(hash) + ".probes");
+	}
+}
+
+/***********************************************************************************/
+bool IrradianceVolume::Build(const PickingService& tracer, const std::vector<ModelPtr>& models, const std::vector<StaticDirectionalLight>& lights,
+	const std::filesystem::path& sky, const Settings& settings)
+{
+	m_probes.clear();
+	if (models.empty())
+	{
+		return false;
+	}
+
+	const auto cachePath{ buildCachePath(models, lights, sky, settings) };
+	if (loadCache(cachePath))
+	{
+		return true;
+	}
+
+	const auto start{ std::chrono::steady_clock::now() };
+
+	AABB bounds{ models.front()->GetBoundingBox() };
+	for (const auto& model : models)
+	{
+		bounds.extend(model->GetBoundingBox().getMin());
+		bounds.extend(model->GetBoundingBox().getMax());
+	}
+
+	m_resolution = glm::max(settings.Resolution, glm::uvec3(2));
+	m_min = bounds.getMin();
+	m_max = bounds.getMax();
+	m_probes.resize(static_cast<std::size_t>(m_resolution.x) * m_resolution.y * m_resolution.z);
+
+	const Sky environment(sky, settings);
+	const auto directions{ makeSphereDirections(std::max(settings.NumRays, 1u)) };
+	const auto bias{ 1e-4f * glm::length(m_max - m_min) };
+	const auto weight{ 4.0f * PI / directions.size() };
+
+	// Incoming radiance along a ray leaving the probe
+	const auto traceRadiance = [&](const glm::vec3& origin, const glm::vec3& direction) {
+		const auto hit{ tracer.Pick(Ray(origin, direction)) };
+		if (!hit)
+		{
+			return environment.Sample(direction);
+		}
+
+		const auto normal{ getHitNormal(*hit, direction) };
+		const auto position{ hit->Position + normal * bias };
+
+		glm::vec3 radiance{ 0.0f };
+		for (const auto& light : lights)
+		{
+			// The forward renderer treats the light direction as a position, so does the bake
+			const auto toLight{ light.Direction - position };
+			const auto distance{ glm::length(toLight) };
+			const auto lightDirection{ toLight / distance };
+			const auto cosine{ glm::dot(normal, lightDirection) };
+			if (cosine <= 0.0f)
+			{
+				continue;
+			}
+
+			const auto occluder{ tracer.Pick(Ray(position, lightDirection)) };
+			if (!occluder || occluder->Distance >= distance)
+			{
+				radiance += settings.Albedo * cosine * light.Color;
+			}
+		}
+		return radiance;
+	};
+
+	ThreadPool::GetInstance().ParallelFor(m_probes.size(), 1, [&](const std::size_t begin, const std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+		{
+			const glm::uvec3 cell(i % m_resolution.x, (i / m_resolution.x) % m_resolution.y, i / (m_resolution.x * m_resolution.y));
+			const auto origin{ m_min + (m_max - m_min) * glm::vec3(cell) / glm::vec3(m_resolution - 1u) };
+
+			Probe radiance{};
+			for (const auto& direction : directions)
+			{
+				const auto sample{ traceRadiance(origin, direction) };
+				const auto basis{ evaluateBasis(direction) };
+				for (std::size_t c = 0; c < NumCoefficients; ++c)
+				{
+					radiance[c] += sample * basis[c];
+				}
+			}
+
+			// Convolve with the clamped cosine (pi, 2pi/3, pi/4 per band) and divide by pi
+			constexpr std::array<float, NumCoefficients> band{ 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+			for (std::size_t c = 0; c < NumCoefficients; ++c)
+			{
+				m_probes[i][c] = radiance[c] * weight * band[c];
+			}
+		}
+	});
+
+	std::cout << "Irradiance Volume: Baked " << m_resolution.x << 'x' << m_resolution.y << 'x' << m_resolution.z << " probes with "
+		<< directions.size() << " rays each in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+
+	saveCache(cachePath);
+	return true;
+}
+
+/***********************************************************************************/
+void IrradianceVolume::Upload()
+{
+	if (m_probes.empty())
+	{
+		return;
+	}
+
+	// Slab s holds floats 4s..4s+3 of every probe's coefficients (r, g, b of coefficient 0, then 1, ...)
+	const auto numProbes{ m_probes.size() };
+	std::vector<float> texels(numProbes * NUM_SLABS * 4, 0.0f);
+	for (std::size_t i = 0; i < numProbes; ++i)
+	{
+		for (std::size_t value = 0; value < NumCoefficients * 3; ++value)
+		{
+			const auto slab{ value / 4 };
+			texels[(slab * numProbes + i) * 4 + value % 4] = m_probes[i][value / 3][static_cast<int>(value % 3)];
+		}
+	}
+
+	if (m_texture == 0)
+	{
+		glGenTextures(1, &m_texture);
+	}
+
+	glBindTexture(GL_TEXTURE_3D, m_texture);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, (GLsizei)m_resolution.x, (GLsizei)m_resolution.y, (GLsizei)(m_resolution.z * NUM_SLABS), 0,
+		GL_RGBA, GL_FLOAT, texels.data());
+	Graphics::GPUMemoryTracker::GetInstance().Track(Graphics::GPUResourceType::Texture, m_texture,
+		Graphics::GetTextureBytes(GL_RGBA16F, (GLsizei)m_resolution.x, (GLsizei)m_resolution.y, (GLsizei)(m_resolution.z * NUM_SLABS)),
+		Graphics::GPUMemoryCategory::Lighting, "Irradiance volume");
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+/***********************************************************************************/
+void IrradianceVolume::Bind(GLShaderProgram& shader, const GLuint textureUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_3D, m_texture);
+
+	shader.SetUniformi("irradianceVolume", static_cast<int>(textureUnit));
+	shader.SetUniform("irradianceVolumeMin", m_min);
+	shader.SetUniform("irradianceVolumeMax", m_max);
+	shader.SetUniform("irradianceVolumeResolution", glm::vec3(m_resolution));
+}
+
+/***********************************************************************************/
+void IrradianceVolume::Delete()
+{
+	Graphics::GPUMemoryTracker::GetInstance().Untrack(Graphics::GPUResourceType::Texture, m_texture);
+	glDeleteTextures(1, &m_texture);
+	m_texture = 0;
+	m_probes.clear();
+}
+
+/***********************************************************************************/
+bool IrradianceVolume::loadCache(const std::filesystem::path& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+	{
+		return false;
+	}
+
+	FileHeader header{};
+	in.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!in || std::memcmp(header.Magic, FileMagic, sizeof(FileMagic)) != 0 ||
+		header.Resolution[0] < 2 || header.Resolution[1] < 2 || header.Resolution[2] < 2)
+	{
+		std::cerr << "Irradiance Volume: Ignoring invalid cache entry " << path << '\n';
+		return false;
+	}
+
+	m_resolution = { header.Resolution[0], header.Resolution[1], header.Resolution[2] };
+	m_min = { header.Min[0], header.Min[1], header.Min[2] };
+	m_max = { header.Max[0], header.Max[1], header.Max[2] };
+	m_probes.resize(static_cast<std::size_t>(m_resolution.x) * m_resolution.y * m_resolution.z);
+	in.read(reinterpret_cast<char*>(m_probes.data()), static_cast<std::streamsize>(m_probes.size() * sizeof(Probe)));
+
+	if (!in)
+	{
+		std::cerr << "Irradiance Volume: Ignoring truncated cache entry " << path << '\n';
+		m_probes.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************************************/
+void IrradianceVolume::saveCache(const std::filesystem::path& path) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	// Written next to the target and renamed, so a crash never leaves a truncated entry behind
+	auto tempPath{ path };
+	tempPath += ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary);
+		if (!out)
+		{
+			std::cerr << "Irradiance Volume: Failed to write " << path << '\n';
+			return;
+		}
+
+		FileHeader header{};
+		std::memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			header.Resolution[axis] = m_resolution[axis];
+			header.Min[axis] = m_min[axis];
+			header.Max[axis] = m_max[axis];
+		}
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(m_probes.data()), static_cast<std::streamsize>(m_probes.size() * sizeof(Probe)));
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+	}
+}
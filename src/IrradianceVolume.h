@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Picking.h"
+#include "graphics/StaticDirectionalLight.h"
+
+#include <glad/glad.h>
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+class GLShaderProgram;
+
+// Grid of irradiance probes spanning the scene bounds, baked on the CPU. Each probe traces rays in all directions
+// through the picking BVH: rays that escape see the HDR sky, rays that hit a surface see it lit once by the
+// directional lights. Shading interpolates the probes trilinearly in a 3D texture.
+class IrradianceVolume {
+public:
+	static constexpr std::size_t NumCoefficients{ 9 };
+	// L2 spherical harmonics of the irradiance around a probe, convolved with the clamped cosine and divided by
+	// pi, so diffuse light for a normal n is albedo * sum(Probe[i] * Y_i(n)).
+	using Probe = std::array<glm::vec3, NumCoefficients>;
+
+	struct Settings {
+		// Probes along each axis, at least 2
+		glm::uvec3 Resolution{ 8, 4, 8 };
+		std::uint32_t NumRays{ 256 };
+		// Reflectance of every surface for the single bounce of direct light
+		float Albedo{ 0.5f };
+		// Radiance of the sky when no HDR sky could be loaded
+		glm::vec3 SkyColor{ 0.3f };
+		float SkyIntensity{ 1.0f };
+	};
+
+	// Bakes the probes, or reads them from Data/cache/irradiance when the models, lights, sky and settings are
+	// unchanged. tracer must have been updated with models. false if there is nothing to place probes around.
+	bool Build(const PickingService& tracer, const std::vector<ModelPtr>& models, const std::vector<StaticDirectionalLight>& lights,
+		const std::filesystem::path& sky, const Settings& settings);
+
+	// Creates or refills the 3D texture from the probes.
+	void Upload();
+	// Binds the texture to textureUnit and sets the irradianceVolume* uniforms of shader.
+	void Bind(GLShaderProgram& shader, const GLuint textureUnit) const;
+	void Delete();
+
+	bool IsEmpty() const noexcept { return m_probes.empty(); }
+	const auto& GetProbes() const noexcept { return m_probes; }
+	auto GetResolution() const noexcept { return m_resolution; }
+	auto GetMin() const noexcept { return m_min; }
+	auto GetMax() const noexcept { return m_max; }
+
+private:
+	bool loadCache(const std::filesystem::path& path);
+	void saveCache(const std::filesystem::path& path) const;
+
+	// x fastest, then y, then z
+	std::vector<Probe> m_probes;
+	glm::uvec3 m_resolution{ 0 };
+	glm::vec3 m_min{ 0.0f }, m_max{ 0.0f };
+
+	// RGBA16F, the 27 coefficients of a probe spread over 7 slabs stacked along z
+	GLuint m_texture{ 0 };
+};
@@ -1,4 +1,15 @@
 #include "Mesh.h"
+#include "BVH.h"
+
+#include <algorithm>
+
+namespace
+{
+	// What meshes build on creation, set through Mesh::SetBuildTriangleBVH and Mesh::SetBuildMeshlets
+	bool buildTriangleBVH{ false };
+	bool buildMeshlets{ false };
+	Graphics::MeshletBuildOptions meshletBuildOptions;
+}
 
 /***********************************************************************************/
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices) : IndexCount(indices.size())
@@ -17,8 +28,16 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indic
 }
 
 /***********************************************************************************/
-void Mesh::setupMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+void Mesh::setupMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& sourceIndices)
 {
+	// Meshlets move their triangles next to each other, everything below uses the reordered indices
+	std::vector<GLuint> meshletIndices;
+	if (buildMeshlets)
+	{
+		meshletIndices = sourceIndices;
+		Meshlets = std::make_shared<const std::vector<Graphics::Meshlet>>(Graphics::BuildMeshlets(vertices, meshletIndices, meshletBuildOptions));
+	}
+	const auto& indices{ buildMeshlets ? meshletIndices : sourceIndices };
 
 	VAO.Init();
 	VAO.Bind();
@@ -38,4 +57,33 @@ void Mesh::setupMesh(const std::vector<Vertex>& vertices, const std::vector<GLui
 	VAO.EnableAttribute(2, 3, vertexSize, reinterpret_cast<void*>(offsetof(Vertex, Normal)));
 	// Tangent
 	VAO.EnableAttribute(3, 3, vertexSize, reinterpret_cast<void*>(offsetof(Vertex, Tangent)));
+
+	if (buildTriangleBVH)
+	{
+		std::vector<glm::vec3> positions(vertices.size());
+		std::transform(vertices.cbegin(), vertices.cend(), positions.begin(), [](const Vertex& vertex) { return vertex.Position; });
+
+		Triangles = std::make_shared<const TriangleBVH>(positions, indices);
+	}
+}
+
+/***********************************************************************************/
+void Mesh::SetBuildTriangleBVH(const bool enabled) noexcept
+{
+	buildTriangleBVH = enabled;
+}
+
+/***********************************************************************************/
+void Mesh::SetBuildMeshlets(const bool enabled, const Graphics::MeshletBuildOptions& options) noexcept
+{
+	buildMeshlets = enabled;
+	meshletBuildOptions = options;
+}
+
+/***********************************************************************************/
+void Mesh::SetAmbientOcclusion(const std::vector<float>& ambientOcclusion)
+{
+	VAO.Bind();
+	VAO.AttachBuffer(GLVertexArray::BufferType::ARRAY, ambientOcclusion.size() * sizeof(float), GLVertexArray::DrawMode::STATIC, ambientOcclusion.data());
+	VAO.EnableAttribute(AmbientOcclusionAttribute, 1, sizeof(float), nullptr);
 }
\ No newline at end of file
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "Vertex.h"
-#include "Graphics/GLVertexArray.h"
+#include "graphics/GLVertexArray.h"
 #include "PBRMaterial.h"
+#include "graphics/Meshlets.h"
 
+#include <memory>
 #include <vector>
 
+class TriangleBVH;
+
 // TODO: Add per-mesh AABB
 /***********************************************************************************/
 struct Mesh {
@@ -16,9 +20,24 @@ struct Mesh {
 
 	auto GetTriangleCount() const noexcept { return IndexCount / 3; }
 
+	// Meshes created while this is on keep a TriangleBVH of their model space triangles for exact picking.
+	static void SetBuildTriangleBVH(const bool enabled) noexcept;
+	// Meshes created while this is on split their triangles into meshlets for cluster culling, which reorders
+	// the index buffer.
+	static void SetBuildMeshlets(const bool enabled, const Graphics::MeshletBuildOptions& options = {}) noexcept;
+
+	// Baked ambient occlusion, one float per vertex. Meshes without it read the attribute's current value,
+	// which the renderer keeps at 1.
+	static constexpr GLuint AmbientOcclusionAttribute{ 4 };
+	void SetAmbientOcclusion(const std::vector<float>& ambientOcclusion);
+
 	const std::size_t IndexCount;
 	GLVertexArray VAO;
 	PBRMaterialPtr Material;
+	// Shared by copies of the mesh, nullptr unless SetBuildTriangleBVH was on
+	std::shared_ptr<const TriangleBVH> Triangles;
+	// Shared by copies of the mesh, nullptr unless SetBuildMeshlets was on
+	std::shared_ptr<const std::vector<Graphics::Meshlet>> Meshlets;
 
 private:
 	void setupMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
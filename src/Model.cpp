@@ -1,14 +1,41 @@
 #include "Model.h"
-#include "Core/RenderSystem.h"
+#include "core/RenderSystem.h"
+#include "graphics/GLTFLoader.h"
+#include "graphics/GPUMemory.h"
+#include "graphics/OBJLoader.h"
 
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
 #include <iostream>
 
-#include "ResourceManager.h"
+#include "resourceManager.h"
+
+/***********************************************************************************/
+bool bakeAmbientOcclusion{ false };
+AmbientOcclusion::Settings ambientOcclusionSettings;
+bool nativeGLTF{ true };
+bool nativeOBJ{ true };
+
+/***********************************************************************************/
+// What the ambient occlusion bake needs of a mesh
+void appendBakeInput(std::vector<AmbientOcclusion::MeshInput>& bakeInputs, const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+{
+	auto& input{ bakeInputs.emplace_back() };
+	input.Positions.reserve(vertices.size());
+	input.Normals.reserve(vertices.size());
+	for (const auto& vertex : vertices)
+	{
+		input.Positions.push_back(vertex.Position);
+		input.Normals.push_back(vertex.Normal);
+	}
+	input.Indices.assign(indices.cbegin(), indices.cend());
+}
 
 /***********************************************************************************/
 Model::Model(const std::string_view Path, const std::string_view Name, const bool flipWindingOrder, const bool loadMaterial) : m_name(Name), m_fullPath(Path)
@@ -23,6 +50,7 @@ Model::Model(const std::string_view Path, const std::string_view Name, const boo
 /***********************************************************************************/
 Model::Model(const std::string_view Name, const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, const PBRMaterialPtr& material) noexcept : m_name(Name)
 {
+	Graphics::GPUMemoryScope memoryScope(Graphics::GPUMemoryCategory::Model, m_name);
 	m_meshes.emplace_back(vertices, indices, material);
 }
 
@@ -52,6 +80,7 @@ void Model::Translate(const glm::vec3& pos)
 	//m_aabb.setMin(pos - m_size / 2.0f);
 	//m_aabb.setMax(pos + m_size / 2.0f);
 	m_aabb.translate(pos);
+	++s_transformGeneration;
 }
 
 /***********************************************************************************/
@@ -59,6 +88,7 @@ void Model::Scale(const glm::vec3& scale)
 {
 	m_scale = scale;
 	m_aabb.scale(scale, glm::vec3(0));
+	++s_transformGeneration;
 }
 
 /***********************************************************************************/
@@ -67,6 +97,7 @@ void Model::SetPosition(const glm::vec3& pos)
 	m_position = pos;
 	//m_aabb.translate(pos);
 	m_aabb.setPosition(pos);
+	++s_transformGeneration;
 }
 
 /***********************************************************************************/
@@ -80,29 +111,30 @@ glm::mat4 Model::GetModelMatrix() const
 }
 
 /***********************************************************************************/
-void Model::Delete()
+void Model::SetBakeAmbientOcclusion(const bool enabled, const AmbientOcclusion::Settings& settings)
 {
-	for (auto& mesh : m_meshes)
-	{
-		mesh.VAO.Delete();
-	}
+	bakeAmbientOcclusion = enabled;
+	ambientOcclusionSettings = settings;
 }
 
 /***********************************************************************************/
-bool Model::loadModel(const std::string_view Path, const bool flipWindingOrder, const bool loadMaterial = true)
+void Model::SetNativeGLTF(const bool enabled) noexcept
 {
-#ifdef _DEBUG
-	std::cout << "Loading model: " << m_name << '\n';
-#endif
+	nativeGLTF = enabled;
+}
 
-	std::cout << sizeof(PBRMaterial) << '\n';
-	
-	Assimp::Importer importer;
-	const aiScene* scene = nullptr;
+/***********************************************************************************/
+void Model::SetNativeOBJ(const bool enabled) noexcept
+{
+	nativeOBJ = enabled;
+}
 
+/***********************************************************************************/
+unsigned int Model::GetAssimpImportFlags(const bool flipWindingOrder) noexcept
+{
 	if (flipWindingOrder)
 	{
-		scene = importer.ReadFile(Path.data(), aiProcess_Triangulate |
+		return aiProcess_Triangulate |
 			aiProcess_JoinIdenticalVertices |
 			aiProcess_GenUVCoords |
 			aiProcess_GenNormals |
@@ -113,62 +145,115 @@ bool Model::loadModel(const std::string_view Path, const bool flipWindingOrder,
 			aiProcess_FlipWindingOrder | // Reverse back-face culling
 			aiProcess_CalcTangentSpace |
 			aiProcess_OptimizeMeshes |
-			aiProcess_SplitLargeMeshes);
-	} else
-	{
-		scene = importer.ReadFile(Path.data(), aiProcess_Triangulate |
-			aiProcess_JoinIdenticalVertices |
-			aiProcess_GenUVCoords |
-			aiProcess_SortByPType |
-			aiProcess_RemoveRedundantMaterials |
-			aiProcess_FindInvalidData |
-			aiProcess_FlipUVs |
-			aiProcess_CalcTangentSpace |
-			aiProcess_GenSmoothNormals |
-			aiProcess_ImproveCacheLocality |
-			aiProcess_OptimizeMeshes |
-			aiProcess_SplitLargeMeshes);
+			aiProcess_SplitLargeMeshes;
 	}
 
-	// Check if scene is not null and model is done loading
-	if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-	{
-		std::cerr << "Assimp Error for " << m_name << ": " << importer.GetErrorString() << '\n';
-		importer.FreeScene();
+	return aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_GenUVCoords |
+		aiProcess_SortByPType |
+		aiProcess_RemoveRedundantMaterials |
+		aiProcess_FindInvalidData |
+		aiProcess_FlipUVs |
+		aiProcess_CalcTangentSpace |
+		aiProcess_GenSmoothNormals |
+		aiProcess_ImproveCacheLocality |
+		aiProcess_OptimizeMeshes |
+		aiProcess_SplitLargeMeshes;
+}
 
-		return false;
+/***********************************************************************************/
+void Model::Delete()
+{
+	for (auto& mesh : m_meshes)
+	{
+		mesh.VAO.Delete();
 	}
+}
+
+/***********************************************************************************/
+bool Model::loadModel(const std::string_view Path, const bool flipWindingOrder, const bool loadMaterial = true)
+{
+#ifdef _DEBUG
+	std::cout << "Loading model: " << m_name << '\n';
+#endif
+
+	// Vertex buffers created below, including baked ambient occlusion, count towards this model
+	Graphics::GPUMemoryScope memoryScope(Graphics::GPUMemoryCategory::Model, m_name);
+
+	std::cout << sizeof(PBRMaterial) << '\n';
 
 	m_fullPath = Path;
 	m_folderPath = Path.substr(0, Path.find_last_of('/')); // Strip the model file name and keep the model folder.
 	m_folderPath += "/";
 
-	processNode(scene->mRootNode, scene, loadMaterial);
+	std::vector<AmbientOcclusion::MeshInput> bakeInputs;
+
+	auto extension{ std::filesystem::path(Path).extension().string() };
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	if (nativeGLTF && (extension == ".gltf" || extension == ".glb"))
+	{
+		if (!loadGLTF(Path, flipWindingOrder, loadMaterial, bakeAmbientOcclusion ? &bakeInputs : nullptr))
+		{
+			return false;
+		}
+	} else if (nativeOBJ && extension == ".obj")
+	{
+		if (!loadOBJ(Path, flipWindingOrder, loadMaterial, bakeAmbientOcclusion ? &bakeInputs : nullptr))
+		{
+			return false;
+		}
+	} else
+	{
+		Assimp::Importer importer;
+		const auto* scene{ importer.ReadFile(Path.data(), GetAssimpImportFlags(flipWindingOrder)) };
+
+		// Check if scene is not null and model is done loading
+		if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			std::cerr << "Assimp Error for " << m_name << ": " << importer.GetErrorString() << '\n';
+			importer.FreeScene();
+
+			return false;
+		}
+
+		processNode(scene->mRootNode, scene, loadMaterial, bakeAmbientOcclusion ? &bakeInputs : nullptr);
+
+		importer.FreeScene();
+	}
+
+	if (bakeAmbientOcclusion)
+	{
+		const auto ambientOcclusion{ AmbientOcclusion::LoadOrBake(bakeInputs, ambientOcclusionSettings) };
+		for (std::size_t i = 0; i < m_meshes.size(); ++i)
+		{
+			m_meshes[i].SetAmbientOcclusion(ambientOcclusion[i]);
+		}
+	}
 
-	importer.FreeScene();
 	return true;
 }
 
 /***********************************************************************************/
-void Model::processNode(aiNode* node, const aiScene* scene, const bool loadMaterial)
+void Model::processNode(aiNode* node, const aiScene* scene, const bool loadMaterial, std::vector<AmbientOcclusion::MeshInput>* bakeInputs)
 {
 
 	// Process all node meshes
 	for (unsigned int i = 0; i < node->mNumMeshes; ++i)
 	{
 		auto* mesh = scene->mMeshes[node->mMeshes[i]];
-		m_meshes.push_back(processMesh(mesh, scene, loadMaterial));
+		m_meshes.push_back(processMesh(mesh, scene, loadMaterial, bakeInputs));
 	}
 
 	// Process their children via recursive tree traversal
 	for (unsigned int i = 0; i < node->mNumChildren; ++i)
 	{
-		processNode(node->mChildren[i], scene, loadMaterial);
+		processNode(node->mChildren[i], scene, loadMaterial, bakeInputs);
 	}
 }
 
 /***********************************************************************************/
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene, const bool loadMaterial)
+Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene, const bool loadMaterial, std::vector<AmbientOcclusion::MeshInput>* bakeInputs)
 {
 	std::vector<Vertex> vertices;
 	glm::vec3 min { 0 }, max{ 0 };
@@ -241,6 +326,11 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene, const bool loadMater
 		}
 	}
 
+	if (bakeInputs)
+	{
+		appendBakeInput(*bakeInputs, vertices, indices);
+	}
+
 	// Process material
 	// http://assimp.sourceforge.net/lib_html/structai_material.html
 	if (loadMaterial)
@@ -300,3 +390,131 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene, const bool loadMater
 
 	return Mesh(vertices, indices);
 }
+
+/***********************************************************************************/
+bool Model::loadGLTF(const std::string_view Path, const bool flipWindingOrder, const bool loadMaterial, std::vector<AmbientOcclusion::MeshInput>* bakeInputs)
+{
+	Graphics::GLTFLoadOptions options;
+	options.FlipWindingOrder = flipWindingOrder;
+	options.LoadMaterials = loadMaterial;
+
+	const auto gltf{ Graphics::LoadGLTF(Path, options) };
+	if (!gltf)
+	{
+		return false;
+	}
+
+	auto& resourceManager{ ResourceManager::GetInstance() };
+	std::vector<PBRMaterialPtr> materials;
+	materials.reserve(gltf->Materials.size());
+	for (const auto& gltfMaterial : gltf->Materials)
+	{
+		// glTF material names are only unique within their file
+		const auto name{ m_name + "/" + gltfMaterial.Name };
+		if (const auto cachedMaterial{ resourceManager.GetMaterial(name) })
+		{
+			materials.push_back(*cachedMaterial);
+			continue;
+		}
+
+		PBRMaterial material;
+		material.Init(name, glm::vec3(gltfMaterial.BaseColor), glm::vec3(1.0f), glm::vec3(gltfMaterial.Metallic),
+			glm::vec3(0.5f, 0.5f, 1.0f), glm::vec3(gltfMaterial.Roughness), gltfMaterial.BaseColor.a);
+
+		// Roughness is in G and metallic in B of one image, which the single channel formats of those usages would
+		// drop. Loaded first so an occlusion map packed into the same image (in R) keeps them too.
+		const auto& textures{ gltfMaterial.Textures };
+		const auto metallicRoughness{ resourceManager.LoadTexture(textures[PBRMaterial::METALLIC], Graphics::TextureUsage::Generic) };
+		material.SetParameterTexture(PBRMaterial::METALLIC, metallicRoughness);
+		material.SetParameterTexture(PBRMaterial::ROUGHNESS, metallicRoughness);
+		material.SetParameterTexture(PBRMaterial::ALBEDO, resourceManager.LoadTexture(textures[PBRMaterial::ALBEDO], Graphics::TextureUsage::Albedo));
+		material.SetParameterTexture(PBRMaterial::AO, resourceManager.LoadTexture(textures[PBRMaterial::AO], Graphics::TextureUsage::AmbientOcclusion));
+		material.SetParameterTexture(PBRMaterial::NORMAL, resourceManager.LoadTexture(textures[PBRMaterial::NORMAL], Graphics::TextureUsage::Normal));
+
+		materials.push_back(resourceManager.CacheMaterial(name, material));
+		++m_numMats;
+	}
+
+	for (const auto& primitive : gltf->Primitives)
+	{
+		m_aabb.extend(primitive.Min);
+		m_aabb.extend(primitive.Max);
+
+		if (bakeInputs)
+		{
+			appendBakeInput(*bakeInputs, primitive.Vertices, primitive.Indices);
+		}
+
+		if (primitive.Material >= 0)
+		{
+			m_meshes.emplace_back(primitive.Vertices, primitive.Indices, materials[primitive.Material]);
+		} else
+		{
+			m_meshes.emplace_back(primitive.Vertices, primitive.Indices);
+		}
+	}
+
+	m_size = m_aabb.getMax() - m_aabb.getMin();
+
+	return true;
+}
+
+/***********************************************************************************/
+bool Model::loadOBJ(const std::string_view Path, const bool flipWindingOrder, const bool loadMaterial, std::vector<AmbientOcclusion::MeshInput>* bakeInputs)
+{
+	Graphics::OBJLoadOptions options;
+	options.FlipWindingOrder = flipWindingOrder;
+	options.LoadMaterials = loadMaterial;
+
+	const auto obj{ Graphics::LoadOBJ(Path, options) };
+	if (!obj)
+	{
+		return false;
+	}
+
+	// Cached under the same names and with the same textures as processMesh, so both paths share materials
+	auto& resourceManager{ ResourceManager::GetInstance() };
+	std::vector<PBRMaterialPtr> materials;
+	materials.reserve(obj->Materials.size());
+	for (const auto& objMaterial : obj->Materials)
+	{
+		if (const auto cachedMaterial{ resourceManager.GetMaterial(objMaterial.Name) })
+		{
+			materials.push_back(*cachedMaterial);
+			continue;
+		}
+
+		const auto albedoPath{ objMaterial.Diffuse.empty() ? std::string("data/textures/default.png") : objMaterial.Diffuse };
+		materials.push_back(resourceManager.CacheMaterial(objMaterial.Name,
+			m_folderPath + albedoPath,
+			"",
+			m_folderPath + objMaterial.Ambient,
+			m_folderPath + objMaterial.Bump,
+			m_folderPath + objMaterial.Shininess,
+			m_folderPath + objMaterial.Opacity));
+		++m_numMats;
+	}
+
+	for (const auto& mesh : obj->Meshes)
+	{
+		m_aabb.extend(mesh.Min);
+		m_aabb.extend(mesh.Max);
+
+		if (bakeInputs)
+		{
+			appendBakeInput(*bakeInputs, mesh.Vertices, mesh.Indices);
+		}
+
+		if (mesh.Material >= 0)
+		{
+			m_meshes.emplace_back(mesh.Vertices, mesh.Indices, materials[mesh.Material]);
+		} else
+		{
+			m_meshes.emplace_back(mesh.Vertices, mesh.Indices);
+		}
+	}
+
+	m_size = m_aabb.getMax() - m_aabb.getMin();
+
+	return true;
+}
@@ -4,7 +4,10 @@
 
 #include "Mesh.h"
 #include "AABB.h"
+#include "AmbientOcclusion.h"
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -32,24 +35,43 @@ public:
 	// Destroys all OpenGL handles for all submeshes. This should only be called by ResourceManager.
 	void Delete();
 
-	auto GetMeshes() const noexcept { return m_meshes; }
-	auto GetBoundingBox() const noexcept { return m_aabb; }
-	auto GetModelName() const noexcept { return m_name; }
-	auto GetModelFolderPath() const noexcept { return m_folderPath; }
-	auto GetModelFullPath() const noexcept { return m_fullPath; }
+	// References stay valid until the model is changed; the render loop reads them every frame without copying
+	const auto& GetMeshes() const noexcept { return m_meshes; }
+	const auto& GetBoundingBox() const noexcept { return m_aabb; }
+	const auto& GetModelName() const noexcept { return m_name; }
+	const auto& GetModelFolderPath() const noexcept { return m_folderPath; }
+	const auto& GetModelFullPath() const noexcept { return m_fullPath; }
 	auto GetPosition() const noexcept { return m_position; }
 	auto GetScale() const noexcept { return m_scale; }
 	void SetPosition(const glm::vec3& pos);
 	void SetSelected(bool selected) { m_selected = selected; }
-	bool GetSelected() { return m_selected; }
+	bool GetSelected() const noexcept { return m_selected; }
+
+	// Changes whenever any model is moved or scaled, so structures built over model bounds know to update.
+	static std::uint32_t GetTransformGeneration() noexcept { return s_transformGeneration.load(std::memory_order_relaxed); }
+
+	// Models loaded from file while this is on get per-vertex ambient occlusion baked over all their meshes
+	// (or read from Data/cache/ao). Meant for static geometry; the AO does not follow other models around.
+	static void SetBakeAmbientOcclusion(const bool enabled, const AmbientOcclusion::Settings& settings = {});
+	// .gltf and .glb files loaded while this is on (the default) go through Graphics::LoadGLTF instead of Assimp
+	static void SetNativeGLTF(const bool enabled) noexcept;
+	// .obj files loaded while this is on (the default) go through Graphics::LoadOBJ instead of Assimp
+	static void SetNativeOBJ(const bool enabled) noexcept;
+	// Post-processing steps models are imported from other formats with
+	static unsigned int GetAssimpImportFlags(const bool flipWindingOrder) noexcept;
 
 protected:
 	std::vector<Mesh> m_meshes;
 
 private:
+	inline static std::atomic<std::uint32_t> s_transformGeneration{ 0 };
+
 	bool loadModel(const std::string_view Path, const bool flipWindingOrder, const bool loadMaterial);
-	void processNode(aiNode* node, const aiScene* scene, const bool loadMaterial);
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene, const bool loadMaterial);
+	bool loadGLTF(const std::string_view Path, const bool flipWindingOrder, const bool loadMaterial, std::vector<AmbientOcclusion::MeshInput>* bakeInputs);
+	bool loadOBJ(const std::string_view Path, const bool flipWindingOrder, const bool loadMaterial, std::vector<AmbientOcclusion::MeshInput>* bakeInputs);
+	// bakeInputs collects the CPU side geometry of each processed mesh, if not null
+	void processNode(aiNode* node, const aiScene* scene, const bool loadMaterial, std::vector<AmbientOcclusion::MeshInput>* bakeInputs);
+	Mesh processMesh(aiMesh* mesh, const aiScene* scene, const bool loadMaterial, std::vector<AmbientOcclusion::MeshInput>* bakeInputs);
 
 	// Transformation data
 	glm::vec3 m_scale, m_position, m_axis;
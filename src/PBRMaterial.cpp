@@ -1,6 +1,6 @@
 #include "PBRMaterial.h"
 
-#include "ResourceManager.h"
+#include "resourceManager.h"
 
 /***********************************************************************************/
 PBRMaterial::PBRMaterial()
@@ -21,13 +21,13 @@ void PBRMaterial::Init(const std::string_view name,
 {
 	Name = name;
 
-	m_materialTextures[ALBEDO] = ResourceManager::GetInstance().LoadTexture(albedoPath);
-	m_materialTextures[AO] = ResourceManager::GetInstance().LoadTexture(aoPath);
-	m_materialTextures[METALLIC] = ResourceManager::GetInstance().LoadTexture(metallicPath);
-	m_materialTextures[NORMAL] = ResourceManager::GetInstance().LoadTexture(normalPath);
-	m_materialTextures[ROUGHNESS] = ResourceManager::GetInstance().LoadTexture(roughnessPath);
+	m_materialTextures[ALBEDO] = ResourceManager::GetInstance().LoadTexture(albedoPath, Graphics::TextureUsage::Albedo);
+	m_materialTextures[AO] = ResourceManager::GetInstance().LoadTexture(aoPath, Graphics::TextureUsage::AmbientOcclusion);
+	m_materialTextures[METALLIC] = ResourceManager::GetInstance().LoadTexture(metallicPath, Graphics::TextureUsage::Metallic);
+	m_materialTextures[NORMAL] = ResourceManager::GetInstance().LoadTexture(normalPath, Graphics::TextureUsage::Normal);
+	m_materialTextures[ROUGHNESS] = ResourceManager::GetInstance().LoadTexture(roughnessPath, Graphics::TextureUsage::Roughness);
 
-	//m_alpha = ResourceManager::GetInstance().LoadTexture(alphaMaskPath);
+	//m_alpha = ResourceManager::GetInstance().LoadTexture(alphaMaskPath, Graphics::TextureUsage::AlphaMask);
 }
 
 /***********************************************************************************/
@@ -60,4 +60,10 @@ unsigned int PBRMaterial::GetParameterTexture(const ParameterType parameter) con
 glm::vec3 PBRMaterial::GetParameterColor(const ParameterType parameter) const noexcept
 {
 	return m_materialColors[parameter];
+}
+
+/***********************************************************************************/
+void PBRMaterial::SetParameterTexture(const ParameterType parameter, const unsigned int texture) noexcept
+{
+	m_materialTextures[parameter] = texture;
 }
\ No newline at end of file
@@ -44,6 +44,8 @@ public:
 
 	unsigned int GetParameterTexture(const ParameterType parameter) const noexcept;
 	glm::vec3 GetParameterColor(const ParameterType parameter) const noexcept;
+	// For textures Init would load with the wrong usage, e.g. glTF's metallic-roughness image that holds both
+	void SetParameterTexture(const ParameterType parameter, const unsigned int texture) noexcept;
 
 	auto GetAlphaValue() const noexcept
 	{
@@ -0,0 +1,100 @@
+#include "Picking.h"
+
+#include <glm/ext/matrix_projection.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+/***********************************************************************************/
+Ray PickingService::GetScreenRay(const glm::vec2& pixel, const glm::mat4& view, const glm::mat4& projection, const glm::vec2& viewport)
+{
+	const glm::vec4 viewportRect(0.0f, 0.0f, viewport.x, viewport.y);
+	const auto nearPoint{ glm::unProject(glm::vec3(pixel.x, viewport.y - pixel.y, 0.0f), view, projection, viewportRect) };
+	const auto farPoint{ glm::unProject(glm::vec3(pixel.x, viewport.y - pixel.y, 1.0f), view, projection, viewportRect) };
+
+	return { nearPoint, glm::normalize(farPoint - nearPoint) };
+}
+
+/***********************************************************************************/
+void PickingService::Update(const std::vector<ModelPtr>& models)
+{
+	// Models are only ever appended to or removed from a scene
+	const auto changed{ models.size() != m_models.size() ||
+		(!models.empty() && (models.front() != m_models.front() || models.back() != m_models.back())) };
+
+	if (changed)
+	{
+		const auto start{ std::chrono::steady_clock::now() };
+
+		m_models = models;
+		updateBounds();
+		m_bvh.Build(m_bounds);
+		m_transformGeneration = Model::GetTransformGeneration();
+
+		std::cout << "Picking BVH built over " << m_models.size() << " models in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+		return;
+	}
+
+	if (m_transformGeneration != Model::GetTransformGeneration())
+	{
+		updateBounds();
+		m_bvh.Refit(m_bounds);
+		m_transformGeneration = Model::GetTransformGeneration();
+	}
+}
+
+/***********************************************************************************/
+std::optional<PickingService::Hit> PickingService::Pick(const Ray& ray) const
+{
+	std::optional<Hit> hit;
+	auto tMax{ std::numeric_limits<float>::max() };
+
+	m_bvh.Traverse(ray, tMax, [&](const std::uint32_t index, float& t) {
+		float tBox;
+		if (!IntersectRayAABB(ray, m_bounds[index].getMin(), m_bounds[index].getMax(), t, tBox))
+		{
+			return;
+		}
+
+		const auto& model{ m_models[index] };
+		const auto& meshes{ model->GetMeshes() };
+
+		if (std::none_of(meshes.cbegin(), meshes.cend(), [](const auto& mesh) { return mesh.Triangles != nullptr; }))
+		{
+			t = tBox;
+			hit = Hit{ model, tBox };
+			return;
+		}
+
+		// Meshes are in model space. The direction is transformed but not normalized, so distances stay the same.
+		const auto toModel{ glm::inverse(model->GetModelMatrix()) };
+		const Ray modelRay(glm::vec3(toModel * glm::vec4(ray.Origin, 1.0f)), glm::vec3(toModel * glm::vec4(ray.Direction, 0.0f)));
+
+		for (std::size_t i = 0; i < meshes.size(); ++i)
+		{
+			std::uint32_t triangle;
+			if (meshes[i].Triangles && meshes[i].Triangles->Intersect(modelRay, t, triangle))
+			{
+				hit = Hit{ model, t, glm::vec3(0.0f), i, triangle };
+			}
+		}
+	});
+
+	if (hit)
+	{
+		hit->Position = ray.Origin + ray.Direction * hit->Distance;
+	}
+
+	return hit;
+}
+
+/***********************************************************************************/
+void PickingService::updateBounds()
+{
+	m_bounds.resize(m_models.size());
+	std::transform(m_models.cbegin(), m_models.cend(), m_bounds.begin(), [](const auto& model) { return model->GetBoundingBox(); });
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "BVH.h"
+#include "Model.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Finds the model a ray hits first. Model bounds are kept in a BVH that is traversed nearest first; meshes
+// that carry a TriangleBVH (see Mesh::SetBuildTriangleBVH) are then hit exactly, other models by their bounds.
+class PickingService {
+public:
+	static constexpr std::size_t NoMesh{ std::numeric_limits<std::size_t>::max() };
+	static constexpr std::uint32_t NoTriangle{ std::numeric_limits<std::uint32_t>::max() };
+
+	struct Hit {
+		ModelPtr Model;
+		float Distance{ 0.0f };
+		glm::vec3 Position{ 0.0f };
+		// Mesh of the model and triangle in its index buffer, NoMesh and NoTriangle for a bounding box hit
+		std::size_t Mesh{ NoMesh };
+		std::uint32_t Triangle{ NoTriangle };
+	};
+
+	// World space ray through a pixel of the viewport, y pointing down like window coordinates.
+	static Ray GetScreenRay(const glm::vec2& pixel, const glm::mat4& view, const glm::mat4& projection, const glm::vec2& viewport);
+
+	// Rebuilds the BVH when models were added or removed and refits it when any model moved since the last call.
+	void Update(const std::vector<ModelPtr>& models);
+
+	std::optional<Hit> Pick(const Ray& ray) const;
+
+	auto GetNumModels() const noexcept { return m_models.size(); }
+
+private:
+	void updateBounds();
+
+	std::vector<ModelPtr> m_models;
+	// World space bounds of m_models
+	std::vector<AABB> m_bounds;
+	BVH m_bvh;
+	std::uint32_t m_transformGeneration{ 0 };
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+// SSE2 is part of the x86-64 baseline, so it is selected at compile time.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GE_SSE2 1
+#include <emmintrin.h>
+#else
+#pragma message ( "SSE2 not available, SIMD code paths fall back to scalar.")
+#endif
+
+// AVX2 paths are compiled alongside the SSE2 ones and selected at runtime.
+#ifdef GE_SSE2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define GE_TARGET_AVX2
+#else
+#define GE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace Platform
+{
+	// True if the CPU and OS support AVX2 and FMA.
+	inline bool HasAVX2() noexcept
+	{
+#if defined(GE_SSE2) && defined(_MSC_VER) && !defined(__clang__)
+		static const bool hasAVX2 = [] {
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+			{
+				return false;
+			}
+
+			__cpuid(info, 1);
+			const bool osSavesYmm{ (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6 };
+			const bool hasFMA{ (info[2] & (1 << 12)) != 0 };
+
+			__cpuidex(info, 7, 0);
+			return osSavesYmm && hasFMA && (info[1] & (1 << 5)) != 0;
+		}();
+		return hasAVX2;
+#elif defined(GE_SSE2)
+		static const bool hasAVX2{ __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") };
+		return hasAVX2;
+#else
+		return false;
+#endif
+	}
+}
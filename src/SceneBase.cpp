@@ -1,8 +1,9 @@
 #include "SceneBase.h"
 
+#include <algorithm>
 #include <string_view>
 #include <iostream>
-#include "ResourceManager.h"
+#include "resourceManager.h"
 #include <pugixml.hpp>
 
 /***********************************************************************************/
@@ -29,6 +30,50 @@ void SceneBase::Update(const double dt)
 	}
 }
 
+/***********************************************************************************/
+void SceneBase::Simulate(const double dt)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_moveMutex);
+		std::swap(m_queuedMoves, m_pendingMoves);
+	}
+	for (const auto& [model, position] : m_pendingMoves)
+	{
+		m_modelPositions[model] = position;
+	}
+	m_pendingMoves.clear();
+
+	Update(dt);
+
+	if (m_saveRequested.exchange(false, std::memory_order_relaxed))
+	{
+		Save();
+	}
+}
+
+/***********************************************************************************/
+void SceneBase::CaptureSnapshot(SceneSnapshot& snapshot) const
+{
+	snapshot.ModelPositions = m_modelPositions;
+	snapshot.DirectionalLights = m_staticDirectionalLights;
+	snapshot.PointLights = m_staticPointLights;
+	snapshot.SpotLights = m_staticSpotLights;
+}
+
+/***********************************************************************************/
+void SceneBase::MoveModel(const ModelPtr& model, const glm::vec3& position)
+{
+	const auto it{ std::find(m_sceneModels.cbegin(), m_sceneModels.cend(), model) };
+	if (it == m_sceneModels.cend())
+	{
+		std::cerr << "Scene Error: Can not move a model that is not part of scene " << m_sceneName << std::endl;
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_moveMutex);
+	m_queuedMoves.emplace_back(static_cast<std::size_t>(std::distance(m_sceneModels.cbegin(), it)), position);
+}
+
 /***********************************************************************************/
 void SceneBase::AddLight(const StaticDirectionalLight& light)
 {
@@ -51,6 +96,7 @@ void SceneBase::AddLight(const StaticSpotLight& light)
 void SceneBase::AddModel(const ModelPtr& model)
 {
 	m_sceneModels.push_back(model);
+	m_modelPositions.push_back(model->GetPosition());
 }
 
 void SceneBase::Save()
@@ -66,13 +112,15 @@ void SceneBase::Save()
 	// Add a root node
 	pugi::xml_node modelsNode = doc.append_child("Models");
 
-	for (auto model : m_sceneModels) {
+	// Positions come from the simulated state, the models may be in between two snapshots
+	for (std::size_t i = 0; i < m_sceneModels.size(); ++i) {
+		const auto& model{ m_sceneModels[i] };
 		pugi::xml_node modelNode = modelsNode.append_child("Model");
 		modelNode.append_attribute("Name") = model->GetModelName().c_str();
 		modelNode.append_attribute("Path") = model->GetModelFullPath().c_str();
-		modelNode.append_attribute("World_X") = model->GetPosition().x;
-		modelNode.append_attribute("World_Y") = model->GetPosition().y;
-		modelNode.append_attribute("World_Z") = model->GetPosition().z;
+		modelNode.append_attribute("World_X") = m_modelPositions[i].x;
+		modelNode.append_attribute("World_Y") = m_modelPositions[i].y;
+		modelNode.append_attribute("World_Z") = m_modelPositions[i].z;
 		modelNode.append_attribute("Scale_X") = model->GetScale().x;
 		modelNode.append_attribute("Scale_Y") = model->GetScale().y;
 		modelNode.append_attribute("Scale_Z") = model->GetScale().z;
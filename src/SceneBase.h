@@ -2,13 +2,17 @@
 #include "Utils.h"
 
 #include "Model.h"
+#include "SceneSnapshot.h"
 
-#include "Graphics/StaticDirectionalLight.h"
-#include "Graphics/StaticPointLight.h"
-#include "Graphics/StaticSpotLight.h"
+#include "graphics/StaticDirectionalLight.h"
+#include "graphics/StaticPointLight.h"
+#include "graphics/StaticSpotLight.h"
 
+#include <atomic>
 #include <string>
 #include <fstream>
+#include <mutex>
+#include <utility>
 #include <pugixml.hpp>
 
 /***********************************************************************************/
@@ -29,8 +33,21 @@ public:
 	MAKE_MOVE_ONLY(SceneBase)
 
 	virtual void Init(const std::string_view sceneName);
+	// Advances the lights and model positions by dt. Runs on the simulation thread when there is one, so it must
+	// not touch the models themselves, they belong to the render thread and follow the published snapshots.
 	virtual void Update(const double dt);
 
+	// One simulation step: applies queued model moves, runs Update and a requested save. Called by the
+	// SimulationThread while it runs, otherwise by the engine once per frame.
+	void Simulate(const double dt);
+	// Copies the simulated state into snapshot, reusing its storage.
+	void CaptureSnapshot(SceneSnapshot& snapshot) const;
+
+	// Thread-safe. Moves model to position at the start of the next simulation step.
+	void MoveModel(const ModelPtr& model, const glm::vec3& position);
+	// Thread-safe. Saves the scene after the next simulation step.
+	void RequestSave() noexcept { m_saveRequested.store(true, std::memory_order_relaxed); }
+
 	auto GetName() const noexcept { return m_sceneName; }
 
 protected:
@@ -52,6 +69,13 @@ private:
 	std::vector<StaticSpotLight> m_staticSpotLights;
 
 	std::vector<ModelPtr> m_sceneModels;
+	// Simulated position of every model in m_sceneModels
+	std::vector<glm::vec3> m_modelPositions;
+
+	// Model moves from other threads (the editor), applied by Simulate
+	std::mutex m_moveMutex;
+	std::vector<std::pair<std::size_t, glm::vec3>> m_queuedMoves, m_pendingMoves;
+	std::atomic<bool> m_saveRequested{ false };
 
 	bool direction;
 };
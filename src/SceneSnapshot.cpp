@@ -0,0 +1,47 @@
+#include "SceneSnapshot.h"
+
+#include <glm/common.hpp>
+
+/***********************************************************************************/
+void InterpolateSnapshots(const SceneSnapshot& from, const SceneSnapshot& to, const float alpha, SceneSnapshot& out)
+{
+	out = to;
+	out.Time = glm::mix(from.Time, to.Time, static_cast<double>(alpha));
+
+	if (from.ModelPositions.size() == to.ModelPositions.size())
+	{
+		for (std::size_t i = 0; i < to.ModelPositions.size(); ++i)
+		{
+			out.ModelPositions[i] = glm::mix(from.ModelPositions[i], to.ModelPositions[i], alpha);
+		}
+	}
+
+	if (from.DirectionalLights.size() == to.DirectionalLights.size())
+	{
+		for (std::size_t i = 0; i < to.DirectionalLights.size(); ++i)
+		{
+			out.DirectionalLights[i].Color = glm::mix(from.DirectionalLights[i].Color, to.DirectionalLights[i].Color, alpha);
+			out.DirectionalLights[i].Direction = glm::mix(from.DirectionalLights[i].Direction, to.DirectionalLights[i].Direction, alpha);
+		}
+	}
+
+	if (from.PointLights.size() == to.PointLights.size())
+	{
+		for (std::size_t i = 0; i < to.PointLights.size(); ++i)
+		{
+			out.PointLights[i].Color = glm::mix(from.PointLights[i].Color, to.PointLights[i].Color, alpha);
+			out.PointLights[i].Position = glm::mix(from.PointLights[i].Position, to.PointLights[i].Position, alpha);
+			out.PointLights[i].Rotation = glm::mix(from.PointLights[i].Rotation, to.PointLights[i].Rotation, alpha);
+		}
+	}
+
+	if (from.SpotLights.size() == to.SpotLights.size())
+	{
+		for (std::size_t i = 0; i < to.SpotLights.size(); ++i)
+		{
+			out.SpotLights[i].Color = glm::mix(from.SpotLights[i].Color, to.SpotLights[i].Color, alpha);
+			out.SpotLights[i].Position = glm::mix(from.SpotLights[i].Position, to.SpotLights[i].Position, alpha);
+			out.SpotLights[i].Direction = glm::mix(from.SpotLights[i].Direction, to.SpotLights[i].Direction, alpha);
+		}
+	}
+}
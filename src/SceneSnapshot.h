@@ -0,0 +1,28 @@
+#pragma once
+
+#include "graphics/StaticDirectionalLight.h"
+#include "graphics/StaticPointLight.h"
+#include "graphics/StaticSpotLight.h"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// State of a scene after a simulation step: everything SceneBase::Update may change, copied out so the
+// render thread never reads the scene while the simulation thread updates it. Models are listed in scene
+// order; their scale is fixed at load time, so only positions are simulated.
+struct SceneSnapshot {
+	// Simulation steps taken and the simulated time in seconds this state belongs to
+	std::uint64_t Tick{ 0 };
+	double Time{ 0.0 };
+
+	std::vector<glm::vec3> ModelPositions;
+	std::vector<StaticDirectionalLight> DirectionalLights;
+	std::vector<StaticPointLight> PointLights;
+	std::vector<StaticSpotLight> SpotLights;
+};
+
+// Blends positions, directions and colors of from and to by alpha (0 = from, 1 = to) into out. Anything
+// added or removed between the two is taken from to. Reuses the storage of out.
+void InterpolateSnapshots(const SceneSnapshot& from, const SceneSnapshot& to, const float alpha, SceneSnapshot& out);
@@ -1,8 +1,9 @@
 #include "Skybox.h"
 
-#include "ResourceManager.h"
-#include "Graphics/GLShaderProgramFactory.h"
-#include "Graphics/GLShaderProgram.h"
+#include "resourceManager.h"
+#include "graphics/GPUMemory.h"
+#include "graphics/GLShaderProgramFactory.h"
+#include "graphics/GLShaderProgram.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -11,6 +12,10 @@
 /***********************************************************************************/
 void Skybox::Init(const std::string_view hdrPath, const std::size_t resolution)
 {
+	// Everything created here, the environment maps and the geometry, counts towards the skybox
+	Graphics::GPUMemoryScope memoryScope(Graphics::GPUMemoryCategory::Skybox, hdrPath);
+	auto& memoryTracker{ Graphics::GPUMemoryTracker::GetInstance() };
+	const auto size{ static_cast<GLsizei>(resolution) };
 
 	const std::array<Vertex, 4> screenQuadVertices {
 		// Positions				// GLTexture Coords
@@ -83,6 +88,7 @@ void Skybox::Init(const std::string_view hdrPath, const std::size_t resolution)
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices.data(), GL_STATIC_DRAW);
+	memoryTracker.Track(Graphics::GPUResourceType::Buffer, vbo, sizeof(vertices));
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
@@ -95,6 +101,7 @@ void Skybox::Init(const std::string_view hdrPath, const std::size_t resolution)
 	glBindFramebuffer(GL_FRAMEBUFFER, m_envMapFBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, envMapRBO);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, (GLsizei)resolution, (GLsizei)resolution);
+	memoryTracker.Track(Graphics::GPUResourceType::Renderbuffer, envMapRBO, Graphics::GetTextureBytes(GL_DEPTH_COMPONENT24, size, size));
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, envMapRBO);
 
 	const auto hdrTexture = ResourceManager::GetInstance().LoadHDRI(hdrPath);
@@ -146,6 +153,7 @@ void Skybox::Init(const std::string_view hdrPath, const std::size_t resolution)
 		renderCube();
 	}
 
+	memoryTracker.Untrack(Graphics::GPUResourceType::Texture, hdrTexture);
 	glDeleteTextures(1, &hdrTexture);
 	convertToCubemapShader.DeleteProgram();
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -153,6 +161,7 @@ void Skybox::Init(const std::string_view hdrPath, const std::size_t resolution)
 	// Generate mipmaps from first mip face (again to reduce bright dots)
 	glBindTexture(GL_TEXTURE_CUBE_MAP, m_envCubemap);
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	memoryTracker.Track(Graphics::GPUResourceType::Texture, m_envCubemap, Graphics::GetTextureBytes(GL_RGB16F, size, size, 6, Graphics::GetNumMipLevels(size, size)));
 
 	// Precompute irradiance cubemap.
 	glGenTextures(1, &m_irradianceMap);
@@ -162,6 +171,7 @@ void Skybox::Init(const std::string_view hdrPath, const std::size_t resolution)
 		// Convoluting a cubemap purposefully scrubs out the fine details so we only need a low-res image (default 32)
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, (GLsizei)resolution / 16, (GLsizei)resolution / 16, 0, GL_RGB, GL_FLOAT, nullptr);
 	}
+	memoryTracker.Track(Graphics::GPUResourceType::Texture, m_irradianceMap, Graphics::GetTextureBytes(GL_RGB16F, size / 16, size / 16, 6));
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -211,6 +221,7 @@ void Skybox::Init(const std::string_view hdrPath, const std::size_t resolution)
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	// Generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	memoryTracker.Track(Graphics::GPUResourceType::Texture, m_prefilterMap, Graphics::GetTextureBytes(GL_RGB16F, size / 4, size / 4, 6, Graphics::GetNumMipLevels(size / 4, size / 4)));
 
 	// Run quasi monte-carlo simulation on the environment lighting to create a prefilter cubemap (since we can't integrate over infinite directions).
 	// Pre-filter the environment map with different roughness values over multiple mipmap levels
@@ -255,6 +266,7 @@ void Skybox::Init(const std::string_view hdrPath, const std::size_t resolution)
 
 	glBindTexture(GL_TEXTURE_2D, m_brdfLUT);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, (GLsizei)resolution, (GLsizei)resolution, 0, GL_RG, GL_FLOAT, nullptr);
+	memoryTracker.Track(Graphics::GPUResourceType::Texture, m_brdfLUT, Graphics::GetTextureBytes(GL_RG16F, size, size));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
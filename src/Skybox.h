@@ -2,7 +2,7 @@
 
 #include <string_view>
 
-#include "Graphics/GLVertexArray.h"
+#include "graphics/GLVertexArray.h"
 
 class Skybox {
 
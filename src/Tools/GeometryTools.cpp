@@ -0,0 +1,446 @@
+#include "GeometryTools.h"
+
+#include "../AmbientOcclusion.h"
+#include "../core/ThreadPool.h"
+#include "../graphics/GLTFLoader.h"
+#include "../graphics/Meshlets.h"
+#include "../graphics/OBJLoader.h"
+#include "../graphics/RenderBackend.h"
+#include "../graphics/RenderScene.h"
+#include "../Model.h"
+#include "../Platform/SIMD.h"
+#include "../ViewFrustum.h"
+
+#include <assimp/scene.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <fmt/core.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	/***********************************************************************************/
+	// Every mesh of the model in model space, the way Model would load it.
+	std::vector<AmbientOcclusion::MeshInput> loadMeshInputs(const std::filesystem::path& path)
+	{
+		Assimp::Importer importer;
+		const auto* scene{ importer.ReadFile(path.string(), aiProcess_Triangulate |
+			aiProcess_JoinIdenticalVertices |
+			aiProcess_SortByPType |
+			aiProcess_GenSmoothNormals |
+			aiProcess_PreTransformVertices) };
+
+		std::vector<AmbientOcclusion::MeshInput> meshes;
+		if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE)
+		{
+			std::cerr << "Ambient Occlusion Benchmark: Failed to load " << path << ": " << importer.GetErrorString() << '\n';
+			return meshes;
+		}
+
+		for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+		{
+			const auto* mesh{ scene->mMeshes[i] };
+			if (!mesh->HasNormals())
+			{
+				continue;
+			}
+
+			auto& input{ meshes.emplace_back() };
+			for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+			{
+				input.Positions.emplace_back(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+				input.Normals.emplace_back(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z);
+			}
+			for (unsigned int f = 0; f < mesh->mNumFaces; ++f)
+			{
+				if (mesh->mFaces[f].mNumIndices == 3)
+				{
+					input.Indices.insert(input.Indices.end(), mesh->mFaces[f].mIndices, mesh->mFaces[f].mIndices + 3);
+				}
+			}
+		}
+
+		return meshes;
+	}
+
+	struct LoadedGeometry {
+		std::size_t Meshes{ 0 };
+		std::size_t Vertices{ 0 };
+		std::size_t Triangles{ 0 };
+	};
+
+	/***********************************************************************************/
+	// Import with Model's post-processing and the conversion into the Vertex and index arrays Mesh uploads
+	std::optional<LoadedGeometry> loadWithAssimp(const std::filesystem::path& path)
+	{
+		Assimp::Importer importer;
+		const auto* scene{ importer.ReadFile(path.string(), Model::GetAssimpImportFlags(true)) };
+		if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE)
+		{
+			std::cerr << "Loading Benchmark: Assimp failed to load " << path << ": " << importer.GetErrorString() << '\n';
+			return std::nullopt;
+		}
+
+		LoadedGeometry geometry;
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+		for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+		{
+			const auto* mesh{ scene->mMeshes[i] };
+			vertices.resize(mesh->mNumVertices);
+			for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+			{
+				vertices[v].Position = glm::vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+				vertices[v].Normal = mesh->HasNormals() ? glm::vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z) : glm::vec3(0.0f);
+				vertices[v].Tangent = mesh->HasTangentsAndBitangents() ? glm::vec3(mesh->mTangents[v].x, mesh->mTangents[v].y, mesh->mTangents[v].z) : glm::vec3(0.0f);
+				vertices[v].TexCoords = mesh->HasTextureCoords(0) ? glm::vec2(mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y) : glm::vec2(0.0f);
+			}
+
+			indices.clear();
+			for (unsigned int f = 0; f < mesh->mNumFaces; ++f)
+			{
+				indices.insert(indices.end(), mesh->mFaces[f].mIndices, mesh->mFaces[f].mIndices + mesh->mFaces[f].mNumIndices);
+			}
+
+			++geometry.Meshes;
+			geometry.Vertices += vertices.size();
+			geometry.Triangles += indices.size() / 3;
+		}
+
+		return geometry;
+	}
+
+	/***********************************************************************************/
+	template<typename MeshList>
+	LoadedGeometry countGeometry(const MeshList& meshes)
+	{
+		LoadedGeometry geometry;
+		for (const auto& mesh : meshes)
+		{
+			++geometry.Meshes;
+			geometry.Vertices += mesh.Vertices.size();
+			geometry.Triangles += mesh.Indices.size() / 3;
+		}
+		return geometry;
+	}
+
+	/***********************************************************************************/
+	// Through the loader Model uses for the file's format instead of Assimp
+	std::optional<LoadedGeometry> loadNative(const std::filesystem::path& path)
+	{
+		if (path.extension() == ".obj")
+		{
+			Graphics::OBJLoadOptions options;
+			options.FlipWindingOrder = true;
+			const auto model{ Graphics::LoadOBJ(path, options) };
+			return model ? std::optional(countGeometry(model->Meshes)) : std::nullopt;
+		}
+
+		Graphics::GLTFLoadOptions options;
+		options.FlipWindingOrder = true;
+		const auto model{ Graphics::LoadGLTF(path, options) };
+		return model ? std::optional(countGeometry(model->Primitives)) : std::nullopt;
+	}
+
+	struct MeshGeometry {
+		std::vector<Vertex> Vertices;
+		std::vector<GLuint> Indices;
+	};
+
+	/***********************************************************************************/
+	template<typename MeshList>
+	std::vector<MeshGeometry> takeGeometry(MeshList& meshes)
+	{
+		std::vector<MeshGeometry> geometry;
+		for (auto& mesh : meshes)
+		{
+			geometry.push_back({ std::move(mesh.Vertices), std::move(mesh.Indices) });
+		}
+		return geometry;
+	}
+
+	/***********************************************************************************/
+	// Vertex and index arrays of every mesh the way Model loads them, through the native loader of the format
+	std::optional<std::vector<MeshGeometry>> loadMeshGeometry(const std::filesystem::path& path)
+	{
+		if (path.extension() == ".obj")
+		{
+			Graphics::OBJLoadOptions options;
+			options.FlipWindingOrder = true;
+			options.LoadMaterials = false;
+			auto model{ Graphics::LoadOBJ(path, options) };
+			return model ? std::optional(takeGeometry(model->Meshes)) : std::nullopt;
+		}
+
+		Graphics::GLTFLoadOptions options;
+		options.FlipWindingOrder = true;
+		options.LoadMaterials = false;
+		auto model{ Graphics::LoadGLTF(path, options) };
+		return model ? std::optional(takeGeometry(model->Primitives)) : std::nullopt;
+	}
+}
+
+namespace Tools
+{
+	/***********************************************************************************/
+	int BenchmarkAmbientOcclusion(const std::filesystem::path& model)
+	{
+		const auto meshes{ loadMeshInputs(model) };
+		if (meshes.empty())
+		{
+			return 1;
+		}
+
+		std::size_t numVertices{ 0 }, numTriangles{ 0 };
+		for (const auto& mesh : meshes)
+		{
+			numVertices += mesh.Positions.size();
+			numTriangles += mesh.Indices.size() / 3;
+		}
+
+		AmbientOcclusion::Settings settings;
+		const auto numRays{ static_cast<double>(numVertices) * settings.NumRays };
+		const auto maxThreads{ ThreadPool::GetInstance().GetNumThreads() };
+
+		std::cout << fmt::format("Ambient Occlusion Benchmark: {}, {} meshes, {} vertices, {} triangles, {} rays per vertex\n",
+			model.filename().string(), meshes.size(), numVertices, numTriangles, settings.NumRays);
+		std::cout << fmt::format("  {:<6} {:>8} {:>10} {:>10} {:>8} {:>8}\n", "ISA", "Threads", "ms", "MRays/s", "Speedup", "Mean AO");
+
+		for (const auto allowSIMD : { false, true })
+		{
+#ifndef GE_SSE2
+			if (allowSIMD)
+			{
+				continue;
+			}
+#endif
+			settings.AllowSIMD = allowSIMD;
+
+			double singleThreaded{ 0.0 };
+			for (std::size_t threads = 1;; threads = std::min(threads * 2, maxThreads))
+			{
+				settings.MaxThreads = threads;
+
+				const auto start{ Clock::now() };
+				const auto result{ AmbientOcclusion::Bake(meshes, settings) };
+				const auto seconds{ std::chrono::duration<double>(Clock::now() - start).count() };
+
+				if (threads == 1)
+				{
+					singleThreaded = seconds;
+				}
+
+				double sum{ 0.0 };
+				for (const auto& values : result)
+				{
+					sum += std::accumulate(values.cbegin(), values.cend(), 0.0);
+				}
+
+				std::cout << fmt::format("  {:<6} {:>8} {:>10.1f} {:>10.2f} {:>7.2f}x {:>8.3f}\n", allowSIMD ? "SSE2" : "Scalar", threads,
+					seconds * 1000.0, numRays / seconds / 1.0e6, singleThreaded / seconds, sum / numVertices);
+
+				if (threads == maxThreads)
+				{
+					break;
+				}
+			}
+		}
+
+		return 0;
+	}
+
+	/***********************************************************************************/
+	int BenchmarkModelLoading(const std::filesystem::path& model)
+	{
+		constexpr std::size_t NumRuns{ 5 };
+
+		std::cout << fmt::format("Model Loading Benchmark: {}, best and median of {} runs, textures not included\n", model.filename().string(), NumRuns);
+		std::cout << fmt::format("  {:<8} {:>10} {:>10} {:>8} {:>10} {:>10} {:>8}\n", "Loader", "Best ms", "Median ms", "Meshes", "Vertices", "Triangles", "Speedup");
+
+		double assimpMedian{ 0.0 };
+		for (const auto native : { false, true })
+		{
+			std::vector<double> times;
+			std::optional<LoadedGeometry> geometry;
+			for (std::size_t run = 0; run < NumRuns; ++run)
+			{
+				const auto start{ Clock::now() };
+				geometry = native ? loadNative(model) : loadWithAssimp(model);
+				times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+				if (!geometry)
+				{
+					return 1;
+				}
+			}
+
+			std::sort(times.begin(), times.end());
+			const auto median{ times[NumRuns / 2] };
+			if (!native)
+			{
+				assimpMedian = median;
+			}
+
+			std::cout << fmt::format("  {:<8} {:>10.1f} {:>10.1f} {:>8} {:>10} {:>10} {:>7.2f}x\n", native ? "Native" : "Assimp", times.front(), median,
+				geometry->Meshes, geometry->Vertices, geometry->Triangles, assimpMedian / median);
+		}
+
+		return 0;
+	}
+
+	/***********************************************************************************/
+	int BenchmarkMeshlets(const std::filesystem::path& model)
+	{
+		using namespace Graphics;
+
+		auto meshes{ loadMeshGeometry(model) };
+		if (!meshes)
+		{
+			return 1;
+		}
+
+		// Built like Mesh does when the Meshlets node enables them, placed in a render scene like Engine does
+		RenderScene scene;
+		AABB bounds;
+		for (const auto& mesh : *meshes)
+		{
+			for (const auto& vertex : mesh.Vertices)
+			{
+				bounds.extend(vertex.Position);
+			}
+		}
+		const auto modelHandle{ scene.AddModel(RenderModel{ glm::mat4(1.0f), bounds, false }) };
+
+		std::size_t numTriangles{ 0 }, numMeshlets{ 0 };
+		const auto buildStart{ Clock::now() };
+		for (std::size_t i = 0; i < meshes->size(); ++i)
+		{
+			auto& mesh{ (*meshes)[i] };
+			const auto meshlets{ BuildMeshlets(mesh.Vertices, mesh.Indices) };
+
+			RenderMesh renderMesh{ static_cast<GLuint>(1 + i), static_cast<GLsizei>(mesh.Indices.size()), modelHandle, {} };
+			renderMesh.FirstMeshlet = scene.AddMeshlets(meshlets);
+			renderMesh.NumMeshlets = static_cast<std::uint32_t>(meshlets.size());
+			scene.AddMesh(renderMesh);
+
+			numTriangles += mesh.Indices.size() / 3;
+			numMeshlets += meshlets.size();
+		}
+		const auto buildMilliseconds{ std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count() };
+
+		std::cout << fmt::format("Meshlet Culling Benchmark: {}, {} meshes, {} triangles, {} meshlets of {:.1f} triangles on average, built in {:.1f} ms\n",
+			model.filename().string(), meshes->size(), numTriangles, numMeshlets, static_cast<double>(numTriangles) / std::max<std::size_t>(numMeshlets, 1), buildMilliseconds);
+
+		// Looking outwards from around the middle of the model, then at it from outside
+		struct View {
+			glm::vec3 Eye;
+			glm::vec3 Target;
+		};
+		std::vector<View> views;
+		const auto center{ bounds.getCenter() };
+		const auto size{ bounds.getMax() - bounds.getMin() };
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			const auto angle{ glm::radians(45.0f * static_cast<float>(i)) };
+			const glm::vec3 direction{ std::cos(angle), -0.1f, std::sin(angle) };
+			const auto eye{ center + 0.2f * size * glm::vec3(direction.x, 0.0f, direction.z) };
+			views.push_back({ eye, eye + direction });
+		}
+		for (std::size_t i = 0; i < 4; ++i)
+		{
+			const auto angle{ glm::radians(90.0f * static_cast<float>(i) + 30.0f) };
+			views.push_back({ center + glm::length(size) * glm::vec3(std::cos(angle), 0.4f, std::sin(angle)), center });
+		}
+
+		constexpr std::size_t NumRuns{ 20 };
+		LinearArena arena;
+		CommandBuffer commands;
+		NullRenderBackend backend;
+
+		// Times are of Cull and CullMeshlets together: SSE2 without cones, then with them in scalar code and SSE2
+		std::cout << fmt::format("  {:<5} {:>10} {:>10} {:>6} {:>10} {:>6} {:>8} {:>8} {:>10} {:>10} {:>10}\n",
+			"View", "Triangles", "Frustum", "%", "+Cone", "%", "Ranges", "Draws", "Frustum us", "Scalar us", "SSE2 us");
+
+		MeshletCullCounts totalFrustum, totalCone;
+		for (std::size_t v = 0; v < views.size(); ++v)
+		{
+			const auto projection{ glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.01f * glm::length(size), 4.0f * glm::length(size)) };
+			const ViewFrustum frustum(glm::lookAt(views[v].Eye, views[v].Target, glm::vec3(0.0f, 1.0f, 0.0f)), projection);
+
+			// Counts of one cull and the best time of NumRuns. The draws of the first run are recorded, with the
+			// number of index ranges in them.
+			std::size_t numRanges{ 0 };
+			const auto cull = [&](const MeshletCullSettings& settings, double& microseconds) {
+				MeshletCullCounts counts;
+				microseconds = std::numeric_limits<double>::max();
+				for (std::size_t run = 0; run < NumRuns; ++run)
+				{
+					arena.Reset();
+					ArenaVector<std::uint32_t> visibleMeshes{ ArenaAllocator<std::uint32_t>(arena) };
+					MeshletDrawList drawList{ arena };
+
+					const auto start{ Clock::now() };
+					scene.Cull(frustum, visibleMeshes);
+					counts = scene.CullMeshlets(frustum, views[v].Eye, visibleMeshes, drawList, settings);
+					microseconds = std::min(microseconds, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+					if (run == 0)
+					{
+						commands.Reset();
+						numRanges = 0;
+						for (std::size_t i = 0; i < visibleMeshes.size(); ++i)
+						{
+							const auto& draw{ drawList.Draws[i] };
+							commands.DrawElementRanges(scene.GetMeshes()[visibleMeshes[i]].VertexArray, GL_TRIANGLES, drawList.Ranges.data() + draw.FirstRange, draw.NumRanges);
+							numRanges += draw.NumRanges;
+						}
+					}
+				}
+				return counts;
+			};
+
+			MeshletCullSettings settings;
+			settings.ConeCulling = false;
+			double frustumMicroseconds, scalarMicroseconds, simdMicroseconds;
+			const auto frustumOnly{ cull(settings, frustumMicroseconds) };
+			settings.ConeCulling = true;
+			settings.AllowSIMD = false;
+			cull(settings, scalarMicroseconds);
+			settings.AllowSIMD = true;
+			const auto withCone{ cull(settings, simdMicroseconds) };
+			totalFrustum += frustumOnly;
+			totalCone += withCone;
+
+			// The recorded draws of the last cull, replayed without OpenGL, submit exactly the kept triangles
+			backend.ResetStats();
+			backend.Execute(commands);
+			const auto& stats{ backend.GetStats() };
+			if (stats.Elements / 3 != withCone.TrianglesAfter)
+			{
+				std::cerr << fmt::format("Meshlet Culling Benchmark: View {} draws {} triangles, culling kept {}\n", v, stats.Elements / 3, withCone.TrianglesAfter);
+				return 1;
+			}
+
+			std::cout << fmt::format("  {:<5} {:>10} {:>10} {:>5.1f}% {:>10} {:>5.1f}% {:>8} {:>8} {:>10.1f} {:>10.1f} {:>10.1f}\n", v,
+				withCone.TrianglesBefore, frustumOnly.TrianglesAfter, 100.0 * frustumOnly.TrianglesAfter / std::max<std::size_t>(withCone.TrianglesBefore, 1),
+				withCone.TrianglesAfter, 100.0 * withCone.TrianglesAfter / std::max<std::size_t>(withCone.TrianglesBefore, 1),
+				numRanges, stats.DrawCalls, frustumMicroseconds, scalarMicroseconds, simdMicroseconds);
+		}
+
+		std::cout << fmt::format("  Total {:>10} {:>10} {:>5.1f}% {:>10} {:>5.1f}%\n", totalCone.TrianglesBefore,
+			totalFrustum.TrianglesAfter, 100.0 * totalFrustum.TrianglesAfter / std::max<std::size_t>(totalCone.TrianglesBefore, 1),
+			totalCone.TrianglesAfter, 100.0 * totalCone.TrianglesAfter / std::max<std::size_t>(totalCone.TrianglesBefore, 1));
+
+		return 0;
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <filesystem>
+
+namespace Tools
+{
+	// Bakes per-vertex ambient occlusion for a model with 1, 2, 4, ... threads, with and without SIMD triangle
+	// tests, and reports bake time, rays per second and the speedup over one thread.
+	int BenchmarkAmbientOcclusion(const std::filesystem::path& model);
+	// Loads a glTF or OBJ model through Assimp, with the post-processing Model uses, and through the engine's own
+	// loader for the format, and reports the time of each up to ready-to-upload vertex and index arrays.
+	int BenchmarkModelLoading(const std::filesystem::path& model);
+	// Splits the meshes of a model into meshlets and culls them from views inside and around it, with the frustum
+	// alone and with the normal cones too. Reports triangles before and after per view, and the culling time with
+	// and without SIMD.
+	int BenchmarkMeshlets(const std::filesystem::path& model);
+}
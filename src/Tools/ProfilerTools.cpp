@@ -0,0 +1,92 @@
+#include "ProfilerTools.h"
+
+#include "../core/Profiler.h"
+#include "../core/ThreadPool.h"
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+#ifdef GE_ENABLE_PROFILER
+	constexpr std::size_t ZonesPerRun{ 4'000'000 };
+	constexpr double BudgetNanoseconds{ 50.0 };
+
+	// Keeps the loop from being optimized away when the zone is compiled out
+	std::atomic<std::uint64_t> g_sink{ 0 };
+
+	/***********************************************************************************/
+	// Nanoseconds per zone over count nested zone pairs (an outer and an inner zone per iteration).
+	double timeZones(const std::size_t count)
+	{
+		const auto start{ std::chrono::steady_clock::now() };
+		for (std::size_t i = 0; i < count / 2; ++i)
+		{
+			PROFILE_SCOPE("BenchmarkOuter");
+			{
+				PROFILE_SCOPE("BenchmarkInner");
+				g_sink.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		const auto elapsed{ std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() };
+
+		return elapsed / static_cast<double>(count);
+	}
+
+	/***********************************************************************************/
+	double timeBaseline(const std::size_t count)
+	{
+		const auto start{ std::chrono::steady_clock::now() };
+		for (std::size_t i = 0; i < count / 2; ++i)
+		{
+			g_sink.fetch_add(1, std::memory_order_relaxed);
+		}
+		const auto elapsed{ std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() };
+
+		return elapsed / static_cast<double>(count);
+	}
+#endif
+}
+
+namespace Tools
+{
+	/***********************************************************************************/
+	int BenchmarkProfiler()
+	{
+#ifdef GE_ENABLE_PROFILER
+		// First use registers the thread log, keep that out of the measurement
+		timeZones(1024);
+
+		const auto baseline{ timeBaseline(ZonesPerRun) };
+		auto singleThread{ timeZones(ZonesPerRun) - baseline };
+		for (int run = 0; run < 4; ++run)
+		{
+			singleThread = std::min(singleThread, timeZones(ZonesPerRun) - baseline);
+		}
+
+		// Every thread writes its own ring, so the cost should not grow with the thread count.
+		auto& pool{ ThreadPool::GetInstance() };
+		const auto numThreads{ pool.GetNumThreads() };
+		std::atomic<std::uint64_t> totalNanoseconds{ 0 };
+		pool.ParallelFor(numThreads, 1, [&](const std::size_t begin, const std::size_t end) {
+			for (auto i = begin; i < end; ++i)
+			{
+				const auto nanoseconds{ timeZones(ZonesPerRun) - baseline };
+				totalNanoseconds.fetch_add(static_cast<std::uint64_t>(nanoseconds * 1000.0), std::memory_order_relaxed);
+			}
+		});
+		const auto multiThread{ static_cast<double>(totalNanoseconds.load()) / 1000.0 / static_cast<double>(numThreads) };
+
+		std::cout << fmt::format("Profile zone cost: {:.1f} ns (1 thread), {:.1f} ns ({} threads), budget {:.0f} ns\n",
+			singleThread, multiThread, numThreads, BudgetNanoseconds);
+
+		return singleThread <= BudgetNanoseconds ? 0 : 1;
+#else
+		std::cout << "Profiler is compiled out, define GE_ENABLE_PROFILER to benchmark it.\n";
+		return 0;
+#endif
+	}
+}
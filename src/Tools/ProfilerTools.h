@@ -0,0 +1,7 @@
+#pragma once
+
+namespace Tools
+{
+	// Cost of a CPU profile zone on one and on all threads, against the 50 ns budget.
+	int BenchmarkProfiler();
+}
@@ -0,0 +1,713 @@
+#include "RenderTools.h"
+
+#include "../graphics/RenderGraph.h"
+#include "../graphics/RenderScene.h"
+#include "../graphics/RenderThread.h"
+#include "../core/SlotMap.h"
+#include "../core/ThreadPool.h"
+#include "../PBRMaterial.h"
+#include "../ViewFrustum.h"
+
+#include <fmt/core.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using Graphics::RenderGraph;
+	using Graphics::RenderGraphTextureDesc;
+
+	/***********************************************************************************/
+	// The pipeline the engine's deferred path is heading for, plus a debug view nobody reads that must be culled.
+	// Returns every transient resource so the aliasing can be checked.
+	std::vector<RenderGraph::ResourceHandle> declareDeferredPipeline(RenderGraph& graph, const bool enableShadows)
+	{
+		const auto noop = [](const RenderGraph::PassResources&) {};
+		const auto screen = [](const GLenum format) { return RenderGraphTextureDesc{ 0, 0, 1.0f, format }; };
+
+		std::vector<RenderGraph::ResourceHandle> transients;
+		const auto create = [&transients](RenderGraph::PassBuilder& builder, const std::string_view name, const RenderGraphTextureDesc& desc) {
+			transients.push_back(builder.Create(name, desc));
+			return transients.back();
+		};
+
+		const auto backbuffer{ graph.ImportFramebuffer("Backbuffer", 0) };
+
+		RenderGraph::ResourceHandle shadowMap, position, normal, albedo, depth, ssao, ssaoBlurred, hdr, bright;
+		graph.AddPass("ShadowMap", [&](RenderGraph::PassBuilder& builder) {
+			shadowMap = create(builder, "ShadowDepth", { 2048, 2048, 1.0f, GL_DEPTH_COMPONENT32, GL_NEAREST, GL_CLAMP_TO_BORDER });
+		}, noop);
+
+		graph.AddPass("GBuffer", [&](RenderGraph::PassBuilder& builder) {
+			position = create(builder, "GPosition", screen(GL_RGBA16F));
+			normal = create(builder, "GNormal", screen(GL_RGBA16F));
+			albedo = create(builder, "GAlbedo", screen(GL_RGBA8));
+			depth = create(builder, "GDepth", screen(GL_DEPTH_COMPONENT24));
+		}, noop);
+
+		graph.AddPass("SSAO", [&](RenderGraph::PassBuilder& builder) {
+			builder.Read(position);
+			builder.Read(normal);
+			ssao = create(builder, "SSAO", screen(GL_R8));
+		}, noop);
+
+		graph.AddPass("SSAOBlur", [&](RenderGraph::PassBuilder& builder) {
+			builder.Read(ssao);
+			ssaoBlurred = create(builder, "SSAOBlurred", screen(GL_R8));
+		}, noop);
+
+		graph.AddPass("GBufferDebugView", [&](RenderGraph::PassBuilder& builder) {
+			builder.Read(normal);
+			create(builder, "DebugView", screen(GL_RGBA8));
+		}, noop);
+
+		graph.AddPass("Lighting", [&](RenderGraph::PassBuilder& builder) {
+			for (const auto input : { position, normal, albedo, ssaoBlurred })
+			{
+				builder.Read(input);
+			}
+			if (enableShadows)
+			{
+				builder.Read(shadowMap);
+			}
+			builder.Write(depth);
+			hdr = create(builder, "HDR", screen(GL_RGBA16F));
+			bright = create(builder, "Brightness", screen(GL_RGBA16F));
+		}, noop);
+
+		// Two rounds of separable ping-pong blur at half resolution
+		auto bloom{ bright };
+		constexpr std::array<std::string_view, 4> bloomPasses{ "BloomH0", "BloomV0", "BloomH1", "BloomV1" };
+		for (const auto pass : bloomPasses)
+		{
+			graph.AddPass(pass, [&](RenderGraph::PassBuilder& builder) {
+				builder.Read(bloom);
+				bloom = create(builder, "Bloom", { 0, 0, 0.5f, GL_RGBA16F, GL_LINEAR });
+			}, noop);
+		}
+
+		RenderGraph::ResourceHandle ldr;
+		graph.AddPass("Tonemap", [&](RenderGraph::PassBuilder& builder) {
+			builder.Read(hdr);
+			builder.Read(bloom);
+			ldr = create(builder, "LDR", screen(GL_RGBA8));
+		}, noop);
+
+		graph.AddPass("FXAA", [&](RenderGraph::PassBuilder& builder) {
+			builder.Read(ldr);
+			builder.Write(backbuffer);
+		}, noop);
+
+		return transients;
+	}
+
+	/***********************************************************************************/
+	// Every pair of transients sharing a physical texture must have disjoint lifetimes.
+	bool checkAliasing(const RenderGraph& graph, const std::vector<RenderGraph::ResourceHandle>& transients)
+	{
+		for (std::size_t a = 0; a < transients.size(); ++a)
+		{
+			for (std::size_t b = a + 1; b < transients.size(); ++b)
+			{
+				const auto physical{ graph.GetPhysicalIndex(transients[a]) };
+				if (physical < 0 || physical != graph.GetPhysicalIndex(transients[b]))
+				{
+					continue;
+				}
+
+				const auto [firstA, lastA] { graph.GetLifetime(transients[a]) };
+				const auto [firstB, lastB] { graph.GetLifetime(transients[b]) };
+				if (firstA <= lastB && firstB <= lastA)
+				{
+					std::cerr << "Render Graph Benchmark Error: Resources " << transients[a] << " and " << transients[b]
+						<< " share physical texture " << physical << " while both are alive\n";
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/***********************************************************************************/
+	bool expectCulled(const RenderGraph& graph, const std::string_view pass, const bool culled)
+	{
+		if (graph.IsCulled(pass) != culled)
+		{
+			std::cerr << "Render Graph Benchmark Error: Pass " << pass << (culled ? " should" : " should not") << " be culled\n";
+			return false;
+		}
+		return true;
+	}
+
+	/***********************************************************************************/
+	// Stand-in for a model of the render list: what the engine's passes read while recording.
+	struct SyntheticModel {
+		glm::vec3 Position;
+		std::array<GLuint, 4> VertexArrays, Textures;
+		std::array<GLsizei, 4> IndexCounts;
+	};
+
+	/***********************************************************************************/
+	std::vector<SyntheticModel> createSyntheticScene(const std::size_t numModels)
+	{
+		std::vector<SyntheticModel> models(numModels);
+		for (std::size_t i = 0; i < numModels; ++i)
+		{
+			auto& model{ models[i] };
+			model.Position = glm::vec3(static_cast<float>(i % 64), 0.0f, static_cast<float>(i / 64));
+			for (std::size_t mesh = 0; mesh < model.VertexArrays.size(); ++mesh)
+			{
+				model.VertexArrays[mesh] = static_cast<GLuint>(1 + i * 4 + mesh);
+				model.Textures[mesh] = static_cast<GLuint>(1 + (i + mesh) % 32);
+				model.IndexCounts[mesh] = static_cast<GLsizei>(300 + 30 * mesh);
+			}
+		}
+		return models;
+	}
+
+	/***********************************************************************************/
+	// Records the shadow (0), forward (1) and bounding box (2) draws the way RenderSystem does. Models drift with
+	// frame, so a replay of the wrong frame changes the checksum.
+	void recordSyntheticPass(Graphics::CommandBuffer& commands, const std::size_t pass, const std::vector<SyntheticModel>& models, const std::uint64_t frame)
+	{
+		constexpr GLint modelLocation{ 0 }, samplerLocation{ 1 }, selectedLocation{ 2 };
+		const auto drift{ glm::vec3(0.0f, 0.01f * static_cast<float>(frame % 100), 0.0f) };
+
+		commands.BindProgram(static_cast<GLuint>(1 + pass));
+		if (pass == 1)
+		{
+			commands.SetUniform(samplerLocation, 0);
+		}
+
+		for (const auto& model : models)
+		{
+			const auto matrix{ glm::translate(glm::mat4(1.0f), model.Position + drift) };
+			commands.SetUniform(modelLocation, matrix);
+
+			if (pass == 2)
+			{
+				commands.SetUniform(selectedLocation, 0);
+				commands.DrawArrays(1, GL_LINE_LOOP, 0, 16);
+				continue;
+			}
+
+			for (std::size_t mesh = 0; mesh < model.VertexArrays.size(); ++mesh)
+			{
+				if (pass == 1)
+				{
+					commands.BindTexture(0, GL_TEXTURE_2D, model.Textures[mesh]);
+				}
+				commands.DrawElements(model.VertexArrays[mesh], GL_TRIANGLES, model.IndexCounts[mesh]);
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	bool expectSameReplay(const std::string_view mode, const Graphics::NullRenderBackend::Stats& reference, const Graphics::NullRenderBackend::Stats& stats)
+	{
+		if (stats.Frames != reference.Frames || stats.Commands != reference.Commands || stats.DrawCalls != reference.DrawCalls ||
+			stats.Elements != reference.Elements || stats.Checksum != reference.Checksum)
+		{
+			std::cerr << "Render Command Benchmark Error: " << mode << " replayed " << stats.Commands << " commands in " << stats.Frames
+				<< " frames (checksum " << stats.Checksum << "), recording on one thread replayed " << reference.Commands << " in "
+				<< reference.Frames << " (checksum " << reference.Checksum << ")\n";
+			return false;
+		}
+		return true;
+	}
+	/***********************************************************************************/
+	// Same members as Model and Mesh, so a ModelPtr traversal touches memory the way the engine's used to.
+	struct LegacyMesh {
+		std::size_t IndexCount;
+		GLuint VertexArray;
+		std::shared_ptr<const Graphics::RenderMaterial> Material;
+		std::shared_ptr<const void> Triangles;
+	};
+
+	struct LegacyModel {
+		glm::mat4 GetModelMatrix() const { return glm::scale(glm::mat4(1.0f), Scale) * glm::translate(glm::mat4(1.0f), Position); }
+
+		std::vector<LegacyMesh> Meshes;
+		glm::vec3 Scale, Position, Axis, Size;
+		float Radians;
+		AABB Bounds;
+		bool Selected;
+		std::string Name, FolderPath, FullPath;
+		std::size_t NumMaterials;
+	};
+
+	using LegacyModelPtr = std::shared_ptr<LegacyModel>;
+
+	/***********************************************************************************/
+	// A grid of models with four meshes each, once as ModelPtrs and once in a RenderScene. Between the allocations
+	// of a model, blocks the size of a loader's strings and vertex data are allocated and kept, as loading does.
+	void createStorageScenes(const std::size_t numModels, std::vector<LegacyModelPtr>& legacy, Graphics::RenderScene& scene,
+		std::vector<std::unique_ptr<char[]>>& loaderBlocks)
+	{
+		constexpr std::size_t meshesPerModel{ 4 }, numMaterials{ 32 };
+		std::mt19937 random(7);
+		std::uniform_int_distribution<std::size_t> blockSize(256, 16 * 1024);
+		const auto allocateLoaderBlock = [&]() { loaderBlocks.emplace_back(std::make_unique<char[]>(blockSize(random))); };
+
+		std::vector<std::shared_ptr<Graphics::RenderMaterial>> materials;
+		std::vector<Graphics::MaterialHandle> materialHandles;
+		for (std::size_t i = 0; i < numMaterials; ++i)
+		{
+			Graphics::RenderMaterial material;
+			material.Textures[PBRMaterial::ALBEDO] = static_cast<GLuint>(1 + i);
+			materials.push_back(std::make_shared<Graphics::RenderMaterial>(material));
+			materialHandles.push_back(scene.AddMaterial(material));
+		}
+
+		const auto side{ static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(numModels)))) };
+		for (std::size_t i = 0; i < numModels; ++i)
+		{
+			const auto position{ glm::vec3(4.0f * static_cast<float>(i % side), 0.0f, 4.0f * static_cast<float>(i / side)) };
+			const AABB bounds(position - glm::vec3(1.0f), position + glm::vec3(1.0f));
+
+			allocateLoaderBlock();
+			auto model{ std::make_shared<LegacyModel>() };
+			model->Scale = glm::vec3(1.0f);
+			model->Position = position;
+			model->Bounds = bounds;
+			model->Selected = false;
+			model->Name = fmt::format("Model_{}_with_a_name_past_small_string_size", i);
+			allocateLoaderBlock();
+
+			const auto handle{ scene.AddModel(Graphics::RenderModel{ model->GetModelMatrix(), bounds, false }) };
+			for (std::size_t mesh = 0; mesh < meshesPerModel; ++mesh)
+			{
+				const auto vertexArray{ static_cast<GLuint>(1 + i * meshesPerModel + mesh) };
+				const auto indexCount{ static_cast<GLsizei>(300 + 30 * mesh) };
+				const auto material{ (i + mesh) % numMaterials };
+
+				model->Meshes.push_back({ static_cast<std::size_t>(indexCount), vertexArray, materials[material], nullptr });
+				allocateLoaderBlock();
+				scene.AddMesh({ vertexArray, indexCount, handle, materialHandles[material] });
+			}
+			legacy.push_back(std::move(model));
+		}
+	}
+
+	/***********************************************************************************/
+	// Culls and records the shadow, forward and bounding box passes the way the engine did with ModelPtrs.
+	void recordLegacyFrame(const std::vector<LegacyModelPtr>& models, const ViewFrustum& frustum, LinearArena& arena,
+		std::array<Graphics::CommandBuffer, 3>& passes)
+	{
+		constexpr GLint modelLocation{ 0 }, selectedLocation{ 2 };
+
+		ArenaVector<LegacyModelPtr> renderList{ ArenaAllocator<LegacyModelPtr>(arena) };
+		renderList.reserve(models.size());
+		for (const auto& model : models)
+		{
+			if (frustum.TestIntersection(model->Bounds) != BoundingVolume::TestResult::OUTSIDE)
+			{
+				renderList.push_back(model);
+			}
+		}
+
+		for (const auto& model : renderList)
+		{
+			passes[0].SetUniform(modelLocation, model->GetModelMatrix());
+			for (const auto& mesh : model->Meshes)
+			{
+				passes[0].DrawElements(mesh.VertexArray, GL_TRIANGLES, static_cast<GLsizei>(mesh.IndexCount));
+			}
+		}
+		for (const auto& model : renderList)
+		{
+			passes[1].SetUniform(modelLocation, model->GetModelMatrix());
+			for (const auto& mesh : model->Meshes)
+			{
+				passes[1].BindTexture(0, GL_TEXTURE_2D, mesh.Material->Textures[PBRMaterial::ALBEDO]);
+				passes[1].DrawElements(mesh.VertexArray, GL_TRIANGLES, static_cast<GLsizei>(mesh.IndexCount));
+			}
+		}
+		for (const auto& model : renderList)
+		{
+			passes[2].SetUniform(modelLocation, glm::translate(glm::mat4(1.0f), model->Bounds.getCenter()));
+			passes[2].SetUniform(selectedLocation, model->Selected ? 1 : 0);
+			passes[2].DrawArrays(1, GL_LINE_LOOP, 0, 16);
+		}
+	}
+
+	/***********************************************************************************/
+	// The same frame from the RenderScene, the way RenderSystem records it.
+	void recordSlotMapFrame(Graphics::RenderScene& scene, const ViewFrustum& frustum, LinearArena& arena,
+		std::array<Graphics::CommandBuffer, 3>& passes)
+	{
+		constexpr GLint modelLocation{ 0 }, selectedLocation{ 2 };
+		constexpr auto noModel{ SlotMap<Graphics::RenderModel>::InvalidIndex };
+
+		ArenaVector<std::uint32_t> renderList{ ArenaAllocator<std::uint32_t>(arena) };
+		scene.Cull(frustum, renderList);
+
+		const auto& models{ scene.GetModels() };
+		const auto& meshes{ scene.GetMeshes() };
+		const auto& materials{ scene.GetMaterials() };
+
+		auto lastModel{ noModel };
+		for (const auto index : renderList)
+		{
+			const auto modelIndex{ scene.GetModelIndex(meshes[index]) };
+			if (modelIndex != lastModel)
+			{
+				passes[0].SetUniform(modelLocation, models[modelIndex].Transform);
+				lastModel = modelIndex;
+			}
+			passes[0].DrawElements(meshes[index].VertexArray, GL_TRIANGLES, meshes[index].IndexCount);
+		}
+
+		lastModel = noModel;
+		for (const auto index : renderList)
+		{
+			const auto& mesh{ meshes[index] };
+			const auto modelIndex{ scene.GetModelIndex(mesh) };
+			if (modelIndex != lastModel)
+			{
+				passes[1].SetUniform(modelLocation, models[modelIndex].Transform);
+				lastModel = modelIndex;
+			}
+			passes[1].BindTexture(0, GL_TEXTURE_2D, materials[scene.GetMaterialIndex(mesh)].Textures[PBRMaterial::ALBEDO]);
+			passes[1].DrawElements(mesh.VertexArray, GL_TRIANGLES, mesh.IndexCount);
+		}
+
+		lastModel = noModel;
+		for (const auto index : renderList)
+		{
+			const auto modelIndex{ scene.GetModelIndex(meshes[index]) };
+			if (modelIndex == lastModel)
+			{
+				continue;
+			}
+			lastModel = modelIndex;
+			passes[2].SetUniform(modelLocation, glm::translate(glm::mat4(1.0f), models[modelIndex].Bounds.getCenter()));
+			passes[2].SetUniform(selectedLocation, models[modelIndex].Selected ? 1 : 0);
+			passes[2].DrawArrays(1, GL_LINE_LOOP, 0, 16);
+		}
+	}
+
+	/***********************************************************************************/
+	// Handles of removed models must stop resolving, also once their slots hold new models.
+	bool checkSlotMapHandles()
+	{
+		Graphics::RenderScene scene;
+		std::vector<Graphics::ModelHandle> handles;
+		for (int i = 0; i < 8; ++i)
+		{
+			handles.push_back(scene.AddModel(Graphics::RenderModel{}));
+			scene.AddMesh({ static_cast<GLuint>(i), 3, handles.back(), {} });
+		}
+
+		scene.RemoveModel(handles[2]);
+		scene.RemoveModel(handles[5]);
+		const auto reused{ scene.AddModel(Graphics::RenderModel{}) };
+		scene.SetSelected(handles[5], true);
+
+		auto passed{ scene.GetModels().size() == 7 && scene.GetMeshes().size() == 6 && reused.Index == handles[5].Index &&
+			reused.Generation != handles[5].Generation };
+		for (const auto& model : scene.GetModels())
+		{
+			passed &= !model.Selected;
+		}
+		for (const auto& mesh : scene.GetMeshes())
+		{
+			passed &= mesh.VertexArray != 2 && mesh.VertexArray != 5 && scene.GetModelIndex(mesh) != SlotMap<Graphics::RenderModel>::InvalidIndex;
+		}
+
+		if (!passed)
+		{
+			std::cerr << "Render Storage Benchmark Error: Slot map handles resolve after their models were removed\n";
+		}
+		return passed;
+	}
+
+}
+
+namespace Tools
+{
+	/***********************************************************************************/
+	int BenchmarkRenderGraph()
+	{
+		constexpr std::array<std::array<GLsizei, 2>, 3> resolutions{ { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } } };
+		constexpr int iterations{ 10000 };
+		constexpr double megabyte{ 1024.0 * 1024.0 };
+
+		std::cout << "Render Graph Benchmark: deferred pipeline, declared and compiled per frame\n";
+		std::cout << fmt::format("  {:<10} {:>8} {:>7} {:>9} {:>9} {:>13} {:>13} {:>13} {:>11}\n",
+			"Resolution", "Shadows", "Passes", "Culled", "Textures", "Requested MB", "Allocated MB", "Saved MB", "Compile us");
+
+		RenderGraph graph;
+		auto passed{ true };
+		for (const auto& [width, height] : resolutions)
+		{
+			for (const auto enableShadows : { true, false })
+			{
+				graph.Reset(width, height);
+				const auto transients{ declareDeferredPipeline(graph, enableShadows) };
+				graph.Compile();
+
+				passed &= checkAliasing(graph, transients);
+				passed &= expectCulled(graph, "GBufferDebugView", true);
+				passed &= expectCulled(graph, "ShadowMap", !enableShadows);
+				passed &= expectCulled(graph, "Tonemap", false);
+
+				const auto start{ Clock::now() };
+				for (int i = 0; i < iterations; ++i)
+				{
+					graph.Reset(width, height);
+					declareDeferredPipeline(graph, enableShadows);
+					graph.Compile();
+				}
+				const auto microseconds{ std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations };
+
+				const auto& stats{ graph.GetStats() };
+				std::cout << fmt::format("  {:<10} {:>8} {:>7} {:>9} {:>4} -> {:<2} {:>13.1f} {:>13.1f} {:>6.1f} ({:>3.0f}%) {:>11.2f}\n",
+					fmt::format("{}x{}", width, height), enableShadows ? "on" : "off", stats.Passes, stats.CulledPasses,
+					stats.TransientTextures, stats.PhysicalTextures, stats.RequestedBytes / megabyte, stats.AllocatedBytes / megabyte,
+					stats.GetSavedBytes() / megabyte, 100.0 * stats.GetSavedBytes() / stats.RequestedBytes, microseconds);
+			}
+		}
+
+		std::cout << (passed ? "  All checks passed\n" : "  Checks FAILED\n");
+		return passed ? 0 : 1;
+	}
+
+	/***********************************************************************************/
+	int BenchmarkRenderCommands()
+	{
+		using Graphics::CommandBuffer;
+		using Graphics::NullRenderBackend;
+		using Graphics::RenderThread;
+
+		constexpr std::size_t numModels{ 5000 };
+		constexpr std::size_t numPasses{ 3 };
+		constexpr std::uint64_t numFrames{ 300 };
+
+		const auto models{ createSyntheticScene(numModels) };
+		auto& threadPool{ ThreadPool::GetInstance() };
+
+		std::cout << fmt::format("Render Command Benchmark: {} models, {} passes, {} frames against the null backend\n", numModels, numPasses, numFrames);
+		std::cout << fmt::format("  {:<28} {:>10} {:>10} {:>10} {:>10} {:>12} {:>10}\n",
+			"Mode", "ms/frame", "Record ms", "Replay ms", "Pacing ms", "Commands", "Arena KB");
+
+		const auto report = [](const std::string_view mode, const double total, const double record, const double replay, const double pacing,
+			const std::size_t commands, const std::size_t bytes) {
+			std::cout << fmt::format("  {:<28} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>12} {:>10.1f}\n",
+				mode, total / numFrames, record / numFrames, replay / numFrames, pacing / numFrames, commands, bytes / 1024.0);
+		};
+		const auto millisecondsSince = [](const Clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		};
+
+		// Recording and replaying on the calling thread, the way a single threaded renderer works
+		std::array<CommandBuffer, numPasses> passes;
+		// Grown once up front, so the first mode does not pay for the page faults
+		for (std::size_t pass = 0; pass < numPasses; ++pass)
+		{
+			recordSyntheticPass(passes[pass], pass, models, 0);
+		}
+
+		NullRenderBackend serialBackend;
+		NullRenderBackend::Stats reference;
+		auto passed{ true };
+		for (const auto parallel : { false, true })
+		{
+			serialBackend.ResetStats();
+			auto record{ 0.0 }, replay{ 0.0 };
+			std::size_t warmCapacity{ 0 };
+			const auto getCapacity = [&passes]() { return passes[0].GetCapacity() + passes[1].GetCapacity() + passes[2].GetCapacity(); };
+
+			const auto start{ Clock::now() };
+			for (std::uint64_t frame = 0; frame < numFrames; ++frame)
+			{
+				const auto recordStart{ Clock::now() };
+				threadPool.ParallelFor(numPasses, 1, [&](const std::size_t begin, const std::size_t end) {
+					for (auto pass = begin; pass < end; ++pass)
+					{
+						passes[pass].Reset();
+						recordSyntheticPass(passes[pass], pass, models, frame);
+					}
+				}, parallel ? 0 : 1);
+				record += millisecondsSince(recordStart);
+
+				const auto replayStart{ Clock::now() };
+				for (const auto& pass : passes)
+				{
+					serialBackend.Execute(pass);
+				}
+				serialBackend.InsertFence();
+				replay += millisecondsSince(replayStart);
+
+				// The first Reset after the arenas grew merges their chunks, from then on they must stay put
+				if (frame == 1)
+				{
+					warmCapacity = getCapacity();
+				}
+			}
+			const auto total{ millisecondsSince(start) };
+
+			const auto usedBytes{ passes[0].GetUsedBytes() + passes[1].GetUsedBytes() + passes[2].GetUsedBytes() };
+			if (getCapacity() != warmCapacity)
+			{
+				std::cerr << "Render Command Benchmark Error: Arenas grew from " << warmCapacity << " to " << getCapacity() << " bytes\n";
+				passed = false;
+			}
+
+			if (!parallel)
+			{
+				reference = serialBackend.GetStats();
+			}
+			passed &= expectSameReplay(parallel ? "Parallel recording" : "Serial recording", reference, serialBackend.GetStats());
+			report(parallel ? "Record parallel, replay" : "Record serial, replay", total, record, replay, 0.0,
+				serialBackend.GetStats().Commands / numFrames, usedBytes);
+		}
+
+		// Recording on this thread and the workers while the render thread replays the previous frames
+		for (const std::uint32_t framesInFlight : { 1u, 2u })
+		{
+			NullRenderBackend backend;
+			RenderThread renderThread;
+			renderThread.Start(backend, framesInFlight, numPasses);
+
+			auto record{ 0.0 };
+			std::size_t frameBytes{ 0 };
+			const auto start{ Clock::now() };
+			for (std::uint64_t frame = 0; frame < numFrames; ++frame)
+			{
+				auto& renderFrame{ renderThread.BeginFrame() };
+
+				const auto recordStart{ Clock::now() };
+				threadPool.ParallelFor(numPasses, 1, [&](const std::size_t begin, const std::size_t end) {
+					for (auto pass = begin; pass < end; ++pass)
+					{
+						recordSyntheticPass(renderFrame.Passes[pass], pass, models, renderFrame.Index);
+					}
+				});
+				record += millisecondsSince(recordStart);
+
+				frameBytes = renderFrame.Passes[0].GetUsedBytes() + renderFrame.Passes[1].GetUsedBytes() + renderFrame.Passes[2].GetUsedBytes();
+				renderThread.Submit();
+			}
+			const auto stats{ renderThread.GetStats() };
+			renderThread.Stop();
+			const auto total{ millisecondsSince(start) };
+
+			const auto mode{ fmt::format("Render thread, {} in flight", framesInFlight) };
+			passed &= expectSameReplay(mode, reference, backend.GetStats());
+			report(mode, total, record, stats.ReplayMilliseconds, stats.PacingMilliseconds, backend.GetStats().Commands / numFrames, frameBytes);
+		}
+
+		std::cout << (passed ? "  All checks passed\n" : "  Checks FAILED\n");
+		return passed ? 0 : 1;
+	}
+
+	/***********************************************************************************/
+	int BenchmarkRenderStorage()
+	{
+		using Graphics::CommandBuffer;
+		using Graphics::NullRenderBackend;
+
+		constexpr std::array<std::size_t, 3> sceneSizes{ 1000, 10000, 50000 };
+		constexpr int numFrames{ 50 };
+		// Larger than the last level caches, streamed through before a cold frame
+		constexpr std::size_t evictionBytes{ 64 * 1024 * 1024 };
+
+		std::cout << "Render Storage Benchmark: culling and recording 3 passes, ModelPtr list against RenderScene slot maps\n";
+		std::cout << fmt::format("  {:<8} {:>8} {:<10} {:>12} {:>12} {:>12} {:>12}\n",
+			"Models", "Visible", "Storage", "Warm ms", "Cold ms", "ns/model", "Speedup");
+
+		std::vector<std::uint8_t> eviction(evictionBytes, 1);
+		std::size_t evictionSum{ 0 };
+		const auto evictCaches = [&]() {
+			for (std::size_t i = 0; i < eviction.size(); i += 64)
+			{
+				evictionSum += eviction[i]++;
+			}
+		};
+
+		auto passed{ checkSlotMapHandles() };
+		for (const auto numModels : sceneSizes)
+		{
+			std::vector<LegacyModelPtr> legacy;
+			Graphics::RenderScene scene;
+			std::vector<std::unique_ptr<char[]>> loaderBlocks;
+			createStorageScenes(numModels, legacy, scene, loaderBlocks);
+
+			// Looking down the grid diagonally, so part of it is outside the frustum
+			const auto extent{ 4.0f * static_cast<float>(std::sqrt(static_cast<double>(numModels))) };
+			const auto view{ glm::lookAt(glm::vec3(-10.0f, 30.0f, -10.0f), glm::vec3(extent * 0.5f, 0.0f, extent * 0.3f), glm::vec3(0.0f, 1.0f, 0.0f)) };
+			const ViewFrustum frustum(view, glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 10000.0f));
+
+			LinearArena arena;
+			std::array<CommandBuffer, 3> passes;
+			std::array<NullRenderBackend::Stats, 2> replays;
+			std::array<double, 2> warm{}, cold{};
+
+			for (const auto slotMaps : { false, true })
+			{
+				const auto recordFrame = [&]() {
+					arena.Reset();
+					for (auto& pass : passes)
+					{
+						pass.Reset();
+					}
+					slotMaps ? recordSlotMapFrame(scene, frustum, arena, passes) : recordLegacyFrame(legacy, frustum, arena, passes);
+				};
+
+				// Warms the arenas, then replays one frame to compare what both storages record
+				recordFrame();
+				recordFrame();
+				NullRenderBackend backend;
+				for (const auto& pass : passes)
+				{
+					backend.Execute(pass);
+				}
+				replays[slotMaps] = backend.GetStats();
+
+				for (int frame = 0; frame < numFrames; ++frame)
+				{
+					evictCaches();
+					const auto coldStart{ Clock::now() };
+					recordFrame();
+					cold[slotMaps] += std::chrono::duration<double, std::milli>(Clock::now() - coldStart).count() / numFrames;
+
+					const auto warmStart{ Clock::now() };
+					recordFrame();
+					warm[slotMaps] += std::chrono::duration<double, std::milli>(Clock::now() - warmStart).count() / numFrames;
+				}
+			}
+
+			passed &= expectSameReplay(fmt::format("Slot maps with {} models", numModels), replays[0], replays[1]);
+
+			const auto visible{ replays[0].CommandsPerType[static_cast<std::size_t>(Graphics::RenderCommandType::DrawArrays)] };
+			for (const auto slotMaps : { false, true })
+			{
+				std::cout << fmt::format("  {:<8} {:>8} {:<10} {:>12.3f} {:>12.3f} {:>12.1f} {:>11.2f}x\n",
+					slotMaps ? "" : std::to_string(numModels), slotMaps ? "" : std::to_string(visible), slotMaps ? "Slot maps" : "ModelPtr",
+					warm[slotMaps], cold[slotMaps], 1e6 * cold[slotMaps] / numModels, slotMaps ? cold[0] / cold[1] : 1.0);
+			}
+		}
+
+		// Keeps the eviction loop from being optimized away
+		if (evictionSum == 0)
+		{
+			std::cout << "  Eviction buffer untouched\n";
+		}
+		std::cout << "  Cold frames start with the scene evicted from the caches, as after the rest of a frame ran; speedup compares them\n";
+		std::cout << (passed ? "  All checks passed\n" : "  Checks FAILED\n");
+		return passed ? 0 : 1;
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace Tools
+{
+	// Compiles a deferred pipeline (shadows, G-buffer, SSAO, bloom, tonemap, FXAA) with the render graph at several
+	// resolutions without a GL context. Checks pass culling and that aliased textures never overlap, and reports
+	// the memory aliasing saves and the compile time. Returns 1 if a check fails.
+	int BenchmarkRenderGraph();
+
+	// Records the draws of a synthetic scene into command buffers every frame, serially, on the workers and
+	// with a RenderThread replaying them (one and two frames in flight) through the null backend. Checks every
+	// mode replays exactly the commands of the serial one and that the arenas stop growing. Returns 1 on failure.
+	int BenchmarkRenderCommands();
+
+	// Culls and records a grid of models (1k, 10k and 50k, four meshes each) from heap allocated ModelPtrs, as the
+	// engine used to, and from a RenderScene's slot maps, with warm caches and with the caches evicted before each
+	// frame. Checks both record the same commands and that handles of removed models stop resolving.
+	// Returns 1 on failure.
+	int BenchmarkRenderStorage();
+}
@@ -0,0 +1,241 @@
+#include "TextureTools.h"
+
+#include "../graphics/KTX2.h"
+#include "../graphics/MipGenerator.h"
+#include "../graphics/TextureCache.h"
+#include "../core/ThreadPool.h"
+#include "../Platform/SIMD.h"
+
+#include <fmt/core.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	/***********************************************************************************/
+	std::vector<std::filesystem::path> findImages(const std::filesystem::path& directory)
+	{
+		constexpr std::array extensions{ ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+
+		std::vector<std::filesystem::path> images;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+		{
+			auto extension{ entry.path().extension().string() };
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+			if (entry.is_regular_file() && std::find(extensions.begin(), extensions.end(), extension) != extensions.end())
+			{
+				images.push_back(entry.path());
+			}
+		}
+
+		// Deterministic order regardless of the file system.
+		std::sort(images.begin(), images.end());
+
+		return images;
+	}
+
+	/***********************************************************************************/
+	double secondsSince(const Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	/***********************************************************************************/
+	// Smooth gradients with high frequency detail and a cut-out alpha channel.
+	std::vector<std::uint8_t> makeTestPattern(const std::uint32_t width, const std::uint32_t height)
+	{
+		std::vector<std::uint8_t> pattern(static_cast<std::size_t>(width) * height * 4);
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			for (std::uint32_t x = 0; x < width; ++x)
+			{
+				auto* pixel{ &pattern[(static_cast<std::size_t>(y) * width + x) * 4] };
+				pixel[0] = static_cast<std::uint8_t>(x * 255 / width);
+				pixel[1] = static_cast<std::uint8_t>(y * 255 / height);
+				pixel[2] = static_cast<std::uint8_t>(((x / 4) ^ (y / 4)) & 1 ? 220 : 30);
+				pixel[3] = static_cast<std::uint8_t>(((x * 7 + y * 13) % 97) < 40 ? 255 : 0);
+			}
+		}
+		return pattern;
+	}
+}
+
+namespace Tools
+{
+	/***********************************************************************************/
+	int BakeTextures(const std::filesystem::path& directory)
+	{
+		const auto images{ findImages(directory) };
+		if (images.empty())
+		{
+			std::cerr << "Texture Baker: No images found in " << directory << '\n';
+			return 1;
+		}
+
+		std::cout << fmt::format("Texture Baker: {} images, {} threads\n", images.size(), ThreadPool::GetInstance().GetNumThreads());
+
+		const auto totalStart{ Clock::now() };
+		std::size_t numFailed{ 0 };
+		for (const auto& image : images)
+		{
+			const auto start{ Clock::now() };
+			const auto usage{ Graphics::GuessTextureUsage(image) };
+			const auto target{ Graphics::BuildTextureCachePath(image, usage) };
+			const auto texture{ target ? Graphics::BakeTexture(image, usage) : std::nullopt };
+			if (!texture || !Graphics::WriteKTX2(*target, Graphics::ToKTX2(*texture)))
+			{
+				++numFailed;
+				continue;
+			}
+
+			std::cout << fmt::format("  {:<48} {} {:>5}x{:<5} {:>2} mips {:>8.1f} ms\n", image.filename().string(), Graphics::GetFormatName(texture->Format),
+				texture->Mips.front().Width, texture->Mips.front().Height, texture->Mips.size(), secondsSince(start) * 1000.0);
+		}
+
+		std::cout << fmt::format("Texture Baker: Done in {:.2f} s, {} failed\n", secondsSince(totalStart), numFailed);
+
+		return numFailed == 0 ? 0 : 1;
+	}
+
+	/***********************************************************************************/
+	int BenchmarkTextures(const std::filesystem::path& directory)
+	{
+		constexpr std::array formats{ Graphics::BlockFormat::BC1, Graphics::BlockFormat::BC3, Graphics::BlockFormat::BC4, Graphics::BlockFormat::BC5, Graphics::BlockFormat::BC7 };
+
+		struct FormatStats {
+			double Seconds{ 0.0 };
+			double PSNRSum{ 0.0 };
+			double MinPSNR{ 1000.0 };
+			std::size_t NumPixels{ 0 };
+			std::size_t NumImages{ 0 };
+		};
+		std::array<FormatStats, formats.size()> stats;
+
+		const auto images{ findImages(directory) };
+		if (images.empty())
+		{
+			std::cerr << "Texture Benchmark: No images found in " << directory << '\n';
+			return 1;
+		}
+
+		std::cout << fmt::format("Texture Benchmark: {} images, {} threads\n", images.size(), ThreadPool::GetInstance().GetNumThreads());
+
+		bool deterministic{ true };
+		for (const auto& image : images)
+		{
+			int width = 0, height = 0, nrComponents = 0;
+			auto* data{ stbi_load(image.string().c_str(), &width, &height, &nrComponents, 4) };
+			if (!data)
+			{
+				continue;
+			}
+
+			for (std::size_t i = 0; i < formats.size(); ++i)
+			{
+				const auto w{ static_cast<std::uint32_t>(width) };
+				const auto h{ static_cast<std::uint32_t>(height) };
+
+				const auto start{ Clock::now() };
+				const auto blocks{ Graphics::CompressImage(data, w, h, formats[i]) };
+				stats[i].Seconds += secondsSince(start);
+
+				const auto decoded{ Graphics::DecompressImage(blocks.data(), w, h, formats[i]) };
+				const auto psnr{ std::min(Graphics::ComputePSNR(data, decoded.data(), w, h, formats[i]), 99.0) };
+				stats[i].PSNRSum += psnr;
+				stats[i].MinPSNR = std::min(stats[i].MinPSNR, psnr);
+				stats[i].NumPixels += static_cast<std::size_t>(width) * height;
+				++stats[i].NumImages;
+
+				deterministic &= Graphics::CompressImage(data, w, h, formats[i]) == blocks;
+			}
+
+			stbi_image_free(data);
+		}
+
+		std::cout << fmt::format("  {:<6} {:>10} {:>10} {:>10}\n", "Format", "MPix/s", "Avg PSNR", "Min PSNR");
+		for (std::size_t i = 0; i < formats.size(); ++i)
+		{
+			if (stats[i].NumImages == 0)
+			{
+				continue;
+			}
+
+			std::cout << fmt::format("  {:<6} {:>10.1f} {:>10.2f} {:>10.2f}\n", Graphics::GetFormatName(formats[i]),
+				stats[i].NumPixels / stats[i].Seconds / 1.0e6, stats[i].PSNRSum / stats[i].NumImages, stats[i].MinPSNR);
+		}
+		std::cout << "Texture Benchmark: Output is " << (deterministic ? "deterministic" : "NOT deterministic") << '\n';
+
+		return deterministic ? 0 : 1;
+	}
+
+	/***********************************************************************************/
+	int BenchmarkMips(const std::filesystem::path& image)
+	{
+		constexpr int numRuns{ 3 };
+
+		std::uint32_t width{ 4096 }, height{ 4096 };
+		std::vector<std::uint8_t> pixels;
+		if (image.empty())
+		{
+			pixels = makeTestPattern(width, height);
+		}
+		else
+		{
+			int w = 0, h = 0, nrComponents = 0;
+			auto* data{ stbi_load(image.string().c_str(), &w, &h, &nrComponents, 4) };
+			if (!data)
+			{
+				std::cerr << "Mip Benchmark: Failed to load " << image << '\n';
+				return 1;
+			}
+			width = static_cast<std::uint32_t>(w);
+			height = static_cast<std::uint32_t>(h);
+			pixels.assign(data, data + static_cast<std::size_t>(w) * h * 4);
+			stbi_image_free(data);
+		}
+
+		std::cout << fmt::format("Mip Benchmark: {}x{}, {} threads, AVX2 {}\n", width, height, ThreadPool::GetInstance().GetNumThreads(),
+			Platform::HasAVX2() ? "available" : "not available");
+		std::cout << fmt::format("  {:<8} {:<6} {:>10} {:>10}\n", "Filter", "ISA", "ms", "MPix/s");
+
+		for (const auto filter : { Graphics::MipFilter::Box, Graphics::MipFilter::Kaiser })
+		{
+			for (const auto allowAVX2 : { false, true })
+			{
+				if (allowAVX2 && !Platform::HasAVX2())
+				{
+					continue;
+				}
+
+				Graphics::MipSettings settings;
+				settings.Filter = filter;
+				settings.PreserveAlphaCoverage = true;
+				settings.AllowAVX2 = allowAVX2;
+
+				auto best{ 1.0e9 };
+				for (int run = 0; run < numRuns; ++run)
+				{
+					const auto start{ Clock::now() };
+					const auto chain{ Graphics::GenerateMipChain(pixels.data(), width, height, settings) };
+					best = std::min(best, secondsSince(start));
+				}
+
+				std::cout << fmt::format("  {:<8} {:<6} {:>10.2f} {:>10.1f}\n", filter == Graphics::MipFilter::Box ? "Box" : "Kaiser",
+					allowAVX2 ? "AVX2" : "SSE2", best * 1000.0, static_cast<double>(width) * height / best / 1.0e6);
+			}
+		}
+
+		return 0;
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <filesystem>
+
+namespace Tools
+{
+	// Compresses every image below directory (usage guessed from the file name) into the texture cache.
+	int BakeTextures(const std::filesystem::path& directory);
+
+	// Encodes every image below directory in each block format and reports throughput and PSNR.
+	// Also checks that repeated encodes are bit-identical.
+	int BenchmarkTextures(const std::filesystem::path& directory);
+
+	// Times mip chain generation for each filter and instruction set. Without an image a
+	// 4096x4096 test pattern is used.
+	int BenchmarkMips(const std::filesystem::path& image);
+}
@@ -0,0 +1,112 @@
+#include "Tools.h"
+
+#include "TextureTools.h"
+#include "ProfilerTools.h"
+#include "GeometryTools.h"
+#include "RenderTools.h"
+
+#include <iostream>
+#include <string_view>
+
+namespace
+{
+	/***********************************************************************************/
+	void printUsage()
+	{
+		std::cout << "Usage: GraphicsEngine [tool] [arguments]\n"
+			<< "  --help                         This list\n"
+			<< "  --bake-textures <directory>    Compress every image below directory into Data/cache/textures\n"
+			<< "  --bench-textures <directory>   Encoder throughput and PSNR for every block format\n"
+			<< "  --bench-mips [image]           Mip generation time per filter and instruction set (4K pattern by default)\n"
+			<< "  --bench-profiler               Cost of a CPU profile zone\n"
+			<< "  --bench-ao [model]             Ambient occlusion bake time per thread count (Sponza by default)\n"
+			<< "  --bench-gltf [model]           glTF load time through Assimp and the native loader (Sponza by default)\n"
+			<< "  --bench-obj [model]            OBJ load time through Assimp and the native loader (Crytek Sponza by default)\n"
+			<< "  --bench-meshlets [model]       Triangles left by meshlet culling per view and its cost (Crytek Sponza by default)\n"
+			<< "  --bench-render-graph           Render graph culling, aliasing savings and compile time\n"
+			<< "  --bench-render-commands        Command recording and replay, on one thread and with a render thread\n"
+			<< "  --bench-render-storage         Culling and recording from ModelPtrs against slot maps, warm and cold caches\n";
+	}
+}
+
+namespace Tools
+{
+	/***********************************************************************************/
+	std::optional<int> Run(const int argc, char** argv)
+	{
+		if (argc < 2)
+		{
+			return std::nullopt;
+		}
+
+		// Anything else is left to the engine
+		const std::string_view tool{ argv[1] };
+		if (tool.substr(0, 2) != "--")
+		{
+			return std::nullopt;
+		}
+		const std::string_view argument{ argc > 2 ? argv[2] : "" };
+
+		if (tool == "--help")
+		{
+			printUsage();
+			return 0;
+		}
+
+		if (tool == "--bake-textures")
+		{
+			return BakeTextures(argument.empty() ? "Data/Models" : argument);
+		}
+		if (tool == "--bench-textures")
+		{
+			return BenchmarkTextures(argument.empty() ? "Data/Models/crytek-sponza" : argument);
+		}
+
+		if (tool == "--bench-mips")
+		{
+			return BenchmarkMips(argument);
+		}
+
+		if (tool == "--bench-profiler")
+		{
+			return BenchmarkProfiler();
+		}
+
+		if (tool == "--bench-ao")
+		{
+			return BenchmarkAmbientOcclusion(argument.empty() ? "Data/Models/gltf/sponza/Sponza.gltf" : argument);
+		}
+
+		if (tool == "--bench-gltf")
+		{
+			return BenchmarkModelLoading(argument.empty() ? "Data/Models/gltf/sponza/Sponza.gltf" : argument);
+		}
+
+		if (tool == "--bench-obj")
+		{
+			return BenchmarkModelLoading(argument.empty() ? "Data/Models/crytek-sponza/sponza.obj" : argument);
+		}
+
+		if (tool == "--bench-meshlets")
+		{
+			return BenchmarkMeshlets(argument.empty() ? "Data/Models/crytek-sponza/sponza.obj" : argument);
+		}
+
+		if (tool == "--bench-render-graph")
+		{
+			return BenchmarkRenderGraph();
+		}
+
+		if (tool == "--bench-render-commands")
+		{
+			return BenchmarkRenderCommands();
+		}
+
+		if (tool == "--bench-render-storage")
+		{
+			return BenchmarkRenderStorage();
+		}
+
+		return std::nullopt;
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <optional>
+
+// Offline utilities and benchmarks reachable from the command line, e.g.
+//   GraphicsEngine --bake-textures Data/Models
+//   GraphicsEngine --bench-textures Data/Models/crytek-sponza
+namespace Tools
+{
+	// Runs the tool argv[1] names, "--help" lists them. Empty if argv[1] names no tool and the engine should start
+	// normally.
+	std::optional<int> Run(const int argc, char** argv);
+}
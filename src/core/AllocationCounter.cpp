@@ -0,0 +1,120 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<std::uint64_t> s_numAllocations{ 0 };
+	std::atomic<std::uint64_t> s_numBytes{ 0 };
+}
+
+/***********************************************************************************/
+std::uint64_t AllocationCounter::GetNumAllocations() noexcept
+{
+	return s_numAllocations.load(std::memory_order_relaxed);
+}
+
+/***********************************************************************************/
+std::uint64_t AllocationCounter::GetNumBytes() noexcept
+{
+	return s_numBytes.load(std::memory_order_relaxed);
+}
+
+#ifdef GE_COUNT_ALLOCATIONS
+
+namespace
+{
+	/***********************************************************************************/
+	void* countedAllocate(const std::size_t size, const std::size_t alignment) noexcept
+	{
+		s_numAllocations.fetch_add(1, std::memory_order_relaxed);
+		s_numBytes.fetch_add(size, std::memory_order_relaxed);
+
+		const auto bytes{ size == 0 ? 1 : size };
+		if (alignment <= alignof(std::max_align_t))
+		{
+			return std::malloc(bytes);
+		}
+#ifdef _WIN32
+		return _aligned_malloc(bytes, alignment);
+#else
+		// aligned_alloc wants a multiple of the alignment
+		return std::aligned_alloc(alignment, (bytes + alignment - 1) & ~(alignment - 1));
+#endif
+	}
+
+	/***********************************************************************************/
+	void countedFree(void* memory, const std::size_t alignment) noexcept
+	{
+#ifdef _WIN32
+		if (alignment > alignof(std::max_align_t))
+		{
+			_aligned_free(memory);
+			return;
+		}
+#endif
+		(void)alignment;
+		std::free(memory);
+	}
+
+	/***********************************************************************************/
+	// Calls the new handler until the allocation succeeds, as the standard operators do
+	void* countedNew(const std::size_t size, const std::size_t alignment)
+	{
+		for (;;)
+		{
+			if (auto* memory{ countedAllocate(size, alignment) })
+			{
+				return memory;
+			}
+
+			const auto handler{ std::get_new_handler() };
+			if (handler == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+			handler();
+		}
+	}
+
+	/***********************************************************************************/
+	void* countedNewNoThrow(const std::size_t size, const std::size_t alignment) noexcept
+	{
+		try
+		{
+			return countedNew(size, alignment);
+		} catch (...)
+		{
+			return nullptr;
+		}
+	}
+
+	constexpr std::size_t DefaultAlignment{ alignof(std::max_align_t) };
+}
+
+void* operator new(std::size_t size) { return countedNew(size, DefaultAlignment); }
+void* operator new[](std::size_t size) { return countedNew(size, DefaultAlignment); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedNewNoThrow(size, DefaultAlignment); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedNewNoThrow(size, DefaultAlignment); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedNew(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedNew(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return countedNewNoThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return countedNewNoThrow(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* memory) noexcept { countedFree(memory, DefaultAlignment); }
+void operator delete[](void* memory) noexcept { countedFree(memory, DefaultAlignment); }
+void operator delete(void* memory, std::size_t) noexcept { countedFree(memory, DefaultAlignment); }
+void operator delete[](void* memory, std::size_t) noexcept { countedFree(memory, DefaultAlignment); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { countedFree(memory, DefaultAlignment); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { countedFree(memory, DefaultAlignment); }
+void operator delete(void* memory, std::align_val_t alignment) noexcept { countedFree(memory, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* memory, std::align_val_t alignment) noexcept { countedFree(memory, static_cast<std::size_t>(alignment)); }
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept { countedFree(memory, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* memory, std::size_t, std::align_val_t alignment) noexcept { countedFree(memory, static_cast<std::size_t>(alignment)); }
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept { countedFree(memory, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept { countedFree(memory, static_cast<std::size_t>(alignment)); }
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts the heap allocations made through the global operator new, on every thread. With GE_COUNT_ALLOCATIONS
+// defined AllocationCounter.cpp replaces the operators with ones that count and forward to malloc; without it
+// nothing is replaced and the counts stay 0.
+namespace AllocationCounter
+{
+	constexpr bool IsEnabled() noexcept
+	{
+#ifdef GE_COUNT_ALLOCATIONS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// Totals since the program started. Compare two reads to count the allocations in between.
+	std::uint64_t GetNumAllocations() noexcept;
+	std::uint64_t GetNumBytes() noexcept;
+}
@@ -0,0 +1,166 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace
+{
+	/***********************************************************************************/
+	std::string getKey(const std::filesystem::path& path)
+	{
+		return path.lexically_normal().generic_string();
+	}
+}
+
+/***********************************************************************************/
+bool FileWatcher::Init()
+{
+	if (m_initialized)
+	{
+		return true;
+	}
+
+#ifdef __linux__
+	m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotify == -1)
+	{
+		std::cerr << "FileWatcher Error: inotify_init1 failed: " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	m_eventBuffer.resize(16 * 1024);
+#else
+	m_lastPoll = std::chrono::steady_clock::now();
+#endif
+
+	m_initialized = true;
+	return true;
+}
+
+/***********************************************************************************/
+void FileWatcher::Shutdown()
+{
+#ifdef __linux__
+	if (m_inotify != -1)
+	{
+		close(m_inotify);
+		m_inotify = -1;
+	}
+	m_directories.clear();
+#endif
+
+	m_files.clear();
+	m_initialized = false;
+}
+
+/***********************************************************************************/
+void FileWatcher::Watch(const std::filesystem::path& path)
+{
+	if (!m_initialized)
+	{
+		return;
+	}
+
+	const auto key{ getKey(path) };
+	if (m_files.count(key) != 0)
+	{
+		return;
+	}
+
+	std::error_code error;
+	m_files.try_emplace(key, WatchedFile{ path, std::filesystem::last_write_time(path, error) });
+
+#ifdef __linux__
+	auto directory{ path.lexically_normal().parent_path() };
+	if (directory.empty())
+	{
+		directory = ".";
+	}
+
+	// inotify returns the existing descriptor for a directory that is already watched
+	const auto wd{ inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) };
+	if (wd == -1)
+	{
+		std::cerr << "FileWatcher Error: Cannot watch " << directory.generic_string() << ": " << std::strerror(errno) << std::endl;
+		return;
+	}
+
+	m_directories.try_emplace(wd, directory);
+#endif
+}
+
+/***********************************************************************************/
+std::vector<std::filesystem::path> FileWatcher::Poll()
+{
+	std::vector<std::filesystem::path> changed;
+	if (!m_initialized)
+	{
+		return changed;
+	}
+
+	const auto addChanged = [&changed](const std::filesystem::path& path) {
+		if (std::find(changed.cbegin(), changed.cend(), path) == changed.cend())
+		{
+			changed.push_back(path);
+		}
+	};
+
+#ifdef __linux__
+	for (;;)
+	{
+		const auto length{ read(m_inotify, m_eventBuffer.data(), m_eventBuffer.size()) };
+		if (length <= 0)
+		{
+			// EAGAIN: no more events
+			break;
+		}
+
+		for (auto offset = 0; offset < length;)
+		{
+			inotify_event event;
+			std::memcpy(&event, m_eventBuffer.data() + offset, sizeof(event));
+			const auto* name{ m_eventBuffer.data() + offset + sizeof(inotify_event) };
+			offset += static_cast<int>(sizeof(inotify_event) + event.len);
+
+			const auto directory{ m_directories.find(event.wd) };
+			if (event.len == 0 || directory == m_directories.cend())
+			{
+				continue;
+			}
+
+			if (const auto file{ m_files.find(getKey(directory->second / name)) }; file != m_files.cend())
+			{
+				addChanged(file->second.Path);
+			}
+		}
+	}
+#else
+	const auto now{ std::chrono::steady_clock::now() };
+	if (now - m_lastPoll < PollInterval)
+	{
+		return changed;
+	}
+	m_lastPoll = now;
+
+	for (auto& [key, file] : m_files)
+	{
+		std::error_code error;
+		const auto modifiedTime{ std::filesystem::last_write_time(file.Path, error) };
+		if (!error && modifiedTime != file.ModifiedTime)
+		{
+			file.ModifiedTime = modifiedTime;
+			addChanged(file.Path);
+		}
+	}
+#endif
+
+	return changed;
+}
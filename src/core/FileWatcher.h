@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports watched files that changed on disk, without blocking. Uses inotify on Linux and watches the
+// directories of the files, since many editors save by writing a new file and renaming it over the old one.
+// Elsewhere the modification times of the watched files are compared every PollInterval.
+class FileWatcher {
+public:
+	FileWatcher() = default;
+	~FileWatcher() { Shutdown(); }
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool Init();
+	void Shutdown();
+
+	// Watching a file twice is harmless.
+	void Watch(const std::filesystem::path& path);
+
+	// Watched files written since the last call, each reported once, as passed to Watch.
+	std::vector<std::filesystem::path> Poll();
+
+private:
+	static constexpr std::chrono::milliseconds PollInterval{ 250 };
+
+	struct WatchedFile {
+		std::filesystem::path Path;
+		std::filesystem::file_time_type ModifiedTime;
+	};
+
+	// Keyed by the normalized path
+	std::unordered_map<std::string, WatchedFile> m_files;
+	bool m_initialized{ false };
+
+#ifdef __linux__
+	int m_inotify{ -1 };
+	// Watch descriptor to directory
+	std::unordered_map<int, std::filesystem::path> m_directories;
+	std::vector<char> m_eventBuffer;
+#else
+	std::chrono::steady_clock::time_point m_lastPoll;
+#endif
+};
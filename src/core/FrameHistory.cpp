@@ -0,0 +1,376 @@
+#include "FrameHistory.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	/***********************************************************************************/
+	float percentile(std::vector<float>& values, const float fraction)
+	{
+		const auto n{ static_cast<std::size_t>(fraction * static_cast<float>(values.size() - 1) + 0.5f) };
+		std::nth_element(values.begin(), values.begin() + n, values.end());
+		return values[n];
+	}
+
+	/***********************************************************************************/
+	FrameHistory::Percentiles computePercentiles(std::vector<float>& values)
+	{
+		if (values.empty())
+		{
+			return {};
+		}
+
+		FrameHistory::Percentiles result;
+		result.Max = *std::max_element(values.cbegin(), values.cend());
+		result.P99 = percentile(values, 0.99f);
+		result.P95 = percentile(values, 0.95f);
+		result.P50 = percentile(values, 0.50f);
+
+		return result;
+	}
+
+	/***********************************************************************************/
+	bool createParentDirectories(const std::filesystem::path& path)
+	{
+		std::error_code ec;
+		if (path.has_parent_path())
+		{
+			std::filesystem::create_directories(path.parent_path(), ec);
+		}
+		return !ec;
+	}
+}
+
+/***********************************************************************************/
+std::string_view GetFramePhaseName(const FramePhase phase) noexcept
+{
+	switch (phase)
+	{
+	case FramePhase::Input:			return "Input";
+	case FramePhase::Camera:		return "Camera";
+	case FramePhase::SceneUpdate:	return "SceneUpdate";
+	case FramePhase::RenderUpdate:	return "RenderUpdate";
+	case FramePhase::Culling:		return "Culling";
+	case FramePhase::Render:		return "Render";
+	case FramePhase::GUI:			return "GUI";
+	case FramePhase::Picking:		return "Picking";
+	case FramePhase::Present:		return "Present";
+	default:						return "Unknown";
+	}
+}
+
+/***********************************************************************************/
+FrameHistory::FrameHistory() : FrameHistory(Settings{})
+{
+}
+
+/***********************************************************************************/
+FrameHistory::FrameHistory(const Settings& settings)
+{
+	SetSettings(settings);
+	m_spikes.reserve(MaxSpikes);
+}
+
+/***********************************************************************************/
+void FrameHistory::SetSettings(const Settings& settings)
+{
+	m_settings = settings;
+	m_settings.Capacity = std::max<std::size_t>(m_settings.Capacity, MedianInterval);
+
+	m_frames.assign(m_settings.Capacity, {});
+	// Refreshing the medians never allocates
+	m_medianScratch.reserve(m_settings.Capacity);
+	Clear();
+}
+
+/***********************************************************************************/
+void FrameHistory::Clear()
+{
+	m_first = 0;
+	m_numFrames = 0;
+
+	m_medianCPU = 0.0f;
+	m_medianGPU = 0.0f;
+	m_medianPhases.fill(0.0f);
+
+	m_spikes.clear();
+	m_totalSpikes = 0;
+}
+
+/***********************************************************************************/
+void FrameHistory::BeginFrame()
+{
+	m_current = {};
+	m_current.Index = m_nextFrameIndex;
+	m_frameStart = Clock::now();
+}
+
+/***********************************************************************************/
+void FrameHistory::EndFrame()
+{
+	m_current.CPUMilliseconds = std::chrono::duration<float, std::milli>(Clock::now() - m_frameStart).count();
+
+	if (m_numFrames < m_frames.size())
+	{
+		++m_numFrames;
+	} else
+	{
+		m_first = (m_first + 1) % m_frames.size();
+	}
+	frameAt(m_numFrames - 1) = m_current;
+	++m_nextFrameIndex;
+
+	if (m_numFrames == MedianInterval || m_current.Index % MedianInterval == 0)
+	{
+		updateMedians();
+	}
+
+	// Not enough history yet to know what a normal frame looks like
+	if (m_numFrames < MedianInterval)
+	{
+		return;
+	}
+
+	const auto threshold{ std::max(m_settings.SpikeMinMilliseconds, m_settings.SpikeFactor * m_medianCPU) };
+	if (m_current.CPUMilliseconds <= threshold)
+	{
+		return;
+	}
+
+	Spike spike;
+	spike.Frame = m_current.Index;
+	spike.Milliseconds = m_current.CPUMilliseconds;
+	spike.MedianMilliseconds = m_medianCPU;
+	auto largestExcess{ -1.0f };
+	for (std::size_t phase = 0; phase < NumPhases; ++phase)
+	{
+		const auto excess{ m_current.PhaseMilliseconds[phase] - m_medianPhases[phase] };
+		if (excess > largestExcess)
+		{
+			largestExcess = excess;
+			spike.Cause = GetFramePhaseName(static_cast<FramePhase>(phase));
+			spike.CauseMilliseconds = m_current.PhaseMilliseconds[phase];
+		}
+	}
+
+	addSpike(spike);
+}
+
+/***********************************************************************************/
+void FrameHistory::addPhaseTime(const FramePhase phase, const Clock::duration duration) noexcept
+{
+	m_current.PhaseMilliseconds[static_cast<std::size_t>(phase)] += std::chrono::duration<float, std::milli>(duration).count();
+}
+
+/***********************************************************************************/
+void FrameHistory::addGPUFrame()
+{
+	const auto frameIndex{ m_nextGPUFrameIndex++ };
+
+	auto gpuMilliseconds{ 0.0f };
+	for (const auto& pass : m_gpuPassScratch)
+	{
+		gpuMilliseconds += pass.Milliseconds;
+	}
+
+	// The frame may already have left the history
+	if (m_numFrames == 0)
+	{
+		return;
+	}
+	const auto oldestIndex{ frameAt(0).Index };
+	if (frameIndex < oldestIndex || frameIndex - oldestIndex >= m_numFrames)
+	{
+		return;
+	}
+	frameAt(frameIndex - oldestIndex).GPUMilliseconds = gpuMilliseconds;
+
+	const auto isSpike{ m_numFrames >= MedianInterval && m_medianGPU > 0.0f &&
+		gpuMilliseconds > std::max(m_settings.SpikeMinMilliseconds, m_settings.SpikeFactor * m_medianGPU) };
+
+	if (isSpike)
+	{
+		Spike spike;
+		spike.Frame = frameIndex;
+		spike.GPU = true;
+		spike.Milliseconds = gpuMilliseconds;
+		spike.MedianMilliseconds = m_medianGPU;
+		auto largestExcess{ -1.0f };
+		for (const auto& pass : m_gpuPassScratch)
+		{
+			const auto average{ std::find_if(m_gpuPassAverages.cbegin(), m_gpuPassAverages.cend(), [&](const auto& p) { return p.Name == pass.Name; }) };
+			const auto excess{ pass.Milliseconds - (average == m_gpuPassAverages.cend() ? 0.0f : average->Milliseconds) };
+			if (excess > largestExcess)
+			{
+				largestExcess = excess;
+				spike.Cause = pass.Name;
+				spike.CauseMilliseconds = pass.Milliseconds;
+			}
+		}
+
+		addSpike(spike);
+		return;
+	}
+
+	// Spikes stay out of the averages so they keep describing a normal frame
+	constexpr float smoothing{ 0.05f };
+	for (const auto& pass : m_gpuPassScratch)
+	{
+		auto average{ std::find_if(m_gpuPassAverages.begin(), m_gpuPassAverages.end(), [&](const auto& p) { return p.Name == pass.Name; }) };
+		if (average == m_gpuPassAverages.end())
+		{
+			m_gpuPassAverages.push_back(pass);
+		} else
+		{
+			average->Milliseconds += smoothing * (pass.Milliseconds - average->Milliseconds);
+		}
+	}
+}
+
+/***********************************************************************************/
+void FrameHistory::updateMedians()
+{
+	auto& values{ m_medianScratch };
+	values.clear();
+	for (std::size_t i = 0; i < m_numFrames; ++i)
+	{
+		values.push_back(frameAt(i).CPUMilliseconds);
+	}
+	m_medianCPU = computePercentiles(values).P50;
+
+	for (std::size_t phase = 0; phase < NumPhases; ++phase)
+	{
+		values.clear();
+		for (std::size_t i = 0; i < m_numFrames; ++i)
+		{
+			values.push_back(frameAt(i).PhaseMilliseconds[phase]);
+		}
+		m_medianPhases[phase] = computePercentiles(values).P50;
+	}
+
+	values.clear();
+	for (std::size_t i = 0; i < m_numFrames; ++i)
+	{
+		if (const auto gpu{ frameAt(i).GPUMilliseconds }; gpu >= 0.0f)
+		{
+			values.push_back(gpu);
+		}
+	}
+	m_medianGPU = computePercentiles(values).P50;
+}
+
+/***********************************************************************************/
+void FrameHistory::addSpike(const Spike& spike)
+{
+	if (m_spikes.size() == MaxSpikes)
+	{
+		m_spikes.erase(m_spikes.begin());
+	}
+	m_spikes.push_back(spike);
+	++m_totalSpikes;
+}
+
+/***********************************************************************************/
+FrameHistory::Frame& FrameHistory::frameAt(const std::size_t i) noexcept
+{
+	return m_frames[(m_first + i) % m_frames.size()];
+}
+
+/***********************************************************************************/
+const FrameHistory::Frame& FrameHistory::GetFrame(const std::size_t i) const noexcept
+{
+	return m_frames[(m_first + i) % m_frames.size()];
+}
+
+/***********************************************************************************/
+FrameHistory::Percentiles FrameHistory::GetCPUPercentiles() const
+{
+	std::vector<float> values;
+	values.reserve(m_numFrames);
+	for (std::size_t i = 0; i < m_numFrames; ++i)
+	{
+		values.push_back(GetFrame(i).CPUMilliseconds);
+	}
+
+	return computePercentiles(values);
+}
+
+/***********************************************************************************/
+FrameHistory::Percentiles FrameHistory::GetGPUPercentiles() const
+{
+	std::vector<float> values;
+	values.reserve(m_numFrames);
+	for (std::size_t i = 0; i < m_numFrames; ++i)
+	{
+		if (const auto gpu{ GetFrame(i).GPUMilliseconds }; gpu >= 0.0f)
+		{
+			values.push_back(gpu);
+		}
+	}
+
+	return computePercentiles(values);
+}
+
+/***********************************************************************************/
+bool FrameHistory::Export(const std::filesystem::path& basePath) const
+{
+	auto csvPath{ basePath };
+	csvPath += ".csv";
+	auto jsonPath{ basePath };
+	jsonPath += ".json";
+
+	createParentDirectories(basePath);
+
+	std::ofstream csv(csvPath);
+	std::ofstream json(jsonPath);
+	if (!csv || !json)
+	{
+		std::cerr << "FrameHistory Error: Failed to write " << basePath.string() << ".csv/.json" << std::endl;
+		return false;
+	}
+
+	csv << "frame,cpu_ms,gpu_ms";
+	for (std::size_t phase = 0; phase < NumPhases; ++phase)
+	{
+		csv << ',' << GetFramePhaseName(static_cast<FramePhase>(phase)) << "_ms";
+	}
+	csv << '\n';
+
+	for (std::size_t i = 0; i < m_numFrames; ++i)
+	{
+		const auto& frame{ GetFrame(i) };
+		csv << fmt::format("{},{:.4f},{:.4f}", frame.Index, frame.CPUMilliseconds, frame.GPUMilliseconds);
+		for (const auto phaseMilliseconds : frame.PhaseMilliseconds)
+		{
+			csv << fmt::format(",{:.4f}", phaseMilliseconds);
+		}
+		csv << '\n';
+	}
+
+	const auto writePercentiles = [&](const std::string_view name, const Percentiles& p) {
+		json << fmt::format("  \"{}\": {{\"p50\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f}}},\n", name, p.P50, p.P95, p.P99, p.Max);
+	};
+
+	json << "{\n";
+	json << fmt::format("  \"frames\": {},\n", m_numFrames);
+	writePercentiles("cpu_ms", GetCPUPercentiles());
+	writePercentiles("gpu_ms", GetGPUPercentiles());
+	json << fmt::format("  \"spike_factor\": {:.2f},\n  \"spike_min_ms\": {:.2f},\n  \"total_spikes\": {},\n",
+		m_settings.SpikeFactor, m_settings.SpikeMinMilliseconds, m_totalSpikes);
+	json << "  \"spikes\": [";
+	for (std::size_t i = 0; i < m_spikes.size(); ++i)
+	{
+		const auto& spike{ m_spikes[i] };
+		json << fmt::format("{}\n    {{\"frame\": {}, \"timeline\": \"{}\", \"ms\": {:.4f}, \"median_ms\": {:.4f}, \"cause\": \"{}\", \"cause_ms\": {:.4f}}}",
+			i ? "," : "", spike.Frame, spike.GPU ? "gpu" : "cpu", spike.Milliseconds, spike.MedianMilliseconds, spike.Cause, spike.CauseMilliseconds);
+	}
+	json << "\n  ]\n}\n";
+
+	std::cout << "Frame history written to " << csvPath.string() << " and " << jsonPath.string() << '\n';
+
+	return true;
+}
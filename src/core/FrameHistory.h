@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// Phases of Engine::Execute that are timed every frame.
+enum class FramePhase : std::uint8_t {
+	Input,
+	Camera,
+	SceneUpdate,
+	RenderUpdate,
+	Culling,
+	Render,
+	GUI,
+	Picking,
+	Present,
+	Count
+};
+
+std::string_view GetFramePhaseName(const FramePhase phase) noexcept;
+
+// Fixed-size history of per-frame CPU, GPU and phase times with percentiles and spike detection.
+// Averages hide stutter; this keeps every frame of the last few seconds.
+class FrameHistory {
+	using Clock = std::chrono::steady_clock;
+public:
+	static constexpr std::size_t NumPhases{ static_cast<std::size_t>(FramePhase::Count) };
+
+	struct Settings {
+		std::size_t Capacity{ 4096 };
+		// A frame is a spike when it takes longer than SpikeFactor times the median of the history
+		// and at least SpikeMinMilliseconds.
+		float SpikeFactor{ 2.0f };
+		float SpikeMinMilliseconds{ 4.0f };
+	};
+
+	struct Frame {
+		std::uint32_t Index{ 0 };
+		float CPUMilliseconds{ 0.0f };
+		// Negative until the GPU timings of the frame have been read back
+		float GPUMilliseconds{ -1.0f };
+		std::array<float, NumPhases> PhaseMilliseconds{};
+	};
+
+	struct Spike {
+		std::uint32_t Frame{ 0 };
+		bool GPU{ false };
+		float Milliseconds{ 0.0f };
+		float MedianMilliseconds{ 0.0f };
+		// Phase (or GPU pass) that exceeded its typical time by the largest amount
+		std::string_view Cause;
+		float CauseMilliseconds{ 0.0f };
+	};
+
+	struct Percentiles {
+		float P50{ 0.0f }, P95{ 0.0f }, P99{ 0.0f }, Max{ 0.0f };
+	};
+
+	// Times one phase of the current frame until it goes out of scope.
+	class ScopedPhase {
+	public:
+		ScopedPhase(FrameHistory& history, const FramePhase phase) noexcept
+			: m_history{ history }, m_phase{ phase }, m_start{ Clock::now() } {}
+		~ScopedPhase() { m_history.addPhaseTime(m_phase, Clock::now() - m_start); }
+
+		ScopedPhase(const ScopedPhase&) = delete;
+		ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+	private:
+		FrameHistory& m_history;
+		const FramePhase m_phase;
+		const Clock::time_point m_start;
+	};
+
+	FrameHistory();
+	explicit FrameHistory(const Settings& settings);
+
+	void BeginFrame();
+	void EndFrame();
+
+	[[nodiscard]] ScopedPhase TimePhase(const FramePhase phase) noexcept { return { *this, phase }; }
+
+	// Per-pass GPU times of the oldest frame still waiting for them. Frames are resolved in order.
+	template<typename PassList>
+	void AddGPUFrame(const PassList& passes)
+	{
+		m_gpuPassScratch.clear();
+		for (const auto& pass : passes)
+		{
+			m_gpuPassScratch.push_back({ pass.Name, static_cast<float>(pass.GPUMilliseconds) });
+		}
+		addGPUFrame();
+	}
+
+	// Frames currently in the history, GetFrame(0) is the oldest
+	std::size_t GetNumFrames() const noexcept { return m_numFrames; }
+	const Frame& GetFrame(const std::size_t i) const noexcept;
+	const Frame& GetLastFrame() const noexcept { return GetFrame(m_numFrames - 1); }
+
+	Percentiles GetCPUPercentiles() const;
+	Percentiles GetGPUPercentiles() const;
+
+	// Most recent spikes, oldest first
+	const auto& GetSpikes() const noexcept { return m_spikes; }
+	auto GetTotalSpikes() const noexcept { return m_totalSpikes; }
+
+	const auto& GetSettings() const noexcept { return m_settings; }
+	// Also clears the history
+	void SetSettings(const Settings& settings);
+
+	// Drops all frames and spikes. GPU times of frames still in flight are discarded when they arrive.
+	void Clear();
+
+	// <path>.csv holds one row per frame, <path>.json adds the percentiles and spikes.
+	bool Export(const std::filesystem::path& basePath) const;
+
+private:
+	static constexpr std::size_t MaxSpikes{ 64 };
+	// Medians used for spike detection are refreshed this often
+	static constexpr std::uint32_t MedianInterval{ 30 };
+
+	struct GPUPass {
+		std::string_view Name;
+		float Milliseconds;
+	};
+
+	void addPhaseTime(const FramePhase phase, const Clock::duration duration) noexcept;
+	void addGPUFrame();
+	void updateMedians();
+	void addSpike(const Spike& spike);
+
+	Frame& frameAt(const std::size_t i) noexcept;
+
+	Settings m_settings;
+	std::vector<Frame> m_frames;
+	// Ring position of the oldest frame and the number of valid frames
+	std::size_t m_first{ 0 }, m_numFrames{ 0 };
+	std::uint32_t m_nextFrameIndex{ 0 }, m_nextGPUFrameIndex{ 0 };
+
+	Frame m_current;
+	Clock::time_point m_frameStart;
+
+	float m_medianCPU{ 0.0f }, m_medianGPU{ 0.0f };
+	std::array<float, NumPhases> m_medianPhases{};
+	std::vector<float> m_medianScratch;
+	std::vector<GPUPass> m_gpuPassScratch;
+	// Moving average of every GPU pass, to name the pass behind a GPU spike
+	std::vector<GPUPass> m_gpuPassAverages;
+
+	std::vector<Spike> m_spikes;
+	std::uint32_t m_totalSpikes{ 0 };
+};
@@ -1,11 +1,16 @@
 #include "GUISystem.h"
 
 #include "../FrameStats.h"
-#include "../ResourceManager.h"
+#include "../resourceManager.h"
 #include "../Input.h"
+#include "Profiler.h"
+#include "FrameHistory.h"
+#include "../graphics/GPUMemory.h"
 
 #include <fmt/core.h>
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -34,6 +39,8 @@ int SSAOKernelSize = 64;
 float SSAOKernelRadius = 0.5f;
 float SSAOKernelBias = 0.025f;
 int enableTextures = 1;
+int enableShadows = 1;
+int enableIrradianceVolume = 1;
 int EnableHDR = 1;
 float HDRExposure = 1.0f;
 float ambientStrength = 1.0f;
@@ -77,7 +84,8 @@ void GUISystem::UpdateInput()
 
 /***********************************************************************************/
 void GUISystem::Render(const int framebufferWidth,
-	const int framebufferHeight, const FrameStats& frameStats, SceneBase* scene)
+	const int framebufferHeight, const FrameStats& frameStats,
+	const FrameHistory& frameHistory, SceneBase* scene)
 {
 	struct nk_colorf bg;
 	bg.r = 0.10f, bg.g = 0.18f, bg.b = 0.24f, bg.a = 1.0f;
@@ -86,23 +94,88 @@ void GUISystem::Render(const int framebufferWidth,
 	
 	const auto frameStatFlags = NK_WINDOW_BORDER | NK_WINDOW_NO_SCROLLBAR | NK_WINDOW_NO_INPUT;
 
-	if (nk_begin(m_nuklearContext, "Frame Stats", nk_recti(0, framebufferHeight - 80, 720, 80), frameStatFlags))
+	if (nk_begin(m_nuklearContext, "Frame Stats", nk_recti(0, framebufferHeight - 180, 720, 180), frameStatFlags))
 	{
 		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
 		{
 			nk_layout_row_push(m_nuklearContext, 720);
 			nk_label(
 				m_nuklearContext,
-				fmt::format("Frame Time: {:.2f} ms ({:.0f} fps) | GPU VRAM Usage: {} MB | RAM Usage: {} MB",
+				fmt::format("Frame Time: {:.2f} ms ({:.0f} fps) | GPU Memory: {} MB tracked{} | RAM Usage: {} MB",
 					frameStats.frameTimeMilliseconds,
 					1.0 / (frameStats.frameTimeMilliseconds / 1000.0),
-					frameStats.videoMemoryUsageKB / 1000,
+					frameStats.trackedVideoMemoryKB / 1000,
+					frameStats.videoMemoryUsageKB > 0 ? fmt::format(", {} MB driver", frameStats.videoMemoryUsageKB / 1000) : std::string(),
 					frameStats.ramUsageKB / 1000
 				).c_str(),
 				NK_TEXT_LEFT
 			);
 		}
 		nk_layout_row_end(m_nuklearContext);
+
+		const auto cpu{ frameHistory.GetCPUPercentiles() };
+		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
+		{
+			nk_layout_row_push(m_nuklearContext, 720);
+			nk_label(
+				m_nuklearContext,
+				fmt::format("CPU p50: {:.2f} ms | p95: {:.2f} ms | p99: {:.2f} ms | max: {:.2f} ms | Spikes: {}",
+					cpu.P50, cpu.P95, cpu.P99, cpu.Max, frameHistory.GetTotalSpikes()
+				).c_str(),
+				NK_TEXT_LEFT
+			);
+		}
+		nk_layout_row_end(m_nuklearContext);
+
+		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
+		{
+			nk_layout_row_push(m_nuklearContext, 720);
+			nk_label(
+				m_nuklearContext,
+				fmt::format("Render Graph: {} passes ({} culled) | Transient Targets: {} MB | Saved by Aliasing: {} MB",
+					frameStats.renderPasses, frameStats.culledRenderPasses,
+					frameStats.transientTextureKB / 1000, frameStats.aliasingSavedKB / 1000
+				).c_str(),
+				NK_TEXT_LEFT
+			);
+		}
+		nk_layout_row_end(m_nuklearContext);
+
+		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
+		{
+			nk_layout_row_push(m_nuklearContext, 720);
+			const auto dynamicResolution{ frameStats.dynamicResolution ?
+				fmt::format("Dynamic Resolution: {:.0f}% | GPU {:.2f} / {:.2f} ms | Error {:+.2f} | P {:+.3f} I {:.3f} D {:+.3f}",
+					frameStats.renderScale * 100.0f, frameStats.gpuFrameMilliseconds, frameStats.targetFrameMilliseconds,
+					frameStats.scaleError, frameStats.scaleProportional, frameStats.scaleIntegral, frameStats.scaleDerivative) :
+				std::string("Dynamic Resolution: off") };
+			nk_label(m_nuklearContext, dynamicResolution.c_str(), NK_TEXT_LEFT);
+		}
+		nk_layout_row_end(m_nuklearContext);
+
+		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
+		{
+			nk_layout_row_push(m_nuklearContext, 720);
+			const auto simulation{ frameStats.threadedSimulation ?
+				fmt::format("Simulation: {:.0f} Hz on its own thread | Step: {:.3f} ms | Dropped Steps: {}",
+					frameStats.simulationTickRate, frameStats.simulationTickMilliseconds, frameStats.droppedSimulationTicks) :
+				std::string("Simulation: once per frame") };
+			nk_label(m_nuklearContext, simulation.c_str(), NK_TEXT_LEFT);
+		}
+		nk_layout_row_end(m_nuklearContext);
+
+		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
+		{
+			nk_layout_row_push(m_nuklearContext, 720);
+			const auto meshlets{ frameStats.meshletCulling ?
+				fmt::format("Meshlets: {} ({} outside, {} back facing) | Triangles: {} -> {} ({:.0f}%)",
+					frameStats.meshlets, frameStats.frustumCulledMeshlets, frameStats.coneCulledMeshlets,
+					frameStats.trianglesBeforeMeshletCulling, frameStats.trianglesAfterMeshletCulling,
+					100.0 * frameStats.trianglesAfterMeshletCulling / std::max<std::size_t>(frameStats.trianglesBeforeMeshletCulling, 1)) :
+				std::string("Meshlet Culling: off") };
+			nk_label(m_nuklearContext, meshlets.c_str(), NK_TEXT_LEFT);
+		}
+		nk_layout_row_end(m_nuklearContext);
 	}
 
 	nk_end(m_nuklearContext);
@@ -165,7 +238,7 @@ void GUISystem::Render(const int framebufferWidth,
 					if (nk_slider_float(m_nuklearContext, -30.0f, &positionX, 30.f, 0.001f))
 					{
 						Input::GetInstance().SetGuiHit();
-						model->SetPosition({ positionX, 0, 0});
+						scene->MoveModel(model, { positionX, 0, 0 });
 					}
 					nk_layout_row_end(m_nuklearContext);
 				}
@@ -236,6 +309,22 @@ void GUISystem::Render(const int framebufferWidth,
 		}
 		nk_layout_row_end(m_nuklearContext);
 
+		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
+		{
+			nk_layout_row_push(m_nuklearContext, 200);
+			nk_checkbox_label(m_nuklearContext, "Enable shadows", &enableShadows);
+			nk_layout_row_end(m_nuklearContext);
+		}
+		nk_layout_row_end(m_nuklearContext);
+
+		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
+		{
+			nk_layout_row_push(m_nuklearContext, 200);
+			nk_checkbox_label(m_nuklearContext, "Enable irradiance volume", &enableIrradianceVolume);
+			nk_layout_row_end(m_nuklearContext);
+		}
+		nk_layout_row_end(m_nuklearContext);
+
 		nk_layout_row_begin(m_nuklearContext, NK_STATIC, 0, 1);
 		{
 			nk_layout_row_push(m_nuklearContext, 200);
@@ -268,10 +357,251 @@ void GUISystem::Render(const int framebufferWidth,
 		
 	nk_end(m_nuklearContext);
 
+	renderFrameHistory(frameHistory, framebufferWidth, framebufferHeight);
+	renderGPUMemory(framebufferWidth, framebufferHeight);
+
+#ifdef GE_ENABLE_PROFILER
+	renderProfiler(framebufferWidth, framebufferHeight);
+#endif
+}
+
+/***********************************************************************************/
+void GUISystem::Draw() const
+{
+	PROFILE_GPU_SCOPE("DrawGUI");
 	nk_glfw3_render(NK_ANTI_ALIASING_ON);
-		
 }
 
+/***********************************************************************************/
+void GUISystem::renderFrameHistory(const FrameHistory& frameHistory, const int framebufferWidth, const int framebufferHeight)
+{
+	// Frames shown in the graph, the percentiles cover the whole history
+	constexpr std::size_t graphFrames{ 240 };
+
+	const auto flags = NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE | NK_WINDOW_TITLE | NK_WINDOW_MINIMIZABLE;
+
+	if (nk_begin(m_nuklearContext, "Frame Time", nk_recti(framebufferWidth - 420, framebufferHeight - 400, 400, 300), flags))
+	{
+		const auto numFrames{ frameHistory.GetNumFrames() };
+		const auto first{ numFrames - std::min(numFrames, graphFrames) };
+
+		auto maxMilliseconds{ 1.0f };
+		for (auto i = first; i < numFrames; ++i)
+		{
+			const auto& frame{ frameHistory.GetFrame(i) };
+			maxMilliseconds = std::max({ maxMilliseconds, frame.CPUMilliseconds, frame.GPUMilliseconds });
+		}
+
+		nk_layout_row_dynamic(m_nuklearContext, 100, 1);
+		if (nk_chart_begin_colored(m_nuklearContext, NK_CHART_LINES, nk_rgb(255, 200, 40), nk_rgb(255, 255, 255),
+			static_cast<int>(numFrames - first), 0.0f, maxMilliseconds))
+		{
+			nk_chart_add_slot_colored(m_nuklearContext, NK_CHART_LINES, nk_rgb(80, 180, 255), nk_rgb(255, 255, 255),
+				static_cast<int>(numFrames - first), 0.0f, maxMilliseconds);
+
+			for (auto i = first; i < numFrames; ++i)
+			{
+				const auto& frame{ frameHistory.GetFrame(i) };
+				nk_chart_push_slot(m_nuklearContext, frame.CPUMilliseconds, 0);
+				nk_chart_push_slot(m_nuklearContext, std::max(frame.GPUMilliseconds, 0.0f), 1);
+			}
+			nk_chart_end(m_nuklearContext);
+		}
+
+		const auto cpu{ frameHistory.GetCPUPercentiles() };
+		const auto gpu{ frameHistory.GetGPUPercentiles() };
+
+		nk_layout_row_dynamic(m_nuklearContext, 0, 1);
+		nk_label(m_nuklearContext, fmt::format("Scale: {:.1f} ms | CPU (yellow) | GPU (blue)", maxMilliseconds).c_str(), NK_TEXT_LEFT);
+		nk_label(m_nuklearContext, fmt::format("CPU p50 {:.2f} | p95 {:.2f} | p99 {:.2f} | max {:.2f}", cpu.P50, cpu.P95, cpu.P99, cpu.Max).c_str(), NK_TEXT_LEFT);
+		nk_label(m_nuklearContext, fmt::format("GPU p50 {:.2f} | p95 {:.2f} | p99 {:.2f} | max {:.2f}", gpu.P50, gpu.P95, gpu.P99, gpu.Max).c_str(), NK_TEXT_LEFT);
+		nk_label(m_nuklearContext, fmt::format("Spikes: {} (latest first)", frameHistory.GetTotalSpikes()).c_str(), NK_TEXT_LEFT);
+
+		const auto& spikes{ frameHistory.GetSpikes() };
+		for (auto spike = spikes.crbegin(); spike != spikes.crend(); ++spike)
+		{
+			nk_label(m_nuklearContext,
+				fmt::format("#{} {} {:.2f} ms (median {:.2f}) - {} {:.2f} ms",
+					spike->Frame, spike->GPU ? "GPU" : "CPU", spike->Milliseconds, spike->MedianMilliseconds,
+					spike->Cause, spike->CauseMilliseconds
+				).c_str(),
+				NK_TEXT_LEFT
+			);
+		}
+
+		if (nk_input_has_mouse_click_in_rect(&m_nuklearContext->input, NK_BUTTON_LEFT, nk_window_get_bounds(m_nuklearContext)))
+		{
+			Input::GetInstance().SetGuiHit();
+		}
+	}
+
+	nk_end(m_nuklearContext);
+}
+
+/***********************************************************************************/
+void GUISystem::renderGPUMemory(const int framebufferWidth, const int framebufferHeight)
+{
+	// Allocations listed individually, the rest only count in the totals
+	constexpr std::size_t maxListed{ 32 };
+	constexpr double megabyte{ 1024.0 * 1024.0 };
+
+	const auto flags = NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE | NK_WINDOW_TITLE | NK_WINDOW_MINIMIZABLE;
+
+	if (nk_begin(m_nuklearContext, "GPU Memory", nk_recti(framebufferWidth - 840, 20, 400, 400), flags))
+	{
+		const auto& tracker{ Graphics::GPUMemoryTracker::GetInstance() };
+		const auto total{ tracker.GetTotals() };
+
+		nk_layout_row_dynamic(m_nuklearContext, 0, 1);
+		nk_label(m_nuklearContext, fmt::format("Total: {:.1f} MB in {} objects", total.Bytes / megabyte, total.Count).c_str(), NK_TEXT_LEFT);
+
+		if (!m_gpuMemoryReportPath.empty() && nk_button_label(m_nuklearContext, "Export Report"))
+		{
+			tracker.ExportReport(m_gpuMemoryReportPath);
+		}
+
+		if (nk_tree_push(m_nuklearContext, NK_TREE_TAB, "By Category", NK_MAXIMIZED))
+		{
+			for (std::size_t i = 0; i < static_cast<std::size_t>(Graphics::GPUMemoryCategory::Count); ++i)
+			{
+				const auto category{ static_cast<Graphics::GPUMemoryCategory>(i) };
+				const auto totals{ tracker.GetTotals(category) };
+				nk_label(m_nuklearContext, fmt::format("{}: {:.1f} MB ({})", Graphics::GetGPUMemoryCategoryName(category), totals.Bytes / megabyte, totals.Count).c_str(), NK_TEXT_LEFT);
+			}
+			nk_tree_pop(m_nuklearContext);
+		}
+
+		if (nk_tree_push(m_nuklearContext, NK_TREE_TAB, "By Type", NK_MINIMIZED))
+		{
+			for (std::size_t i = 0; i < static_cast<std::size_t>(Graphics::GPUResourceType::Count); ++i)
+			{
+				const auto type{ static_cast<Graphics::GPUResourceType>(i) };
+				const auto totals{ tracker.GetTotals(type) };
+				nk_label(m_nuklearContext, fmt::format("{}: {:.1f} MB ({})", Graphics::GetGPUResourceTypeName(type), totals.Bytes / megabyte, totals.Count).c_str(), NK_TEXT_LEFT);
+			}
+			nk_tree_pop(m_nuklearContext);
+		}
+
+		if (nk_tree_push(m_nuklearContext, NK_TREE_TAB, "Largest", NK_MINIMIZED))
+		{
+			const auto allocations{ tracker.GetAllocations() };
+			for (std::size_t i = 0; i < std::min(allocations.size(), maxListed); ++i)
+			{
+				const auto& allocation{ allocations[i] };
+				nk_label(m_nuklearContext,
+					fmt::format("{:.2f} MB  {} {}  {}", allocation.Bytes / megabyte, Graphics::GetGPUMemoryCategoryName(allocation.Category),
+						Graphics::GetGPUResourceTypeName(allocation.Type), allocation.Owner).c_str(),
+					NK_TEXT_LEFT
+				);
+			}
+			nk_tree_pop(m_nuklearContext);
+		}
+
+		if (nk_input_has_mouse_click_in_rect(&m_nuklearContext->input, NK_BUTTON_LEFT, nk_window_get_bounds(m_nuklearContext)))
+		{
+			Input::GetInstance().SetGuiHit();
+		}
+	}
+
+	nk_end(m_nuklearContext);
+}
+
+#ifdef GE_ENABLE_PROFILER
+/***********************************************************************************/
+void GUISystem::renderProfiler(const int framebufferWidth, const int framebufferHeight)
+{
+	const auto flags = NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE | NK_WINDOW_TITLE | NK_WINDOW_MINIMIZABLE;
+
+	if (nk_begin(m_nuklearContext, "Profiler", nk_recti(framebufferWidth - 420, 20, 400, 500), flags))
+	{
+		auto& profiler{ Profiler::GetInstance() };
+
+		nk_layout_row_dynamic(m_nuklearContext, 0, 1);
+		nk_label(m_nuklearContext,
+			fmt::format("Frame {} | CPU {:.2f} ms | GPU {:.2f} ms",
+				profiler.GetFrameIndex(),
+				profiler.GetLastFrameCPUMilliseconds(),
+				profiler.GetLastFrameGPUMilliseconds()
+			).c_str(),
+			NK_TEXT_LEFT
+		);
+
+		if (nk_button_label(m_nuklearContext, "Export Chrome Trace"))
+		{
+			profiler.ExportChromeTrace("Data/benchmarks/profile_trace.json");
+		}
+
+		const auto threadFrames{ profiler.CollectLastFrame() };
+		for (std::size_t thread = 0; thread < threadFrames.size(); ++thread)
+		{
+			const auto& threadFrame{ threadFrames[thread] };
+			const auto initialState{ thread < 2 ? NK_MAXIMIZED : NK_MINIMIZED };
+			const auto seed{ static_cast<int>(thread * 64) };
+
+			if (!nk_tree_push_hashed(m_nuklearContext, NK_TREE_TAB, threadFrame.Name.c_str(), initialState,
+				threadFrame.Name.c_str(), static_cast<int>(threadFrame.Name.size()), seed))
+			{
+				continue;
+			}
+
+			// Zones with children become tree nodes, collapsed ones skip their subtree.
+			std::size_t openNodes{ 0 };
+			std::uint32_t skipBelow{ ~0u };
+			const auto& zones{ threadFrame.Zones };
+			for (std::size_t i = 0; i < zones.size(); ++i)
+			{
+				const auto& zone{ zones[i] };
+				while (openNodes > zone.Depth)
+				{
+					nk_tree_pop(m_nuklearContext);
+					--openNodes;
+				}
+				if (zone.Depth > skipBelow)
+				{
+					continue;
+				}
+				skipBelow = ~0u;
+
+				const auto label{ zone.Calls > 1 ?
+					fmt::format("{}  {:.3f} ms  ({}x)", zone.Name, zone.Milliseconds, zone.Calls) :
+					fmt::format("{}  {:.3f} ms", zone.Name, zone.Milliseconds) };
+
+				const auto hasChildren{ i + 1 < zones.size() && zones[i + 1].Depth > zone.Depth };
+				if (!hasChildren)
+				{
+					nk_layout_row_dynamic(m_nuklearContext, 0, 1);
+					nk_label(m_nuklearContext, label.c_str(), NK_TEXT_LEFT);
+					continue;
+				}
+
+				if (nk_tree_push_hashed(m_nuklearContext, NK_TREE_NODE, label.c_str(), NK_MAXIMIZED,
+					zone.Name, static_cast<int>(std::strlen(zone.Name)), seed + static_cast<int>(zone.Depth) + 1))
+				{
+					++openNodes;
+				} else
+				{
+					skipBelow = zone.Depth;
+				}
+			}
+
+			while (openNodes > 0)
+			{
+				nk_tree_pop(m_nuklearContext);
+				--openNodes;
+			}
+			nk_tree_pop(m_nuklearContext);
+		}
+
+		if (nk_input_has_mouse_click_in_rect(&m_nuklearContext->input, NK_BUTTON_LEFT, nk_window_get_bounds(m_nuklearContext)))
+		{
+			Input::GetInstance().SetGuiHit();
+		}
+	}
+
+	nk_end(m_nuklearContext);
+}
+#endif
+
 /***********************************************************************************/
 void GUISystem::Shutdown() const
 {
@@ -289,6 +619,8 @@ void GUISystem::Update(RenderSystem* renderSystem, SceneBase* scene)
 	renderSystem->renderSettings.ssao.KernelRadius= SSAOKernelRadius;
 	renderSystem->renderSettings.ssao.KernelBias = SSAOKernelBias;
 	renderSystem->renderSettings.renderPass.EnableTextures = enableTextures;
+	renderSystem->renderSettings.renderPass.EnableShadows = enableShadows;
+	renderSystem->renderSettings.renderPass.EnableIrradianceVolume = enableIrradianceVolume && renderSystem->HasIrradianceVolume();
 	renderSystem->renderSettings.postProcessing.hdr.EnableExposure = EnableHDR;
 	renderSystem->renderSettings.postProcessing.hdr.Exposure= HDRExposure;
 	renderSystem->renderSettings.ambientStrength = ambientStrength;
@@ -299,7 +631,7 @@ void GUISystem::Update(RenderSystem* renderSystem, SceneBase* scene)
 	scene->m_staticDirectionalLights[0].Direction.z = directionalLightRotZ;*/
 	if (saveScene)
 	{
-		scene->Save();
+		scene->RequestSave();
 		saveScene = false;
 	}
 		
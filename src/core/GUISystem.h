@@ -1,10 +1,13 @@
 #pragma once
 
+#include <filesystem>
+
 /***********************************************************************************/
 // Forward Declarations
 struct nk_context;
 struct GLFWwindow;
 struct FrameStats;
+class FrameHistory;
 struct RenderSystem;
 class SceneBase;
 /***********************************************************************************/
@@ -18,14 +21,32 @@ public:
 	GUISystem& operator=(const GUISystem&) = delete;
 
 	void Init(GLFWwindow* windowPtr);
+	// Builds the widgets of this frame, no OpenGL
 	void Render(const int framebufferWidth,
 		const int framebufferHeight,
-		const FrameStats& frameStats, SceneBase* scene);
+		const FrameStats& frameStats,
+		const FrameHistory& frameHistory, SceneBase* scene);
+	// Draws what Render built on the thread owning the context. Render must not run again until it returned.
+	void Draw() const;
 	void Shutdown() const;
 	void Update(RenderSystem* renderSystem, SceneBase* scene);
 	void UpdateInput();
+	// Where the GPU Memory window's export button writes, the button is hidden if empty
+	void SetGPUMemoryReportPath(const std::filesystem::path& basePath) { m_gpuMemoryReportPath = basePath; }
 
 private:
+	// Graph of recent CPU/GPU frame times with percentiles and spikes
+	void renderFrameHistory(const FrameHistory& frameHistory, const int framebufferWidth, const int framebufferHeight);
+
+	// Tracked GPU memory per category and type, and the largest allocations
+	void renderGPUMemory(const int framebufferWidth, const int framebufferHeight);
+
+#ifdef GE_ENABLE_PROFILER
+	// Zone tree of the last frame per thread and the GPU
+	void renderProfiler(const int framebufferWidth, const int framebufferHeight);
+#endif
+
 	nk_context* m_nuklearContext{ nullptr };
 	bool m_guiClicked = false;
+	std::filesystem::path m_gpuMemoryReportPath;
 };
\ No newline at end of file
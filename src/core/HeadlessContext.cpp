@@ -0,0 +1,187 @@
+#include "HeadlessContext.h"
+
+#include <pugixml.hpp>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+#include <iostream>
+
+#ifdef __linux__
+/***********************************************************************************/
+bool HeadlessContext::Init(const pugi::xml_node& windowNode)
+{
+	// Prefer Mesa's surfaceless platform, it needs neither X11/Wayland nor a DRM device.
+	EGLDisplay display{ EGL_NO_DISPLAY };
+	const auto getPlatformDisplay{ reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT")) };
+	if (getPlatformDisplay)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major{ 0 }, minor{ 0 };
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cerr << "HeadlessContext Error: Failed to initialize an EGL display. Error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+		return false;
+	}
+	std::cout << "EGL Version: " << major << '.' << minor << " (" << eglQueryString(display, EGL_VENDOR) << ")\n";
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cerr << "HeadlessContext Error: EGL display does not support desktop OpenGL." << std::endl;
+		eglTerminate(display);
+		return false;
+	}
+
+	// Nothing is ever drawn to an EGL surface, any OpenGL capable config will do.
+	const EGLint configAttributes[]{
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config{ nullptr };
+	EGLint numConfigs{ 0 };
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs == 0)
+	{
+		config = nullptr; // EGL_NO_CONFIG_KHR
+	}
+
+	const EGLint contextAttributes[]{
+		EGL_CONTEXT_MAJOR_VERSION, windowNode.attribute("major").as_int(4),
+		EGL_CONTEXT_MINOR_VERSION, windowNode.attribute("minor").as_int(4),
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef _DEBUG
+		EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+		EGL_NONE
+	};
+
+	auto* context{ eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes) };
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cerr << "HeadlessContext Error: Failed to create an OpenGL context. Error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+		eglTerminate(display);
+		return false;
+	}
+
+	// Requires EGL_KHR_surfaceless_context
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::cerr << "HeadlessContext Error: Failed to make the context current without a surface. Error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+		eglDestroyContext(display, context);
+		eglTerminate(display);
+		return false;
+	}
+
+	m_display = display;
+	m_context = context;
+
+	return true;
+}
+
+/***********************************************************************************/
+void HeadlessContext::Shutdown()
+{
+	if (m_display)
+	{
+		eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(m_display, m_context);
+		eglTerminate(m_display);
+	}
+
+	m_display = nullptr;
+	m_context = nullptr;
+}
+
+/***********************************************************************************/
+void HeadlessContext::MakeContextCurrent()
+{
+	if (!eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context))
+	{
+		std::cerr << "HeadlessContext Error: Failed to make the context current. Error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+	}
+}
+
+/***********************************************************************************/
+void HeadlessContext::ReleaseContext()
+{
+	eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+/***********************************************************************************/
+void* HeadlessContext::GetProcAddress(const char* name)
+{
+	return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+#else
+/***********************************************************************************/
+bool HeadlessContext::Init(const pugi::xml_node& windowNode)
+{
+	if (!glfwInit())
+	{
+		std::cerr << "HeadlessContext Error: Failed to start GLFW." << std::endl;
+		return false;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, windowNode.attribute("major").as_int(4));
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, windowNode.attribute("minor").as_int(4));
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef _DEBUG
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	// The window only provides the context, its size is unrelated to the render resolution.
+	m_window = glfwCreateWindow(1, 1, "Headless", nullptr, nullptr);
+	if (!m_window)
+	{
+		std::cerr << "HeadlessContext Error: Failed to create a hidden GLFW window." << std::endl;
+		glfwTerminate();
+		return false;
+	}
+
+	glfwMakeContextCurrent(m_window);
+	glfwSwapInterval(0);
+
+	return true;
+}
+
+/***********************************************************************************/
+void HeadlessContext::Shutdown()
+{
+	if (m_window)
+	{
+		glfwDestroyWindow(m_window);
+		glfwTerminate();
+	}
+
+	m_window = nullptr;
+}
+
+/***********************************************************************************/
+void HeadlessContext::MakeContextCurrent()
+{
+	glfwMakeContextCurrent(m_window);
+}
+
+/***********************************************************************************/
+void HeadlessContext::ReleaseContext()
+{
+	glfwMakeContextCurrent(nullptr);
+}
+
+/***********************************************************************************/
+void* HeadlessContext::GetProcAddress(const char* name)
+{
+	return reinterpret_cast<void*>(glfwGetProcAddress(name));
+}
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+/***********************************************************************************/
+// Forward Declarations
+namespace pugi
+{
+	class xml_node;
+}
+struct GLFWwindow;
+
+/***********************************************************************************/
+// OpenGL context without a visible window, used for automated performance and regression runs.
+// On Linux this is a surfaceless EGL context, which also works on Mesa llvmpipe on machines without
+// a display or GPU. Other platforms fall back to a hidden GLFW window.
+// Nothing is presented, the renderer draws into an offscreen framebuffer.
+class HeadlessContext {
+public:
+	HeadlessContext() noexcept = default;
+
+	HeadlessContext(HeadlessContext&&) = delete;
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(HeadlessContext&&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	~HeadlessContext() = default;
+
+	// Creates a core profile context with the version requested by the Window node and makes it current.
+	bool Init(const pugi::xml_node& windowNode);
+	void Shutdown();
+
+	// Makes the context current on the calling thread. It must not be current on another one.
+	void MakeContextCurrent();
+	// Detaches the context from the calling thread, so another thread can make it current.
+	void ReleaseContext();
+
+	// OpenGL function loader for glad.
+	static void* GetProcAddress(const char* name);
+
+private:
+#ifdef __linux__
+	void* m_display{ nullptr };
+	void* m_context{ nullptr };
+#else
+	GLFWwindow* m_window{ nullptr };
+#endif
+};
@@ -0,0 +1,79 @@
+#include "LinearArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+/***********************************************************************************/
+void* LinearArena::Allocate(const std::size_t size, const std::size_t alignment)
+{
+	const auto fits = [size, alignment](Chunk& chunk) -> void* {
+		const auto base{ reinterpret_cast<std::uintptr_t>(chunk.Data.get()) };
+		const auto offset{ ((base + chunk.Used + alignment - 1) & ~(alignment - 1)) - base };
+		if (offset + size > chunk.Size)
+		{
+			return nullptr;
+		}
+		chunk.Used = offset + size;
+		return chunk.Data.get() + offset;
+	};
+
+	for (; m_current < m_chunks.size(); ++m_current)
+	{
+		if (auto* memory{ fits(m_chunks[m_current]) })
+		{
+			return memory;
+		}
+	}
+
+	// Chunks come from new[], aligned for any fundamental type; larger alignments get slack
+	Chunk chunk;
+	chunk.Size = std::max(m_chunkSize, size + alignment);
+	chunk.Data = std::make_unique<std::byte[]>(chunk.Size);
+	m_chunks.push_back(std::move(chunk));
+	m_current = m_chunks.size() - 1;
+
+	return fits(m_chunks.back());
+}
+
+/***********************************************************************************/
+void LinearArena::Reset()
+{
+	if (m_chunks.size() > 1)
+	{
+		const auto capacity{ GetCapacity() };
+		m_chunks.clear();
+
+		Chunk chunk;
+		chunk.Size = capacity;
+		chunk.Data = std::make_unique<std::byte[]>(capacity);
+		m_chunks.push_back(std::move(chunk));
+	}
+
+	for (auto& chunk : m_chunks)
+	{
+		chunk.Used = 0;
+	}
+	m_current = 0;
+}
+
+/***********************************************************************************/
+std::size_t LinearArena::GetUsedBytes() const noexcept
+{
+	std::size_t used{ 0 };
+	for (const auto& chunk : m_chunks)
+	{
+		used += chunk.Used;
+	}
+	return used;
+}
+
+/***********************************************************************************/
+std::size_t LinearArena::GetCapacity() const noexcept
+{
+	std::size_t capacity{ 0 };
+	for (const auto& chunk : m_chunks)
+	{
+		capacity += chunk.Size;
+	}
+	return capacity;
+}
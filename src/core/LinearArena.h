@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for data that lives for one frame. Allocating moves a pointer, nothing is freed individually;
+// Reset releases everything at once. Memory is kept across frames: when a frame needed more than one chunk,
+// Reset replaces them with a single chunk of their total size, so a steady workload stops allocating after
+// the first frames. Not thread-safe, give every recording thread its own arena.
+class LinearArena {
+public:
+	struct Chunk {
+		std::unique_ptr<std::byte[]> Data;
+		std::size_t Size{ 0 };
+		std::size_t Used{ 0 };
+	};
+
+	explicit LinearArena(const std::size_t chunkSize = 64 * 1024) : m_chunkSize(chunkSize) {}
+
+	LinearArena(LinearArena&&) noexcept = default;
+	LinearArena& operator=(LinearArena&&) noexcept = default;
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	void* Allocate(const std::size_t size, const std::size_t alignment = alignof(std::max_align_t));
+
+	// Objects are never destroyed, so only trivially destructible types are allowed.
+	template<typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "LinearArena never runs destructors");
+		return ::new (Allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+	}
+
+	template<typename T>
+	T* NewArray(const std::size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "LinearArena never runs destructors");
+		auto* data{ static_cast<T*>(Allocate(sizeof(T) * count, alignof(T))) };
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			::new (data + i) T();
+		}
+		return data;
+	}
+
+	// Invalidates everything allocated since the last Reset.
+	void Reset();
+
+	// Chunks in allocation order. Allocations never span chunks.
+	const auto& GetChunks() const noexcept { return m_chunks; }
+	std::size_t GetUsedBytes() const noexcept;
+	std::size_t GetCapacity() const noexcept;
+
+private:
+	std::vector<Chunk> m_chunks;
+	// Chunk allocations currently go to
+	std::size_t m_current{ 0 };
+	std::size_t m_chunkSize;
+};
+
+// Standard allocator handing out memory of a LinearArena, for containers that live no longer than the arena's
+// next Reset. deallocate does nothing: memory a container gives back is only reused after the Reset, so reserve
+// up front instead of letting the container grow.
+template<typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+
+	explicit ArenaAllocator(LinearArena& arena) noexcept : m_arena(&arena) {}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.GetArena()) {}
+
+	T* allocate(const std::size_t count)
+	{
+		return static_cast<T*>(m_arena->Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	void deallocate(T*, const std::size_t) noexcept {}
+
+	LinearArena* GetArena() const noexcept { return m_arena; }
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const noexcept { return m_arena == other.GetArena(); }
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const noexcept { return m_arena != other.GetArena(); }
+
+private:
+	LinearArena* m_arena;
+};
+
+// Vector in a LinearArena, e.g. the per-frame lists of the main loop. The elements' destructors still run.
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,149 @@
+#include "MappedFile.h"
+
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+/***********************************************************************************/
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+/***********************************************************************************/
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_open = std::exchange(other.m_open, false);
+#ifdef _WIN32
+		m_file = std::exchange(other.m_file, nullptr);
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+	}
+	return *this;
+}
+
+/***********************************************************************************/
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+	Close();
+
+#ifdef _WIN32
+	const auto file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "MappedFile Error: Failed to open " << path << ": error " << GetLastError() << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		std::cerr << "MappedFile Error: Failed to read the size of " << path << ": error " << GetLastError() << std::endl;
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_size = static_cast<std::size_t>(size.QuadPart);
+	m_open = true;
+	if (m_size == 0)
+	{
+		return true;
+	}
+
+	m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const auto* view{ m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr };
+	if (view == nullptr)
+	{
+		std::cerr << "MappedFile Error: Failed to map " << path << ": error " << GetLastError() << std::endl;
+		Close();
+		return false;
+	}
+	m_data = static_cast<const std::byte*>(view);
+#else
+	const auto file{ open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+	if (file == -1)
+	{
+		std::cerr << "MappedFile Error: Failed to open " << path << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) == -1)
+	{
+		std::cerr << "MappedFile Error: Failed to read the size of " << path << ": " << std::strerror(errno) << std::endl;
+		close(file);
+		return false;
+	}
+
+	m_size = static_cast<std::size_t>(status.st_size);
+	m_open = true;
+	if (m_size > 0)
+	{
+		auto* view{ mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0) };
+		if (view == MAP_FAILED)
+		{
+			std::cerr << "MappedFile Error: Failed to map " << path << ": " << std::strerror(errno) << std::endl;
+			close(file);
+			m_size = 0;
+			m_open = false;
+			return false;
+		}
+		// Parsers read front to back, let the kernel read ahead
+		madvise(view, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const std::byte*>(view);
+	}
+
+	// The mapping keeps the file alive
+	close(file);
+#endif
+
+	return true;
+}
+
+/***********************************************************************************/
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_data != nullptr)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+	if (m_file != nullptr)
+	{
+		CloseHandle(m_file);
+		m_file = nullptr;
+	}
+#else
+	if (m_data != nullptr)
+	{
+		munmap(const_cast<std::byte*>(m_data), m_size);
+	}
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+	m_open = false;
+}
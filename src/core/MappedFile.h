@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+// Read-only view of a whole file mapped into memory. Pages are read on first access, so parsers can walk large
+// files without copying them into a buffer first.
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// Maps path, replacing the current mapping. Empty files open with a null data pointer.
+	bool Open(const std::filesystem::path& path);
+	void Close();
+
+	const std::byte* GetData() const noexcept { return m_data; }
+	std::size_t GetSize() const noexcept { return m_size; }
+	bool IsOpen() const noexcept { return m_open; }
+
+private:
+	const std::byte* m_data{ nullptr };
+	std::size_t m_size{ 0 };
+	bool m_open{ false };
+
+#ifdef _WIN32
+	void* m_file{ nullptr };
+	void* m_mapping{ nullptr };
+#endif
+};
@@ -0,0 +1,390 @@
+#include "Profiler.h"
+
+#ifdef GE_ENABLE_PROFILER
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+/***********************************************************************************/
+Profiler::Profiler() : m_epochTicks{ Now() }, m_epochTime{ std::chrono::steady_clock::now() },
+	m_ticksPerMillisecond{ measureTicksPerMillisecond() }
+{
+	auto gpuLog{ std::make_unique<ThreadLog>() };
+	gpuLog->Name = "GPU";
+	m_gpuLog = gpuLog.get();
+	m_threads.push_back(std::move(gpuLog));
+}
+
+/***********************************************************************************/
+double Profiler::TicksToMilliseconds(const std::uint64_t ticks) const
+{
+	return static_cast<double>(ticks) / ticksPerMillisecond();
+}
+
+/***********************************************************************************/
+double Profiler::measureTicksPerMillisecond() const
+{
+#ifdef GE_PROFILER_RDTSC
+	// The TSC rate is derived from the time since startup, which gets more precise the longer we run.
+	const auto elapsedTicks{ Now() - m_epochTicks };
+	const auto elapsedMilliseconds{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_epochTime).count() };
+	if (elapsedTicks == 0 || elapsedMilliseconds <= 0.0)
+	{
+		return 1.0e6;
+	}
+	return static_cast<double>(elapsedTicks) / elapsedMilliseconds;
+#else
+	using Period = std::chrono::steady_clock::period;
+	return static_cast<double>(Period::den) / (static_cast<double>(Period::num) * 1000.0);
+#endif
+}
+
+/***********************************************************************************/
+Profiler::ThreadLog& Profiler::registerThread()
+{
+	std::lock_guard<std::mutex> lock(m_threadsMutex);
+
+	auto log{ std::make_unique<ThreadLog>() };
+	log->Name = fmt::format("Thread {}", m_threads.size());
+	m_threads.push_back(std::move(log));
+
+	return *m_threads.back();
+}
+
+/***********************************************************************************/
+void Profiler::SetThreadName(std::string name)
+{
+	auto& log{ GetThreadLog() };
+
+	std::lock_guard<std::mutex> lock(m_threadsMutex);
+	log.Name = std::move(name);
+}
+
+/***********************************************************************************/
+void Profiler::NewFrame()
+{
+	const auto now{ Now() };
+	if (m_frameStarted)
+	{
+		m_lastFrameCPUMilliseconds = TicksToMilliseconds(now - m_frameStart);
+		m_frameIndex.fetch_add(1, std::memory_order_relaxed);
+	}
+	m_frameStarted = true;
+	m_frameStart = now;
+#ifdef GE_PROFILER_RDTSC
+	// Gets more precise the longer we run
+	m_ticksPerMillisecond.store(measureTicksPerMillisecond(), std::memory_order_relaxed);
+#endif
+}
+
+/***********************************************************************************/
+void Profiler::NewGPUFrame()
+{
+	if (!m_gpuEnabled)
+	{
+		return;
+	}
+
+	m_gpuFrames[m_gpuCurrent].Pending = true;
+	m_gpuCurrent = (m_gpuCurrent + 1) % MaxGPUFramesInFlight;
+
+	while (resolveOldestGPU(false))
+	{
+	}
+
+	// The GPU is MaxGPUFramesInFlight frames behind, wait for the oldest.
+	if (m_gpuFrames[m_gpuCurrent].Pending)
+	{
+		resolveOldestGPU(true);
+	}
+
+	if (GetFrameIndex() - m_calibrationFrame >= GPUCalibrationInterval)
+	{
+		calibrateGPU();
+	}
+
+	auto& frame{ m_gpuFrames[m_gpuCurrent] };
+	frame.Zones.clear();
+	frame.LastQuery = 0;
+	frame.Frame = GetFrameIndex();
+	frame.GPUReference = m_gpuReference;
+	frame.CPUReference = m_cpuReference;
+	m_gpuDepth = 0;
+}
+
+/***********************************************************************************/
+void Profiler::calibrateGPU()
+{
+	glGetInteger64v(GL_TIMESTAMP, &m_gpuReference);
+	m_cpuReference = Now();
+	m_calibrationFrame = GetFrameIndex();
+}
+
+/***********************************************************************************/
+void Profiler::InitGPU()
+{
+	m_gpuEnabled = true;
+	m_gpuCurrent = m_gpuOldest = 0;
+
+	calibrateGPU();
+
+	auto& frame{ m_gpuFrames[m_gpuCurrent] };
+	frame.Frame = GetFrameIndex();
+	frame.GPUReference = m_gpuReference;
+	frame.CPUReference = m_cpuReference;
+}
+
+/***********************************************************************************/
+void Profiler::ShutdownGPU()
+{
+	for (auto& frame : m_gpuFrames)
+	{
+		if (!frame.Queries.empty())
+		{
+			glDeleteQueries(static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+		}
+		frame.Queries.clear();
+		frame.Zones.clear();
+		frame.Pending = false;
+	}
+
+	m_gpuEnabled = false;
+}
+
+/***********************************************************************************/
+std::uint32_t Profiler::BeginGPUZone(const char* name)
+{
+	if (!m_gpuEnabled)
+	{
+		return InvalidGPUZone;
+	}
+
+	auto& frame{ m_gpuFrames[m_gpuCurrent] };
+	const auto query{ static_cast<std::uint32_t>(frame.Zones.size() * 2) };
+	if (frame.Queries.size() < query + 2)
+	{
+		// Grow in batches, query objects are never released until shutdown
+		constexpr std::size_t batchSize{ 32 };
+		const auto oldSize{ frame.Queries.size() };
+		frame.Queries.resize(oldSize + batchSize);
+		glGenQueries(static_cast<GLsizei>(batchSize), frame.Queries.data() + oldSize);
+	}
+
+	glQueryCounter(frame.Queries[query], GL_TIMESTAMP);
+	frame.LastQuery = query;
+	frame.Zones.push_back({ name, m_gpuDepth++, query });
+
+	return static_cast<std::uint32_t>(frame.Zones.size() - 1);
+}
+
+/***********************************************************************************/
+void Profiler::EndGPUZone(const std::uint32_t zone)
+{
+	if (zone == InvalidGPUZone || !m_gpuEnabled)
+	{
+		return;
+	}
+
+	auto& frame{ m_gpuFrames[m_gpuCurrent] };
+	const auto query{ frame.Zones[zone].Query + 1 };
+
+	glQueryCounter(frame.Queries[query], GL_TIMESTAMP);
+	frame.LastQuery = query;
+	--m_gpuDepth;
+}
+
+/***********************************************************************************/
+bool Profiler::resolveOldestGPU(const bool wait)
+{
+	auto& frame{ m_gpuFrames[m_gpuOldest] };
+	if (!frame.Pending)
+	{
+		return false;
+	}
+
+	if (!frame.Zones.empty())
+	{
+		// Queries complete in submission order, the last one issued tells whether the frame is done.
+		if (!wait)
+		{
+			GLint available{ 0 };
+			glGetQueryObjectiv(frame.Queries[frame.LastQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				return false;
+			}
+		}
+
+		const auto ticksPerNanosecond{ ticksPerMillisecond() / 1.0e6 };
+		const auto toCPUTicks = [&](const GLuint64 gpuTime) {
+			const auto offset{ static_cast<double>(static_cast<std::int64_t>(gpuTime) - frame.GPUReference) * ticksPerNanosecond };
+			return static_cast<std::uint64_t>(std::max(0.0, static_cast<double>(frame.CPUReference) + offset));
+		};
+
+		auto gpuMilliseconds{ 0.0 };
+		for (const auto& zone : frame.Zones)
+		{
+			GLuint64 begin{ 0 }, end{ 0 };
+			glGetQueryObjectui64v(frame.Queries[zone.Query], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.Queries[zone.Query + 1], GL_QUERY_RESULT, &end);
+
+			if (zone.Depth == 0)
+			{
+				gpuMilliseconds += static_cast<double>(end - begin) / 1.0e6;
+			}
+
+			m_gpuLog->Push({ zone.Name, toCPUTicks(begin), toCPUTicks(end), zone.Depth, frame.Frame });
+		}
+
+		m_lastFrameGPUMilliseconds.store(gpuMilliseconds, std::memory_order_relaxed);
+		m_lastResolvedGPUFrame.store(frame.Frame, std::memory_order_relaxed);
+	}
+
+	frame.Pending = false;
+	m_gpuOldest = (m_gpuOldest + 1) % MaxGPUFramesInFlight;
+
+	return true;
+}
+
+/***********************************************************************************/
+std::vector<Profiler::ThreadFrame> Profiler::CollectLastFrame() const
+{
+	std::vector<ThreadFrame> threadFrames;
+
+	const auto frameIndex{ GetFrameIndex() };
+	if (frameIndex == 0)
+	{
+		return threadFrames;
+	}
+
+	const auto ticksPerMs{ ticksPerMillisecond() };
+
+	std::lock_guard<std::mutex> lock(m_threadsMutex);
+	for (const auto& log : m_threads)
+	{
+		const auto targetFrame{ log.get() == m_gpuLog ? m_lastResolvedGPUFrame.load(std::memory_order_relaxed) : frameIndex - 1 };
+
+		// Newest events are at the end, walk back until we leave the frame.
+		std::vector<Event> events;
+		const auto count{ log->Count.load(std::memory_order_acquire) };
+		const auto oldest{ count > ThreadLog::Capacity ? count - ThreadLog::Capacity : 0 };
+		for (auto i = count; i > oldest; --i)
+		{
+			const auto& event{ log->Events[(i - 1) & (ThreadLog::Capacity - 1)] };
+			if (event.Frame < targetFrame)
+			{
+				break;
+			}
+			if (event.Frame == targetFrame)
+			{
+				events.push_back(event);
+			}
+		}
+
+		if (events.empty())
+		{
+			continue;
+		}
+
+		// Parents start before (or with) their children
+		std::sort(events.begin(), events.end(), [](const auto& a, const auto& b) {
+			return a.Start != b.Start ? a.Start < b.Start : a.Depth < b.Depth;
+		});
+
+		// Merge zones with the same name under the same parent. path holds the node index per depth.
+		ThreadFrame threadFrame{ log->Name, {} };
+		auto& nodes{ threadFrame.Zones };
+		std::vector<std::size_t> path;
+		for (const auto& event : events)
+		{
+			const auto depth{ std::min<std::size_t>(event.Depth, path.size()) };
+			path.resize(depth);
+
+			// Siblings live between the parent and the end of the parent's subtree
+			auto position{ depth == 0 ? 0 : path.back() + 1 };
+			auto match{ nodes.size() };
+			for (; position < nodes.size() && nodes[position].Depth >= depth; ++position)
+			{
+				if (nodes[position].Depth == depth && nodes[position].Name == event.Name)
+				{
+					match = position;
+				}
+			}
+
+			const auto milliseconds{ static_cast<double>(event.End - event.Start) / ticksPerMs };
+			if (match != nodes.size())
+			{
+				++nodes[match].Calls;
+				nodes[match].Milliseconds += milliseconds;
+			} else
+			{
+				match = position;
+				nodes.insert(nodes.begin() + position, { event.Name, static_cast<std::uint32_t>(depth), 1, milliseconds });
+			}
+
+			path.push_back(match);
+		}
+
+		threadFrames.push_back(std::move(threadFrame));
+	}
+
+	return threadFrames;
+}
+
+/***********************************************************************************/
+bool Profiler::ExportChromeTrace(const std::filesystem::path& path) const
+{
+	std::error_code ec;
+	if (path.has_parent_path())
+	{
+		std::filesystem::create_directories(path.parent_path(), ec);
+	}
+
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cerr << "Profiler Error: Failed to write " << path.string() << std::endl;
+		return false;
+	}
+
+	const auto ticksPerMicrosecond{ ticksPerMillisecond() / 1000.0 };
+	const auto toMicroseconds = [&](const std::uint64_t ticks) {
+		return ticks > m_epochTicks ? static_cast<double>(ticks - m_epochTicks) / ticksPerMicrosecond : 0.0;
+	};
+
+	std::size_t numEvents{ 0 };
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	std::lock_guard<std::mutex> lock(m_threadsMutex);
+	for (std::size_t thread = 0; thread < m_threads.size(); ++thread)
+	{
+		const auto& log{ *m_threads[thread] };
+
+		out << fmt::format("{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+			numEvents++ ? ",\n" : "", thread, log.Name);
+
+		const auto count{ log.Count.load(std::memory_order_acquire) };
+		const auto oldest{ count > ThreadLog::Capacity ? count - ThreadLog::Capacity : 0 };
+		for (auto i = oldest; i < count; ++i)
+		{
+			const auto& event{ log.Events[i & (ThreadLog::Capacity - 1)] };
+			const auto start{ toMicroseconds(event.Start) };
+			const auto duration{ std::max(0.0, toMicroseconds(event.End) - start) };
+
+			out << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"frame\":{}}}}}",
+				event.Name, thread, start, duration, event.Frame);
+			++numEvents;
+		}
+	}
+
+	out << "\n]}\n";
+
+	std::cout << "Profiler: Wrote " << numEvents << " trace events to " << path.string() << '\n';
+
+	return true;
+}
+
+#endif
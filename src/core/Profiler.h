@@ -0,0 +1,277 @@
+#pragma once
+
+// Low overhead frame profiler.
+//
+//	PROFILE_SCOPE("Culling");		// CPU zone until the end of the scope
+//	PROFILE_GPU_SCOPE("ShadowMap");	// CPU zone plus GL_TIMESTAMP queries, GL thread only
+//
+// PROFILE_NEW_FRAME starts a frame of the main loop, PROFILE_NEW_GPU_FRAME the frame's GL work on the
+// thread that owns the context. They are separate so a render thread can replay a frame after the next began.
+//
+// CPU zones go into a ring buffer owned by the recording thread, so recording never locks. GPU zones are
+// read back a few frames later and never stall the pipeline. Everything, including the GUI overlay and
+// trace export, is compiled out unless GE_ENABLE_PROFILER is defined.
+
+#ifdef GE_ENABLE_PROFILER
+
+#include <glad/glad.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define GE_PROFILER_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GE_PROFILER_RDTSC
+#endif
+
+class Profiler {
+	Profiler();
+	~Profiler() = default;
+public:
+
+	static auto& GetInstance()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	struct Event {
+		// Zone names are string literals
+		const char* Name;
+		// Ticks, see Now()
+		std::uint64_t Start;
+		std::uint64_t End;
+		// Nesting level inside the thread (or the GPU timeline)
+		std::uint32_t Depth;
+		std::uint32_t Frame;
+	};
+
+	// Events of one thread. Only the owning thread writes, readers copy what they need.
+	struct ThreadLog {
+		static constexpr std::size_t Capacity{ 1 << 16 };
+
+		void Push(const Event& event) noexcept
+		{
+			const auto count{ Count.load(std::memory_order_relaxed) };
+			Events[count & (Capacity - 1)] = event;
+			Count.store(count + 1, std::memory_order_release);
+		}
+
+		std::array<Event, Capacity> Events;
+		std::atomic<std::uint64_t> Count{ 0 };
+		std::uint32_t Depth{ 0 };
+		std::string Name;
+	};
+
+	// Aggregated zone of one frame, children follow their parent in depth-first order.
+	struct ZoneNode {
+		const char* Name;
+		std::uint32_t Depth;
+		// Number of zones with this name under the same parent
+		std::uint32_t Calls;
+		double Milliseconds;
+	};
+
+	// Timeline of one thread (or the GPU) for a single frame.
+	struct ThreadFrame {
+		std::string Name;
+		std::vector<ZoneNode> Zones;
+	};
+
+	// Raw timer, rdtsc where available. Convert with TicksToMilliseconds.
+	static std::uint64_t Now() noexcept
+	{
+#ifdef GE_PROFILER_RDTSC
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	double TicksToMilliseconds(const std::uint64_t ticks) const;
+
+	// Log of the calling thread, created on first use.
+	static ThreadLog& GetThreadLog()
+	{
+		thread_local ThreadLog* log{ nullptr };
+		if (log == nullptr)
+		{
+			log = &GetInstance().registerThread();
+		}
+		return *log;
+	}
+
+	// Display name of the calling thread in the overlay and trace.
+	void SetThreadName(std::string name);
+
+	auto GetFrameIndex() const noexcept { return m_frameIndex.load(std::memory_order_relaxed); }
+
+	// Ends the previous frame and starts the next one. Called first thing in each iteration of the main loop.
+	void NewFrame();
+	// Closes the GPU zones issued since the last call and reads back finished frames. Called on the GL thread
+	// before each frame's GL work. Its GPU zones belong to the main loop frame current at that point.
+	void NewGPUFrame();
+
+	// Handle of GPU zones begun while GPU profiling is off
+	static constexpr std::uint32_t InvalidGPUZone{ ~0u };
+
+	// GPU zones need a current GL context.
+	void InitGPU();
+	void ShutdownGPU();
+	// Returns a handle for EndGPUZone.
+	std::uint32_t BeginGPUZone(const char* name);
+	void EndGPUZone(const std::uint32_t zone);
+
+	// Zones of the last completed frame per thread; GPU zones from the newest frame read back.
+	std::vector<ThreadFrame> CollectLastFrame() const;
+	// Milliseconds of the last completed frame, CPU wall time and GPU time of all top level zones.
+	auto GetLastFrameCPUMilliseconds() const noexcept { return m_lastFrameCPUMilliseconds; }
+	auto GetLastFrameGPUMilliseconds() const noexcept { return m_lastFrameGPUMilliseconds.load(std::memory_order_relaxed); }
+
+	// Writes everything still in the ring buffers as Chrome trace event JSON (chrome://tracing, Perfetto).
+	bool ExportChromeTrace(const std::filesystem::path& path) const;
+
+private:
+	ThreadLog& registerThread();
+
+	double ticksPerMillisecond() const noexcept { return m_ticksPerMillisecond.load(std::memory_order_relaxed); }
+	// Tick rate over the time since startup
+	double measureTicksPerMillisecond() const;
+	// Samples GL_TIMESTAMP and Now() together. Reading GL_TIMESTAMP waits for the GL, so it is only taken
+	// every GPUCalibrationInterval frames.
+	void calibrateGPU();
+
+	// Reads back the oldest pending GPU frame. False if there is none, or it is incomplete and wait is not set.
+	bool resolveOldestGPU(const bool wait);
+
+	static constexpr std::size_t MaxGPUFramesInFlight{ 4 };
+	static constexpr std::uint32_t GPUCalibrationInterval{ 600 };
+
+	struct GPUZone {
+		const char* Name;
+		std::uint32_t Depth;
+		// Index of the begin query, the end query follows it
+		std::uint32_t Query;
+	};
+
+	struct GPUFrame {
+		std::vector<GLuint> Queries;
+		std::vector<GPUZone> Zones;
+		std::uint32_t Frame{ 0 };
+		// Most recently issued query
+		std::uint32_t LastQuery{ 0 };
+		// Calibration the frame was issued with, to place GPU zones on the CPU timeline
+		std::int64_t GPUReference{ 0 };
+		std::uint64_t CPUReference{ 0 };
+		bool Pending{ false };
+	};
+
+	// Tick rate is measured between this sample and each NewFrame, conversions use the last measurement
+	const std::uint64_t m_epochTicks;
+	const std::chrono::steady_clock::time_point m_epochTime;
+	std::atomic<double> m_ticksPerMillisecond;
+
+	mutable std::mutex m_threadsMutex;
+	std::vector<std::unique_ptr<ThreadLog>> m_threads;
+
+	std::atomic<std::uint32_t> m_frameIndex{ 0 };
+	std::uint64_t m_frameStart{ 0 };
+	bool m_frameStarted{ false };
+	double m_lastFrameCPUMilliseconds{ 0.0 };
+	// Written by the GL thread
+	std::atomic<double> m_lastFrameGPUMilliseconds{ 0.0 };
+
+	// Resolved GPU zones are stored as events of a pseudo thread
+	ThreadLog* m_gpuLog{ nullptr };
+	std::array<GPUFrame, MaxGPUFramesInFlight> m_gpuFrames;
+	std::size_t m_gpuCurrent{ 0 }, m_gpuOldest{ 0 };
+	std::uint32_t m_gpuDepth{ 0 };
+	std::atomic<std::uint32_t> m_lastResolvedGPUFrame{ 0 };
+	// Last GL_TIMESTAMP and Now() taken together, and the frame they were taken on
+	std::int64_t m_gpuReference{ 0 };
+	std::uint64_t m_cpuReference{ 0 };
+	std::uint32_t m_calibrationFrame{ 0 };
+	bool m_gpuEnabled{ false };
+};
+
+// RAII CPU zone.
+class ProfileZone {
+public:
+	explicit ProfileZone(const char* name) noexcept
+		: m_log{ Profiler::GetThreadLog() }, m_name{ name }, m_start{ Profiler::Now() }
+	{
+		++m_log.Depth;
+	}
+
+	~ProfileZone()
+	{
+		const auto end{ Profiler::Now() };
+		--m_log.Depth;
+		m_log.Push({ m_name, m_start, end, m_log.Depth, Profiler::GetInstance().GetFrameIndex() });
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	Profiler::ThreadLog& m_log;
+	const char* m_name;
+	const std::uint64_t m_start;
+};
+
+// RAII CPU and GPU zone.
+class ProfileGPUZone {
+public:
+	explicit ProfileGPUZone(const char* name)
+		: m_cpuZone{ name }, m_gpuZone{ Profiler::GetInstance().BeginGPUZone(name) }
+	{
+	}
+
+	~ProfileGPUZone()
+	{
+		Profiler::GetInstance().EndGPUZone(m_gpuZone);
+	}
+
+	ProfileGPUZone(const ProfileGPUZone&) = delete;
+	ProfileGPUZone& operator=(const ProfileGPUZone&) = delete;
+
+private:
+	ProfileZone m_cpuZone;
+	const std::uint32_t m_gpuZone;
+};
+
+#define GE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GE_PROFILE_CONCAT(a, b) GE_PROFILE_CONCAT_IMPL(a, b)
+
+#define PROFILE_SCOPE(name) const ProfileZone GE_PROFILE_CONCAT(profileZone, __LINE__){ name }
+#define PROFILE_GPU_SCOPE(name) const ProfileGPUZone GE_PROFILE_CONCAT(profileZone, __LINE__){ name }
+#define PROFILE_THREAD_NAME(name) Profiler::GetInstance().SetThreadName(name)
+#define PROFILE_NEW_FRAME() Profiler::GetInstance().NewFrame()
+#define PROFILE_NEW_GPU_FRAME() Profiler::GetInstance().NewGPUFrame()
+#define PROFILE_INIT_GPU() Profiler::GetInstance().InitGPU()
+#define PROFILE_SHUTDOWN_GPU() Profiler::GetInstance().ShutdownGPU()
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#define PROFILE_NEW_FRAME() ((void)0)
+#define PROFILE_NEW_GPU_FRAME() ((void)0)
+#define PROFILE_INIT_GPU() ((void)0)
+#define PROFILE_SHUTDOWN_GPU() ((void)0)
+
+#endif
@@ -1,6 +1,10 @@
 #include "RenderSystem.h"
 
-#include "../Graphics/GLShaderProgramFactory.h"
+#include "../graphics/GLShaderProgramFactory.h"
+#include "../graphics/GPUMemory.h"
+#include "../graphics/ShaderPreprocessor.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
 #include "../Camera.h"
 
 #include "../Input.h"
@@ -11,9 +15,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <GLFW/glfw3.h>
 
+#include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <iostream>
-#include <random>
-#include "../ResourceManager.h"
+#include <sstream>
+#include "../resourceManager.h"
 #include "../DebugUtility.h"
 
 // https://developer.download.nvidia.com/opengl/specs/GL_NVX_gpu_memory_info.txt
@@ -36,22 +44,34 @@ MessageCallback(GLenum source,
 }
 
 /***********************************************************************************/
-float ourLerp(float a, float b, float f)
-{
-	return a + f * (b - a);
-}
-
-void RenderSystem::Init(const pugi::xml_node& renderNode)
+// Compile-time shader features a program can declare in config.xml. A variant is compiled with
+// "#define <Keyword>" for each feature whose setting is on; bit i of a variant stands for ShaderFeatures[i].
+struct ShaderFeature {
+	const char* Keyword;
+	bool (*IsEnabled)(const RenderSettings& settings);
+};
+
+const std::array<ShaderFeature, 5> ShaderFeatures{ {
+	{ "ENABLE_TEXTURES", [](const RenderSettings& settings) { return settings.renderPass.EnableTextures; } },
+	{ "ENABLE_SHADOWS", [](const RenderSettings& settings) { return settings.renderPass.EnableShadows; } },
+	{ "ENABLE_HDR", [](const RenderSettings& settings) { return settings.postProcessing.hdr.EnableExposure; } },
+	{ "ENABLE_IRRADIANCE_VOLUME", [](const RenderSettings& settings) { return settings.renderPass.EnableIrradianceVolume; } },
+	{ "ENABLE_BINDLESS_TEXTURES", [](const RenderSettings& settings) { return settings.renderPass.BindlessTextures; } }
+} };
+
+void RenderSystem::Init(const pugi::xml_node& renderNode, const GLADloadproc loader, const bool offscreen)
 {
 
 	m_rendererNode = renderNode;
 
-	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+	if (!gladLoadGLLoader(loader))
 	{
 		std::cerr << "Failed to start GLAD.";
 		std::abort();
 	}
 
+	PROFILE_INIT_GPU();
+
 	queryHardwareCaps();
 
 	std::cout << m_caps << '\n';
@@ -69,6 +89,9 @@ void RenderSystem::Init(const pugi::xml_node& renderNode)
 	m_width = width;
 	m_height = height;
 
+	// Decides the shader variants, so it has to be known before they compile
+	renderSettings.renderPass.BindlessTextures = m_rendererNode.child("Materials").attribute("bindless").as_bool() && GLAD_GL_ARB_bindless_texture;
+
 	compileShaders();
 	auto lightNode = m_rendererNode.child("Lighting");
 	float r = lightNode.child("Ambient").attribute("r").as_float();
@@ -78,10 +101,48 @@ void RenderSystem::Init(const pugi::xml_node& renderNode)
 	ambient = glm::vec3(r, g, b) * ambientStrength;
 
 	setupScreenquad();
-	setupGBuffer();
-	setupSSAOBuffer();
-	setupDirectionalShadowMapping();
 	initBoundingBoxDrawing();
+	if (offscreen)
+	{
+		setupOffscreenTarget();
+	}
+	m_passTimer.Init();
+	// Timings resolve on the GL side and are handed out by Update
+	m_passTimer.SetResolveCallback([this](const std::vector<PassTiming>& passes) {
+		std::lock_guard<std::mutex> lock(m_passTimingMutex);
+		m_resolvedPassTimings.insert(m_resolvedPassTimings.end(), passes.cbegin(), passes.cend());
+		m_resolvedPassCounts.push_back(passes.size());
+	});
+
+	// Started by the engine once the context can move
+	const auto renderThreadNode{ m_rendererNode.child("RenderThread") };
+	m_renderThreadEnabled = renderThreadNode.attribute("enabled").as_bool();
+	m_framesInFlight = renderThreadNode.attribute("framesInFlight").as_uint(m_framesInFlight);
+	m_frameData.resize(1);
+
+	// Headless runs are benchmarks and image comparisons, they always render at full resolution
+	const auto dynamicResolutionNode{ m_rendererNode.child("DynamicResolution") };
+	Graphics::DynamicResolution::Settings dynamicResolution;
+	dynamicResolution.Enabled = dynamicResolutionNode.attribute("enabled").as_bool() && !offscreen;
+	dynamicResolution.TargetMilliseconds = dynamicResolutionNode.attribute("targetFrameTime").as_double(dynamicResolution.TargetMilliseconds);
+	dynamicResolution.MinScale = dynamicResolutionNode.attribute("minScale").as_float(dynamicResolution.MinScale);
+	dynamicResolution.MaxScale = dynamicResolutionNode.attribute("maxScale").as_float(dynamicResolution.MaxScale);
+	dynamicResolution.Step = dynamicResolutionNode.attribute("step").as_float(dynamicResolution.Step);
+	dynamicResolution.ProportionalGain = dynamicResolutionNode.attribute("kp").as_float(dynamicResolution.ProportionalGain);
+	dynamicResolution.IntegralGain = dynamicResolutionNode.attribute("ki").as_float(dynamicResolution.IntegralGain);
+	dynamicResolution.DerivativeGain = dynamicResolutionNode.attribute("kd").as_float(dynamicResolution.DerivativeGain);
+	m_dynamicResolution.Init(dynamicResolution);
+	m_upscaleSharpness = dynamicResolutionNode.attribute("sharpness").as_float(m_upscaleSharpness);
+
+	// Probes are baked per scene, long after the config document is gone
+	const auto volumeNode{ m_rendererNode.child("IrradianceVolume") };
+	m_irradianceVolumeEnabled = volumeNode.attribute("enabled").as_bool();
+	m_irradianceVolumeSettings.Resolution.x = volumeNode.attribute("probesX").as_uint(m_irradianceVolumeSettings.Resolution.x);
+	m_irradianceVolumeSettings.Resolution.y = volumeNode.attribute("probesY").as_uint(m_irradianceVolumeSettings.Resolution.y);
+	m_irradianceVolumeSettings.Resolution.z = volumeNode.attribute("probesZ").as_uint(m_irradianceVolumeSettings.Resolution.z);
+	m_irradianceVolumeSettings.NumRays = volumeNode.attribute("rays").as_uint(m_irradianceVolumeSettings.NumRays);
+	m_irradianceVolumeSettings.Albedo = volumeNode.attribute("albedo").as_float(m_irradianceVolumeSettings.Albedo);
+	m_irradianceVolumeSettings.SkyIntensity = volumeNode.attribute("skyIntensity").as_float(m_irradianceVolumeSettings.SkyIntensity);
 	//setupTextureSamplers();
 
 	glEnable(GL_DEBUG_OUTPUT);
@@ -90,64 +151,10 @@ void RenderSystem::Init(const pugi::xml_node& renderNode)
 	setDefaultState();
 	//glEnable(GL_MULTISAMPLE);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_targetFBO);
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glViewport(0, 0, width, height);
 
-	static auto& deferredShader = m_shaderCache.at("Deferred");
-	static auto& shaderLightingPass = m_shaderCache.at("LightingPass");
-	static auto& shaderSSAO = m_shaderCache.at("SSAO");
-	static auto& shaderSSAOBlur = m_shaderCache.at("SSAOBlur");
-	static auto& shaderHDR = m_shaderCache.at("PostProcess_HDR");
-
-	deferredShader.Bind();
-	deferredShader.SetUniformi("gPosition", 0);
-	deferredShader.SetUniformi("gNormal", 1);
-	deferredShader.SetUniformi("gAlbedoSpec", 2);
-
-	shaderLightingPass.Bind();
-	shaderLightingPass.SetUniformi("gPosition", 0);
-	shaderLightingPass.SetUniformi("gNormal", 1);
-	shaderLightingPass.SetUniformi("gAlbedo", 2);
-	shaderLightingPass.SetUniformi("ssao", 3);
-	shaderLightingPass.SetUniformi("depthMap", 4);
-
-	shaderSSAO.Bind();
-	shaderSSAO.SetUniformi("gPosition", 0);
-	shaderSSAO.SetUniformi("gNormal", 1);
-	shaderSSAO.SetUniformi("texNoise", 2);
-
-	shaderSSAOBlur.Bind();
-	shaderSSAOBlur.SetUniformi("ssaoInput", 0);
-
-	shaderHDR.Bind();
-	shaderHDR.SetUniformi("hdrBuffer", 0);
-
-	fboShadows.Init("Shadows");
-	fboShadows.Bind();
-	glGenTextures(1, &depthCubeMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
-	for (unsigned int i = 0; i < 6; ++i)
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-	// attach depth texture as FBO's depth buffer
-	glBindFramebuffer(GL_FRAMEBUFFER, fboShadows.GetId());
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubeMap, 0);
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		printf(" Failed to initialize the shadow frame buffer!\n");
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
 	// shaderLightingPass	= ssao.vs			ssao_lighting.fs
 	// shaderGeometryPass	= ssao_geometry.vs	ssao_geometry.fs
 	// shaderSSAO			= ssao.vs			ssao.fs
@@ -158,15 +165,31 @@ void RenderSystem::Init(const pugi::xml_node& renderNode)
 /***********************************************************************************/
 void RenderSystem::Update(const Camera& camera)
 {
+	PROFILE_SCOPE("RenderSystem::Update");
+
+	deliverPassTimings();
+
+	updateShaderFeatures();
+
+	// Building and checking variants needs the context, with the render thread that is a sync point. It only
+	// happens while files changed or variants are compiling.
+	const auto changedFiles{ m_shaderWatcher.Poll() };
+	const auto compiling{ std::any_of(m_shaderPrograms.cbegin(), m_shaderPrograms.cend(), [](const auto& program) { return !program.second.Pending.empty(); }) };
+	if (!changedFiles.empty() || compiling)
+	{
+		invoke([&]() {
+			reloadShaders(changedFiles);
+			pollShaders();
+		});
+	}
 
-	// Window size changed.
+	// Window size changed. The graph sets the viewport of every pass from the frame's size.
 	if (Input::GetInstance().ShouldResize())
 	{
 		m_width = Input::GetInstance().GetWidth();
 		m_height = Input::GetInstance().GetHeight();
 
 		UpdateView(camera);
-		glViewport(0, 0, (GLsizei)m_width, (GLsizei)m_height);
 	}
 
 	// Update view matrix inside UBO
@@ -176,93 +199,360 @@ void RenderSystem::Update(const Camera& camera)
 }
 
 /***********************************************************************************/
-void RenderSystem::Shutdown() const
+void RenderSystem::Shutdown()
 {
-	for (const auto& shader : m_shaderCache)
+	StopRenderThread();
+
+	PROFILE_SHUTDOWN_GPU();
+	m_passTimer.Shutdown();
+
+	// Ready variants delete their programs when destroyed
+	for (auto& [name, variants] : m_shaderPrograms)
+	{
+		for (auto& [variant, pending] : variants.Pending)
+		{
+			Graphics::GLShaderProgramFactory::discardShaderProgram(pending);
+		}
+	}
+	m_shaderPrograms.clear();
+	m_shaderWatcher.Shutdown();
+	m_shaderDependents.clear();
+
+	m_irradianceVolume.Delete();
+	m_materialTable.Delete();
+	m_transientTextures.Shutdown();
+
+	if (m_targetFBO)
 	{
-		shader.second.DeleteProgram();
+		m_offscreenFBO.Delete();
+		Graphics::GPUMemoryTracker::GetInstance().Untrack(Graphics::GPUResourceType::Texture, m_offscreenColorTexture);
+		Graphics::GPUMemoryTracker::GetInstance().Untrack(Graphics::GPUResourceType::Renderbuffer, m_offscreenDepthBuffer);
+		glDeleteTextures(1, &m_offscreenColorTexture);
+		glDeleteRenderbuffers(1, &m_offscreenDepthBuffer);
+		m_targetFBO = 0;
 	}
 }
 
-void RenderSystem::renderDepthBuffer(const Camera& camera, RenderListIterator renderListBegin, RenderListIterator renderListEnd)
+/***********************************************************************************/
+void RenderSystem::StartRenderThread(std::function<void()> acquire, std::function<void()> present, std::function<void()> release)
 {
-	static auto& gbufferShader = m_shaderCache.at("GBuffer");
-	glm::mat4 projection = camera.GetProjMatrix((float)m_width, (float)m_height);
-	glm::mat4 view = camera.GetViewMatrix();
+	if (!m_renderThreadEnabled || m_renderThread.IsRunning())
+	{
+		return;
+	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fboGBuffer.GetId());
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	gbufferShader.Bind();
-	gbufferShader.SetUniform("projection", projection);
-	gbufferShader.SetUniform("view", view);
+	// Everything issued here must reach the driver before the context moves
+	glFlush();
+	release();
+	m_acquireContext = acquire;
+
+	Graphics::RenderThread::Callbacks callbacks;
+	callbacks.OnStart = std::move(acquire);
+	callbacks.Replay = [this](const Graphics::RenderThread::Frame& frame) {
+		const auto& data{ m_frameData[frame.Slot] };
+		executeFrame(data, frame.Passes.data());
+		if (data.Overlay)
+		{
+			data.Overlay();
+		}
+	};
+	callbacks.OnFrameEnd = std::move(present);
+	callbacks.OnStop = std::move(release);
 
-	renderModelsWithTextures(gbufferShader, renderListBegin, renderListEnd);
+	m_renderThread.Start(m_commandBackend, m_framesInFlight, NumPassCommands, std::move(callbacks));
+	// Nothing is submitted yet, the thread does not read them
+	m_frameData.resize(m_renderThread.GetNumFrames());
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	std::cout << "Render thread started, " << m_renderThread.GetMaxFramesInFlight() << " frames in flight\n";
 }
 
 /***********************************************************************************/
-void RenderSystem::Render(const Camera& camera, RenderListIterator renderListBegin, RenderListIterator renderListEnd, const SceneBase& scene, const bool globalWireframe)
+void RenderSystem::StopRenderThread()
 {
+	if (!m_renderThread.IsRunning())
+	{
+		return;
+	}
+
+	// A frame begun but not submitted is dropped
+	m_renderThread.Stop();
+	m_currentFrame = nullptr;
+	m_acquireContext();
+}
+
+/***********************************************************************************/
+void RenderSystem::WaitForReplay()
+{
+	if (m_renderThread.IsRunning())
+	{
+		m_renderThread.WaitForReplay();
+	}
+}
+
+/***********************************************************************************/
+void RenderSystem::Finish()
+{
+	invoke([]() { glFinish(); });
+}
+
+/***********************************************************************************/
+void RenderSystem::invoke(const std::function<void()>& task)
+{
+	if (m_renderThread.IsRunning())
+	{
+		m_renderThread.Invoke(task);
+	} else
+	{
+		task();
+	}
+}
+
+/***********************************************************************************/
+void RenderSystem::Render(const Camera& camera, const Graphics::RenderScene& renderScene, RenderListIterator renderListBegin, RenderListIterator renderListEnd, const SceneSnapshot& scene, const bool globalWireframe,
+	const Graphics::MeshletDrawList* meshletDraws)
+{
+	PROFILE_SCOPE("RenderSystem::Render");
+
+	// Waits while the render thread is too far behind
+	m_currentFrame = m_renderThread.IsRunning() ? &m_renderThread.BeginFrame() : nullptr;
+	auto& frame{ m_frameData[m_currentFrame != nullptr ? m_currentFrame->Slot : 0] };
+
+	frame.Projection = camera.GetProjMatrix((float)m_width, (float)m_height);
+	frame.View = camera.GetViewMatrix();
+	frame.ViewPosition = camera.GetPosition();
+	// Only the forward path reads the light, scenes may not have one
+	if (!scene.DirectionalLights.empty())
+	{
+		frame.LightDirection = scene.DirectionalLights[0].Direction;
+		frame.LightColor = scene.DirectionalLights[0].Color;
+	}
+	frame.Ambient = ambient * renderSettings.ambientStrength;
+	frame.Width = m_width;
+	frame.Height = m_height;
+	frame.RenderScale = m_dynamicResolution.GetScale();
+	frame.Settings = renderSettings;
+	frame.Overlay = nullptr;
+
+	static constexpr float near_plane = 0.0f, far_plane = 1000.0f;
+	//static const glm::mat4 lightProjection = glm::ortho(-50.0f, 50.0f, -50.0f, 50.0f, near_plane, far_plane);
+	static const glm::mat4 lightProjection = glm::ortho(-50.0f, 50.0f, -50.0f, 50.0f, near_plane, far_plane);
+
+	auto lightView = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f),
+		DirectionalLightTarget,
+		glm::vec3(0.0f, 1.0f, 0.0f));
+
+	/*auto lightView = glm::lookAt(scene.m_staticDirectionalLights[0].Direction,
+		DirectionalLightTarget,
+		glm::vec3(0.0f, 1.0f, 0.0f));*/
+
+	/*auto lightView = glm::lookAt(glm::vec3(-20.0f, 40.0f, -10.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));*/
+
+	frame.LightSpaceMatrix = lightProjection * lightView;
+
+	// Get the shaders we need, the first render call waits for them to finish compiling.
+	// Passes whose shader failed to build are skipped.
+	resolveShaders(frame);
+
+	// The draws of the scene passes are recorded up front on the workers and replayed when the passes execute.
+	// Recording only reads the render scene and the programs' uniform tables.
+	auto* passes{ m_currentFrame != nullptr ? m_currentFrame->Passes.data() : m_passCommands.data() };
+	recordPassCommands(passes, frame, renderScene, renderListBegin, renderListEnd, meshletDraws);
+
+	if (m_currentFrame == nullptr)
+	{
+		executeFrame(frame, passes);
+	}
+}
+
+/***********************************************************************************/
+void RenderSystem::Overlay(std::function<void()> draw)
+{
+	if (m_currentFrame == nullptr)
+	{
+		draw();
+		return;
+	}
+
+	m_frameData[m_currentFrame->Slot].Overlay = std::move(draw);
+}
+
+/***********************************************************************************/
+void RenderSystem::Submit()
+{
+	if (m_currentFrame == nullptr)
+	{
+		return;
+	}
+
+	m_currentFrame = nullptr;
+	m_renderThread.Submit();
+}
+
+/***********************************************************************************/
+void RenderSystem::executeFrame(const FrameData& frame, const Graphics::CommandBuffer* passes)
+{
+	PROFILE_NEW_GPU_FRAME();
+	PROFILE_GPU_SCOPE("Render");
 	setDefaultState();
-	glm::mat4 projection = camera.GetProjMatrix((float)m_width, (float)m_height);
-	glm::mat4 view = camera.GetViewMatrix();
-	glm::mat4 model = glm::mat4(1.0f);
 
-	//glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	//glBindBuffer(GL_UNIFORM_BUFFER, m_uboMatrices);
+	const auto& settings{ frame.Settings };
+	auto* forward_renderer{ frame.ForwardShader };
+	auto* shaderBoundingBox{ frame.BoundingBoxShader };
+	auto* shaderUpscale{ frame.UpscaleShader };
 
-	// Get the shaders we need (static vars initialized during first render call).
-	static auto& gbufferShader = m_shaderCache.at("GBuffer");
-	static auto& deferredShader = m_shaderCache.at("Deferred");
-	static auto& deferredLightBoxShader = m_shaderCache.at("DeferredLightBox");
-	static auto& forward_renderer = m_shaderCache.at("forward_renderer");
-	static auto& shaderBoundingBox = m_shaderCache.at("bounding_box");
+	m_passTimer.BeginFrame();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glClearColor(0.0, 0.0, 0.0, 1.0);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// The offscreen backbuffer follows the screen size like the graph's targets
+	if (m_targetFBO != 0 && (m_offscreenWidth != frame.Width || m_offscreenHeight != frame.Height))
+	{
+		resizeOffscreenTarget(frame.Width, frame.Height);
+	}
+
+	using Graphics::RenderGraph;
+	m_renderGraph.Reset((GLsizei)frame.Width, (GLsizei)frame.Height);
+	const auto backbuffer{ m_renderGraph.ImportFramebuffer("Backbuffer", m_targetFBO) };
+
+	// Below full resolution the scene passes draw into smaller targets the post pass upscales. At full resolution,
+	// or without the upscale shader, they draw straight into the backbuffer.
+	const auto renderScale{ frame.RenderScale };
+	const auto upscale{ renderScale < 1.0f && shaderUpscale != nullptr };
+	RenderGraph::ResourceHandle sceneColor{ backbuffer }, sceneDepth{ RenderGraph::InvalidResource };
 
 	//gBuffer.Bind();
 	// 1. geometry pass: render scene's geometry/color data into gbuffer
 	// -----------------------------------------------------------------
-	//renderDepthBuffer(camera, renderListBegin, renderListEnd);
-	renderDirectionalShadowMapping(scene, renderListBegin, renderListEnd);
+	// Culled by the graph unless the forward pass samples the shadow map
+	RenderGraph::ResourceHandle shadowMap{ RenderGraph::InvalidResource };
+	m_renderGraph.AddPass("ShadowMap",
+		[&](RenderGraph::PassBuilder& builder) {
+			const Graphics::RenderGraphTextureDesc desc{ (GLsizei)m_shadowMapResolution, (GLsizei)m_shadowMapResolution, 1.0f, GL_DEPTH_COMPONENT32, GL_NEAREST, GL_CLAMP_TO_BORDER };
+			shadowMap = builder.Create("ShadowDepth", desc);
+		},
+		[&](const RenderGraph::PassResources&) {
+			renderDirectionalShadowMapping(frame, passes[ShadowPassCommands]);
+		}
+	);
 
 	// 2. Lighting pass
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	forward_renderer.Bind();
-
-	forward_renderer.SetUniform("projection", projection);
-	forward_renderer.SetUniform("view", view);
-	forward_renderer.SetUniform("viewPos", camera.GetPosition());
-	forward_renderer.SetUniform("directionalLightDirection", scene.m_staticDirectionalLights[0].Direction);
-	forward_renderer.SetUniform("directionalLightColor", scene.m_staticDirectionalLights[0].Color);
-
+	m_renderGraph.AddPass("Forward",
+		[&](RenderGraph::PassBuilder& builder) {
+			if (settings.renderPass.EnableShadows)
+			{
+				builder.Read(shadowMap);
+			}
+			if (upscale)
+			{
+				sceneColor = builder.Create("SceneColor", { 0, 0, renderScale, GL_RGBA8, GL_LINEAR });
+				sceneDepth = builder.Create("SceneDepth", { 0, 0, renderScale, GL_DEPTH_COMPONENT24 });
+			} else
+			{
+				builder.Write(backbuffer);
+			}
+		},
+		[&](const RenderGraph::PassResources& resources) {
+			m_shadowDepthTexture = settings.renderPass.EnableShadows ? resources.GetTexture(shadowMap) : 0;
+
+			glClearColor(0.0, 0.0, 0.0, 1.0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			if (forward_renderer == nullptr)
+			{
+				return;
+			}
+
+			forward_renderer->Bind();
+
+			forward_renderer->SetUniform("projection", frame.Projection);
+			forward_renderer->SetUniform("view", frame.View);
+			forward_renderer->SetUniform("viewPos", frame.ViewPosition);
+			forward_renderer->SetUniform("directionalLightDirection", frame.LightDirection);
+			forward_renderer->SetUniform("directionalLightColor", frame.LightColor);
+
+
+			/*for (size_t i = 0; i < scene.m_staticPointLights.size(); ++i)
+			{
+				forward_renderer.SetUniform("pointLights[" + std::to_string(i) + "].position", scene.m_staticPointLights[0].Position);
+				forward_renderer.SetVec3("pointLights[" + std::to_string(i) + "].ambient", {0.05f, 0.05f, 0.05f});
+				forward_renderer.SetVec3("pointLights[" + std::to_string(i) + "].diffuse", {0.8f, 0.8f, 0.8f});
+				forward_renderer.SetVec3("pointLights[" + std::to_string(i) + "].specular", {1.0f, 1.0f, 1.0f});
+				forward_renderer.SetUniformf("pointLights[" + std::to_string(i) + "].constant", 1.0);
+				forward_renderer.SetUniformf("pointLights[" + std::to_string(i) + "].linear", 0.09f);
+				forward_renderer.SetUniformf("pointLights[" + std::to_string(i) + "].quadratic", 0.032f);
+			}*/
+
+			forward_renderer->SetUniform("lightSpaceMatrix", frame.LightSpaceMatrix);
+	
+			forward_renderer->SetUniform("ambient", frame.Ambient);
+			if (settings.renderPass.EnableIrradianceVolume)
+			{
+				m_irradianceVolume.Bind(*forward_renderer, 2);
+			}
+
+			{
+				PROFILE_GPU_SCOPE("DrawModelsTextured");
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, m_shadowDepthTexture);
+				m_materialTable.Bind();
+				m_commandBackend.Execute(passes[ForwardPassCommands]);
+			}
+		}
+	);
+
+	m_renderGraph.AddPass("BoundingBoxes",
+		[&](RenderGraph::PassBuilder& builder) {
+			builder.Write(sceneColor);
+			if (upscale)
+			{
+				builder.Write(sceneDepth);
+			}
+		},
+		[&](const RenderGraph::PassResources&) {
+			if (shaderBoundingBox == nullptr)
+			{
+				return;
+			}
+			shaderBoundingBox->Bind();
+			shaderBoundingBox->SetUniform("projection", frame.Projection);
+			shaderBoundingBox->SetUniform("view", frame.View);
+
+			{
+				PROFILE_GPU_SCOPE("BoundingBoxes");
+				m_commandBackend.Execute(passes[BoundingBoxPassCommands]);
+				glBindVertexArray(0);
+			}
+		}
+	);
 
-	/*for (size_t i = 0; i < scene.m_staticPointLights.size(); ++i)
+	if (upscale)
 	{
-		forward_renderer.SetUniform("pointLights[" + std::to_string(i) + "].position", scene.m_staticPointLights[0].Position);
-		forward_renderer.SetVec3("pointLights[" + std::to_string(i) + "].ambient", {0.05f, 0.05f, 0.05f});
-		forward_renderer.SetVec3("pointLights[" + std::to_string(i) + "].diffuse", {0.8f, 0.8f, 0.8f});
-		forward_renderer.SetVec3("pointLights[" + std::to_string(i) + "].specular", {1.0f, 1.0f, 1.0f});
-		forward_renderer.SetUniformf("pointLights[" + std::to_string(i) + "].constant", 1.0);
-		forward_renderer.SetUniformf("pointLights[" + std::to_string(i) + "].linear", 0.09f);
-		forward_renderer.SetUniformf("pointLights[" + std::to_string(i) + "].quadratic", 0.032f);
-	}*/
-
-	forward_renderer.SetUniform("lightSpaceMatrix", m_lightSpaceMatrix);
-	
-	forward_renderer.SetUniform("ambient", ambient * renderSettings.ambientStrength);
+		m_renderGraph.AddPass("Upscale",
+			[&](RenderGraph::PassBuilder& builder) {
+				builder.Read(sceneColor);
+				builder.Write(backbuffer);
+			},
+			[&](const RenderGraph::PassResources& resources) {
+				glDisable(GL_DEPTH_TEST);
+				shaderUpscale->Bind();
+				shaderUpscale->SetUniformf("renderScale", renderScale);
+				shaderUpscale->SetUniformf("sharpness", m_upscaleSharpness);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, resources.GetTexture(sceneColor));
+				renderQuad();
+				glEnable(GL_DEPTH_TEST);
+			}
+		);
+	}
 
-	renderModelsWithTextures(forward_renderer, renderListBegin, renderListEnd);
+	m_renderGraph.Compile();
+	m_renderGraph.Execute(m_transientTextures, [this](const std::string_view pass) { m_passTimer.BeginPass(pass); });
 
-	shaderBoundingBox.Bind();
-	shaderBoundingBox.SetUniform("projection", projection);
-	shaderBoundingBox.SetUniform("view", view);
-	shaderBoundingBox.SetUniform("projection", projection);
+	m_passTimer.EndFrame();
 
-	renderModelBoundingBox(shaderBoundingBox, renderListBegin, renderListEnd);
+	{
+		std::lock_guard<std::mutex> lock(m_renderGraphStatsMutex);
+		m_renderGraphStats = m_renderGraph.GetStats();
+	}
 
 	//glActiveTexture(GL_TEXTURE0);
 	//glBindTexture(GL_TEXTURE_2D, gPosition);
@@ -319,15 +609,127 @@ void RenderSystem::Render(const Camera& camera, RenderListIterator renderListBeg
 }
 
 /***********************************************************************************/
-int RenderSystem::GetVideoMemUsageKB() const
+void RenderSystem::BuildIrradianceVolume(const SceneBase& scene, const PickingService& tracer)
 {
+	invoke([this]() { m_irradianceVolume.Delete(); });
+
+	if (!m_irradianceVolumeEnabled)
+	{
+		renderSettings.renderPass.EnableIrradianceVolume = false;
+		return;
+	}
+
+	auto settings{ m_irradianceVolumeSettings };
+	// Without an HDR sky the probes see the constant ambient light instead
+	settings.SkyColor = ambient;
+
+	if (m_irradianceVolume.Build(tracer, scene.m_sceneModels, scene.m_staticDirectionalLights, scene.m_skyboxPath, settings))
+	{
+		invoke([this]() { m_irradianceVolume.Upload(); });
+	}
+
+	renderSettings.renderPass.EnableIrradianceVolume = HasIrradianceVolume();
+}
+
+/***********************************************************************************/
+void RenderSystem::BuildMaterialTable(const Graphics::RenderScene& renderScene)
+{
+	invoke([&]() {
+		m_materialTable.Build(renderScene.GetMaterials(), renderSettings.renderPass.BindlessTextures ?
+			Graphics::MaterialTable::TextureMode::Bindless : Graphics::MaterialTable::TextureMode::Arrays);
+	});
+}
+
+/***********************************************************************************/
+int RenderSystem::GetVideoMemUsageKB()
+{
+	// Other vendors do not report it, GPUMemoryTracker has the engine's own allocations everywhere
+	if (!GLAD_GL_NVX_gpu_memory_info)
+	{
+		return 0;
+	}
+
 	GLint currentAvailable{ 0 };
 
-	glGetIntegerv(GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &currentAvailable);
+	invoke([&currentAvailable]() { glGetIntegerv(GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &currentAvailable); });
 
 	return m_caps.TotalVideoMemoryKB - currentAvailable;
 }
 
+/***********************************************************************************/
+std::vector<std::uint8_t> RenderSystem::ReadFramebuffer()
+{
+	std::vector<std::uint8_t> pixels(m_width * m_height * 4);
+
+	invoke([&]() {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_targetFBO);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, (GLsizei)m_width, (GLsizei)m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	});
+
+	// GL rows start at the bottom
+	const auto rowSize{ m_width * 4 };
+	for (std::size_t y = 0; y < m_height / 2; ++y)
+	{
+		std::swap_ranges(pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize, pixels.begin() + (m_height - 1 - y) * rowSize);
+	}
+
+	return pixels;
+}
+
+/***********************************************************************************/
+void RenderSystem::FlushPassTimings()
+{
+	invoke([this]() { m_passTimer.Flush(); });
+	deliverPassTimings();
+}
+
+/***********************************************************************************/
+Graphics::RenderGraph::Stats RenderSystem::GetRenderGraphStats()
+{
+	std::lock_guard<std::mutex> lock(m_renderGraphStatsMutex);
+	return m_renderGraphStats;
+}
+
+/***********************************************************************************/
+void RenderSystem::deliverPassTimings()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_passTimingMutex);
+		std::swap(m_resolvedPassTimings, m_deliveredPassTimings);
+		std::swap(m_resolvedPassCounts, m_deliveredPassCounts);
+	}
+
+	if (m_deliveredPassCounts.empty())
+	{
+		return;
+	}
+
+	auto first{ m_deliveredPassTimings.cbegin() };
+	for (const auto count : m_deliveredPassCounts)
+	{
+		m_passTimings.assign(first, first + count);
+		first += count;
+
+		if (m_onPassTimings)
+		{
+			m_onPassTimings(m_passTimings);
+		}
+	}
+	m_deliveredPassTimings.clear();
+	m_deliveredPassCounts.clear();
+
+	// Timings arrive a few frames late, the controller is fed the newest one
+	auto gpuMilliseconds{ 0.0 };
+	for (const auto& pass : m_passTimings)
+	{
+		gpuMilliseconds += pass.GPUMilliseconds;
+	}
+	m_dynamicResolution.Update(gpuMilliseconds);
+}
+
 /***********************************************************************************/
 // TODO: This needs to be gutted and put elsewhere
 void RenderSystem::UpdateView(const Camera& camera)
@@ -340,25 +742,332 @@ void RenderSystem::UpdateView(const Camera& camera)
 /***********************************************************************************/
 void RenderSystem::compileShaders()
 {
-	m_shaderCache.clear();
+	const auto start{ std::chrono::steady_clock::now() };
+
+	m_shaderPrograms.clear();
+	m_missingShaders.clear();
+	m_shaderDependents.clear();
+
+	if (m_rendererNode.attribute("hotReloadShaders").as_bool() && m_shaderWatcher.Init())
+	{
+		std::cout << "Shader hot reload enabled\n";
+	}
+
 	for (auto program = m_rendererNode.child("Program"); program; program = program.next_sibling("Program"))
 	{
+		const std::string name{ program.attribute("name").as_string() };
+		ShaderProgramVariants variants;
 
 		// Get all shader files that make up the program
-		std::vector<Graphics::ShaderStage> stages;
 		for (auto shader = program.child("Shader"); shader; shader = shader.next_sibling("Shader"))
 		{
-			stages.emplace_back(shader.attribute("path").as_string(), shader.attribute("type").as_string());
+			variants.Stages.emplace_back(shader.attribute("path").as_string(), shader.attribute("type").as_string());
+		}
+
+		// Space separated feature keywords
+		std::istringstream features{ program.attribute("features").as_string() };
+		for (std::string keyword; features >> keyword;)
+		{
+			const auto feature{ std::find_if(ShaderFeatures.cbegin(), ShaderFeatures.cend(), [&keyword](const auto& feature) { return keyword == feature.Keyword; }) };
+			if (feature == ShaderFeatures.cend())
+			{
+				std::cerr << "RenderSystem Error: Unknown shader feature " << keyword << " in program " << name << std::endl;
+				continue;
+			}
+
+			variants.FeatureMask |= 1u << (feature - ShaderFeatures.cbegin());
+		}
+
+		m_shaderPrograms.try_emplace(name, std::move(variants));
+	}
+
+	updateShaderFeatures();
+
+	// Without parallel compile a submitted program blocks the first time it is checked, so only
+	// variants that are actually used get compiled.
+	if (!Graphics::GLShaderProgramFactory::enableParallelCompile())
+	{
+		std::cout << m_shaderPrograms.size() << " shader programs compile on first use\n";
+		return;
+	}
+
+	// Other variants are built when the settings ask for them
+	for (auto& [name, variants] : m_shaderPrograms)
+	{
+		submitShader(name, variants, m_shaderFeatures & variants.FeatureMask);
+	}
+
+	std::cout << fmt::format("{} shader programs submitted for parallel compilation in {:.1f} ms\n", m_shaderPrograms.size(),
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+/***********************************************************************************/
+void RenderSystem::updateShaderFeatures()
+{
+	// Without probes the shaders would sample an empty texture
+	renderSettings.renderPass.EnableIrradianceVolume &= HasIrradianceVolume();
+
+	m_shaderFeatures = 0;
+	for (std::size_t i = 0; i < ShaderFeatures.size(); ++i)
+	{
+		if (ShaderFeatures[i].IsEnabled(renderSettings))
+		{
+			m_shaderFeatures |= 1u << i;
 		}
+	}
+}
 
-		std::string name{ program.attribute("name").as_string() };
+/***********************************************************************************/
+GLShaderProgram* RenderSystem::getShader(const std::string_view name)
+{
+	const auto program{ m_shaderPrograms.find(name) };
+	if (program == m_shaderPrograms.end())
+	{
+		if (m_missingShaders.emplace(name).second)
+		{
+			std::cerr << "RenderSystem Error: No shader program named " << name << " in the config" << std::endl;
+		}
+		return nullptr;
+	}
+
+	auto& variants{ program->second };
+	const auto variant{ m_shaderFeatures & variants.FeatureMask };
 
-		auto shaderProgram{ Graphics::GLShaderProgramFactory::createShaderProgram(name, stages) };
+	if (const auto shader{ variants.Ready.find(variant) }; shader != variants.Ready.end())
+	{
+		return &shader->second;
+	}
 
-		if (shaderProgram)
+	if (variants.Failed.count(variant) == 0)
+	{
+		auto pending{ variants.Pending.find(variant) };
+		if (pending == variants.Pending.end())
 		{
-			m_shaderCache.try_emplace(name, std::move(shaderProgram.value())); // value_or for default and remove if-check?
+			submitShader(program->first, variants, variant);
+			pending = variants.Pending.find(variant);
 		}
+
+		// Toggling a feature never stalls a frame when the driver compiles in the background
+		if (variants.Ready.empty() || !Graphics::GLShaderProgramFactory::isParallelCompileEnabled())
+		{
+			auto shaderProgram{ Graphics::GLShaderProgramFactory::pollShaderProgram(pending->second, true) };
+			variants.Pending.erase(pending);
+
+			if (shaderProgram)
+			{
+				auto& shader{ variants.Ready.try_emplace(variant, std::move(shaderProgram.value())).first->second };
+				setInitialUniforms(shader);
+				return &shader;
+			}
+
+			variants.Failed.insert(variant);
+		}
+	}
+
+	// Any variant that did build is better than skipping the pass
+	return variants.Ready.empty() ? nullptr : &variants.Ready.begin()->second;
+}
+
+/***********************************************************************************/
+bool RenderSystem::isShaderResolved(const std::string_view name) const
+{
+	const auto program{ m_shaderPrograms.find(name) };
+	if (program == m_shaderPrograms.cend())
+	{
+		return true;
+	}
+
+	// Mirrors getShader: only a variant that is neither ready nor failed gets submitted or polled, unless the
+	// driver compiles it in the background and another variant stands in
+	const auto& variants{ program->second };
+	const auto variant{ m_shaderFeatures & variants.FeatureMask };
+	return variants.Ready.count(variant) != 0 || variants.Failed.count(variant) != 0 ||
+		(variants.Pending.count(variant) != 0 && !variants.Ready.empty() && Graphics::GLShaderProgramFactory::isParallelCompileEnabled());
+}
+
+/***********************************************************************************/
+void RenderSystem::resolveShaders(FrameData& frame)
+{
+	const auto lookup = [this, &frame]() {
+		frame.ForwardShader = getShader("forward_renderer");
+		frame.BoundingBoxShader = getShader("bounding_box");
+		frame.UpscaleShader = getShader("PostProcess_Upscale");
+		frame.ShadowDepthShader = getShader("directional_shadow_mapping");
+	};
+
+	if (isShaderResolved("forward_renderer") && isShaderResolved("bounding_box") && isShaderResolved("PostProcess_Upscale") &&
+		isShaderResolved("directional_shadow_mapping"))
+	{
+		lookup();
+	} else
+	{
+		invoke(lookup);
+	}
+}
+
+/***********************************************************************************/
+void RenderSystem::submitShader(const std::string& name, ShaderProgramVariants& program, const std::uint32_t variant)
+{
+	std::vector<std::string> defines;
+	for (std::size_t i = 0; i < ShaderFeatures.size(); ++i)
+	{
+		if (variant & (1u << i))
+		{
+			defines.emplace_back(ShaderFeatures[i].Keyword);
+		}
+	}
+
+	auto& pending{ program.Pending.insert_or_assign(variant, Graphics::GLShaderProgramFactory::submitShaderProgram(name, program.Stages, defines)).first->second };
+
+	// Includes may have been added or removed since the last build
+	for (auto& [file, programs] : m_shaderDependents)
+	{
+		programs.erase(name);
+	}
+
+	for (const auto& stage : program.Stages)
+	{
+		const auto path{ Graphics::ShaderPreprocessor::Normalize(stage.filePath) };
+		m_shaderDependents[path.generic_string()].insert(name);
+		m_shaderWatcher.Watch(path);
+	}
+
+	for (const auto& files : pending.StageFiles)
+	{
+		for (const auto& file : files)
+		{
+			m_shaderDependents[file.generic_string()].insert(name);
+			m_shaderWatcher.Watch(file);
+		}
+	}
+}
+
+/***********************************************************************************/
+void RenderSystem::reloadShaders(const std::vector<std::filesystem::path>& changedFiles)
+{
+	if (changedFiles.empty())
+	{
+		return;
+	}
+
+	std::unordered_set<std::string> programs;
+	for (const auto& file : changedFiles)
+	{
+		Graphics::ShaderPreprocessor::GetInstance().Invalidate(file);
+
+		if (const auto dependents{ m_shaderDependents.find(Graphics::ShaderPreprocessor::Normalize(file).generic_string()) }; dependents != m_shaderDependents.cend())
+		{
+			programs.insert(dependents->second.cbegin(), dependents->second.cend());
+		}
+	}
+
+	for (const auto& name : programs)
+	{
+		const auto program{ m_shaderPrograms.find(name) };
+		if (program == m_shaderPrograms.end())
+		{
+			continue;
+		}
+
+		auto& variants{ program->second };
+
+		// Every variant built so far, successfully or not
+		std::unordered_set<std::uint32_t> rebuild(variants.Failed.cbegin(), variants.Failed.cend());
+		for (const auto& [variant, shader] : variants.Ready)
+		{
+			rebuild.insert(variant);
+		}
+		for (auto& [variant, pending] : variants.Pending)
+		{
+			Graphics::GLShaderProgramFactory::discardShaderProgram(pending);
+			rebuild.insert(variant);
+		}
+		variants.Pending.clear();
+		variants.Failed.clear();
+
+		std::cout << "Reloading shader program " << name << " (" << rebuild.size() << " variants)" << std::endl;
+
+		for (const auto variant : rebuild)
+		{
+			submitShader(name, variants, variant);
+		}
+	}
+}
+
+/***********************************************************************************/
+void RenderSystem::pollShaders()
+{
+	for (auto& [name, variants] : m_shaderPrograms)
+	{
+		for (auto pending = variants.Pending.begin(); pending != variants.Pending.end();)
+		{
+			auto shaderProgram{ Graphics::GLShaderProgramFactory::pollShaderProgram(pending->second, false) };
+			if (shaderProgram)
+			{
+				// A reloaded variant replaces (and deletes) the one in use
+				variants.Ready.erase(pending->first);
+				setInitialUniforms(variants.Ready.try_emplace(pending->first, std::move(shaderProgram.value())).first->second);
+			} else if (pending->second.Status == Graphics::PendingShaderProgram::State::Failed)
+			{
+				variants.Failed.insert(pending->first);
+			} else
+			{
+				++pending;
+				continue;
+			}
+
+			pending = variants.Pending.erase(pending);
+		}
+	}
+}
+
+/***********************************************************************************/
+void RenderSystem::setInitialUniforms(GLShaderProgram& shader) const
+{
+	const auto name{ shader.GetProgramName() };
+
+	if (name == "Deferred")
+	{
+		shader.Bind();
+		shader.SetUniformi("gPosition", 0);
+		shader.SetUniformi("gNormal", 1);
+		shader.SetUniformi("gAlbedoSpec", 2);
+	} else if (name == "LightingPass")
+	{
+		shader.Bind();
+		shader.SetUniformi("gPosition", 0);
+		shader.SetUniformi("gNormal", 1);
+		shader.SetUniformi("gAlbedo", 2);
+		shader.SetUniformi("ssao", 3);
+		shader.SetUniformi("depthMap", 4);
+	} else if (name == "SSAO")
+	{
+		shader.Bind();
+		shader.SetUniformi("gPosition", 0);
+		shader.SetUniformi("gNormal", 1);
+		shader.SetUniformi("texNoise", 2);
+	} else if (name == "SSAOBlur")
+	{
+		shader.Bind();
+		shader.SetUniformi("ssaoInput", 0);
+	} else if (name == "PostProcess_HDR")
+	{
+		shader.Bind();
+		shader.SetUniformi("hdrBuffer", 0);
+	} else if (name == "PostProcess_Upscale")
+	{
+		shader.Bind();
+		shader.SetUniformi("sceneColor", 0);
+	} else if (name == "forward_renderer")
+	{
+		// Array samplers of material.glsl, compiled out in the bindless variant
+		std::array<GLint, Graphics::MaterialTable::MaxTextureArrays> units;
+		for (std::size_t i = 0; i < units.size(); ++i)
+		{
+			units[i] = static_cast<GLint>(Graphics::MaterialTable::FirstTextureUnit + i);
+		}
+		shader.Bind();
+		glUniform1iv(shader.GetUniformLocation("materialTextures"), static_cast<GLsizei>(units.size()), units.data());
 	}
 }
 
@@ -368,8 +1077,12 @@ void RenderSystem::queryHardwareCaps()
 	// Anisotropic filtering
 	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &m_caps.MaxAnisotropy);
 
-	// Video memory
-	glGetIntegerv(GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &m_caps.TotalVideoMemoryKB);
+	// Video memory, the query is NVIDIA only and leaves garbage elsewhere
+	m_caps.TotalVideoMemoryKB = 0;
+	if (GLAD_GL_NVX_gpu_memory_info)
+	{
+		glGetIntegerv(GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &m_caps.TotalVideoMemoryKB);
+	}
 }
 
 /***********************************************************************************/
@@ -377,6 +1090,9 @@ void RenderSystem::setDefaultState()
 {
 	glEnable(GL_DEPTH_TEST);
 
+	// Meshes without baked ambient occlusion read this instead of a vertex stream
+	glVertexAttrib1f(Mesh::AmbientOcclusionAttribute, 1.0f);
+
 	/*glFrontFace(GL_CCW);
 	glCullFace(GL_BACK);
 	glEnable(GL_CULL_FACE);
@@ -386,119 +1102,138 @@ void RenderSystem::setDefaultState()
 	//glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-void RenderSystem::renderModelBoundingBox(GLShaderProgram& shader, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const
+/***********************************************************************************/
+void RenderSystem::recordPassCommands(Graphics::CommandBuffer* passes, const FrameData& frame, const Graphics::RenderScene& renderScene,
+	RenderListIterator renderListBegin, RenderListIterator renderListEnd, const Graphics::MeshletDrawList* meshletDraws)
 {
-	auto begin{ renderListBegin };
+	PROFILE_SCOPE("RecordCommands");
 
-	while (begin != renderListEnd)
-	{
-		glm::vec3 min = (*begin)->GetBoundingBox().getMin();
-		glm::vec3 max = (*begin)->GetBoundingBox().getMax();
-		glm::mat4 model = glm::mat4(1.0f);
-		
-		model = glm::translate(model, (*begin)->GetBoundingBox().getCenter());
-		model = glm::scale(model, glm::vec3((max.x - min.x) / 2, (max.y - min.y) / 2, (max.z - min.z) / 2));
-
-		shader.SetUniform("model", model);
-		//shader.SetUniform("minExtents", (*begin)->GetBoundingBox().getMin());
-		//shader.SetUniform("maxExtents", (*begin)->GetBoundingBox().getMax());
-		if ((*begin)->GetSelected())
+	// One pass per task, each into its own buffer and arena
+	ThreadPool::GetInstance().ParallelFor(NumPassCommands, 1, [&](const std::size_t begin, const std::size_t end) {
+		for (auto pass = begin; pass < end; ++pass)
 		{
-			shader.SetUniformi("selected", true);
-		} else
-		{
-			shader.SetUniformi("selected", false);
+			auto& commands{ passes[pass] };
+			commands.Reset();
+
+			if (pass == ShadowPassCommands && frame.ShadowDepthShader != nullptr)
+			{
+				recordModelsNoTextures(commands, *frame.ShadowDepthShader, renderScene, renderListBegin, renderListEnd);
+			} else if (pass == ForwardPassCommands && frame.ForwardShader != nullptr)
+			{
+				recordModelsWithTextures(commands, *frame.ForwardShader, renderScene, renderListBegin, renderListEnd, meshletDraws);
+			} else if (pass == BoundingBoxPassCommands && frame.BoundingBoxShader != nullptr)
+			{
+				recordModelBoundingBoxes(commands, *frame.BoundingBoxShader, renderScene, renderListBegin, renderListEnd);
+			}
 		}
-		
-		const auto& meshes{ (*begin)->GetMeshes() };
-		for (const auto& mesh : meshes)
+	});
+}
+
+/***********************************************************************************/
+void RenderSystem::recordModelBoundingBoxes(Graphics::CommandBuffer& commands, const GLShaderProgram& shader, const Graphics::RenderScene& renderScene,
+	RenderListIterator renderListBegin, RenderListIterator renderListEnd) const
+{
+	PROFILE_SCOPE("RecordBoundingBoxes");
+	const auto modelLocation{ shader.GetUniformLocation("model") };
+	const auto selectedLocation{ shader.GetUniformLocation("selected") };
+
+	const auto& models{ renderScene.GetModels() };
+	const auto& meshes{ renderScene.GetMeshes() };
+	auto lastModel{ SlotMap<Graphics::RenderModel>::InvalidIndex };
+	for (auto begin{ renderListBegin }; begin != renderListEnd; ++begin)
+	{
+		// Meshes of a model are listed together, one box per run
+		const auto modelIndex{ renderScene.GetModelIndex(meshes[*begin]) };
+		if (modelIndex == lastModel)
 		{
-			glBindVertexArray(boundingBoxVAO);
-			glDrawArrays(GL_LINE_LOOP, 0, boundingBoxVertices.size());
-			glBindVertexArray(0);
+			continue;
 		}
-		++begin;
+		lastModel = modelIndex;
+
+		const auto& aabb{ models[modelIndex].Bounds };
+		const auto min{ aabb.getMin() };
+		const auto max{ aabb.getMax() };
+
+		auto model{ glm::translate(glm::mat4(1.0f), aabb.getCenter()) };
+		model = glm::scale(model, (max - min) * 0.5f);
+
+		commands.SetUniform(modelLocation, model);
+		commands.SetUniform(selectedLocation, models[modelIndex].Selected ? 1 : 0);
+		commands.DrawArrays(boundingBoxVAO, GL_LINE_LOOP, 0, static_cast<GLsizei>(boundingBoxVertices.size()));
 	}
 }
 
 /***********************************************************************************/
-void RenderSystem::renderModelsWithTextures(GLShaderProgram& shader, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const
+void RenderSystem::recordModelsWithTextures(Graphics::CommandBuffer& commands, const GLShaderProgram& shader, const Graphics::RenderScene& renderScene,
+	RenderListIterator renderListBegin, RenderListIterator renderListEnd, const Graphics::MeshletDrawList* meshletDraws) const
 {
-	//glBindSampler(m_samplerPBRTextures, 3);
-	//glBindSampler(m_samplerPBRTextures, 4);
-	//glBindSampler(m_samplerPBRTextures, 5);
-	//glBindSampler(m_samplerPBRTextures, 6);
-	// glBindSampler(m_samplerPBRTextures, 7);
-
-	auto begin{ renderListBegin };
-
-	while (begin != renderListEnd)
+	PROFILE_SCOPE("RecordModelsTextured");
+	const auto modelLocation{ shader.GetUniformLocation("model") };
+	const auto materialLocation{ shader.GetUniformLocation("materialIndex") };
+
+	// The shadow map on unit 1 is bound by the pass, its texture is only known once the graph executes
+	commands.SetUniform(shader.GetUniformLocation("shadowMap"), 1);
+
+	// Material textures are bound once for the pass by the material table, draws only switch the index
+	const auto& models{ renderScene.GetModels() };
+	const auto& meshes{ renderScene.GetMeshes() };
+	auto lastModel{ SlotMap<Graphics::RenderModel>::InvalidIndex };
+	auto lastMaterial{ SlotMap<Graphics::RenderMaterial>::InvalidIndex };
+	for (auto begin{ renderListBegin }; begin != renderListEnd; ++begin)
 	{
-		shader.SetUniform("model", (*begin)->GetModelMatrix());
+		const auto& mesh{ meshes[*begin] };
+		// Meshes whose meshlets were all culled are skipped
+		const auto* draw{ meshletDraws != nullptr ? &meshletDraws->Draws[begin - renderListBegin] : nullptr };
+		if (draw != nullptr && draw->NumRanges == 0)
+		{
+			continue;
+		}
 
-		const auto& meshes{ (*begin)->GetMeshes() };
-		for (const auto& mesh : meshes)
+		const auto modelIndex{ renderScene.GetModelIndex(mesh) };
+		if (modelIndex != lastModel)
 		{
+			commands.SetUniform(modelLocation, models[modelIndex].Transform);
+			lastModel = modelIndex;
+		}
 
-			//uniform sampler2D texture_diffuse1;
-			//uniform sampler2D texture_specular1;
-			//glUniform1i(glGetUniformLocation(shader., (name + number).c_str()), i);
-
-			shader.SetUniformi("diffuseTexture", 0);
-			shader.SetUniformi("shadowMap", 1);
-			
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, mesh.Material->GetParameterTexture(PBRMaterial::ALBEDO));
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, m_shadowDepthTexture);
-			//shader.SetUniformi("diffuseTexture", 0);
-			//glActiveTexture(GL_TEXTURE1);
-			//glBindTexture(GL_TEXTURE_2D, mesh.Material->GetParameterTexture(PBRMaterial::METALLIC));
-			//shader.SetUniformi("texture_specular1", 1);
-			//shader.SetUniformi("texture_specular1", mesh.Material->GetParameterTexture(PBRMaterial::METALLIC));
-
-
-		/*	glActiveTexture(GL_TEXTURE3);
-			glBindTexture(GL_TEXTURE_2D, mesh.Material->GetParameterTexture(PBRMaterial::ALBEDO));
-			glActiveTexture(GL_TEXTURE4);
-			glBindTexture(GL_TEXTURE_2D, mesh.Material->GetParameterTexture(PBRMaterial::NORMAL));
-			glActiveTexture(GL_TEXTURE5);
-			glBindTexture(GL_TEXTURE_2D, mesh.Material->GetParameterTexture(PBRMaterial::METALLIC));
-			glActiveTexture(GL_TEXTURE6);
-			glBindTexture(GL_TEXTURE_2D, mesh.Material->GetParameterTexture(PBRMaterial::ROUGHNESS));*/
-
-			//glActiveTexture(GL_TEXTURE7);
-			//glBindTexture(GL_TEXTURE_2D, mesh.Material.AOMap);
-
-			mesh.VAO.Bind();
-			glDrawElements(GL_TRIANGLES, (GLsizei)mesh.IndexCount, GL_UNSIGNED_INT, nullptr);
-			glBindTexture(GL_TEXTURE_2D, 0);
+		const auto materialIndex{ m_materialTable.GetIndex(renderScene.GetMaterialIndex(mesh)) };
+		if (materialIndex != lastMaterial)
+		{
+			commands.SetUniform(materialLocation, static_cast<int>(materialIndex));
+			lastMaterial = materialIndex;
 		}
 
-		++begin;
+		if (draw != nullptr)
+		{
+			commands.DrawElementRanges(mesh.VertexArray, GL_TRIANGLES, meshletDraws->Ranges.data() + draw->FirstRange, draw->NumRanges);
+		} else
+		{
+			commands.DrawElements(mesh.VertexArray, GL_TRIANGLES, mesh.IndexCount);
+		}
 	}
-
-	glBindSampler(m_samplerPBRTextures, 0);
 }
 
 /***********************************************************************************/
-void RenderSystem::renderModelsNoTextures(GLShaderProgram& shader, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const
+void RenderSystem::recordModelsNoTextures(Graphics::CommandBuffer& commands, const GLShaderProgram& shader, const Graphics::RenderScene& renderScene,
+	RenderListIterator renderListBegin, RenderListIterator renderListEnd) const
 {
-	auto begin{ renderListBegin };
+	PROFILE_SCOPE("RecordModels");
+	const auto modelLocation{ shader.GetUniformLocation("model") };
 
-	while (begin != renderListEnd)
+	const auto& models{ renderScene.GetModels() };
+	const auto& meshes{ renderScene.GetMeshes() };
+	auto lastModel{ SlotMap<Graphics::RenderModel>::InvalidIndex };
+	for (auto begin{ renderListBegin }; begin != renderListEnd; ++begin)
 	{
-		shader.SetUniform("model", (*begin)->GetModelMatrix());
-
-		const auto& meshes{ (*begin)->GetMeshes() };
-		for (const auto& mesh : meshes)
+		const auto& mesh{ meshes[*begin] };
+		const auto modelIndex{ renderScene.GetModelIndex(mesh) };
+		if (modelIndex != lastModel)
 		{
-			mesh.VAO.Bind();
-			glDrawElements(GL_TRIANGLES, (GLsizei)mesh.IndexCount, GL_UNSIGNED_INT, nullptr);
-			glBindTexture(GL_TEXTURE_2D, 0);
+			commands.SetUniform(modelLocation, models[modelIndex].Transform);
+			lastModel = modelIndex;
 		}
 
-		++begin;
+		commands.DrawElements(mesh.VertexArray, GL_TRIANGLES, mesh.IndexCount);
 	}
 }
 
@@ -510,41 +1245,28 @@ void RenderSystem::renderQuad() const
 }
 
 /***********************************************************************************/
-void RenderSystem::renderDirectionalShadowMapping(const SceneBase& scene, RenderListIterator renderListBegin, RenderListIterator renderListEnd)
+void RenderSystem::renderDirectionalShadowMapping(const FrameData& frame, const Graphics::CommandBuffer& commands)
 {
+	PROFILE_GPU_SCOPE("ShadowMap");
 	glEnable(GL_DEPTH_TEST);
 
-	static auto& shadowDepthShader = m_shaderCache.at("directional_shadow_mapping");
-	shadowDepthShader.Bind();
-	static constexpr float near_plane = 0.0f, far_plane = 1000.0f;
-	//static const glm::mat4 lightProjection = glm::ortho(-50.0f, 50.0f, -50.0f, 50.0f, near_plane, far_plane);
-	static const glm::mat4 lightProjection = glm::ortho(-50.0f, 50.0f, -50.0f, 50.0f, near_plane, far_plane);
-
-	auto lightView = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f),
-		DirectionalLightTarget,
-		glm::vec3(0.0f, 1.0f, 0.0f));
-	
-	/*auto lightView = glm::lookAt(scene.m_staticDirectionalLights[0].Direction,
-		DirectionalLightTarget,
-		glm::vec3(0.0f, 1.0f, 0.0f));*/
-
-	/*auto lightView = glm::lookAt(glm::vec3(-20.0f, 40.0f, -10.0f),
-		glm::vec3(0.0f, 0.0f, 0.0f),
-		glm::vec3(0.0f, 1.0f, 0.0f));*/
-
-	m_lightSpaceMatrix = lightProjection * lightView;
-
-	shadowDepthShader.SetUniform("lightSpaceMatrix", m_lightSpaceMatrix);
+	auto* shadowDepthShader{ frame.ShadowDepthShader };
+	if (shadowDepthShader == nullptr)
+	{
+		return;
+	}
+	shadowDepthShader->Bind();
+	shadowDepthShader->SetUniform("lightSpaceMatrix", frame.LightSpaceMatrix);
 
+	// The render graph has bound the shadow map and set the viewport
 	glCullFace(GL_FRONT); // Solve peter-panning
-	glViewport(0, 0, m_shadowMapResolution, m_shadowMapResolution);
-	m_shadowFBO.Bind();
 	glClear(GL_DEPTH_BUFFER_BIT);
 
-	renderModelsNoTextures(shadowDepthShader, renderListBegin, renderListEnd);
+	{
+		PROFILE_GPU_SCOPE("DrawModels");
+		m_commandBackend.Execute(commands);
+	}
 
-	m_shadowFBO.Unbind();
-	glViewport(0, 0, (GLsizei)m_width, (GLsizei)m_height);
 	glCullFace(GL_BACK);
 }
 
@@ -559,6 +1281,7 @@ void RenderSystem::setupScreenquad()
 			Vertex({ 1.0f, -1.0f, 0.0f }, { 1.0f, 0.0f })
 	};
 
+	Graphics::GPUMemoryScope memoryScope(Graphics::GPUMemoryCategory::Pass, "Screen quad");
 	m_quadVAO.Init();
 	m_quadVAO.Bind();
 	m_quadVAO.AttachBuffer(GLVertexArray::BufferType::ARRAY,
@@ -582,51 +1305,6 @@ void RenderSystem::setupTextureSamplers()
 
 }
 
-/***********************************************************************************/
-void RenderSystem::setupDirectionalShadowMapping()
-{
-	const static float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-
-	m_shadowFBO.Init("Shadow Depth FBO");
-	m_shadowFBO.Bind();
-
-	// Depth texture
-	if (m_shadowDepthTexture)
-	{
-		glDeleteTextures(1, &m_shadowDepthTexture);
-	}
-	glGenTextures(1, &m_shadowDepthTexture);
-	glBindTexture(GL_TEXTURE_2D, m_shadowDepthTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, m_shadowMapResolution, m_shadowMapResolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER); // Clamp to border to fix over-sampling
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-	// Colour texture for Variance Shadow Mapping (VSM)
-	if (m_shadowColorTexture)
-	{
-		glDeleteTextures(1, &m_shadowColorTexture);
-	}
-	glGenTextures(1, &m_shadowColorTexture);
-	glBindTexture(GL_TEXTURE_2D, m_shadowColorTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, m_shadowMapResolution, m_shadowMapResolution, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // Hardware linear filtering gives us soft shadows for free!
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER); // Clamp to border to fix over-sampling
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, m_caps.MaxAnisotropy); // Anisotropic filtering for sharper angles
-	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-	m_shadowFBO.AttachTexture(m_shadowDepthTexture, GLFramebuffer::AttachmentType::DEPTH);
-	//m_shadowFBO.AttachTexture(m_shadowColorTexture, GLFramebuffer::AttachmentType::COLOR0);
-
-	m_shadowFBO.Unbind();
-}
-
-
 /***********************************************************************************/
 void RenderSystem::setProjectionMatrix(const Camera& camera)
 {
@@ -635,127 +1313,61 @@ void RenderSystem::setProjectionMatrix(const Camera& camera)
 	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), value_ptr(m_projMatrix));
 }
 
-void RenderSystem::setupGBuffer()
+/***********************************************************************************/
+void RenderSystem::setupOffscreenTarget()
 {
-	fboGBuffer.Init("GBuffer");
-	fboGBuffer.Bind();
+	m_offscreenFBO.Init("Offscreen");
+	glGenTextures(1, &m_offscreenColorTexture);
+	glGenRenderbuffers(1, &m_offscreenDepthBuffer);
+	m_targetFBO = m_offscreenFBO.GetId();
 
-	// position color buffer
-	glGenTextures(1, &gPosition);
-	glBindTexture(GL_TEXTURE_2D, gPosition);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_width, m_height, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-	// normal color buffer
-	glGenTextures(1, &gNormal);
-	glBindTexture(GL_TEXTURE_2D, gNormal);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_width, m_height, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-	// color + specular color buffer
-	glGenTextures(1, &gAlbedo);
-	glBindTexture(GL_TEXTURE_2D, gAlbedo);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedo, 0);
-	// tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
-	unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-	glDrawBuffers(3, attachments);
-	// create and attach depth buffer (renderbuffer)
-	unsigned int rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, m_width, m_height);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-	// finally check if framebuffer is complete
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	resizeOffscreenTarget(m_width, m_height);
 }
 
-void RenderSystem::setupSSAOBuffer()
+/***********************************************************************************/
+void RenderSystem::resizeOffscreenTarget(const std::size_t width, const std::size_t height)
 {
-	// Create framebuffer to hold SSAO processing stage
-	fboSSAO.Init("SSAO");
-	fboSSAO.Bind();
-
-	// SSAO color buffer
-	glGenTextures(1, &ssaoColorBuffer);
-	glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, m_width, m_height, 0, GL_RED, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBuffer, 0);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "SSAO Framebuffer not complete!" << std::endl;
-	// and blur stage
-	fboSSAOBlur.Init("SSAO Blur");
-	fboSSAOBlur.Bind();
-	glGenTextures(1, &ssaoColorBufferBlur);
-	glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, m_width, m_height, 0, GL_RED, GL_FLOAT, NULL);
+	m_offscreenWidth = width;
+	m_offscreenHeight = height;
+	m_offscreenFBO.Bind();
+
+	glBindTexture(GL_TEXTURE_2D, m_offscreenColorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, (GLsizei)width, (GLsizei)height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	Graphics::GPUMemoryTracker::GetInstance().Track(Graphics::GPUResourceType::Texture, m_offscreenColorTexture,
+		Graphics::GetTextureBytes(GL_RGBA8, (GLsizei)width, (GLsizei)height), Graphics::GPUMemoryCategory::Pass, "Offscreen");
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBufferBlur, 0);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "SSAO Blur Framebuffer not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// generate sample kernel
-	// ----------------------
-	std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
-	std::default_random_engine generator;
-	for (unsigned int i = 0; i < 64; ++i)
-	{
-		glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
-		sample = glm::normalize(sample);
-		sample *= randomFloats(generator);
-		float scale = float(i) / 64.0f;
+	m_offscreenFBO.AttachTexture(m_offscreenColorTexture, GLFramebuffer::AttachmentType::COLOR0);
 
-		// scale samples s.t. they're more aligned to center of kernel
-		scale = ourLerp(0.1f, 1.0f, scale * scale);
-		sample *= scale;
-		ssaoKernel.push_back(sample);
-	}
+	glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenDepthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, (GLsizei)width, (GLsizei)height);
+	Graphics::GPUMemoryTracker::GetInstance().Track(Graphics::GPUResourceType::Renderbuffer, m_offscreenDepthBuffer,
+		Graphics::GetTextureBytes(GL_DEPTH_COMPONENT24, (GLsizei)width, (GLsizei)height), Graphics::GPUMemoryCategory::Pass, "Offscreen");
+	m_offscreenFBO.AttachRenderBuffer(m_offscreenDepthBuffer, GLFramebuffer::AttachmentType::DEPTH);
 
-	// generate noise texture
-	// ----------------------
-	for (unsigned int i = 0; i < 16; i++)
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 	{
-		glm::vec3 noise(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, 0.0f); // rotate around z-axis (in tangent space)
-		ssaoNoise.push_back(noise);
+		std::cerr << "RenderSystem Error: Offscreen framebuffer not complete!" << std::endl;
 	}
 
-	glGenTextures(1, &noiseTexture);
-	glBindTexture(GL_TEXTURE_2D, noiseTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 4, 4, 0, GL_RGB, GL_FLOAT, &ssaoNoise[0]);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void RenderSystem::renderDepthPass(GLShaderProgram& shader, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const
+void RenderSystem::renderDepthPass(GLShaderProgram& shader, const Graphics::RenderScene& renderScene, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const
 {
-	auto begin{ renderListBegin };
+	const auto& models{ renderScene.GetModels() };
+	const auto& meshes{ renderScene.GetMeshes() };
 
-	while (begin != renderListEnd)
+	for (auto begin{ renderListBegin }; begin != renderListEnd; ++begin)
 	{
-		shader.SetUniform("modelMatrix", (*begin)->GetModelMatrix());
-
-		const auto& meshes{ (*begin)->GetMeshes() };
-		for (const auto& mesh : meshes)
-		{
-
-			mesh.VAO.Bind();
-			glDrawElements(GL_TRIANGLES, (GLsizei)mesh.IndexCount, GL_UNSIGNED_INT, nullptr);
-			glBindTexture(GL_TEXTURE_2D, 0);
-		}
+		const auto& mesh{ meshes[*begin] };
+		shader.SetUniform("modelMatrix", models[renderScene.GetModelIndex(mesh)].Transform);
 
-		++begin;
+		glBindVertexArray(mesh.VertexArray);
+		glDrawElements(GL_TRIANGLES, mesh.IndexCount, GL_UNSIGNED_INT, nullptr);
+		glBindTexture(GL_TEXTURE_2D, 0);
 	}
 }
 
@@ -765,6 +1377,8 @@ void RenderSystem::initBoundingBoxDrawing()
 	glGenBuffers(1, &boundingBoxVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, boundingBoxVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * boundingBoxVertices.size(), &boundingBoxVertices[0], GL_STATIC_DRAW);
+	Graphics::GPUMemoryTracker::GetInstance().Track(Graphics::GPUResourceType::Buffer, boundingBoxVBO, sizeof(glm::vec3) * boundingBoxVertices.size(),
+		Graphics::GPUMemoryCategory::Other, "Bounding boxes");
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	// Generate VAO
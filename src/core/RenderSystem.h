@@ -2,18 +2,39 @@
 
 #include "../Model.h"
 #include "../Skybox.h"
-#include "../Graphics/GLFrameBuffer.h"
-#include "../Graphics/GLVertexArray.h"
-#include "../Graphics/GLShaderProgram.h"
-#include "../Graphics/HardwareCaps.h"
+#include "../IrradianceVolume.h"
+#include "../graphics/GLFrameBuffer.h"
+#include "../graphics/GLVertexArray.h"
+#include "../graphics/GLShaderProgram.h"
+#include "../graphics/GLShaderProgramFactory.h"
+#include "../graphics/GLPassTimer.h"
+#include "../graphics/HardwareCaps.h"
+#include "../graphics/DynamicResolution.h"
+#include "../graphics/RenderGraph.h"
+#include "../graphics/TransientTexturePool.h"
+#include "../graphics/RenderBackend.h"
+#include "../graphics/RenderScene.h"
+#include "../graphics/RenderThread.h"
+#include "../graphics/MaterialTable.h"
+#include "FileWatcher.h"
+#include "LinearArena.h"
 
 #include <pugixml.hpp>
 
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class Camera;
 class SceneBase;
+struct SceneSnapshot;
 class GLShaderProgram;
 
 struct SSAO {
@@ -23,12 +44,17 @@ struct SSAO {
 };
 
 struct RenderPass{
-	bool EnableTextures;
+	bool EnableTextures{ true };
+	bool EnableShadows{ true };
+	// Only takes effect while a baked irradiance volume exists
+	bool EnableIrradianceVolume{ true };
+	// Material textures as GL_ARB_bindless_texture handles instead of texture arrays, fixed at Init
+	bool BindlessTextures{ false };
 };
 
 struct HDR {
-	bool EnableExposure;
-	float Exposure;
+	bool EnableExposure{ true };
+	float Exposure{ 1.0f };
 };
 struct PostProcessing {
 	HDR hdr;
@@ -40,24 +66,79 @@ struct RenderSettings {
 	float ambientStrength;
 };
 
+// Indices into RenderScene::GetMeshes() of the meshes drawn in a frame, allocated from the engine's per-frame arena
+using RenderList = ArenaVector<std::uint32_t>;
+
 class RenderSystem {
-	using RenderListIterator = std::vector<ModelPtr>::const_iterator;
+	using RenderListIterator = RenderList::const_iterator;
 public:
-	void Init(const pugi::xml_node& rendererNode);
+	// loader resolves OpenGL functions for the current context. With offscreen set the final image goes
+	// to an internal framebuffer instead of the default one (headless mode).
+	void Init(const pugi::xml_node& rendererNode, const GLADloadproc loader, const bool offscreen = false);
 	void Update(const Camera& camera);
 
-	void Shutdown() const;
+	void Shutdown();
 
 	void UpdateView(const Camera& camera);
 
+	// Records the frame's draws and executes them, or with the render thread running queues them until Submit.
 	void Render(const Camera& camera,
+		const Graphics::RenderScene& renderScene,
 		RenderListIterator renderListBegin,
 		RenderListIterator renderListEnd,
-		const SceneBase& scene,
-		const bool globalWireFrame = false
+		const SceneSnapshot& scene,
+		const bool globalWireFrame = false,
+		// Index ranges the forward pass draws of each listed mesh instead of all its indices, from
+		// RenderScene::CullMeshlets over the same list. The shadow pass always draws whole meshes.
+		const Graphics::MeshletDrawList* meshletDraws = nullptr
 	);
-
-	int GetVideoMemUsageKB() const;
+	// Draws over the frame Render recorded last, after its passes. Runs right away without the render thread.
+	// draw must stay small enough for std::function's local storage, so frames do not allocate.
+	void Overlay(std::function<void()> draw);
+	// Hands the frame Render recorded to the render thread. Does nothing without it.
+	void Submit();
+
+	// Moves the context to a thread replaying the recorded frames if the config enables it. acquire makes the
+	// context current on the calling thread and release detaches it, present runs after every frame.
+	void StartRenderThread(std::function<void()> acquire, std::function<void()> present, std::function<void()> release);
+	// Replays what was submitted, waits for the GPU and makes the context current on this thread again.
+	void StopRenderThread();
+	bool HasRenderThread() const noexcept { return m_renderThread.IsRunning(); }
+	auto GetRenderThreadStats() { return m_renderThread.GetStats(); }
+	// Blocks until the render thread replayed every submitted frame, the GPU may still be working on them.
+	void WaitForReplay();
+	// Blocks until the GPU finished every submitted frame.
+	void Finish();
+
+	// Driver reported usage of the whole process, 0 unless the driver has GL_NVX_gpu_memory_info
+	int GetVideoMemUsageKB();
+
+	// Bakes (or loads from cache) the irradiance probes of the scene if the config enables them. tracer must
+	// have been updated with the scene's models and hold their triangles.
+	void BuildIrradianceVolume(const SceneBase& scene, const PickingService& tracer);
+	bool HasIrradianceVolume() const noexcept { return !m_irradianceVolume.IsEmpty(); }
+	// Uploads the materials of renderScene for the forward pass. Call again after materials were added.
+	void BuildMaterialTable(const Graphics::RenderScene& renderScene);
+
+	// Per-pass CPU and GPU times of the newest frame the GPU has finished.
+	const auto& GetPassTimings() const noexcept { return m_passTimings; }
+	// Called once for every rendered frame, a few frames after it was submitted. Always on this thread, from
+	// Update, even when the render thread resolved the timings.
+	void SetPassTimingCallback(GLPassTimer::ResolveCallback callback) { m_onPassTimings = std::move(callback); }
+	// Waits for the GPU and reports all outstanding pass timings.
+	void FlushPassTimings();
+
+	// Scale the scene is rendered at and the state of the controller choosing it.
+	const auto& GetDynamicResolution() const noexcept { return m_dynamicResolution; }
+
+	// Passes culled and memory saved by aliasing in the last frame's render graph.
+	Graphics::RenderGraph::Stats GetRenderGraphStats();
+
+	// Reads back the final image as RGBA8, top row first.
+	std::vector<std::uint8_t> ReadFramebuffer();
+
+	auto GetWidth() const noexcept { return m_width; }
+	auto GetHeight() const noexcept { return m_height; }
 	glm::vec3 DirectionalLightTarget;
 
 	RenderSettings renderSettings;
@@ -66,38 +147,98 @@ private:
 	glm::vec3 ambient;
 	float ambientStrength;
 
+	// Everything the GL side of a frame reads, captured when it is recorded. The render thread replays a frame
+	// while the next one is recorded, so nothing it uses may change under it.
+	struct FrameData {
+		glm::mat4 Projection, View, LightSpaceMatrix;
+		glm::vec3 ViewPosition, LightDirection, LightColor, Ambient;
+		std::size_t Width{ 0 }, Height{ 0 };
+		float RenderScale{ 1.0f };
+		RenderSettings Settings;
+		GLShaderProgram* ForwardShader{ nullptr };
+		GLShaderProgram* BoundingBoxShader{ nullptr };
+		GLShaderProgram* UpscaleShader{ nullptr };
+		GLShaderProgram* ShadowDepthShader{ nullptr };
+		std::function<void()> Overlay;
+	};
+
 	void initBoundingBoxDrawing();
+	// Reads the programs from the config. With parallel compile they are all submitted to the driver
+	// right away, otherwise each one compiles on first use.
 	void compileShaders();
+	// Compiled shader permutations of one program from the config, keyed by the ShaderFeatures bits they
+	// were built with
+	struct ShaderProgramVariants {
+		std::vector<Graphics::ShaderStage> Stages;
+		// Features the program declares, a variant is the enabled subset of them
+		std::uint32_t FeatureMask{ 0 };
+		std::unordered_map<std::uint32_t, GLShaderProgram> Ready;
+		// Submitted to the driver but not checked yet
+		std::unordered_map<std::uint32_t, Graphics::PendingShaderProgram> Pending;
+		// Failed to build, not retried until one of their files changes
+		std::unordered_set<std::uint32_t> Failed;
+	};
+
+	// Feature bits selected by renderSettings
+	void updateShaderFeatures();
+	// Variant of a program matching the current features, finishing its compilation if necessary. With parallel
+	// compile a variant built earlier is used until a new one is ready. nullptr if nothing could be built.
+	GLShaderProgram* getShader(const std::string_view name);
+	// False if getShader(name) would call OpenGL to build or check a variant
+	bool isShaderResolved(const std::string_view name) const;
+	// Looks up the programs of the frame's passes, on the render thread if one has to be built
+	void resolveShaders(FrameData& frame);
+	// Hands a variant to the driver and records which source files it depends on
+	void submitShader(const std::string& name, ShaderProgramVariants& program, const std::uint32_t variant);
+	// Resubmits only the programs built from the source files that changed on disk. The old variants stay in
+	// use until the new ones are ready, and for good if they fail to build.
+	void reloadShaders(const std::vector<std::filesystem::path>& changedFiles);
+	// Moves variants the driver has finished in the background into the shader cache. Never blocks.
+	void pollShaders();
+	// Sampler units and other uniforms that never change, set once a program is ready
+	void setInitialUniforms(GLShaderProgram& shader) const;
 	//
 	void queryHardwareCaps();
 	// Sets the default state required for rendering
 	void setDefaultState();
-	// Render models boundingbox contained in the renderlist.
-	void renderModelBoundingBox(GLShaderProgram& shader, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const;
-	// Render models contained in the renderlist
-	void renderModelsWithTextures(GLShaderProgram& shader, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const;
-	// Render models without binding textures (for a depth or shadow pass perhaps)
-	void renderModelsNoTextures(GLShaderProgram& shader, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const;
+	// Runs task on the render thread once it replayed everything submitted, or right here without one
+	void invoke(const std::function<void()>& task);
+	// Records the draws of the shadow, forward and bounding box passes into passes (NumPassCommands of them) in
+	// parallel. A pass whose shader is missing records nothing.
+	void recordPassCommands(Graphics::CommandBuffer* passes, const FrameData& frame, const Graphics::RenderScene& renderScene,
+		RenderListIterator renderListBegin, RenderListIterator renderListEnd, const Graphics::MeshletDrawList* meshletDraws);
+	// GL side of a frame: runs the render graph, replaying passes, then draws the overlay. On the render thread
+	// if it runs.
+	void executeFrame(const FrameData& frame, const Graphics::CommandBuffer* passes);
+	// Hands pass timings the GL side resolved to the callback and the dynamic resolution controller
+	void deliverPassTimings();
+	// Records the bounding box of every model with a mesh in the renderlist.
+	void recordModelBoundingBoxes(Graphics::CommandBuffer& commands, const GLShaderProgram& shader, const Graphics::RenderScene& renderScene,
+		RenderListIterator renderListBegin, RenderListIterator renderListEnd) const;
+	// Records meshes contained in the renderlist, only the ranges of meshletDraws where given
+	void recordModelsWithTextures(Graphics::CommandBuffer& commands, const GLShaderProgram& shader, const Graphics::RenderScene& renderScene,
+		RenderListIterator renderListBegin, RenderListIterator renderListEnd, const Graphics::MeshletDrawList* meshletDraws) const;
+	// Records meshes without binding textures (for a depth or shadow pass perhaps)
+	void recordModelsNoTextures(Graphics::CommandBuffer& commands, const GLShaderProgram& shader, const Graphics::RenderScene& renderScene,
+		RenderListIterator renderListBegin, RenderListIterator renderListEnd) const;
 	// Render NDC screenquad
 	void renderQuad() const;
 	// Renders shadowmap
-	void renderDirectionalShadowMapping(const SceneBase& scene, RenderListIterator renderListBegin, RenderListIterator renderListEnd);
+	void renderDirectionalShadowMapping(const FrameData& frame, const Graphics::CommandBuffer& commands);
 	// Configure NDC screenquad
 	void setupScreenquad();
 	// Setup texture samplers
 	void setupTextureSamplers();
-	// Setup FBO, resolution, etc for shadow mapping
-	void setupDirectionalShadowMapping();
 	// Sets projection matrix variable and updates UBO
 	void setProjectionMatrix(const Camera& camera);
-	// Sets Framebuffer for GBuffer
-	void setupGBuffer();
-	// Sets framebuffer for ssao computation
-	void setupSSAOBuffer();
+	// Color and depth target replacing the default framebuffer in headless mode
+	void setupOffscreenTarget();
+	// (Re)allocates the offscreen target at the given size
+	void resizeOffscreenTarget(const std::size_t width, const std::size_t height);
 
-	void renderDepthBuffer(const Camera& camera, RenderListIterator renderListBegin, RenderListIterator renderListEnd);
-	void renderDepthPass(GLShaderProgram& shader, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const;
+	void renderDepthPass(GLShaderProgram& shader, const Graphics::RenderScene& renderScene, RenderListIterator renderListBegin, RenderListIterator renderListEnd) const;
 
+	// Only valid during Init, the engine frees the config document afterwards
 	pugi::xml_node m_rendererNode;
 
 	Graphics::HardwareCaps m_caps;
@@ -105,58 +246,84 @@ private:
 	// Screen dimensions
 	std::size_t m_width{ 0 }, m_height{ 0 };
 
+	// Framebuffer the final image is rendered to, 0 unless offscreen
+	GLuint m_targetFBO{ 0 };
+	GLFramebuffer m_offscreenFBO;
+	GLuint m_offscreenColorTexture{ 0 }, m_offscreenDepthBuffer{ 0 };
+	std::size_t m_offscreenWidth{ 0 }, m_offscreenHeight{ 0 };
+
+	// Used by the GL side only. Resolved timings are queued under the mutex, flat, with the pass count of each
+	// frame, and swapped out by Update. Both sides keep their capacity, so steady frames do not allocate.
+	GLPassTimer m_passTimer;
+	std::mutex m_passTimingMutex;
+	std::vector<PassTiming> m_resolvedPassTimings, m_deliveredPassTimings;
+	std::vector<std::size_t> m_resolvedPassCounts, m_deliveredPassCounts;
+	// Newest delivered frame
+	std::vector<PassTiming> m_passTimings;
+	GLPassTimer::ResolveCallback m_onPassTimings;
+
+	// Fed the GPU time of the newest frame delivered by each Update
+	Graphics::DynamicResolution m_dynamicResolution;
+	// Unsharp mask applied while upscaling, weighted by how far below full resolution the scene is
+	float m_upscaleSharpness{ 0.5f };
+
 	// Uniform buffer for projection and view matrix
 	GLuint m_uboMatrices{ 0 };
 
 	// Projection matrix
-	glm::mat4 m_projMatrix, m_lightSpaceMatrix;
+	glm::mat4 m_projMatrix;
 
 	// Texture samplers
 	GLuint m_samplerPBRTextures{ 0 };
 
-	// Shadow mapping
-	GLuint m_shadowMapResolution{ 2048 }, m_shadowDepthTexture{ 0 }, m_shadowColorTexture{ 0 };
-	GLFramebuffer m_shadowFBO;
-
-	// Depth frame Buffer
-	GLFramebuffer m_depthBuffer;
+	// Passes of the frame and the textures they render to. The graph is declared anew every frame; the pool
+	// keeps its textures between frames and reallocates them when their size changes. GL side only, the stats
+	// of the last executed graph are copied out under m_renderGraphStatsMutex.
+	Graphics::RenderGraph m_renderGraph;
+	Graphics::TransientTexturePool m_transientTextures;
+	std::mutex m_renderGraphStatsMutex;
+	Graphics::RenderGraph::Stats m_renderGraphStats;
+
+	// Draws of the scene passes, recorded every frame and replayed by the passes. Without the render thread the
+	// frame is recorded here, with it into the thread's frame.
+	static constexpr std::size_t ShadowPassCommands{ 0 }, ForwardPassCommands{ 1 }, BoundingBoxPassCommands{ 2 }, NumPassCommands{ 3 };
+	std::array<Graphics::CommandBuffer, NumPassCommands> m_passCommands;
+	Graphics::GLRenderBackend m_commandBackend;
+
+	// Replays the frames while the next is recorded, if the config enables it. One FrameData per frame of the
+	// thread, or a single one without it. m_currentFrame is the one Render recorded last.
+	Graphics::RenderThread m_renderThread;
+	bool m_renderThreadEnabled{ false };
+	std::uint32_t m_framesInFlight{ 2 };
+	std::function<void()> m_acquireContext;
+	std::vector<FrameData> m_frameData;
+	Graphics::RenderThread::Frame* m_currentFrame{ nullptr };
+
+	// Shadow mapping. The depth texture belongs to the render graph and is 0 while shadows are off.
+	GLuint m_shadowMapResolution{ 2048 }, m_shadowDepthTexture{ 0 };
 
 	// Environment map
 	Skybox m_skybox;
-
-	// Compiled shader cache
-	std::unordered_map<std::string, GLShaderProgram> m_shaderCache;
+	// Baked indirect diffuse light of the active scene
+	IrradianceVolume m_irradianceVolume;
+	bool m_irradianceVolumeEnabled{ false };
+	IrradianceVolume::Settings m_irradianceVolumeSettings;
+	// Materials of the active scene, draws select one by index
+	Graphics::MaterialTable m_materialTable;
+
+	// Every program in the config and its compiled variants. Ordered with a transparent comparator, getShader
+	// looks programs up every frame by string_view without building a key.
+	std::map<std::string, ShaderProgramVariants, std::less<>> m_shaderPrograms;
+	// Programs asked for that are not in the config, reported once
+	std::unordered_set<std::string> m_missingShaders;
+	std::uint32_t m_shaderFeatures{ 0 };
+	// Shader hot reload: every source file, includes too, and the programs built from it
+	FileWatcher m_shaderWatcher;
+	std::unordered_map<std::string, std::unordered_set<std::string>> m_shaderDependents;
 
 	// Screen-quad
 	GLVertexArray m_quadVAO;
 
-	// Post-Processing
-	// HDR
-	GLuint m_hdrColorBuffer{ 0 }, m_brightnessThresholdColorBuffer{ 0 };
-	GLFramebuffer m_hdrFBO;
-	// Bloom
-	std::array<GLFramebuffer, 2> m_pingPongFBOs;
-	std::array<GLuint, 2> m_pingPongColorBuffers{0, 0};
-	// Vibrance
-	const float m_vibrance{ 0.1f };
-	const glm::vec4 m_coefficient{ 0.299f, 0.587f, 0.114f, 0.0f };
-
-	GLFramebuffer fboGBuffer;
-	GLFramebuffer fboSSAO;
-	GLFramebuffer fboSSAOBlur;
-	GLFramebuffer fbolightingPass;
-	GLFramebuffer fboShadows;
-
-	unsigned int lightingPassTexture;
-	unsigned int gPosition, gNormal, gAlbedo;
-	unsigned int rboDepth;
-
-	std::vector<glm::vec3> ssaoKernel;
-	std::vector<glm::vec3> ssaoNoise;
-	unsigned int noiseTexture;
-	unsigned int depthCubeMap;
-	unsigned int ssaoColorBuffer, ssaoColorBufferBlur;
-
 	// Bounding box
 	GLuint boundingBoxVBO;
 	GLuint boundingBoxVAO;
@@ -198,13 +365,4 @@ private:
 	glm::vec3(-1.0f, 1.0f, 1.0f),
 	glm::vec3(-1.0f, 1.0f, -1.0f)
 	};
-
-	// lighting info
-	// -------------
-	std::vector<glm::vec3> lightPositions;
-    std::vector<glm::vec3> lightColors;
-
-	// Shadow Info
-	const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
-	std::vector<glm::mat4> shadowTransforms;
 };
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "SimulationThread.h"
+#include "Profiler.h"
+
+#include "../SceneBase.h"
+
+#include <algorithm>
+
+/***********************************************************************************/
+void SimulationThread::Start(SceneBase& scene, const double tickRate)
+{
+	Stop();
+
+	m_scene = &scene;
+	m_tickSeconds = 1.0 / std::max(tickRate, 1.0);
+
+	// The render thread has a state to show before the first step lands
+	scene.CaptureSnapshot(m_current);
+	m_current.Tick = 0;
+	m_current.Time = 0.0;
+	m_previous = m_current;
+
+	m_ticks.store(0, std::memory_order_relaxed);
+	m_droppedTicks.store(0, std::memory_order_relaxed);
+	m_tickMilliseconds.store(0.0, std::memory_order_relaxed);
+
+	m_stop = false;
+	m_start = Clock::now();
+	m_thread = std::thread(&SimulationThread::threadLoop, this);
+}
+
+/***********************************************************************************/
+void SimulationThread::Stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_stopCondition.notify_one();
+	m_thread.join();
+
+	// Drop what was published after the last Interpolate, a restart must not pick it up
+	while (m_snapshots.Update())
+	{
+	}
+}
+
+/***********************************************************************************/
+SimulationThread::Stats SimulationThread::GetStats() const noexcept
+{
+	Stats stats;
+	stats.Ticks = m_ticks.load(std::memory_order_relaxed);
+	stats.DroppedTicks = m_droppedTicks.load(std::memory_order_relaxed);
+	stats.TickMilliseconds = m_tickMilliseconds.load(std::memory_order_relaxed);
+
+	return stats;
+}
+
+/***********************************************************************************/
+void SimulationThread::Interpolate(SceneSnapshot& out)
+{
+	if (m_snapshots.Update())
+	{
+		std::swap(m_previous, m_current);
+		m_current = m_snapshots.GetReadBuffer();
+	}
+
+	// One step behind the simulation the two newest snapshots almost always enclose the time shown. Snapshots
+	// missed by a slow frame do not matter, alpha is computed from their times rather than assumed to be a step.
+	const auto renderTime{ getTime(Clock::now()) - m_tickSeconds };
+	const auto span{ m_current.Time - m_previous.Time };
+	const auto alpha{ span > 0.0 ? std::clamp((renderTime - m_previous.Time) / span, 0.0, 1.0) : 1.0 };
+
+	InterpolateSnapshots(m_previous, m_current, static_cast<float>(alpha), out);
+}
+
+/***********************************************************************************/
+void SimulationThread::threadLoop()
+{
+	PROFILE_THREAD_NAME("Simulation");
+
+	const auto tick{ std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_tickSeconds)) };
+	auto next{ m_start };
+	std::uint64_t numTicks{ 0 };
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		next += tick;
+		if (m_stopCondition.wait_until(lock, next, [this]() { return m_stop; }))
+		{
+			break;
+		}
+		lock.unlock();
+
+		// Behind schedule the wait returns right away and steps run back to back. After a long stall
+		// (debugger, loading) the backlog beyond MaxCatchUpTicks is skipped instead of simulated.
+		const auto stepStart{ Clock::now() };
+		const auto behind{ stepStart > next ? static_cast<std::uint64_t>((stepStart - next) / tick) : 0 };
+		if (behind > MaxCatchUpTicks)
+		{
+			next += tick * static_cast<Clock::rep>(behind - MaxCatchUpTicks);
+			m_droppedTicks.fetch_add(behind - MaxCatchUpTicks, std::memory_order_relaxed);
+		}
+
+		{
+			PROFILE_SCOPE("Simulate");
+			m_scene->Simulate(m_tickSeconds);
+		}
+
+		auto& snapshot{ m_snapshots.GetWriteBuffer() };
+		m_scene->CaptureSnapshot(snapshot);
+		snapshot.Tick = ++numTicks;
+		snapshot.Time = getTime(next);
+		m_snapshots.Publish();
+
+		const auto milliseconds{ std::chrono::duration<double, std::milli>(Clock::now() - stepStart).count() };
+		const auto average{ m_tickMilliseconds.load(std::memory_order_relaxed) };
+		m_tickMilliseconds.store(numTicks == 1 ? milliseconds : average + 0.05 * (milliseconds - average), std::memory_order_relaxed);
+		m_ticks.store(numTicks, std::memory_order_relaxed);
+
+		lock.lock();
+	}
+}
+
+/***********************************************************************************/
+double SimulationThread::getTime(const Clock::time_point time) const noexcept
+{
+	return std::chrono::duration<double>(time - m_start).count();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "TripleBuffer.h"
+#include "../SceneSnapshot.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+class SceneBase;
+
+// Steps a scene at a fixed rate on its own thread, so simulation overlaps with rendering and does not depend
+// on the frame rate. Every step publishes a SceneSnapshot through a TripleBuffer; the render thread picks up
+// the two newest and interpolates between them one step in the past, which keeps motion smooth at any frame
+// rate. While it runs, the thread owns the scene's simulated state (see SceneBase::Simulate).
+class SimulationThread {
+	using Clock = std::chrono::steady_clock;
+public:
+	struct Stats {
+		std::uint64_t Ticks{ 0 };
+		// Steps skipped because the simulation fell further behind than MaxCatchUpTicks
+		std::uint64_t DroppedTicks{ 0 };
+		// Average CPU time of a step
+		double TickMilliseconds{ 0.0 };
+	};
+
+	// Steps run back to back to catch up after a stall before the remaining ones are dropped
+	static constexpr std::uint32_t MaxCatchUpTicks{ 5 };
+
+	SimulationThread() = default;
+	~SimulationThread() { Stop(); }
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	// Captures the current state of scene as the first snapshot and starts stepping it tickRate times a second.
+	void Start(SceneBase& scene, const double tickRate);
+	// Waits for the step in progress to finish. The scene belongs to the calling thread again afterwards.
+	void Stop();
+
+	bool IsRunning() const noexcept { return m_thread.joinable(); }
+	double GetTickSeconds() const noexcept { return m_tickSeconds; }
+	Stats GetStats() const noexcept;
+
+	// Render thread. Picks up the newest snapshot and writes the state one step before now, interpolated
+	// between the two newest snapshots, to out.
+	void Interpolate(SceneSnapshot& out);
+
+private:
+	void threadLoop();
+	// Seconds since Start on the simulation clock
+	double getTime(const Clock::time_point time) const noexcept;
+
+	SceneBase* m_scene{ nullptr };
+	double m_tickSeconds{ 1.0 / 60.0 };
+	Clock::time_point m_start;
+
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_stopCondition;
+	bool m_stop{ false };
+
+	TripleBuffer<SceneSnapshot> m_snapshots;
+	// Render thread: the two newest snapshots picked up
+	SceneSnapshot m_previous, m_current;
+
+	std::atomic<std::uint64_t> m_ticks{ 0 };
+	std::atomic<std::uint64_t> m_droppedTicks{ 0 };
+	std::atomic<double> m_tickMilliseconds{ 0.0 };
+};
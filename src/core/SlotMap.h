@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Refers to a value in a SlotMap<T>. A handle outlives its value safely: once the value is erased the slot's
+// generation moves on, and the handle no longer resolves even after the slot holds a new value.
+template<typename T>
+struct SlotHandle {
+	static constexpr std::uint32_t InvalidIndex{ ~0u };
+
+	std::uint32_t Index{ InvalidIndex };
+	std::uint32_t Generation{ 0 };
+
+	bool IsValid() const noexcept { return Index != InvalidIndex; }
+
+	bool operator==(const SlotHandle& other) const noexcept { return Index == other.Index && Generation == other.Generation; }
+	bool operator!=(const SlotHandle& other) const noexcept { return !(*this == other); }
+};
+
+// Values stored back to back in one array and addressed through generational handles. Erase moves the last
+// value into the hole, so GetValues() is always packed and iterating it touches only live values. Dense
+// indices (positions in GetValues()) are cheaper than handles but only stay valid until the next Erase.
+template<typename T>
+class SlotMap {
+public:
+	using Handle = SlotHandle<T>;
+	static constexpr std::uint32_t InvalidIndex{ Handle::InvalidIndex };
+
+	void Reserve(const std::size_t size)
+	{
+		m_values.reserve(size);
+		m_valueSlots.reserve(size);
+		m_slots.reserve(size);
+	}
+
+	Handle Insert(T value)
+	{
+		std::uint32_t slot;
+		if (m_freeSlot != InvalidIndex)
+		{
+			slot = m_freeSlot;
+			m_freeSlot = m_slots[slot].DenseIndex;
+		} else
+		{
+			slot = static_cast<std::uint32_t>(m_slots.size());
+			m_slots.push_back({});
+		}
+
+		m_slots[slot].DenseIndex = static_cast<std::uint32_t>(m_values.size());
+		m_values.push_back(std::move(value));
+		m_valueSlots.push_back(slot);
+
+		return { slot, m_slots[slot].Generation };
+	}
+
+	// Returns false if handle was already stale.
+	bool Erase(const Handle handle)
+	{
+		const auto denseIndex{ GetDenseIndex(handle) };
+		if (denseIndex == InvalidIndex)
+		{
+			return false;
+		}
+
+		const auto lastIndex{ static_cast<std::uint32_t>(m_values.size() - 1) };
+		if (denseIndex != lastIndex)
+		{
+			m_values[denseIndex] = std::move(m_values[lastIndex]);
+			m_valueSlots[denseIndex] = m_valueSlots[lastIndex];
+			m_slots[m_valueSlots[denseIndex]].DenseIndex = denseIndex;
+		}
+		m_values.pop_back();
+		m_valueSlots.pop_back();
+
+		auto& slot{ m_slots[handle.Index] };
+		++slot.Generation;
+		slot.DenseIndex = m_freeSlot;
+		m_freeSlot = handle.Index;
+		return true;
+	}
+
+	// Invalidates every handle handed out so far.
+	void Clear()
+	{
+		for (const auto slot : m_valueSlots)
+		{
+			++m_slots[slot].Generation;
+			m_slots[slot].DenseIndex = m_freeSlot;
+			m_freeSlot = slot;
+		}
+		m_values.clear();
+		m_valueSlots.clear();
+	}
+
+	// nullptr if handle is stale
+	T* Get(const Handle handle) noexcept
+	{
+		const auto denseIndex{ GetDenseIndex(handle) };
+		return denseIndex != InvalidIndex ? &m_values[denseIndex] : nullptr;
+	}
+	const T* Get(const Handle handle) const noexcept
+	{
+		const auto denseIndex{ GetDenseIndex(handle) };
+		return denseIndex != InvalidIndex ? &m_values[denseIndex] : nullptr;
+	}
+
+	bool Contains(const Handle handle) const noexcept { return GetDenseIndex(handle) != InvalidIndex; }
+
+	// Position of the value in GetValues(), InvalidIndex if handle is stale
+	std::uint32_t GetDenseIndex(const Handle handle) const noexcept
+	{
+		if (handle.Index >= m_slots.size() || m_slots[handle.Index].Generation != handle.Generation)
+		{
+			return InvalidIndex;
+		}
+		return m_slots[handle.Index].DenseIndex;
+	}
+	Handle GetHandle(const std::uint32_t denseIndex) const noexcept
+	{
+		const auto slot{ m_valueSlots[denseIndex] };
+		return { slot, m_slots[slot].Generation };
+	}
+
+	const auto& GetValues() const noexcept { return m_values; }
+	auto& GetValues() noexcept { return m_values; }
+	auto GetSize() const noexcept { return m_values.size(); }
+	auto IsEmpty() const noexcept { return m_values.empty(); }
+
+private:
+	struct Slot {
+		// Index into m_values while the slot is used, the next free slot while it is not
+		std::uint32_t DenseIndex{ InvalidIndex };
+		std::uint32_t Generation{ 0 };
+	};
+
+	std::vector<T> m_values;
+	// Slot of every value, to fix up the slot when Erase moves a value
+	std::vector<std::uint32_t> m_valueSlots;
+	std::vector<Slot> m_slots;
+	std::uint32_t m_freeSlot{ InvalidIndex };
+};
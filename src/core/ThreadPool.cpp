@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <string>
+
+// Set on pool workers (and on a caller while it executes chunks) so nested loops run inline.
+thread_local bool t_insideParallelFor{ false };
+
+/***********************************************************************************/
+ThreadPool::ThreadPool()
+{
+	const auto hardwareThreads{ std::max(1u, std::thread::hardware_concurrency()) };
+
+	// The calling thread always participates, so spawn one less worker.
+	m_workers.reserve(hardwareThreads - 1);
+	for (std::size_t i = 0; i < hardwareThreads - 1; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+/***********************************************************************************/
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_shutdown = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+/***********************************************************************************/
+void ThreadPool::parallelFor(const std::size_t count, const std::size_t grainSize, const RangeFunc& func, const std::size_t maxThreads)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	const auto grain{ std::max<std::size_t>(grainSize, 1) };
+	const auto numChunks{ (count + grain - 1) / grain };
+	auto numThreads{ maxThreads == 0 ? GetNumThreads() : std::min(maxThreads, GetNumThreads()) };
+	numThreads = std::min(numThreads, numChunks);
+
+	// Not worth waking anyone up, or we are already running on a worker.
+	if (numThreads <= 1 || t_insideParallelFor)
+	{
+		func(0, count);
+		return;
+	}
+
+	// Only one loop can own the workers at a time.
+	std::lock_guard<std::mutex> submitLock(m_submitMutex);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func = &func;
+		m_count = count;
+		m_grainSize = grain;
+		m_activeWorkers = numThreads - 1;
+		m_pendingWorkers = m_workers.size();
+		m_nextIndex.store(0, std::memory_order_relaxed);
+		++m_generation;
+	}
+	m_wakeCondition.notify_all();
+
+	t_insideParallelFor = true;
+	runChunks();
+	t_insideParallelFor = false;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this] { return m_pendingWorkers == 0; });
+	m_func = nullptr;
+}
+
+/***********************************************************************************/
+void ThreadPool::workerLoop(const std::size_t workerIndex)
+{
+	t_insideParallelFor = true;
+	PROFILE_THREAD_NAME("Worker " + std::to_string(workerIndex));
+
+	std::uint64_t seenGeneration{ 0 };
+	while (true)
+	{
+		bool participate{ false };
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeCondition.wait(lock, [&] { return m_shutdown || m_generation != seenGeneration; });
+			if (m_shutdown)
+			{
+				return;
+			}
+			seenGeneration = m_generation;
+			participate = workerIndex < m_activeWorkers;
+		}
+
+		if (participate)
+		{
+			runChunks();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_pendingWorkers == 0)
+			{
+				m_doneCondition.notify_one();
+			}
+		}
+	}
+}
+
+/***********************************************************************************/
+void ThreadPool::runChunks()
+{
+	PROFILE_SCOPE("ParallelFor");
+
+	while (true)
+	{
+		const auto begin{ m_nextIndex.fetch_add(m_grainSize, std::memory_order_relaxed) };
+		if (begin >= m_count)
+		{
+			return;
+		}
+
+		(*m_func)(begin, std::min(begin + m_grainSize, m_count));
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker pool for data-parallel loops (texture baking, importers, culling).
+class ThreadPool {
+	ThreadPool();
+	~ThreadPool();
+public:
+
+	static auto& GetInstance()
+	{
+		static ThreadPool instance;
+		return instance;
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Receives a half-open range [begin, end) of loop indices.
+	using RangeFunc = std::function<void(const std::size_t begin, const std::size_t end)>;
+
+	// Splits [0, count) into chunks of grainSize and runs them on the workers and the calling thread.
+	// Blocks until every chunk is done. maxThreads limits the participating threads (0 = all).
+	// Nested calls from inside a worker run serially on that worker.
+	template<typename Func>
+	void ParallelFor(const std::size_t count, const std::size_t grainSize, const Func& func, const std::size_t maxThreads = 0)
+	{
+		// func outlives the call, so it is referenced rather than copied into the RangeFunc. A reference_wrapper
+		// fits in std::function's local storage, loops run every frame without allocating.
+		parallelFor(count, grainSize, RangeFunc(std::cref(func)), maxThreads);
+	}
+
+	// Number of threads that take part in a ParallelFor, including the caller.
+	auto GetNumThreads() const noexcept { return m_workers.size() + 1; }
+
+private:
+	void parallelFor(const std::size_t count, const std::size_t grainSize, const RangeFunc& func, const std::size_t maxThreads);
+	void workerLoop(const std::size_t workerIndex);
+	void runChunks();
+
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_submitMutex;
+	std::mutex m_mutex;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_doneCondition;
+
+	// State of the job currently being executed
+	const RangeFunc* m_func{ nullptr };
+	std::size_t m_count{ 0 };
+	std::size_t m_grainSize{ 1 };
+	std::size_t m_activeWorkers{ 0 };
+	std::size_t m_pendingWorkers{ 0 };
+	std::atomic<std::size_t> m_nextIndex{ 0 };
+	std::uint64_t m_generation{ 0 };
+	bool m_shutdown{ false };
+};
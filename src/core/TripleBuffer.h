@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of the latest value from one writer thread to one reader thread. The writer fills its
+// buffer and publishes it, the reader picks up the newest published buffer. Neither side ever waits: values
+// published faster than the reader looks are dropped, and the reader keeps its buffer until a newer one
+// arrives. Buffers are reused, so values owning memory (vectors) stop allocating once they reached full size.
+template<typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Writer thread. Buffer to fill before Publish, holding whatever was published two values ago.
+	T& GetWriteBuffer() noexcept { return m_buffers[m_write].Value; }
+	// Writer thread. Makes the write buffer the newest value and hands the writer a free buffer.
+	void Publish() noexcept
+	{
+		m_write = m_shared.exchange(static_cast<std::uint8_t>(m_write | NewBit), std::memory_order_acq_rel) & IndexMask;
+	}
+
+	// Reader thread. Swaps in the newest value if one was published since the last call.
+	bool Update() noexcept
+	{
+		if ((m_shared.load(std::memory_order_relaxed) & NewBit) == 0)
+		{
+			return false;
+		}
+		m_read = m_shared.exchange(m_read, std::memory_order_acq_rel) & IndexMask;
+		return true;
+	}
+	// Reader thread. Value picked up by the last successful Update.
+	const T& GetReadBuffer() const noexcept { return m_buffers[m_read].Value; }
+
+private:
+	static constexpr std::uint8_t IndexMask{ 0x3 };
+	static constexpr std::uint8_t NewBit{ 0x4 };
+
+	// Own cache lines so the threads do not false-share while one writes and the other reads
+	struct alignas(64) Slot {
+		T Value{};
+	};
+
+	std::array<Slot, 3> m_buffers;
+	// Index of the middle buffer, with NewBit set while it holds a value the reader has not seen
+	alignas(64) std::atomic<std::uint8_t> m_shared{ 1 };
+	alignas(64) std::uint8_t m_write{ 0 };
+	alignas(64) std::uint8_t m_read{ 2 };
+};
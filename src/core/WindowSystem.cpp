@@ -6,15 +6,13 @@
 
 #include <iostream>
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-
 /***********************************************************************************/
 GLFWwindow* WindowSystem::Init(const pugi::xml_node& windowNode)
 {
 
 	// Gross lambda to connect the Input singleton to GLFW callbacks
 #define genericInputCallback(functionName)\
-	[](GLFWwindow* window, const auto... args) {\
+	[](GLFWwindow* window, auto... args) {\
 		const auto ptr = static_cast<Input*>(glfwGetWindowUserPointer(window));\
 		if (ptr->functionName) { ptr->functionName(args...); }\
 	}
@@ -61,7 +59,7 @@ GLFWwindow* WindowSystem::Init(const pugi::xml_node& windowNode)
 	glfwMakeContextCurrent(m_window);
 	glfwFocusWindow(m_window);
 	
-	glfwSetFramebufferSizeCallback(m_window, framebuffer_size_callback);
+	// No framebuffer size callback, the renderer sets the viewport every frame on whichever thread owns the context
 	glfwSetWindowSizeCallback(m_window, genericInputCallback(Input::GetInstance().windowResized));
 	/*glfwSetKeyCallback(m_window, genericInputCallback(Input::GetInstance().keyPressed));
 	glfwSetCursorPosCallback(m_window, genericInputCallback(Input::GetInstance().mouseMoved));
@@ -78,15 +76,6 @@ GLFWwindow* WindowSystem::Init(const pugi::xml_node& windowNode)
 	return m_window;
 }
 
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-// ---------------------------------------------------------------------------------------------
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
-{
-	// make sure the viewport matches the new window dimensions; note that width and 
-	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
-}
-
 /***********************************************************************************/
 void WindowSystem::SetWindowPos(const std::size_t x, const std::size_t y) const
 {
@@ -99,6 +88,18 @@ void WindowSystem::SwapBuffers() const
 	glfwSwapBuffers(m_window);
 }
 
+/***********************************************************************************/
+void WindowSystem::MakeContextCurrent() const
+{
+	glfwMakeContextCurrent(m_window);
+}
+
+/***********************************************************************************/
+void WindowSystem::ReleaseContext() const
+{
+	glfwMakeContextCurrent(nullptr);
+}
+
 /***********************************************************************************/
 void WindowSystem::EnableCursor() const
 {
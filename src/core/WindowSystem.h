@@ -30,8 +30,14 @@ public:
 	void Shutdown() const;
 
 	void SetWindowPos(const std::size_t x, const std::size_t y) const;
+	// Any thread may present, the render thread does while it owns the context.
 	void SwapBuffers() const;
 
+	// Makes the window's context current on the calling thread. It must not be current on another one.
+	void MakeContextCurrent() const;
+	// Detaches the context from the calling thread, so another thread can make it current.
+	void ReleaseContext() const;
+
 	void EnableCursor() const;
 	void DisableCursor() const;
 
@@ -0,0 +1,922 @@
+#include "BlockCompression.h"
+
+#include "../core/ThreadPool.h"
+#include "../Platform/SIMD.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	// 16 pixels of a 4x4 block in structure-of-arrays layout, values in [0, 255].
+	struct alignas(16) Block {
+		float R[16];
+		float G[16];
+		float B[16];
+		float A[16];
+	};
+
+	// Up to 16 interpolated colors, same layout as Block.
+	struct alignas(16) Palette {
+		float R[16];
+		float G[16];
+		float B[16];
+		float A[16];
+	};
+
+	// BC7 4-bit index interpolation weights (out of 64)
+	constexpr int BC7_WEIGHTS[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	/***********************************************************************************/
+	void fetchBlock(const std::uint8_t* rgba, const std::uint32_t width, const std::uint32_t height, const std::uint32_t blockX, const std::uint32_t blockY, Block& block)
+	{
+		for (std::uint32_t y = 0; y < 4; ++y)
+		{
+			// Replicate edge pixels for images that are not a multiple of 4.
+			const auto srcY{ std::min(blockY * 4 + y, height - 1) };
+			for (std::uint32_t x = 0; x < 4; ++x)
+			{
+				const auto srcX{ std::min(blockX * 4 + x, width - 1) };
+				const auto* pixel{ rgba + (static_cast<std::size_t>(srcY) * width + srcX) * 4 };
+				const auto i{ y * 4 + x };
+				block.R[i] = pixel[0];
+				block.G[i] = pixel[1];
+				block.B[i] = pixel[2];
+				block.A[i] = pixel[3];
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	// Finds the nearest palette entry for every pixel. Returns the summed squared error.
+	float selectIndices(const Block& block, const Palette& palette, const int numEntries, const bool useAlpha, std::uint8_t* indices)
+	{
+		float totalError{ 0.0f };
+
+#ifdef GE_SSE2
+		const auto alphaMask{ useAlpha ? _mm_set1_ps(1.0f) : _mm_setzero_ps() };
+
+		for (int i = 0; i < 16; i += 4)
+		{
+			const auto r{ _mm_load_ps(block.R + i) };
+			const auto g{ _mm_load_ps(block.G + i) };
+			const auto b{ _mm_load_ps(block.B + i) };
+			const auto a{ _mm_load_ps(block.A + i) };
+
+			auto bestError{ _mm_set1_ps(FLT_MAX) };
+			auto bestIndex{ _mm_setzero_si128() };
+
+			for (int k = 0; k < numEntries; ++k)
+			{
+				const auto dr{ _mm_sub_ps(r, _mm_set1_ps(palette.R[k])) };
+				const auto dg{ _mm_sub_ps(g, _mm_set1_ps(palette.G[k])) };
+				const auto db{ _mm_sub_ps(b, _mm_set1_ps(palette.B[k])) };
+				const auto da{ _mm_mul_ps(_mm_sub_ps(a, _mm_set1_ps(palette.A[k])), alphaMask) };
+
+				auto error{ _mm_mul_ps(dr, dr) };
+				error = _mm_add_ps(error, _mm_mul_ps(dg, dg));
+				error = _mm_add_ps(error, _mm_mul_ps(db, db));
+				error = _mm_add_ps(error, _mm_mul_ps(da, da));
+
+				const auto closer{ _mm_castps_si128(_mm_cmplt_ps(error, bestError)) };
+				bestError = _mm_min_ps(error, bestError);
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			alignas(16) float errors[4];
+			alignas(16) std::int32_t bestIndices[4];
+			_mm_store_ps(errors, bestError);
+			_mm_store_si128(reinterpret_cast<__m128i*>(bestIndices), bestIndex);
+
+			for (int j = 0; j < 4; ++j)
+			{
+				indices[i + j] = static_cast<std::uint8_t>(bestIndices[j]);
+				totalError += errors[j];
+			}
+		}
+#else
+		const auto alphaWeight{ useAlpha ? 1.0f : 0.0f };
+
+		for (int i = 0; i < 16; ++i)
+		{
+			auto bestError{ FLT_MAX };
+			int bestIndex{ 0 };
+			for (int k = 0; k < numEntries; ++k)
+			{
+				const auto dr{ block.R[i] - palette.R[k] };
+				const auto dg{ block.G[i] - palette.G[k] };
+				const auto db{ block.B[i] - palette.B[k] };
+				const auto da{ (block.A[i] - palette.A[k]) * alphaWeight };
+				const auto error{ dr * dr + dg * dg + db * db + da * da };
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = k;
+				}
+			}
+			indices[i] = static_cast<std::uint8_t>(bestIndex);
+			totalError += bestError;
+		}
+#endif
+
+		return totalError;
+	}
+
+	/***********************************************************************************/
+	// Principal axis of the block colors through power iteration on the covariance matrix.
+	void principalAxis(const Block& block, const bool useAlpha, float mean[4], float axis[4])
+	{
+		const float* channels[4]{ block.R, block.G, block.B, block.A };
+		const int numChannels{ useAlpha ? 4 : 3 };
+
+		float minValue[4]{ FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+		float maxValue[4]{ -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (int c = 0; c < 4; ++c)
+		{
+			mean[c] = 0.0f;
+			axis[c] = 0.0f;
+			if (c >= numChannels)
+			{
+				continue;
+			}
+			for (int i = 0; i < 16; ++i)
+			{
+				mean[c] += channels[c][i];
+				minValue[c] = std::min(minValue[c], channels[c][i]);
+				maxValue[c] = std::max(maxValue[c], channels[c][i]);
+			}
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4]{};
+		for (int i = 0; i < 16; ++i)
+		{
+			float d[4]{};
+			for (int c = 0; c < numChannels; ++c)
+			{
+				d[c] = channels[c][i] - mean[c];
+			}
+			for (int row = 0; row < numChannels; ++row)
+			{
+				for (int col = row; col < numChannels; ++col)
+				{
+					covariance[row][col] += d[row] * d[col];
+				}
+			}
+		}
+		for (int row = 0; row < numChannels; ++row)
+		{
+			for (int col = 0; col < row; ++col)
+			{
+				covariance[row][col] = covariance[col][row];
+			}
+		}
+
+		// Start from the bounding box diagonal, which is usually close already.
+		float v[4]{};
+		for (int c = 0; c < numChannels; ++c)
+		{
+			v[c] = maxValue[c] - minValue[c];
+		}
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4]{};
+			for (int row = 0; row < numChannels; ++row)
+			{
+				for (int col = 0; col < numChannels; ++col)
+				{
+					next[row] += covariance[row][col] * v[col];
+				}
+			}
+
+			float length{ 0.0f };
+			for (int c = 0; c < numChannels; ++c)
+			{
+				length += next[c] * next[c];
+			}
+			if (length < 1e-12f)
+			{
+				break;
+			}
+			length = 1.0f / std::sqrt(length);
+			for (int c = 0; c < numChannels; ++c)
+			{
+				v[c] = next[c] * length;
+			}
+		}
+
+		float length{ 0.0f };
+		for (int c = 0; c < numChannels; ++c)
+		{
+			length += v[c] * v[c];
+		}
+		if (length < 1e-12f)
+		{
+			// Solid block, any axis works.
+			for (int c = 0; c < numChannels; ++c)
+			{
+				v[c] = 1.0f;
+			}
+			length = static_cast<float>(numChannels);
+		}
+		length = 1.0f / std::sqrt(length);
+		for (int c = 0; c < numChannels; ++c)
+		{
+			axis[c] = v[c] * length;
+		}
+	}
+
+	/***********************************************************************************/
+	// Projects the block onto its principal axis to get the initial endpoints.
+	void initialEndpoints(const Block& block, const bool useAlpha, float e0[4], float e1[4])
+	{
+		float mean[4], axis[4];
+		principalAxis(block, useAlpha, mean, axis);
+
+		auto tMin{ FLT_MAX }, tMax{ -FLT_MAX };
+		for (int i = 0; i < 16; ++i)
+		{
+			const auto t{ (block.R[i] - mean[0]) * axis[0] + (block.G[i] - mean[1]) * axis[1] +
+				(block.B[i] - mean[2]) * axis[2] + (block.A[i] - mean[3]) * axis[3] };
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+
+		for (int c = 0; c < 4; ++c)
+		{
+			e0[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+			e1[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+		}
+		if (!useAlpha)
+		{
+			e0[3] = e1[3] = 255.0f;
+		}
+	}
+
+	/***********************************************************************************/
+	// Least squares endpoints for fixed indices. weights[i] is the blend toward e1 of palette entry i.
+	bool refitEndpoints(const Block& block, const std::uint8_t* indices, const float* weights, float e0[4], float e1[4])
+	{
+		float alpha2{ 0.0f }, beta2{ 0.0f }, alphaBeta{ 0.0f };
+		float alphaX[4]{}, betaX[4]{};
+		const float* channels[4]{ block.R, block.G, block.B, block.A };
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const auto w1{ weights[indices[i]] };
+			const auto w0{ 1.0f - w1 };
+			alpha2 += w0 * w0;
+			beta2 += w1 * w1;
+			alphaBeta += w0 * w1;
+			for (int c = 0; c < 4; ++c)
+			{
+				alphaX[c] += w0 * channels[c][i];
+				betaX[c] += w1 * channels[c][i];
+			}
+		}
+
+		const auto determinant{ alpha2 * beta2 - alphaBeta * alphaBeta };
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			return false;
+		}
+
+		const auto invDeterminant{ 1.0f / determinant };
+		for (int c = 0; c < 4; ++c)
+		{
+			e0[c] = std::clamp((alphaX[c] * beta2 - betaX[c] * alphaBeta) * invDeterminant, 0.0f, 255.0f);
+			e1[c] = std::clamp((betaX[c] * alpha2 - alphaX[c] * alphaBeta) * invDeterminant, 0.0f, 255.0f);
+		}
+
+		return true;
+	}
+
+	/***********************************************************************************/
+	// Writes little-endian bit fields, starting at bit 0 of the first byte.
+	struct BitWriter {
+		std::uint8_t* Out;
+		int Position{ 0 };
+
+		void Write(const std::uint32_t value, const int numBits)
+		{
+			for (int i = 0; i < numBits; ++i, ++Position)
+			{
+				Out[Position >> 3] |= static_cast<std::uint8_t>(((value >> i) & 1u) << (Position & 7));
+			}
+		}
+	};
+
+	struct BitReader {
+		const std::uint8_t* In;
+		int Position{ 0 };
+
+		std::uint32_t Read(const int numBits)
+		{
+			std::uint32_t value{ 0 };
+			for (int i = 0; i < numBits; ++i, ++Position)
+			{
+				value |= static_cast<std::uint32_t>((In[Position >> 3] >> (Position & 7)) & 1u) << i;
+			}
+			return value;
+		}
+	};
+
+	/***********************************************************************************/
+	std::uint16_t packRGB565(const float color[4])
+	{
+		const auto r{ static_cast<std::uint16_t>(std::lround(color[0] * 31.0f / 255.0f)) };
+		const auto g{ static_cast<std::uint16_t>(std::lround(color[1] * 63.0f / 255.0f)) };
+		const auto b{ static_cast<std::uint16_t>(std::lround(color[2] * 31.0f / 255.0f)) };
+		return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	/***********************************************************************************/
+	void unpackRGB565(const std::uint16_t packed, int color[3])
+	{
+		const auto r{ (packed >> 11) & 31 };
+		const auto g{ (packed >> 5) & 63 };
+		const auto b{ packed & 31 };
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	/***********************************************************************************/
+	void buildBC1Palette(const std::uint16_t c0, const std::uint16_t c1, Palette& palette)
+	{
+		int color0[3], color1[3];
+		unpackRGB565(c0, color0);
+		unpackRGB565(c1, color1);
+
+		float* channels[3]{ palette.R, palette.G, palette.B };
+		for (int c = 0; c < 3; ++c)
+		{
+			channels[c][0] = static_cast<float>(color0[c]);
+			channels[c][1] = static_cast<float>(color1[c]);
+			channels[c][2] = static_cast<float>((2 * color0[c] + color1[c]) / 3);
+			channels[c][3] = static_cast<float>((color0[c] + 2 * color1[c]) / 3);
+		}
+		std::fill_n(palette.A, 4, 255.0f);
+	}
+
+	/***********************************************************************************/
+	// Four color mode only, which is also what BC3 requires for its color block.
+	void encodeBC1(const Block& block, std::uint8_t* out)
+	{
+		constexpr float weights[4]{ 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		float e0[4], e1[4];
+		initialEndpoints(block, false, e0, e1);
+
+		auto c0{ packRGB565(e1) };
+		auto c1{ packRGB565(e0) };
+
+		Palette palette;
+		std::uint8_t indices[16];
+		buildBC1Palette(c0, c1, palette);
+		auto error{ selectIndices(block, palette, 4, false, indices) };
+
+		for (int iteration = 0; iteration < 2 && c0 != c1; ++iteration)
+		{
+			if (!refitEndpoints(block, indices, weights, e0, e1))
+			{
+				break;
+			}
+
+			const auto refitC0{ packRGB565(e0) };
+			const auto refitC1{ packRGB565(e1) };
+
+			Palette refitPalette;
+			std::uint8_t refitIndices[16];
+			buildBC1Palette(refitC0, refitC1, refitPalette);
+			const auto refitError{ selectIndices(block, refitPalette, 4, false, refitIndices) };
+			if (refitError >= error)
+			{
+				break;
+			}
+
+			error = refitError;
+			c0 = refitC0;
+			c1 = refitC1;
+			std::memcpy(indices, refitIndices, sizeof(indices));
+		}
+
+		std::uint32_t packedIndices{ 0 };
+		if (c0 < c1)
+		{
+			// Swapping the endpoints maps 0<->1 and 2<->3.
+			std::swap(c0, c1);
+			for (auto& index : indices)
+			{
+				index ^= 1;
+			}
+		}
+		if (c0 != c1)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				packedIndices |= static_cast<std::uint32_t>(indices[i]) << (i * 2);
+			}
+		}
+
+		out[0] = static_cast<std::uint8_t>(c0 & 0xFF);
+		out[1] = static_cast<std::uint8_t>(c0 >> 8);
+		out[2] = static_cast<std::uint8_t>(c1 & 0xFF);
+		out[3] = static_cast<std::uint8_t>(c1 >> 8);
+		std::memcpy(out + 4, &packedIndices, sizeof(packedIndices));
+	}
+
+	/***********************************************************************************/
+	// Eight value mode: the two endpoints plus six interpolated values.
+	void encodeBC4(const float* values, std::uint8_t* out)
+	{
+		auto minValue{ values[0] }, maxValue{ values[0] };
+		for (int i = 1; i < 16; ++i)
+		{
+			minValue = std::min(minValue, values[i]);
+			maxValue = std::max(maxValue, values[i]);
+		}
+
+		const auto r0{ static_cast<int>(std::lround(maxValue)) };
+		const auto r1{ static_cast<int>(std::lround(minValue)) };
+
+		std::memset(out, 0, 8);
+		out[0] = static_cast<std::uint8_t>(r0);
+		out[1] = static_cast<std::uint8_t>(r1);
+
+		if (r0 == r1)
+		{
+			// Index 0 everywhere decodes to r0.
+			return;
+		}
+
+		const auto scale{ 7.0f / static_cast<float>(r0 - r1) };
+
+		BitWriter writer{ out + 2 };
+		for (int i = 0; i < 16; ++i)
+		{
+			// Position along the ramp from r1 (0) to r0 (7)
+			const auto step{ std::clamp(static_cast<int>(std::lround((values[i] - r1) * scale)), 0, 7) };
+			std::uint32_t index;
+			if (step == 0)
+			{
+				index = 1;
+			}
+			else if (step == 7)
+			{
+				index = 0;
+			}
+			else
+			{
+				index = static_cast<std::uint32_t>(8 - step);
+			}
+			writer.Write(index, 3);
+		}
+	}
+
+	/***********************************************************************************/
+	// Splits an endpoint into 7-bit color plus the shared p-bit that minimizes the error.
+	void quantizeBC7Endpoint(const float endpoint[4], std::uint8_t quantized[4], std::uint8_t& pBit)
+	{
+		auto bestError{ FLT_MAX };
+		for (std::uint8_t p = 0; p < 2; ++p)
+		{
+			std::uint8_t candidate[4];
+			float error{ 0.0f };
+			for (int c = 0; c < 4; ++c)
+			{
+				const auto q{ std::clamp(static_cast<int>(std::lround((endpoint[c] - p) * 0.5f)), 0, 127) };
+				candidate[c] = static_cast<std::uint8_t>(q);
+				const auto d{ static_cast<float>((q << 1) | p) - endpoint[c] };
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				std::memcpy(quantized, candidate, 4);
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	void buildBC7Palette(const std::uint8_t q0[4], const std::uint8_t p0, const std::uint8_t q1[4], const std::uint8_t p1, Palette& palette)
+	{
+		float* channels[4]{ palette.R, palette.G, palette.B, palette.A };
+		for (int c = 0; c < 4; ++c)
+		{
+			const auto a{ (q0[c] << 1) | p0 };
+			const auto b{ (q1[c] << 1) | p1 };
+			for (int i = 0; i < 16; ++i)
+			{
+				channels[c][i] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * a + BC7_WEIGHTS[i] * b + 32) >> 6);
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	// Mode 6: one subset, 7.7.7.7 endpoints with unique p-bits and 4-bit indices.
+	void encodeBC7(const Block& block, std::uint8_t* out)
+	{
+		float weights[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			weights[i] = BC7_WEIGHTS[i] / 64.0f;
+		}
+
+		float e0[4], e1[4];
+		initialEndpoints(block, true, e0, e1);
+
+		std::uint8_t q0[4], q1[4], p0, p1;
+		quantizeBC7Endpoint(e0, q0, p0);
+		quantizeBC7Endpoint(e1, q1, p1);
+
+		Palette palette;
+		std::uint8_t indices[16];
+		buildBC7Palette(q0, p0, q1, p1, palette);
+		auto error{ selectIndices(block, palette, 16, true, indices) };
+
+		for (int iteration = 0; iteration < 2; ++iteration)
+		{
+			if (!refitEndpoints(block, indices, weights, e0, e1))
+			{
+				break;
+			}
+
+			std::uint8_t refitQ0[4], refitQ1[4], refitP0, refitP1;
+			quantizeBC7Endpoint(e0, refitQ0, refitP0);
+			quantizeBC7Endpoint(e1, refitQ1, refitP1);
+
+			Palette refitPalette;
+			std::uint8_t refitIndices[16];
+			buildBC7Palette(refitQ0, refitP0, refitQ1, refitP1, refitPalette);
+			const auto refitError{ selectIndices(block, refitPalette, 16, true, refitIndices) };
+			if (refitError >= error)
+			{
+				break;
+			}
+
+			error = refitError;
+			std::memcpy(q0, refitQ0, 4);
+			std::memcpy(q1, refitQ1, 4);
+			p0 = refitP0;
+			p1 = refitP1;
+			std::memcpy(indices, refitIndices, sizeof(indices));
+		}
+
+		// The anchor index (pixel 0) is stored without its high bit.
+		if (indices[0] & 8)
+		{
+			std::swap(q0, q1);
+			std::swap(p0, p1);
+			for (auto& index : indices)
+			{
+				index = static_cast<std::uint8_t>(15 - index);
+			}
+		}
+
+		std::memset(out, 0, 16);
+		BitWriter writer{ out };
+		writer.Write(1u << 6, 7);
+		for (int c = 0; c < 4; ++c)
+		{
+			writer.Write(q0[c], 7);
+			writer.Write(q1[c], 7);
+		}
+		writer.Write(p0, 1);
+		writer.Write(p1, 1);
+		writer.Write(indices[0], 3);
+		for (int i = 1; i < 16; ++i)
+		{
+			writer.Write(indices[i], 4);
+		}
+	}
+
+	/***********************************************************************************/
+	void encodeBlock(const Block& block, const Graphics::BlockFormat format, std::uint8_t* out)
+	{
+		switch (format)
+		{
+		case Graphics::BlockFormat::BC1:
+			encodeBC1(block, out);
+			break;
+		case Graphics::BlockFormat::BC3:
+			encodeBC4(block.A, out);
+			encodeBC1(block, out + 8);
+			break;
+		case Graphics::BlockFormat::BC4:
+			encodeBC4(block.R, out);
+			break;
+		case Graphics::BlockFormat::BC5:
+			encodeBC4(block.R, out);
+			encodeBC4(block.G, out + 8);
+			break;
+		case Graphics::BlockFormat::BC7:
+			encodeBC7(block, out);
+			break;
+		}
+	}
+
+	/***********************************************************************************/
+	// Decoded pixels are written to a 4x4 RGBA8 scratch block.
+	void decodeBC1(const std::uint8_t* in, std::uint8_t* pixels)
+	{
+		const auto c0{ static_cast<std::uint16_t>(in[0] | (in[1] << 8)) };
+		const auto c1{ static_cast<std::uint16_t>(in[2] | (in[3] << 8)) };
+		std::uint32_t indices;
+		std::memcpy(&indices, in + 4, sizeof(indices));
+
+		int color[4][4];
+		unpackRGB565(c0, color[0]);
+		unpackRGB565(c1, color[1]);
+		color[0][3] = color[1][3] = color[2][3] = color[3][3] = 255;
+		for (int c = 0; c < 3; ++c)
+		{
+			if (c0 > c1)
+			{
+				color[2][c] = (2 * color[0][c] + color[1][c]) / 3;
+				color[3][c] = (color[0][c] + 2 * color[1][c]) / 3;
+			}
+			else
+			{
+				color[2][c] = (color[0][c] + color[1][c]) / 2;
+				color[3][c] = 0;
+			}
+		}
+		if (c0 <= c1)
+		{
+			color[3][3] = 0;
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const auto index{ (indices >> (i * 2)) & 3 };
+			for (int c = 0; c < 4; ++c)
+			{
+				pixels[i * 4 + c] = static_cast<std::uint8_t>(color[index][c]);
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	void decodeBC4(const std::uint8_t* in, std::uint8_t* pixels, const int channel)
+	{
+		const int r0{ in[0] };
+		const int r1{ in[1] };
+
+		int values[8]{ r0, r1 };
+		if (r0 > r1)
+		{
+			for (int i = 1; i < 7; ++i)
+			{
+				values[i + 1] = ((7 - i) * r0 + i * r1) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+			{
+				values[i + 1] = ((5 - i) * r0 + i * r1) / 5;
+			}
+			values[6] = 0;
+			values[7] = 255;
+		}
+
+		BitReader reader{ in + 2 };
+		for (int i = 0; i < 16; ++i)
+		{
+			pixels[i * 4 + channel] = static_cast<std::uint8_t>(values[reader.Read(3)]);
+		}
+	}
+
+	/***********************************************************************************/
+	void decodeBC7(const std::uint8_t* in, std::uint8_t* pixels)
+	{
+		BitReader reader{ in };
+		if (reader.Read(7) != (1u << 6))
+		{
+			// Only mode 6 is ever produced by the encoder.
+			std::fill_n(pixels, 64, std::uint8_t{ 0 });
+			return;
+		}
+
+		std::uint8_t q0[4], q1[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			q0[c] = static_cast<std::uint8_t>(reader.Read(7));
+			q1[c] = static_cast<std::uint8_t>(reader.Read(7));
+		}
+		const auto p0{ static_cast<std::uint8_t>(reader.Read(1)) };
+		const auto p1{ static_cast<std::uint8_t>(reader.Read(1)) };
+
+		Palette palette;
+		buildBC7Palette(q0, p0, q1, p1, palette);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const auto index{ reader.Read(i == 0 ? 3 : 4) };
+			pixels[i * 4 + 0] = static_cast<std::uint8_t>(palette.R[index]);
+			pixels[i * 4 + 1] = static_cast<std::uint8_t>(palette.G[index]);
+			pixels[i * 4 + 2] = static_cast<std::uint8_t>(palette.B[index]);
+			pixels[i * 4 + 3] = static_cast<std::uint8_t>(palette.A[index]);
+		}
+	}
+
+	/***********************************************************************************/
+	void decodeBlock(const std::uint8_t* in, const Graphics::BlockFormat format, std::uint8_t* pixels)
+	{
+		switch (format)
+		{
+		case Graphics::BlockFormat::BC1:
+			decodeBC1(in, pixels);
+			break;
+		case Graphics::BlockFormat::BC3:
+			decodeBC1(in + 8, pixels);
+			decodeBC4(in, pixels, 3);
+			break;
+		case Graphics::BlockFormat::BC4:
+			std::fill_n(pixels, 64, std::uint8_t{ 255 });
+			decodeBC4(in, pixels, 0);
+			for (int i = 0; i < 16; ++i)
+			{
+				pixels[i * 4 + 1] = pixels[i * 4 + 2] = 0;
+			}
+			break;
+		case Graphics::BlockFormat::BC5:
+			std::fill_n(pixels, 64, std::uint8_t{ 255 });
+			decodeBC4(in, pixels, 0);
+			decodeBC4(in + 8, pixels, 1);
+			for (int i = 0; i < 16; ++i)
+			{
+				pixels[i * 4 + 2] = 0;
+			}
+			break;
+		case Graphics::BlockFormat::BC7:
+			decodeBC7(in, pixels);
+			break;
+		}
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	BlockFormat ChooseBlockFormat(const TextureUsage usage, const bool hasAlpha) noexcept
+	{
+		switch (usage)
+		{
+		case TextureUsage::Albedo:
+			return BlockFormat::BC7;
+		case TextureUsage::Normal:
+			return BlockFormat::BC5;
+		case TextureUsage::Roughness:
+		case TextureUsage::Metallic:
+		case TextureUsage::AmbientOcclusion:
+		case TextureUsage::AlphaMask:
+			return BlockFormat::BC4;
+		default:
+			return hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+		}
+	}
+
+	/***********************************************************************************/
+	std::size_t GetBlockSize(const BlockFormat format) noexcept
+	{
+		return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+	}
+
+	/***********************************************************************************/
+	std::size_t GetCompressedSize(const BlockFormat format, const std::uint32_t width, const std::uint32_t height) noexcept
+	{
+		const std::size_t blocksX{ (width + 3) / 4 };
+		const std::size_t blocksY{ (height + 3) / 4 };
+		return blocksX * blocksY * GetBlockSize(format);
+	}
+
+	/***********************************************************************************/
+	std::uint32_t GetGLInternalFormat(const BlockFormat format) noexcept
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+		case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+		case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+		}
+		return 0;
+	}
+
+	/***********************************************************************************/
+	const char* GetFormatName(const BlockFormat format) noexcept
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: return "BC1";
+		case BlockFormat::BC3: return "BC3";
+		case BlockFormat::BC4: return "BC4";
+		case BlockFormat::BC5: return "BC5";
+		case BlockFormat::BC7: return "BC7";
+		}
+		return "Unknown";
+	}
+
+	/***********************************************************************************/
+	std::vector<std::uint8_t> CompressImage(const std::uint8_t* rgba, const std::uint32_t width, const std::uint32_t height, const BlockFormat format)
+	{
+		const std::uint32_t blocksX{ (width + 3) / 4 };
+		const std::uint32_t blocksY{ (height + 3) / 4 };
+		const auto blockSize{ GetBlockSize(format) };
+
+		std::vector<std::uint8_t> blocks(static_cast<std::size_t>(blocksX) * blocksY * blockSize);
+
+		// Every block row writes its own slice of the output, so the result does not depend on scheduling.
+		ThreadPool::GetInstance().ParallelFor(blocksY, 1, [&](const std::size_t begin, const std::size_t end) {
+			Block block;
+			for (auto blockY = begin; blockY < end; ++blockY)
+			{
+				for (std::uint32_t blockX = 0; blockX < blocksX; ++blockX)
+				{
+					fetchBlock(rgba, width, height, blockX, static_cast<std::uint32_t>(blockY), block);
+					encodeBlock(block, format, blocks.data() + (blockY * blocksX + blockX) * blockSize);
+				}
+			}
+		});
+
+		return blocks;
+	}
+
+	/***********************************************************************************/
+	std::vector<std::uint8_t> DecompressImage(const std::uint8_t* blocks, const std::uint32_t width, const std::uint32_t height, const BlockFormat format)
+	{
+		const std::uint32_t blocksX{ (width + 3) / 4 };
+		const std::uint32_t blocksY{ (height + 3) / 4 };
+		const auto blockSize{ GetBlockSize(format) };
+
+		std::vector<std::uint8_t> image(static_cast<std::size_t>(width) * height * 4);
+
+		ThreadPool::GetInstance().ParallelFor(blocksY, 1, [&](const std::size_t begin, const std::size_t end) {
+			std::uint8_t pixels[64];
+			for (auto blockY = begin; blockY < end; ++blockY)
+			{
+				for (std::uint32_t blockX = 0; blockX < blocksX; ++blockX)
+				{
+					decodeBlock(blocks + (blockY * blocksX + blockX) * blockSize, format, pixels);
+
+					for (std::uint32_t y = 0; y < 4; ++y)
+					{
+						for (std::uint32_t x = 0; x < 4; ++x)
+						{
+							const auto dstX{ blockX * 4 + x };
+							const auto dstY{ blockY * 4 + y };
+							if (dstX < width && dstY < height)
+							{
+								std::memcpy(&image[(dstY * width + dstX) * 4], &pixels[(y * 4 + x) * 4], 4);
+							}
+						}
+					}
+				}
+			}
+		});
+
+		return image;
+	}
+
+	/***********************************************************************************/
+	double ComputePSNR(const std::uint8_t* reference, const std::uint8_t* decoded, const std::uint32_t width, const std::uint32_t height, const BlockFormat format)
+	{
+		int numChannels{ 4 };
+		switch (format)
+		{
+		case BlockFormat::BC1: numChannels = 3; break;
+		case BlockFormat::BC4: numChannels = 1; break;
+		case BlockFormat::BC5: numChannels = 2; break;
+		default: break;
+		}
+
+		const auto numPixels{ static_cast<std::size_t>(width) * height };
+		double squaredError{ 0.0 };
+		for (std::size_t i = 0; i < numPixels; ++i)
+		{
+			for (int c = 0; c < numChannels; ++c)
+			{
+				const double d{ static_cast<double>(reference[i * 4 + c]) - decoded[i * 4 + c] };
+				squaredError += d * d;
+			}
+		}
+
+		const auto meanSquaredError{ squaredError / (static_cast<double>(numPixels) * numChannels) };
+		if (meanSquaredError <= 0.0)
+		{
+			return std::numeric_limits<double>::infinity();
+		}
+
+		return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Graphics
+{
+	// How a texture is sampled by the material, used to pick a block format.
+	enum class TextureUsage {
+		Generic,
+		Albedo,
+		Normal,
+		Roughness,
+		Metallic,
+		AmbientOcclusion,
+		AlphaMask
+	};
+
+	enum class BlockFormat : std::uint32_t {
+		BC1,	// RGB, 4bpp
+		BC3,	// RGBA, 8bpp
+		BC4,	// R, 4bpp
+		BC5,	// RG, 8bpp
+		BC7		// RGBA, 8bpp (mode 6 only)
+	};
+
+	struct CompressedMip {
+		std::uint32_t Width{ 0 };
+		std::uint32_t Height{ 0 };
+		std::vector<std::uint8_t> Data;
+	};
+
+	struct CompressedTexture {
+		BlockFormat Format{ BlockFormat::BC1 };
+		std::vector<CompressedMip> Mips;
+	};
+
+	// Albedo -> BC7, normals -> BC5, single channel maps -> BC4, anything else -> BC1/BC3.
+	BlockFormat ChooseBlockFormat(const TextureUsage usage, const bool hasAlpha) noexcept;
+
+	// Bytes per 4x4 block (8 or 16).
+	std::size_t GetBlockSize(const BlockFormat format) noexcept;
+	std::size_t GetCompressedSize(const BlockFormat format, const std::uint32_t width, const std::uint32_t height) noexcept;
+	// Matching GL internal format (S3TC/RGTC/BPTC).
+	std::uint32_t GetGLInternalFormat(const BlockFormat format) noexcept;
+	const char* GetFormatName(const BlockFormat format) noexcept;
+
+	// Compresses a tightly packed RGBA8 image. Block rows are encoded in parallel and the
+	// output is identical regardless of thread count.
+	std::vector<std::uint8_t> CompressImage(const std::uint8_t* rgba, const std::uint32_t width, const std::uint32_t height, const BlockFormat format);
+
+	// Decodes blocks back to RGBA8. Only used for quality measurements.
+	std::vector<std::uint8_t> DecompressImage(const std::uint8_t* blocks, const std::uint32_t width, const std::uint32_t height, const BlockFormat format);
+
+	// Peak signal-to-noise ratio in dB, over the channels the format stores.
+	double ComputePSNR(const std::uint8_t* reference, const std::uint8_t* decoded, const std::uint32_t width, const std::uint32_t height, const BlockFormat format);
+}
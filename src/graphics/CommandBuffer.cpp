@@ -0,0 +1,104 @@
+#include "CommandBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	void CommandBuffer::Reset()
+	{
+		m_arena.Reset();
+		m_numCommands = 0;
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::BindProgram(const GLuint program)
+	{
+		push<Commands::BindProgram>(RenderCommandType::BindProgram).Program = program;
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::BindTexture(const GLuint unit, const GLenum target, const GLuint texture)
+	{
+		auto& command{ push<Commands::BindTexture>(RenderCommandType::BindTexture) };
+		command.Unit = unit;
+		command.Target = target;
+		command.Texture = texture;
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::SetUniform(const GLint location, const int value)
+	{
+		auto& command{ push<Commands::UniformInt>(RenderCommandType::UniformInt) };
+		command.Location = location;
+		command.Value = value;
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::SetUniform(const GLint location, const float value)
+	{
+		auto& command{ push<Commands::UniformFloat>(RenderCommandType::UniformFloat) };
+		command.Location = location;
+		command.Value = value;
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::SetUniform(const GLint location, const glm::vec3& value)
+	{
+		auto& command{ push<Commands::UniformVec3>(RenderCommandType::UniformVec3) };
+		command.Location = location;
+		command.Value = value;
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::SetUniform(const GLint location, const glm::mat4& value)
+	{
+		auto& command{ push<Commands::UniformMat4>(RenderCommandType::UniformMat4) };
+		command.Location = location;
+		command.Value = value;
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::DrawElements(const GLuint vertexArray, const GLenum mode, const GLsizei count, const GLuint first)
+	{
+		auto& command{ push<Commands::DrawElements>(RenderCommandType::DrawElements) };
+		command.VertexArray = vertexArray;
+		command.Mode = mode;
+		command.Count = count;
+		command.First = first;
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::DrawElementRanges(const GLuint vertexArray, const GLenum mode, const IndexRange* ranges, const std::size_t numRanges)
+	{
+		if (numRanges == 1)
+		{
+			DrawElements(vertexArray, mode, ranges[0].Count, ranges[0].First);
+			return;
+		}
+
+		// Command sizes are 16 bit, long lists are split over several commands
+		constexpr auto maxRanges{ (std::numeric_limits<std::uint16_t>::max() - sizeof(Commands::MultiDrawElements)) / sizeof(IndexRange) };
+		for (std::size_t offset = 0; offset < numRanges; offset += maxRanges)
+		{
+			const auto count{ std::min(numRanges - offset, maxRanges) };
+			auto& command{ push<Commands::MultiDrawElements>(RenderCommandType::MultiDrawElements, count * sizeof(IndexRange)) };
+			command.VertexArray = vertexArray;
+			command.Mode = mode;
+			command.DrawCount = static_cast<GLsizei>(count);
+			std::memcpy(&command + 1, ranges + offset, count * sizeof(IndexRange));
+		}
+	}
+
+	/***********************************************************************************/
+	void CommandBuffer::DrawArrays(const GLuint vertexArray, const GLenum mode, const GLint first, const GLsizei count)
+	{
+		auto& command{ push<Commands::DrawArrays>(RenderCommandType::DrawArrays) };
+		command.VertexArray = vertexArray;
+		command.Mode = mode;
+		command.First = first;
+		command.Count = count;
+	}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../core/LinearArena.h"
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Graphics
+{
+	enum class RenderCommandType : std::uint16_t {
+		BindProgram,
+		BindTexture,
+		UniformInt,
+		UniformFloat,
+		UniformVec3,
+		UniformMat4,
+		DrawElements,
+		MultiDrawElements,
+		DrawArrays,
+		Count
+	};
+
+	// Part of an element buffer, in indices
+	struct IndexRange {
+		GLuint First;
+		GLsizei Count;
+	};
+
+	// Every command starts with this header. Commands are packed back to back, Size bytes apart.
+	struct RenderCommand {
+		RenderCommandType Type;
+		std::uint16_t Size;
+	};
+
+	namespace Commands
+	{
+		struct BindProgram : RenderCommand {
+			GLuint Program;
+		};
+
+		struct BindTexture : RenderCommand {
+			GLuint Unit;
+			GLenum Target;
+			GLuint Texture;
+		};
+
+		struct UniformInt : RenderCommand {
+			GLint Location;
+			GLint Value;
+		};
+
+		struct UniformFloat : RenderCommand {
+			GLint Location;
+			float Value;
+		};
+
+		struct UniformVec3 : RenderCommand {
+			GLint Location;
+			glm::vec3 Value;
+		};
+
+		struct UniformMat4 : RenderCommand {
+			GLint Location;
+			glm::mat4 Value;
+		};
+
+		// 32 bit indices starting at index First of the element buffer of VertexArray
+		struct DrawElements : RenderCommand {
+			GLuint VertexArray;
+			GLenum Mode;
+			GLsizei Count;
+			GLuint First;
+		};
+
+		// Followed by DrawCount IndexRanges of the element buffer of VertexArray, drawn with one call
+		struct MultiDrawElements : RenderCommand {
+			GLuint VertexArray;
+			GLenum Mode;
+			GLsizei DrawCount;
+
+			const IndexRange* GetRanges() const noexcept { return reinterpret_cast<const IndexRange*>(this + 1); }
+		};
+
+		struct DrawArrays : RenderCommand {
+			GLuint VertexArray;
+			GLenum Mode;
+			GLint First;
+			GLsizei Count;
+		};
+	}
+
+	// Draw commands of a pass recorded without touching OpenGL, so recording can run on any thread. Replayed by
+	// a RenderBackend on the thread owning the context. Uniforms are set by location (GLShaderProgram::
+	// GetUniformLocation), and objects by name. Commands live in a LinearArena that Reset recycles every frame.
+	class CommandBuffer {
+	public:
+		explicit CommandBuffer(const std::size_t chunkSize = 64 * 1024) : m_arena(chunkSize) {}
+
+		void Reset();
+
+		void BindProgram(const GLuint program);
+		void BindTexture(const GLuint unit, const GLenum target, const GLuint texture);
+		void SetUniform(const GLint location, const int value);
+		void SetUniform(const GLint location, const float value);
+		void SetUniform(const GLint location, const glm::vec3& value);
+		void SetUniform(const GLint location, const glm::mat4& value);
+		void DrawElements(const GLuint vertexArray, const GLenum mode, const GLsizei count, const GLuint first = 0);
+		// One DrawElements for a single range, MultiDrawElements for more. Nothing for none.
+		void DrawElementRanges(const GLuint vertexArray, const GLenum mode, const IndexRange* ranges, const std::size_t numRanges);
+		void DrawArrays(const GLuint vertexArray, const GLenum mode, const GLint first, const GLsizei count);
+
+		// Calls func(const RenderCommand&) for every command in recording order.
+		template<typename Func>
+		void ForEach(Func&& func) const
+		{
+			for (const auto& chunk : m_arena.GetChunks())
+			{
+				const auto* data{ chunk.Data.get() };
+				for (std::size_t offset = 0; offset < chunk.Used;)
+				{
+					const auto& command{ *reinterpret_cast<const RenderCommand*>(data + offset) };
+					func(command);
+					offset += command.Size;
+				}
+			}
+		}
+
+		auto GetNumCommands() const noexcept { return m_numCommands; }
+		auto GetUsedBytes() const noexcept { return m_arena.GetUsedBytes(); }
+		auto GetCapacity() const noexcept { return m_arena.GetCapacity(); }
+
+	private:
+		template<typename T>
+		T& push(const RenderCommandType type, const std::size_t payloadSize = 0)
+		{
+			// 4 byte alignment and sizes keep the commands of a chunk gapless, which ForEach relies on
+			static_assert(alignof(T) == 4 && sizeof(T) % 4 == 0, "Commands must be 4 byte aligned and sized");
+			auto* command{ ::new (m_arena.Allocate(sizeof(T) + payloadSize, alignof(T))) T{} };
+			command->Type = type;
+			command->Size = static_cast<std::uint16_t>(sizeof(T) + payloadSize);
+			++m_numCommands;
+			return *command;
+		}
+
+		LinearArena m_arena;
+		std::size_t m_numCommands{ 0 };
+	};
+}
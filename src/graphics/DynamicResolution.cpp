@@ -0,0 +1,66 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	void DynamicResolution::Init(const Settings& settings)
+	{
+		m_settings = settings;
+		m_settings.MinScale = std::clamp(m_settings.MinScale, 0.1f, 1.0f);
+		m_settings.MaxScale = std::clamp(m_settings.MaxScale, m_settings.MinScale, 1.0f);
+		m_settings.Step = std::max(m_settings.Step, 0.01f);
+		m_settings.Smoothing = std::clamp(m_settings.Smoothing, 0.01f, 1.0f);
+
+		m_state = {};
+		m_state.Scale = m_state.RawScale = m_state.Integral = m_settings.MaxScale;
+		m_hasHistory = false;
+	}
+
+	/***********************************************************************************/
+	float DynamicResolution::Update(const double gpuMilliseconds)
+	{
+		if (!m_settings.Enabled || gpuMilliseconds <= 0.0 || m_settings.TargetMilliseconds <= 0.0)
+		{
+			return GetScale();
+		}
+
+		// Timer queries jitter from frame to frame, the controller only sees the trend
+		m_state.GPUMilliseconds = gpuMilliseconds;
+		m_state.SmoothedMilliseconds = m_hasHistory ?
+			m_state.SmoothedMilliseconds + m_settings.Smoothing * (gpuMilliseconds - m_state.SmoothedMilliseconds) : gpuMilliseconds;
+
+		auto error{ static_cast<float>((m_settings.TargetMilliseconds - m_state.SmoothedMilliseconds) / m_settings.TargetMilliseconds) };
+		if (std::abs(error) < m_settings.Deadband)
+		{
+			error = 0.0f;
+		}
+		const auto previousError{ m_hasHistory ? m_state.Error : error };
+		m_hasHistory = true;
+
+		m_state.Error = error;
+		m_state.Proportional = m_settings.ProportionalGain * error;
+		m_state.Derivative = m_settings.DerivativeGain * (error - previousError);
+		// Clamped so the integral does not wind up while the scale is pinned at a limit
+		m_state.Integral = std::clamp(m_state.Integral + m_settings.IntegralGain * error, m_settings.MinScale, m_settings.MaxScale);
+
+		m_state.RawScale = std::clamp(m_state.Integral + m_state.Proportional + m_state.Derivative, m_settings.MinScale, m_settings.MaxScale);
+
+		// Rounded to a step, with some hysteresis against timing noise
+		if (std::abs(m_state.RawScale - m_state.Scale) > 0.75f * m_settings.Step)
+		{
+			const auto steps{ std::round((m_state.RawScale - m_settings.MinScale) / m_settings.Step) };
+			const auto scale{ m_state.RawScale == m_settings.MaxScale ? m_settings.MaxScale :
+				std::clamp(m_settings.MinScale + steps * m_settings.Step, m_settings.MinScale, m_settings.MaxScale) };
+			if (scale != m_state.Scale)
+			{
+				m_state.Scale = scale;
+				++m_state.NumScaleChanges;
+			}
+		}
+
+		return m_state.Scale;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Graphics
+{
+	// Picks the scale the scene is rendered at so the GPU frame time stays at a target. A PID controller works on
+	// the relative error (target - measured) / target: the integral term carries the scale the scene settles at,
+	// the proportional and derivative terms react to load changes. Scale changes smaller than a step are ignored,
+	// since every new scale means new render targets.
+	class DynamicResolution {
+	public:
+		struct Settings {
+			bool Enabled{ false };
+			double TargetMilliseconds{ 16.6 };
+			// Per axis
+			float MinScale{ 0.5f }, MaxScale{ 1.0f };
+			float Step{ 0.05f };
+			// Relative error tolerated without changing the scale. Between two steps the scale would flip back
+			// and forth otherwise.
+			float Deadband{ 0.1f };
+			float ProportionalGain{ 0.2f }, IntegralGain{ 0.05f }, DerivativeGain{ 0.05f };
+			// Weight of the newest frame in the smoothed GPU time the controller sees
+			float Smoothing{ 0.25f };
+		};
+
+		// What the controller saw and did for the last frame.
+		struct State {
+			float Scale{ 1.0f };
+			// Output before rounding to a step
+			float RawScale{ 1.0f };
+			double GPUMilliseconds{ 0.0 }, SmoothedMilliseconds{ 0.0 };
+			float Error{ 0.0f };
+			float Proportional{ 0.0f }, Integral{ 0.0f }, Derivative{ 0.0f };
+			std::uint64_t NumScaleChanges{ 0 };
+		};
+
+		void Init(const Settings& settings);
+		// Feeds the GPU time of one finished frame and returns the scale for the next ones.
+		float Update(const double gpuMilliseconds);
+
+		bool IsEnabled() const noexcept { return m_settings.Enabled; }
+		float GetScale() const noexcept { return m_settings.Enabled ? m_state.Scale : 1.0f; }
+		const auto& GetSettings() const noexcept { return m_settings; }
+		const auto& GetState() const noexcept { return m_state; }
+
+	private:
+		Settings m_settings;
+		State m_state;
+		bool m_hasHistory{ false };
+	};
+}
@@ -1,4 +1,4 @@
-#include "GLFramebuffer.h"
+#include "GLFrameBuffer.h"
 
 #include <iostream>
 
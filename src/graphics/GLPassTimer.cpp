@@ -0,0 +1,137 @@
+#include "GLPassTimer.h"
+
+/***********************************************************************************/
+void GLPassTimer::Init()
+{
+	for (auto& frame : m_frames)
+	{
+		glGenQueries(static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+		frame.Passes.reserve(MaxPasses);
+	}
+}
+
+/***********************************************************************************/
+void GLPassTimer::Shutdown()
+{
+	for (auto& frame : m_frames)
+	{
+		glDeleteQueries(static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+		frame.Queries.fill(0);
+		frame.Pending = false;
+	}
+}
+
+/***********************************************************************************/
+void GLPassTimer::BeginFrame()
+{
+	resolve(false);
+
+	// All slots in flight: the GPU is more than MaxFramesInFlight frames behind, wait for the oldest.
+	if (m_frames[m_current].Pending)
+	{
+		resolveOldest(true);
+	}
+
+	m_frames[m_current].Passes.clear();
+}
+
+/***********************************************************************************/
+void GLPassTimer::EndFrame()
+{
+	EndPass();
+
+	m_frames[m_current].Pending = true;
+	m_current = (m_current + 1) % MaxFramesInFlight;
+}
+
+/***********************************************************************************/
+void GLPassTimer::BeginPass(const std::string_view name)
+{
+	EndPass();
+
+	auto& frame{ m_frames[m_current] };
+	if (frame.Passes.size() == MaxPasses)
+	{
+		return;
+	}
+
+	glQueryCounter(frame.Queries[frame.Passes.size() * 2], GL_TIMESTAMP);
+	frame.Passes.push_back({ name });
+
+	m_passOpen = true;
+	m_passStart = Clock::now();
+}
+
+/***********************************************************************************/
+void GLPassTimer::EndPass()
+{
+	if (!m_passOpen)
+	{
+		return;
+	}
+
+	auto& frame{ m_frames[m_current] };
+	glQueryCounter(frame.Queries[frame.Passes.size() * 2 - 1], GL_TIMESTAMP);
+	frame.Passes.back().CPUMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - m_passStart).count();
+
+	m_passOpen = false;
+}
+
+/***********************************************************************************/
+void GLPassTimer::Flush()
+{
+	resolve(true);
+}
+
+/***********************************************************************************/
+void GLPassTimer::resolve(const bool wait)
+{
+	while (resolveOldest(wait))
+	{
+	}
+}
+
+/***********************************************************************************/
+bool GLPassTimer::resolveOldest(const bool wait)
+{
+	auto& frame{ m_frames[m_oldest] };
+	if (!frame.Pending)
+	{
+		return false;
+	}
+
+	if (!frame.Passes.empty())
+	{
+		// Queries complete in order, so the last one tells whether the whole frame is done.
+		if (!wait)
+		{
+			GLint available{ 0 };
+			glGetQueryObjectiv(frame.Queries[frame.Passes.size() * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				return false;
+			}
+		}
+
+		for (std::size_t i = 0; i < frame.Passes.size(); ++i)
+		{
+			GLuint64 begin{ 0 }, end{ 0 };
+			glGetQueryObjectui64v(frame.Queries[i * 2], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.Queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+			frame.Passes[i].GPUMilliseconds = static_cast<double>(end - begin) / 1'000'000.0;
+		}
+	}
+
+	frame.Pending = false;
+	m_oldest = (m_oldest + 1) % MaxFramesInFlight;
+
+	m_results = frame.Passes;
+	++m_numResolvedFrames;
+	if (m_onResolved)
+	{
+		m_onResolved(m_results);
+	}
+
+	return true;
+}
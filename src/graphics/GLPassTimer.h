@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// CPU and GPU time spent in one render pass.
+struct PassTiming {
+	// Pass names are string literals and outlive the timer.
+	std::string_view Name;
+	double CPUMilliseconds{ 0.0 };
+	double GPUMilliseconds{ 0.0 };
+};
+
+// Times render passes with GL_TIMESTAMP queries. Results are read back a few frames later, so timing
+// never stalls the CPU on the GPU. Passes are flat: BeginPass ends the previous one if it is still open.
+class GLPassTimer {
+public:
+	// Receives the passes of one frame in submission order, once its queries have completed.
+	using ResolveCallback = std::function<void(const std::vector<PassTiming>&)>;
+
+	void Init();
+	void Shutdown();
+
+	void BeginFrame();
+	void EndFrame();
+
+	void BeginPass(const std::string_view name);
+	void EndPass();
+
+	// Called for every frame, in order.
+	void SetResolveCallback(ResolveCallback callback) { m_onResolved = std::move(callback); }
+
+	// Waits for all submitted frames and reports them. Used at the end of benchmark runs.
+	void Flush();
+
+	// Newest resolved frame.
+	const auto& GetResults() const noexcept { return m_results; }
+	// Frames resolved so far, tells whether GetResults holds a new frame.
+	auto GetNumResolvedFrames() const noexcept { return m_numResolvedFrames; }
+
+private:
+	static constexpr std::size_t MaxFramesInFlight{ 4 };
+	static constexpr std::size_t MaxPasses{ 32 };
+
+	using Clock = std::chrono::steady_clock;
+
+	struct Frame {
+		// Begin and end timestamp per pass
+		std::array<GLuint, MaxPasses * 2> Queries{};
+		std::vector<PassTiming> Passes;
+		bool Pending{ false };
+	};
+
+	// Reads back pending frames oldest first. Stops at the first incomplete one unless wait is set.
+	void resolve(const bool wait);
+	// False if there is nothing pending, or the oldest frame is incomplete and wait is not set.
+	bool resolveOldest(const bool wait);
+
+	std::array<Frame, MaxFramesInFlight> m_frames;
+	// Frame being recorded and the oldest one not yet resolved
+	std::size_t m_current{ 0 }, m_oldest{ 0 };
+	bool m_passOpen{ false };
+	Clock::time_point m_passStart;
+
+	std::vector<PassTiming> m_results;
+	std::uint64_t m_numResolvedFrames{ 0 };
+	ResolveCallback m_onResolved;
+};
@@ -1,5 +1,7 @@
 #include "GLShaderProgram.h"
 
+#include "../Hash.h"
+
 #include <cassert>
 #include <iostream>
 
@@ -36,76 +38,85 @@ void GLShaderProgram::DeleteProgram() const
 
 
 /***********************************************************************************/
-GLShaderProgram& GLShaderProgram::SetUniformi(const std::string& uniformName, const int value)
+GLShaderProgram& GLShaderProgram::SetUniformi(const std::string_view uniformName, const int value)
 {
-	glUniform1i(m_uniforms.at(uniformName), value);
+	glUniform1i(GetUniformLocation(uniformName), value);
 
 	return *this;
 }
 
 /***********************************************************************************/
-GLShaderProgram& GLShaderProgram::SetUniformf(const std::string& uniformName, const float value)
+GLShaderProgram& GLShaderProgram::SetUniformf(const std::string_view uniformName, const float value)
 {
-	glUniform1f(m_uniforms.at(uniformName), value);
+	glUniform1f(GetUniformLocation(uniformName), value);
 
 	return *this;
 }
 
 /***********************************************************************************/
-GLShaderProgram& GLShaderProgram::SetUniform(const std::string& uniformName, const glm::ivec2& value)
+GLShaderProgram& GLShaderProgram::SetUniform(const std::string_view uniformName, const glm::ivec2& value)
 {
-	glUniform2iv(m_uniforms.at(uniformName), 1, &value[0]);
+	glUniform2iv(GetUniformLocation(uniformName), 1, &value[0]);
 
 	return *this;
 }
 
 /***********************************************************************************/
-GLShaderProgram& GLShaderProgram::SetUniform(const std::string& uniformName, const glm::vec2& value)
+GLShaderProgram& GLShaderProgram::SetUniform(const std::string_view uniformName, const glm::vec2& value)
 {
-	glUniform2f(m_uniforms.at(uniformName), value.x, value.y);
+	glUniform2f(GetUniformLocation(uniformName), value.x, value.y);
 
 	return *this;
 }
 
 /***********************************************************************************/
-GLShaderProgram& GLShaderProgram::SetUniform(const std::string& uniformName, const glm::vec3& value)
+GLShaderProgram& GLShaderProgram::SetUniform(const std::string_view uniformName, const glm::vec3& value)
 {
-	glUniform3f(m_uniforms.at(uniformName), value.x, value.y, value.z);
+	glUniform3f(GetUniformLocation(uniformName), value.x, value.y, value.z);
 
 	return *this;
 }
 
 /***********************************************************************************/
-GLShaderProgram& GLShaderProgram::SetUniform(const std::string& uniformName, const glm::vec4& value)
+GLShaderProgram& GLShaderProgram::SetUniform(const std::string_view uniformName, const glm::vec4& value)
 {
-	glUniform4f(m_uniforms.at(uniformName), value.x, value.y, value.z, value.w);
+	glUniform4f(GetUniformLocation(uniformName), value.x, value.y, value.z, value.w);
 
 	return *this;
 }
 
 /***********************************************************************************/
-GLShaderProgram& GLShaderProgram::SetUniform(const std::string& uniformName, const glm::mat3x3& value)
+GLShaderProgram& GLShaderProgram::SetUniform(const std::string_view uniformName, const glm::mat3x3& value)
 {
-	glUniformMatrix3fv(m_uniforms.at(uniformName), 1, GL_FALSE, value_ptr(value));
+	glUniformMatrix3fv(GetUniformLocation(uniformName), 1, GL_FALSE, value_ptr(value));
 
 	return *this;
 }
 
-GLShaderProgram& GLShaderProgram::SetVec3(const std::string& uniformName, const glm::vec3& value)
+GLShaderProgram& GLShaderProgram::SetVec3(const std::string_view uniformName, const glm::vec3& value)
 {
-	glUniform3fv(glGetUniformLocation(m_programID, uniformName.c_str()), 1, &value[0]);
+	glUniform3fv(GetUniformLocation(uniformName), 1, &value[0]);
 
 	return *this;
 }
 
 /***********************************************************************************/
-GLShaderProgram& GLShaderProgram::SetUniform(const std::string& uniformName, const glm::mat4x4& value)
+GLShaderProgram& GLShaderProgram::SetUniform(const std::string_view uniformName, const glm::mat4x4& value)
 {
-	glUniformMatrix4fv(m_uniforms.at(uniformName), 1, GL_FALSE, value_ptr(value));
+	glUniformMatrix4fv(GetUniformLocation(uniformName), 1, GL_FALSE, value_ptr(value));
 
 	return *this;
 }
 
+/***********************************************************************************/
+GLint GLShaderProgram::GetUniformLocation(const std::string_view uniformName) const noexcept
+{
+	const auto uniform{ m_uniforms.find(Hash::Hash64(uniformName)) };
+
+	// -1 makes glUniform* a no-op, for uniforms a shader permutation compiled out
+	return uniform != m_uniforms.cend() ? uniform->second : -1;
+}
+
 /***********************************************************************************/
 void GLShaderProgram::getUniforms()
 {
@@ -127,7 +138,10 @@ void GLShaderProgram::getUniforms()
 
 		std::cout << "Shader: " << m_programName << " - " << "Pushback uniform: " << nameStr << "\n";
 		// TODO: Filter out uniform block members using glGetActiveUniformsiv
-		m_uniforms.try_emplace(nameStr, glGetUniformLocation(m_programID, name));
+		if (!m_uniforms.try_emplace(Hash::Hash64(nameStr), glGetUniformLocation(m_programID, name)).second)
+		{
+			std::cerr << "GLShaderProgram Error: Uniform " << nameStr << " of " << m_programName << " collides with another uniform's hash\n";
+		}
 	}
 
 	std::cout << "###############################################\n";
@@ -5,8 +5,10 @@
 
 #include <glad/glad.h>
 
+#include <cstdint>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 
 class GLShaderProgram {
 
@@ -44,22 +46,27 @@ public:
 	void Bind() const;
 	void DeleteProgram() const;
 
-	GLShaderProgram& SetUniformi(const std::string& uniformName, const int value);
-	GLShaderProgram& SetUniformf(const std::string& uniformName, const float value);
-	GLShaderProgram& SetUniform(const std::string& uniformName, const glm::ivec2& value);
-	GLShaderProgram& SetUniform(const std::string& uniformName, const glm::vec2& value);
-	GLShaderProgram& SetUniform(const std::string& uniformName, const glm::vec3& value);
-	GLShaderProgram& SetUniform(const std::string& uniformName, const glm::vec4& value);
-	GLShaderProgram& SetUniform(const std::string& uniformName, const glm::mat3x3& value);
-	GLShaderProgram& SetUniform(const std::string& uniformName, const glm::mat4x4& value);
-	GLShaderProgram& SetVec3(const std::string& uniformName, const glm::vec3& value);
+	GLShaderProgram& SetUniformi(const std::string_view uniformName, const int value);
+	GLShaderProgram& SetUniformf(const std::string_view uniformName, const float value);
+	GLShaderProgram& SetUniform(const std::string_view uniformName, const glm::ivec2& value);
+	GLShaderProgram& SetUniform(const std::string_view uniformName, const glm::vec2& value);
+	GLShaderProgram& SetUniform(const std::string_view uniformName, const glm::vec3& value);
+	GLShaderProgram& SetUniform(const std::string_view uniformName, const glm::vec4& value);
+	GLShaderProgram& SetUniform(const std::string_view uniformName, const glm::mat3x3& value);
+	GLShaderProgram& SetUniform(const std::string_view uniformName, const glm::mat4x4& value);
+	GLShaderProgram& SetVec3(const std::string_view uniformName, const glm::vec3& value);
 
-	auto GetProgramName() const noexcept { return m_programName; }
+	const auto& GetProgramName() const noexcept { return m_programName; }
+	auto GetProgramID() const noexcept { return m_programID; }
+	// Location of an active uniform, -1 if the program does not use it. Only reads the table built at link
+	// time, so commands can be recorded on any thread.
+	GLint GetUniformLocation(const std::string_view uniformName) const noexcept;
 
 private:
 	void getUniforms();
 
-	std::unordered_map<std::string, int> m_uniforms;
+	// Uniform locations keyed by the hash of their name, so setting a uniform by name never builds a string
+	std::unordered_map<std::uint64_t, GLint> m_uniforms;
 
 	GLuint m_programID{ 0 };
 	std::string m_programName;
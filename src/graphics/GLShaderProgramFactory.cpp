@@ -1,13 +1,16 @@
 #include "GLShaderProgramFactory.h"
 
-#include "../ResourceManager.h"
+#include "ShaderCache.h"
+#include "ShaderPreprocessor.h"
 
 #include <glad/glad.h>
 
 #include <fmt/core.h>
 
+#include <algorithm>
 #include <iostream>
 #include <unordered_map>
+#include <utility>
 
 namespace Graphics
 {
@@ -22,48 +25,68 @@ namespace Graphics
 	};
 
 	/***********************************************************************************/
-	void compile(const GLuint id, const GLchar* shaderCode)
-	{
-		glShaderSource(id, 1, &shaderCode, nullptr);
-		glCompileShader(id);
-	}
+	bool parallelCompileEnabled{ false };
 
 	/***********************************************************************************/
-	bool compileStage(const GLuint id, const std::string& shaderCode)
+	// Non-blocking check whether the driver has finished a shader or program
+	bool isComplete(const GLuint id, const bool isProgram)
 	{
- 		GLint success{ GL_FALSE };
-		GLint logLength{ -1 };
+		if (!parallelCompileEnabled)
+		{
+			return true;
+		}
 
-		compile(id, shaderCode.c_str());
+		GLint complete{ GL_FALSE };
+		if (isProgram)
+		{
+			glGetProgramiv(id, GL_COMPLETION_STATUS_ARB, &complete);
+		} else
+		{
+			glGetShaderiv(id, GL_COMPLETION_STATUS_ARB, &complete);
+		}
+		return complete == GL_TRUE;
+	}
 
+	/***********************************************************************************/
+	bool checkStage(const GLuint id, const std::string& programName, const Graphics::ShaderStage& stage, const std::vector<std::filesystem::path>& files)
+	{
+		GLint success{ GL_FALSE };
 		glGetShaderiv(id, GL_COMPILE_STATUS, &success);
-		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &logLength);
 
 		if (!success)
 		{
-			//GLchar infoLog[1024];
-			std::vector<GLchar> infoLog(logLength);
-			glGetShaderInfoLog(id, logLength, NULL, infoLog.data());
-			std::cout << fmt::format("{}", std::string(infoLog.cbegin(), infoLog.cend())) << std::endl;
-			abort();
+			GLint logLength{ 0 };
+			glGetShaderiv(id, GL_INFO_LOG_LENGTH, &logLength);
+
+			std::vector<GLchar> infoLog(std::max(logLength, 1));
+			glGetShaderInfoLog(id, logLength, nullptr, infoLog.data());
+			std::cerr << fmt::format("Shader Error: {} ({} stage {}) failed to compile:\n{}", programName, stage.type, stage.filePath, infoLog.data());
+			// Messages refer to included files by their source string number
+			for (std::size_t i = 1; i < files.size(); ++i)
+			{
+				std::cerr << fmt::format("  source {} = {}\n", i, files[i].generic_string());
+			}
+			std::cerr << std::endl;
 		}
 
 		return success == GL_TRUE;
 	}
 
 	/***********************************************************************************/
-	bool linkProgram(const GLuint id)
+	bool checkProgram(const GLuint id, const std::string& programName)
 	{
 		GLint success{ GL_FALSE };
-		GLint logLength{ -1 };
-
-		glLinkProgram(id);
 		glGetProgramiv(id, GL_LINK_STATUS, &success);
-		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &logLength);
 
-		std::vector<GLchar> infoLog(0, logLength);
-		glGetProgramInfoLog(id, logLength, nullptr, infoLog.data());
-		std::cout << fmt::format("{}", std::string(infoLog.cbegin(), infoLog.cend())) << std::endl;
+		if (!success)
+		{
+			GLint logLength{ 0 };
+			glGetProgramiv(id, GL_INFO_LOG_LENGTH, &logLength);
+
+			std::vector<GLchar> infoLog(std::max(logLength, 1));
+			glGetProgramInfoLog(id, logLength, nullptr, infoLog.data());
+			std::cerr << fmt::format("Shader Error: {} failed to link:\n{}", programName, infoLog.data()) << std::endl;
+		}
 
 		return success == GL_TRUE;
 	}
@@ -72,116 +95,242 @@ namespace Graphics
 	bool validateProgram(const GLuint id)
 	{
 		GLint success{ GL_FALSE };
-		GLint logLength{ -1 };
 
 		glValidateProgram(id);
 		glGetProgramiv(id, GL_VALIDATE_STATUS, &success);
-		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &logLength);
-
-		std::vector<GLchar> infoLog(0, logLength);
-		glGetProgramInfoLog(id, logLength, nullptr, infoLog.data());
-		//std::cout << fmt::format("{}", std::string(infoLog.cbegin(), infoLog.cend())) << std::endl;
 
 		return success == GL_TRUE;
 	}
 
 	/***********************************************************************************/
-	void scanForIncludes(std::string& shaderCode)
+	void replaceAll(std::string& str, const std::string& from, const std::string& to)
 	{
-		std::size_t startPos = 0;
-		const static std::string includeDirective{ "#include " };
+		std::size_t start_pos = 0;
 
-		// Scan string for all instances of include directive
-		while ((startPos = shaderCode.find(includeDirective, startPos)) != std::string::npos)
+		while ((start_pos = str.find(from, start_pos)) != std::string::npos)
 		{
-			// Find position of include directive
-			const auto pos = startPos + includeDirective.length() + 1;
-			const auto length = shaderCode.find('"', pos);
-			const auto pathToIncludedFile = shaderCode.substr(pos, length - pos);
+			str.replace(start_pos, from.length(), to);
+			start_pos += to.length(); // In case 'to' contains 'from', like replacing 'x' with 'yx'
+		}
+	}
 
-			// Load included file
-			const auto includedFile = ResourceManager::GetInstance().LoadTextFile(pathToIncludedFile) + "\n";
-			// Insert into shader code
-			shaderCode.replace(startPos, (length + 1) - startPos, includedFile);
+	/***********************************************************************************/
+	// Inserts the defines after #version, which has to stay the first directive, and restores the line numbers
+	void injectDefines(std::string& shaderCode, const std::vector<std::string>& defines)
+	{
+		if (defines.empty())
+		{
+			return;
+		}
 
-			// Increment start position and continue scanning
-			startPos += includedFile.length();
+		std::size_t insertPos{ 0 };
+		std::size_t line{ 1 };
+		if (const auto version{ shaderCode.find("#version") }; version != std::string::npos)
+		{
+			insertPos = shaderCode.find('\n', version);
+			insertPos = insertPos == std::string::npos ? shaderCode.size() : insertPos + 1;
+			line += static_cast<std::size_t>(std::count(shaderCode.cbegin(), shaderCode.cbegin() + insertPos, '\n'));
+		}
+
+		std::string block;
+		for (const auto& define : defines)
+		{
+			block += "#define " + define + '\n';
 		}
+		block += fmt::format("#line {} 0\n", line);
+
+		shaderCode.insert(insertPos, block);
 	}
 
 	/***********************************************************************************/
-	void replaceAll(std::string& str, const std::string& from, const std::string& to)
+	bool GLShaderProgramFactory::enableParallelCompile()
 	{
-		std::size_t start_pos = 0;
-
-		while ((start_pos = str.find(from, start_pos)) != std::string::npos)
+		if (!GLAD_GL_ARB_parallel_shader_compile)
 		{
-			str.replace(start_pos, from.length(), to);
-			start_pos += to.length(); // In case 'to' contains 'from', like replacing 'x' with 'yx'
+			return false;
 		}
+
+		// Let the driver pick the number of compiler threads
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		parallelCompileEnabled = true;
+
+		return true;
 	}
 
 	/***********************************************************************************/
-	std::optional<GLShaderProgram> GLShaderProgramFactory::createShaderProgram(
+	bool GLShaderProgramFactory::isParallelCompileEnabled() noexcept
+	{
+		return parallelCompileEnabled;
+	}
+
+	/***********************************************************************************/
+	PendingShaderProgram GLShaderProgramFactory::submitShaderProgram(
 		const std::string& programName,
-		const std::vector<Graphics::ShaderStage>& stages
+		const std::vector<Graphics::ShaderStage>& stages,
+		const std::vector<std::string>& defines
 	)
 	{
+		PendingShaderProgram pending;
+		pending.Name = programName;
+		pending.Stages = stages;
+
+		// Preprocessed sources form the cache key, so edits to included files are picked up too
+		std::vector<std::string> sources;
+		sources.reserve(stages.size());
+		pending.StageFiles.reserve(stages.size());
+		for (const auto& stage : stages)
+		{
+			auto preprocessed{ ShaderPreprocessor::GetInstance().Process(stage.filePath) };
+			if (!preprocessed)
+			{
+				std::cerr << "Shader Error: " << programName << " (" << stage.type << " stage " << stage.filePath << ") failed to preprocess" << std::endl;
+				discardShaderProgram(pending);
+				return pending;
+			}
 
-		std::cout << "Building shader program " << programName << std::endl;
+			replaceAll(preprocessed->Source, "hash ", "#");
+			injectDefines(preprocessed->Source, defines);
+			sources.push_back(std::move(preprocessed->Source));
+			pending.StageFiles.push_back(std::move(preprocessed->Files));
+		}
 
-		std::vector<GLuint> shaderIds;
+		pending.CacheKey = BuildShaderCacheKey(stages, sources);
+		if (const auto cachedProgramID{ LoadCachedProgram(pending.CacheKey) }; cachedProgramID != 0)
+		{
+			std::cout << "Loaded shader program " << programName << " from cache" << std::endl;
+			pending.ProgramID = cachedProgramID;
+			pending.Status = PendingShaderProgram::State::Ready;
+			return pending;
+		}
 
-		bool success{ true };
-		for (auto i = 0; i < stages.size(); ++i)
+		std::cout << "Building shader program " << programName;
+		for (const auto& define : defines)
 		{
-			auto id{ glCreateShader(Type2GL_ENUM.at(stages[i].type)) };
-			shaderIds.push_back(id);
-			auto shaderCode{ ResourceManager::GetInstance().LoadTextFile(stages[i].filePath) };
-			scanForIncludes(shaderCode);
-			replaceAll(shaderCode, "hash ", "#");
-			if (!compileStage(id, shaderCode))
-			{
-				success = false;
-				break;
-			}
+			std::cout << ' ' << define;
 		}
-		if (!success)
+		std::cout << std::endl;
+
+		for (std::size_t i = 0; i < stages.size(); ++i)
 		{
-			for (const auto id : shaderIds)
+			const auto type{ Type2GL_ENUM.find(stages[i].type) };
+			if (type == Type2GL_ENUM.cend())
 			{
-				glDeleteShader(id);
+				std::cerr << "Shader Error: " << programName << " has a stage of unknown type " << stages[i].type << std::endl;
+				discardShaderProgram(pending);
+				return pending;
 			}
-			return std::nullopt;
+
+			const auto id{ glCreateShader(type->second) };
+			const auto* shaderCode{ sources[i].c_str() };
+			glShaderSource(id, 1, &shaderCode, nullptr);
+			glCompileShader(id);
+
+			pending.ShaderIDs.push_back(id);
 		}
 
-		GLuint programID{ glCreateProgram() };
+		return pending;
+	}
+
+	/***********************************************************************************/
+	std::optional<GLShaderProgram> GLShaderProgramFactory::pollShaderProgram(PendingShaderProgram& pending, const bool wait)
+	{
+		using State = PendingShaderProgram::State;
 
-		for (const auto id : shaderIds)
+		if (pending.Status == State::Compiling)
 		{
-			glAttachShader(programID, id);
+			if (!wait && !std::all_of(pending.ShaderIDs.cbegin(), pending.ShaderIDs.cend(), [](const auto id) { return isComplete(id, false); }))
+			{
+				return std::nullopt;
+			}
+
+			for (std::size_t i = 0; i < pending.ShaderIDs.size(); ++i)
+			{
+				if (!checkStage(pending.ShaderIDs[i], pending.Name, pending.Stages[i], pending.StageFiles[i]))
+				{
+					discardShaderProgram(pending);
+					return std::nullopt;
+				}
+			}
+
+			pending.ProgramID = glCreateProgram();
+			for (const auto id : pending.ShaderIDs)
+			{
+				glAttachShader(pending.ProgramID, id);
+			}
+			glProgramParameteri(pending.ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glLinkProgram(pending.ProgramID);
+
+			pending.Status = State::Linking;
 		}
-		// link and validate
-		if (!linkProgram(programID) || !validateProgram(programID))
+
+		if (pending.Status == State::Linking)
 		{
-			for (const auto id : shaderIds)
+			if (!wait && !isComplete(pending.ProgramID, true))
+			{
+				return std::nullopt;
+			}
+
+			if (!checkProgram(pending.ProgramID, pending.Name) || !validateProgram(pending.ProgramID))
 			{
-				glDetachShader(programID, id);
+				discardShaderProgram(pending);
+				return std::nullopt;
+			}
+
+			for (const auto id : pending.ShaderIDs)
+			{
+				glDetachShader(pending.ProgramID, id);
 				glDeleteShader(id);
 			}
-			glDeleteProgram(programID);
+			pending.ShaderIDs.clear();
+
+			StoreCachedProgram(pending.CacheKey, pending.ProgramID);
+
+			pending.Status = State::Ready;
+		}
+
+		if (pending.Status != State::Ready)
+		{
 			return std::nullopt;
 		}
 
-		for (const auto id : shaderIds)
+		// The GLShaderProgram owns the program from here on
+		const auto programID{ std::exchange(pending.ProgramID, 0) };
+
+		// leave uniform introspection to GLShaderProgram
+		return std::make_optional<GLShaderProgram>({ pending.Name, programID });
+	}
+
+	/***********************************************************************************/
+	void GLShaderProgramFactory::discardShaderProgram(PendingShaderProgram& pending)
+	{
+		for (const auto id : pending.ShaderIDs)
 		{
-			glDetachShader(programID, id);
+			if (pending.ProgramID != 0)
+			{
+				glDetachShader(pending.ProgramID, id);
+			}
 			glDeleteShader(id);
 		}
+		pending.ShaderIDs.clear();
 
-		// leave uniform introspection to GLShaderProgram
+		if (pending.ProgramID != 0)
+		{
+			glDeleteProgram(pending.ProgramID);
+			pending.ProgramID = 0;
+		}
 
-		return std::make_optional<GLShaderProgram>({ programName, programID });
+		pending.Status = PendingShaderProgram::State::Failed;
+	}
+
+	/***********************************************************************************/
+	std::optional<GLShaderProgram> GLShaderProgramFactory::createShaderProgram(
+		const std::string& programName,
+		const std::vector<Graphics::ShaderStage>& stages,
+		const std::vector<std::string>& defines
+	)
+	{
+		auto pending{ submitShaderProgram(programName, stages, defines) };
+		return pollShaderProgram(pending, true);
 	}
 
 }; // namespace Graphics
\ No newline at end of file
@@ -3,18 +3,63 @@
 #include "GLShaderProgram.h"
 #include "ShaderStage.h"
 
+#include <cstdint>
+#include <filesystem>
 #include <optional>
+#include <string>
 #include <vector>
 
 namespace Graphics
 {
 
+    // Program handed to the driver whose compile and link results have not been checked yet.
+    struct PendingShaderProgram {
+        enum class State {
+            Compiling,
+            Linking,
+            Ready,
+            Failed
+        };
+
+        std::string Name;
+        std::uint64_t CacheKey{ 0 };
+        std::vector<Graphics::ShaderStage> Stages;
+        // Files each stage was preprocessed from, the stage file first (see ShaderPreprocessor::Result)
+        std::vector<std::vector<std::filesystem::path>> StageFiles;
+        std::vector<GLuint> ShaderIDs;
+        GLuint ProgramID{ 0 };
+        State Status{ State::Compiling };
+    };
+
     class GLShaderProgramFactory {
     public:
+        // Lets the driver compile on its own threads (ARB/KHR_parallel_shader_compile) and answer
+        // completion queries without blocking. Needs a current context; false if unsupported.
+        static bool enableParallelCompile();
+        static bool isParallelCompileEnabled() noexcept;
+
+        // Loads, preprocesses and submits all stages without waiting for the compiler. A cached binary
+        // makes the program ready right away. Every define is injected as "#define <define>" after #version,
+        // so each permutation is a separate program with its own binary cache entry.
+        static PendingShaderProgram submitShaderProgram(
+            const std::string& programName,
+            const std::vector<Graphics::ShaderStage>& stages,
+            const std::vector<std::string>& defines = {}
+        );
+
+        // Advances compilation and linking, returns the program once it is ready. Without wait it only
+        // blocks on drivers lacking parallel compile. Errors are logged and leave pending Failed.
+        static std::optional<GLShaderProgram> pollShaderProgram(PendingShaderProgram& pending, const bool wait);
+
+        // Releases a program that is still compiling or has failed.
+        static void discardShaderProgram(PendingShaderProgram& pending);
+
+        // Submits and waits for the program.
         static std::optional<GLShaderProgram> createShaderProgram(
             const std::string& programName,
-            const std::vector<Graphics::ShaderStage>& stages
+            const std::vector<Graphics::ShaderStage>& stages,
+            const std::vector<std::string>& defines = {}
         );
     };
 
-}; // namespace Graphics
\ No newline at end of file
+}; // namespace Graphics
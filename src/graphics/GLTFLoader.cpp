@@ -0,0 +1,923 @@
+#include "GLTFLoader.h"
+#include "MeshProcessing.h"
+
+#include "../core/MappedFile.h"
+#include "../Hash.h"
+#include "../PBRMaterial.h"
+#include "../Platform/SIMD.h"
+
+#include <cereal_rapidjson/document.h>
+#include <cereal_rapidjson/error/en.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+
+namespace
+{
+	// cereal's RapidJSON, see ext/include/cereal_rapidjson/README.md
+	namespace json = CEREAL_RAPIDJSON_NAMESPACE;
+
+	constexpr std::uint32_t GLBMagic{ 0x46546C67 };			// "glTF"
+	constexpr std::uint32_t GLBChunkJSON{ 0x4E4F534A };		// "JSON"
+	constexpr std::uint32_t GLBChunkBinary{ 0x004E4942 };	// "BIN\0"
+
+	// accessor.componentType
+	constexpr std::uint32_t Byte{ 5120 };
+	constexpr std::uint32_t UnsignedByte{ 5121 };
+	constexpr std::uint32_t Short{ 5122 };
+	constexpr std::uint32_t UnsignedShort{ 5123 };
+	constexpr std::uint32_t UnsignedInt{ 5125 };
+	constexpr std::uint32_t Float{ 5126 };
+
+	// primitive.mode
+	constexpr std::uint32_t Triangles{ 4 };
+	constexpr std::uint32_t TriangleStrip{ 5 };
+	constexpr std::uint32_t TriangleFan{ 6 };
+
+	constexpr std::uint32_t None{ ~0u };
+
+	// Backing of ZeroAccessor, 16 bytes for the SIMD loads
+	alignas(16) constexpr std::array<float, 4> Zeros{};
+
+	static_assert(sizeof(Vertex) == 11 * sizeof(float) && offsetof(Vertex, TexCoords) == 3 * sizeof(float) &&
+		offsetof(Vertex, Normal) == 5 * sizeof(float) && offsetof(Vertex, Tangent) == 8 * sizeof(float),
+		"The accessor conversion writes Vertex as 11 packed floats");
+
+	struct Span {
+		const std::byte* Data{ nullptr };
+		std::size_t Size{ 0 };
+	};
+
+	// Element i of an accessor starts at Data + i * Stride
+	struct Accessor {
+		const std::byte* Data{ nullptr };
+		std::size_t Stride{ 0 };
+		std::size_t Count{ 0 };
+		std::uint32_t ComponentType{ Float };
+		std::uint32_t Components{ 0 };
+		bool Normalized{ false };
+		const json::Value* Min{ nullptr };
+		const json::Value* Max{ nullptr };
+
+		auto IsFloat(const std::uint32_t components) const noexcept { return ComponentType == Float && Components == components; }
+	};
+
+	// Stands in for an attribute a primitive does not have: every element reads as 0
+	const Accessor ZeroAccessor{ reinterpret_cast<const std::byte*>(Zeros.data()), 0, 0, Float, 4 };
+
+	// The parsed file and the memory its buffers live in, kept until every primitive is converted
+	struct Document {
+		std::filesystem::path Path;
+		json::Document Root;
+		MappedFile File;
+		std::vector<MappedFile> BufferFiles;
+		std::vector<std::string> DecodedBuffers;
+		std::vector<Span> Buffers;
+		// BIN chunk of a .glb, buffer 0 if that has no uri
+		Span BinaryChunk;
+	};
+
+	/***********************************************************************************/
+	void reportError(const Document& document, const std::string_view message)
+	{
+		std::cerr << fmt::format("glTF Error: {}: {}\n", document.Path.string(), message);
+	}
+
+	/***********************************************************************************/
+	const json::Value* getMember(const json::Value& object, const char* name)
+	{
+		if (!object.IsObject())
+		{
+			return nullptr;
+		}
+		const auto member{ object.FindMember(name) };
+		return member != object.MemberEnd() ? &member->value : nullptr;
+	}
+
+	/***********************************************************************************/
+	std::uint32_t getUint(const json::Value& object, const char* name, const std::uint32_t fallback = None)
+	{
+		const auto* value{ getMember(object, name) };
+		return value && value->IsUint() ? value->GetUint() : fallback;
+	}
+
+	/***********************************************************************************/
+	float getFloat(const json::Value& object, const char* name, const float fallback)
+	{
+		const auto* value{ getMember(object, name) };
+		return value && value->IsNumber() ? value->GetFloat() : fallback;
+	}
+
+	/***********************************************************************************/
+	std::string_view getString(const json::Value& object, const char* name)
+	{
+		const auto* value{ getMember(object, name) };
+		return value && value->IsString() ? std::string_view(value->GetString(), value->GetStringLength()) : std::string_view();
+	}
+
+	/***********************************************************************************/
+	// Element index of the top level array name, nullptr if either does not exist
+	const json::Value* getElement(const Document& document, const char* name, const std::uint32_t index)
+	{
+		const auto* array{ getMember(document.Root, name) };
+		if (array == nullptr || !array->IsArray() || index >= array->Size())
+		{
+			return nullptr;
+		}
+		return &(*array)[index];
+	}
+
+	/***********************************************************************************/
+	std::size_t getComponentSize(const std::uint32_t componentType) noexcept
+	{
+		switch (componentType)
+		{
+		case Byte:
+		case UnsignedByte:
+			return 1;
+		case Short:
+		case UnsignedShort:
+			return 2;
+		case UnsignedInt:
+		case Float:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	/***********************************************************************************/
+	std::uint32_t getNumComponents(const std::string_view type) noexcept
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4" || type == "MAT2") return 4;
+		if (type == "MAT3") return 9;
+		if (type == "MAT4") return 16;
+		return 0;
+	}
+
+	/***********************************************************************************/
+	// Relative URIs may escape characters, e.g. spaces as %20
+	std::string decodeURI(const std::string_view uri)
+	{
+		std::string decoded;
+		decoded.reserve(uri.size());
+		for (std::size_t i = 0; i < uri.size(); ++i)
+		{
+			if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2])))
+			{
+				decoded += static_cast<char>(std::stoi(std::string(uri.substr(i + 1, 2)), nullptr, 16));
+				i += 2;
+			} else
+			{
+				decoded += uri[i];
+			}
+		}
+		return decoded;
+	}
+
+	/***********************************************************************************/
+	// Decodes base64 up to the padding or the first character outside the alphabet
+	std::string decodeBase64(const std::string_view text)
+	{
+		const auto sextet = [](const char c) -> int {
+			if (c >= 'A' && c <= 'Z') return c - 'A';
+			if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+			if (c >= '0' && c <= '9') return c - '0' + 52;
+			if (c == '+') return 62;
+			if (c == '/') return 63;
+			return -1;
+		};
+
+		std::string decoded;
+		decoded.reserve(text.size() / 4 * 3);
+
+		std::uint32_t bits{ 0 };
+		int bitCount{ 0 };
+		for (const auto c : text)
+		{
+			const auto value{ sextet(c) };
+			if (value < 0)
+			{
+				break;
+			}
+			bits = (bits << 6) | static_cast<std::uint32_t>(value);
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				decoded += static_cast<char>((bits >> bitCount) & 0xFF);
+			}
+		}
+		return decoded;
+	}
+
+	/***********************************************************************************/
+	// Payload of a base64 data: URI, empty if uri is not one
+	std::optional<std::string> decodeDataURI(const std::string_view uri)
+	{
+		constexpr std::string_view marker{ ";base64," };
+		const auto start{ uri.find(marker) };
+		if (uri.substr(0, 5) != "data:" || start == std::string_view::npos)
+		{
+			return std::nullopt;
+		}
+		return decodeBase64(uri.substr(start + marker.size()));
+	}
+
+	/***********************************************************************************/
+	// Finds the JSON (and BIN chunk) of a .glb, or takes the whole file as JSON
+	bool parseDocument(Document& document)
+	{
+		const auto* data{ document.File.GetData() };
+		const auto size{ document.File.GetSize() };
+		Span jsonText{ data, size };
+
+		std::uint32_t header[3]{};
+		if (size >= sizeof(header))
+		{
+			std::memcpy(header, data, sizeof(header));
+		}
+
+		if (header[0] == GLBMagic)
+		{
+			if (header[1] != 2 || header[2] > size)
+			{
+				reportError(document, fmt::format("Unsupported or truncated GLB (version {}, {} of {} bytes)", header[1], size, header[2]));
+				return false;
+			}
+
+			// Chunks follow the header, JSON first, each padded to 4 bytes
+			jsonText = {};
+			for (std::size_t offset = sizeof(header); offset + 8 <= header[2];)
+			{
+				std::uint32_t chunk[2];
+				std::memcpy(chunk, data + offset, sizeof(chunk));
+				offset += sizeof(chunk);
+				if (chunk[0] > header[2] - offset)
+				{
+					reportError(document, "GLB chunk runs past the end of the file");
+					return false;
+				}
+
+				if (chunk[1] == GLBChunkJSON && jsonText.Data == nullptr)
+				{
+					jsonText = { data + offset, chunk[0] };
+				} else if (chunk[1] == GLBChunkBinary && document.BinaryChunk.Data == nullptr)
+				{
+					document.BinaryChunk = { data + offset, chunk[0] };
+				}
+				offset += (chunk[0] + 3u) & ~3u;
+			}
+
+			if (jsonText.Data == nullptr)
+			{
+				reportError(document, "GLB has no JSON chunk");
+				return false;
+			}
+		}
+
+		document.Root.Parse(reinterpret_cast<const char*>(jsonText.Data), jsonText.Size);
+		if (document.Root.HasParseError() || !document.Root.IsObject())
+		{
+			reportError(document, fmt::format("Invalid JSON at offset {}: {}", document.Root.GetErrorOffset(), json::GetParseError_En(document.Root.GetParseError())));
+			return false;
+		}
+
+		return true;
+	}
+
+	/***********************************************************************************/
+	// Maps external buffer files, decodes data: URIs and takes the BIN chunk for buffer 0 of a .glb
+	bool loadBuffers(Document& document)
+	{
+		const auto* buffers{ getMember(document.Root, "buffers") };
+		if (buffers == nullptr || !buffers->IsArray())
+		{
+			return true;
+		}
+
+		document.BufferFiles.reserve(buffers->Size());
+		for (json::SizeType i = 0; i < buffers->Size(); ++i)
+		{
+			const auto& buffer{ (*buffers)[i] };
+			const auto uri{ getString(buffer, "uri") };
+			const std::size_t byteLength{ getUint(buffer, "byteLength", 0) };
+
+			Span span;
+			if (uri.empty())
+			{
+				if (i != 0 || document.BinaryChunk.Data == nullptr)
+				{
+					reportError(document, fmt::format("Buffer {} has no uri", i));
+					return false;
+				}
+				span = document.BinaryChunk;
+			} else if (auto decoded{ decodeDataURI(uri) })
+			{
+				const auto& bytes{ document.DecodedBuffers.emplace_back(std::move(*decoded)) };
+				span = { reinterpret_cast<const std::byte*>(bytes.data()), bytes.size() };
+			} else
+			{
+				auto& file{ document.BufferFiles.emplace_back() };
+				if (!file.Open(document.Path.parent_path() / decodeURI(uri)))
+				{
+					return false;
+				}
+				span = { file.GetData(), file.GetSize() };
+			}
+
+			if (span.Size < byteLength)
+			{
+				reportError(document, fmt::format("Buffer {} holds {} bytes, {} expected", i, span.Size, byteLength));
+				return false;
+			}
+			document.Buffers.push_back(span);
+		}
+
+		return true;
+	}
+
+	/***********************************************************************************/
+	// Bytes of a buffer view, empty if it is out of range
+	std::optional<Span> getBufferView(const Document& document, const std::uint32_t index, std::size_t* stride = nullptr)
+	{
+		const auto* view{ getElement(document, "bufferViews", index) };
+		const auto buffer{ view ? getUint(*view, "buffer") : None };
+		if (view == nullptr || buffer >= document.Buffers.size())
+		{
+			reportError(document, fmt::format("Buffer view {} is missing or has no buffer", index));
+			return std::nullopt;
+		}
+
+		const std::size_t offset{ getUint(*view, "byteOffset", 0) };
+		const std::size_t length{ getUint(*view, "byteLength", 0) };
+		if (offset + length > document.Buffers[buffer].Size)
+		{
+			reportError(document, fmt::format("Buffer view {} runs past its buffer", index));
+			return std::nullopt;
+		}
+
+		if (stride != nullptr)
+		{
+			*stride = getUint(*view, "byteStride", 0);
+		}
+		return Span{ document.Buffers[buffer].Data + offset, length };
+	}
+
+	/***********************************************************************************/
+	std::optional<Accessor> getAccessor(const Document& document, const std::uint32_t index)
+	{
+		const auto* object{ getElement(document, "accessors", index) };
+		if (object == nullptr)
+		{
+			reportError(document, fmt::format("Accessor {} does not exist", index));
+			return std::nullopt;
+		}
+		if (getMember(*object, "sparse") != nullptr || getMember(*object, "bufferView") == nullptr)
+		{
+			reportError(document, fmt::format("Accessor {} is sparse or has no buffer view, which is not supported", index));
+			return std::nullopt;
+		}
+
+		Accessor accessor;
+		accessor.Count = getUint(*object, "count", 0);
+		accessor.ComponentType = getUint(*object, "componentType", 0);
+		accessor.Components = getNumComponents(getString(*object, "type"));
+		const auto* normalized{ getMember(*object, "normalized") };
+		accessor.Normalized = normalized && normalized->IsBool() && normalized->GetBool();
+		accessor.Min = getMember(*object, "min");
+		accessor.Max = getMember(*object, "max");
+
+		const auto elementSize{ getComponentSize(accessor.ComponentType) * accessor.Components };
+		if (elementSize == 0)
+		{
+			reportError(document, fmt::format("Accessor {} has an unknown component type or type", index));
+			return std::nullopt;
+		}
+
+		const auto view{ getBufferView(document, getUint(*object, "bufferView"), &accessor.Stride) };
+		if (!view)
+		{
+			return std::nullopt;
+		}
+
+		accessor.Stride = std::max(accessor.Stride, elementSize);
+		const std::size_t offset{ getUint(*object, "byteOffset", 0) };
+		if (accessor.Count > 0 && offset + accessor.Stride * (accessor.Count - 1) + elementSize > view->Size)
+		{
+			reportError(document, fmt::format("Accessor {} runs past its buffer view", index));
+			return std::nullopt;
+		}
+
+		accessor.Data = view->Data + offset;
+		return accessor;
+	}
+
+	/***********************************************************************************/
+	// Accessor of a primitive attribute, with Count 0 if the primitive has none
+	std::optional<Accessor> getAttribute(const Document& document, const json::Value& attributes, const char* name, const std::size_t count)
+	{
+		const auto index{ getUint(attributes, name) };
+		if (index == None)
+		{
+			return ZeroAccessor;
+		}
+
+		auto accessor{ getAccessor(document, index) };
+		if (accessor && count != None && accessor->Count != count)
+		{
+			reportError(document, fmt::format("Attribute {} has {} elements, the positions {}", name, accessor->Count, count));
+			return std::nullopt;
+		}
+		return accessor;
+	}
+
+	/***********************************************************************************/
+	float readComponent(const std::byte* data, const std::uint32_t componentType, const bool normalized) noexcept
+	{
+		switch (componentType)
+		{
+		case Float: { float value; std::memcpy(&value, data, sizeof(value)); return value; }
+		case UnsignedByte: { std::uint8_t value; std::memcpy(&value, data, sizeof(value)); return normalized ? value / 255.0f : value; }
+		case Byte: { std::int8_t value; std::memcpy(&value, data, sizeof(value)); return normalized ? std::max(value / 127.0f, -1.0f) : value; }
+		case UnsignedShort: { std::uint16_t value; std::memcpy(&value, data, sizeof(value)); return normalized ? value / 65535.0f : value; }
+		case Short: { std::int16_t value; std::memcpy(&value, data, sizeof(value)); return normalized ? std::max(value / 32767.0f, -1.0f) : value; }
+		case UnsignedInt: { std::uint32_t value; std::memcpy(&value, data, sizeof(value)); return static_cast<float>(value); }
+		default: return 0.0f;
+		}
+	}
+
+	/***********************************************************************************/
+	// Writes up to components floats of elements begin..end of accessor into the member at floatOffset of each vertex
+	void convertAttribute(const Accessor& accessor, const std::size_t floatOffset, const std::uint32_t components, Vertex* vertices, const std::size_t begin, const std::size_t end) noexcept
+	{
+		const auto componentSize{ getComponentSize(accessor.ComponentType) };
+		const auto numRead{ std::min(components, accessor.Components) };
+
+		for (auto i = begin; i < end; ++i)
+		{
+			auto* out{ reinterpret_cast<float*>(vertices + i) + floatOffset };
+			const auto* element{ accessor.Data + i * accessor.Stride };
+			for (std::uint32_t c = 0; c < components; ++c)
+			{
+				out[c] = c < numRead ? readComponent(element + c * componentSize, accessor.ComponentType, accessor.Normalized) : 0.0f;
+			}
+		}
+	}
+
+#ifdef GE_SSE2
+	/***********************************************************************************/
+	// All float attributes: writes whole vertices in one pass with 16 byte loads and stores. Each store runs into the
+	// next member, which is written after it, and the tangent store into the next vertex. 12 byte elements are read
+	// 16 bytes at a time, which stays inside the accessor up to the second to last element. So the last vertex is left
+	// to convertAttribute.
+	void interleaveFloats(const Accessor& positions, const Accessor& texCoords, const Accessor& normals, const Accessor& tangents, Vertex* vertices) noexcept
+	{
+		for (std::size_t i = 0; i + 1 < positions.Count; ++i)
+		{
+			auto* out{ reinterpret_cast<float*>(vertices + i) };
+			_mm_storeu_ps(out, _mm_loadu_ps(reinterpret_cast<const float*>(positions.Data + i * positions.Stride)));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + 3), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(texCoords.Data + i * texCoords.Stride)));
+			_mm_storeu_ps(out + 5, _mm_loadu_ps(reinterpret_cast<const float*>(normals.Data + i * normals.Stride)));
+			_mm_storeu_ps(out + 8, _mm_loadu_ps(reinterpret_cast<const float*>(tangents.Data + i * tangents.Stride)));
+		}
+	}
+#endif
+
+	/***********************************************************************************/
+	// Widens the indices to 32 bits, 8 or 16 at a time for the common 16 and 8 bit indices
+	void readIndices(const Accessor& accessor, GLuint* out) noexcept
+	{
+		const auto componentSize{ getComponentSize(accessor.ComponentType) };
+		std::size_t i{ 0 };
+
+		if (accessor.Stride == componentSize)
+		{
+			if (accessor.ComponentType == UnsignedInt)
+			{
+				std::memcpy(out, accessor.Data, accessor.Count * sizeof(GLuint));
+				return;
+			}
+#ifdef GE_SSE2
+			const auto zero{ _mm_setzero_si128() };
+			if (accessor.ComponentType == UnsignedShort)
+			{
+				for (; i + 8 <= accessor.Count; i += 8)
+				{
+					const auto indices{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(accessor.Data + i * 2)) };
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(indices, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(indices, zero));
+				}
+			} else if (accessor.ComponentType == UnsignedByte)
+			{
+				for (; i + 16 <= accessor.Count; i += 16)
+				{
+					const auto indices{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(accessor.Data + i)) };
+					const auto low{ _mm_unpacklo_epi8(indices, zero) };
+					const auto high{ _mm_unpackhi_epi8(indices, zero) };
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(low, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(low, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpacklo_epi16(high, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 12), _mm_unpackhi_epi16(high, zero));
+				}
+			}
+#endif
+		}
+
+		for (; i < accessor.Count; ++i)
+		{
+			out[i] = static_cast<GLuint>(readComponent(accessor.Data + i * accessor.Stride, accessor.ComponentType, false));
+		}
+	}
+
+	/***********************************************************************************/
+	// Turns strips and fans into lists, reading consecutive vertices for primitives without indices
+	std::vector<GLuint> toTriangleList(std::vector<GLuint> indices, const std::uint32_t mode)
+	{
+		if (mode == Triangles)
+		{
+			indices.resize(indices.size() - indices.size() % 3);
+			return indices;
+		}
+
+		std::vector<GLuint> triangles;
+		triangles.reserve(indices.size() > 2 ? (indices.size() - 2) * 3 : 0);
+		for (std::size_t i = 2; i < indices.size(); ++i)
+		{
+			if (mode == TriangleFan)
+			{
+				triangles.insert(triangles.end(), { indices[0], indices[i - 1], indices[i] });
+			} else if (i % 2 == 0)
+			{
+				triangles.insert(triangles.end(), { indices[i - 2], indices[i - 1], indices[i] });
+			} else
+			{
+				triangles.insert(triangles.end(), { indices[i - 1], indices[i - 2], indices[i] });
+			}
+		}
+		return triangles;
+	}
+
+	/***********************************************************************************/
+	bool readBounds(const Accessor& positions, glm::vec3& min, glm::vec3& max)
+	{
+		const auto isVec3{ [](const json::Value* value) {
+			return value && value->IsArray() && value->Size() == 3 && (*value)[0].IsNumber() && (*value)[1].IsNumber() && (*value)[2].IsNumber();
+		} };
+		if (!isVec3(positions.Min) || !isVec3(positions.Max))
+		{
+			return false;
+		}
+
+		for (json::SizeType i = 0; i < 3; ++i)
+		{
+			min[i] = (*positions.Min)[i].GetFloat();
+			max[i] = (*positions.Max)[i].GetFloat();
+		}
+		return true;
+	}
+
+	/***********************************************************************************/
+	std::optional<Graphics::GLTFPrimitive> convertPrimitive(const Document& document, const json::Value& object, const Graphics::GLTFLoadOptions& options)
+	{
+		const auto mode{ getUint(object, "mode", Triangles) };
+		const auto* attributes{ getMember(object, "attributes") };
+		if (mode != Triangles && mode != TriangleStrip && mode != TriangleFan)
+		{
+			// Points and lines, nothing the renderer draws
+			return Graphics::GLTFPrimitive{};
+		}
+		if (attributes == nullptr || getUint(*attributes, "POSITION") == None)
+		{
+			reportError(document, "Primitive without positions");
+			return std::nullopt;
+		}
+
+		const auto positions{ getAccessor(document, getUint(*attributes, "POSITION")) };
+		if (!positions || !positions->IsFloat(3))
+		{
+			reportError(document, "Positions must be float VEC3");
+			return std::nullopt;
+		}
+
+		const auto normals{ getAttribute(document, *attributes, "NORMAL", positions->Count) };
+		const auto tangents{ getAttribute(document, *attributes, "TANGENT", positions->Count) };
+		const auto texCoords{ options.LoadMaterials ? getAttribute(document, *attributes, "TEXCOORD_0", positions->Count) : ZeroAccessor };
+		if (!normals || !tangents || !texCoords)
+		{
+			return std::nullopt;
+		}
+
+		Graphics::GLTFPrimitive primitive;
+		primitive.Material = options.LoadMaterials ? static_cast<int>(getUint(object, "material")) : -1;
+
+		const auto numVertices{ positions->Count };
+		primitive.Vertices.resize(numVertices);
+		auto* vertices{ primitive.Vertices.data() };
+
+		std::size_t first{ 0 };
+#ifdef GE_SSE2
+		if (normals->IsFloat(normals->Count ? 3 : 4) && tangents->IsFloat(4) && texCoords->IsFloat(texCoords->Count ? 2 : 4))
+		{
+			interleaveFloats(*positions, *texCoords, *normals, *tangents, vertices);
+			first = numVertices > 0 ? numVertices - 1 : 0;
+		}
+#endif
+		convertAttribute(*positions, 0, 3, vertices, first, numVertices);
+		convertAttribute(*texCoords, 3, 2, vertices, first, numVertices);
+		convertAttribute(*normals, 5, 3, vertices, first, numVertices);
+		convertAttribute(*tangents, 8, 3, vertices, first, numVertices);
+
+		const auto indexAccessor{ getUint(object, "indices") };
+		if (indexAccessor != None)
+		{
+			const auto indices{ getAccessor(document, indexAccessor) };
+			if (!indices || indices->Components != 1 || (indices->ComponentType != UnsignedByte && indices->ComponentType != UnsignedShort && indices->ComponentType != UnsignedInt))
+			{
+				reportError(document, "Indices must be unsigned scalars");
+				return std::nullopt;
+			}
+			primitive.Indices.resize(indices->Count);
+			readIndices(*indices, primitive.Indices.data());
+		} else
+		{
+			primitive.Indices.resize(numVertices);
+			for (std::size_t i = 0; i < numVertices; ++i)
+			{
+				primitive.Indices[i] = static_cast<GLuint>(i);
+			}
+		}
+
+		if (!primitive.Indices.empty() && *std::max_element(primitive.Indices.cbegin(), primitive.Indices.cend()) >= numVertices)
+		{
+			reportError(document, "Index out of range");
+			return std::nullopt;
+		}
+		primitive.Indices = toTriangleList(std::move(primitive.Indices), mode);
+
+		// In the file's counter-clockwise winding, so generated normals face outwards
+		if (normals->Count == 0)
+		{
+			Graphics::GenerateNormals(primitive.Vertices, primitive.Indices);
+		}
+		if (tangents->Count == 0 && texCoords->Count != 0)
+		{
+			Graphics::GenerateTangents(primitive.Vertices, primitive.Indices);
+		}
+
+		if (options.FlipWindingOrder)
+		{
+			for (std::size_t i = 0; i + 2 < primitive.Indices.size(); i += 3)
+			{
+				std::swap(primitive.Indices[i + 1], primitive.Indices[i + 2]);
+			}
+		}
+
+		if (!readBounds(*positions, primitive.Min, primitive.Max) && numVertices > 0)
+		{
+			primitive.Min = primitive.Max = vertices[0].Position;
+			for (const auto& vertex : primitive.Vertices)
+			{
+				primitive.Min = glm::min(primitive.Min, vertex.Position);
+				primitive.Max = glm::max(primitive.Max, vertex.Position);
+			}
+		}
+
+		return primitive;
+	}
+
+	/***********************************************************************************/
+	// Writes image bytes held by the file to Data/cache/gltf, named by their hash so each is written once
+	std::filesystem::path cacheEmbeddedImage(const Document& document, const Span bytes, const std::string_view mimeType)
+	{
+		const auto directory{ std::filesystem::current_path() / "Data/cache/gltf" };
+		const auto path{ directory / fmt::format("{:016x}{}", Hash::Hash64(bytes.Data, bytes.Size), mimeType == "image/png" ? ".png" : ".jpg") };
+
+		std::error_code error;
+		if (std::filesystem::exists(path, error))
+		{
+			return path;
+		}
+
+		std::filesystem::create_directories(directory, error);
+		std::ofstream file(path, std::ios::binary);
+		if (!file.write(reinterpret_cast<const char*>(bytes.Data), static_cast<std::streamsize>(bytes.Size)))
+		{
+			reportError(document, fmt::format("Failed to write embedded image to {}", path.string()));
+			return {};
+		}
+		return path;
+	}
+
+	/***********************************************************************************/
+	// File of the image behind a textureInfo object, empty if there is none
+	std::filesystem::path getTexturePath(const Document& document, const json::Value* textureInfo)
+	{
+		const auto* texture{ textureInfo ? getElement(document, "textures", getUint(*textureInfo, "index")) : nullptr };
+		const auto* image{ texture ? getElement(document, "images", getUint(*texture, "source")) : nullptr };
+		if (image == nullptr)
+		{
+			return {};
+		}
+
+		const auto uri{ getString(*image, "uri") };
+		if (const auto decoded{ decodeDataURI(uri) })
+		{
+			const auto mimeType{ uri.substr(5, uri.find(';') - 5) };
+			return cacheEmbeddedImage(document, { reinterpret_cast<const std::byte*>(decoded->data()), decoded->size() }, mimeType);
+		}
+		if (!uri.empty())
+		{
+			return document.Path.parent_path() / decodeURI(uri);
+		}
+
+		const auto view{ getBufferView(document, getUint(*image, "bufferView")) };
+		return view ? cacheEmbeddedImage(document, *view, getString(*image, "mimeType")) : std::filesystem::path();
+	}
+
+	/***********************************************************************************/
+	std::vector<Graphics::GLTFMaterial> readMaterials(const Document& document)
+	{
+		std::vector<Graphics::GLTFMaterial> materials;
+		const auto* objects{ getMember(document.Root, "materials") };
+		if (objects == nullptr || !objects->IsArray())
+		{
+			return materials;
+		}
+
+		materials.reserve(objects->Size());
+		for (json::SizeType i = 0; i < objects->Size(); ++i)
+		{
+			const auto& object{ (*objects)[i] };
+			auto& material{ materials.emplace_back() };
+
+			const auto name{ getString(object, "name") };
+			material.Name = name.empty() ? fmt::format("material{}", i) : std::string(name);
+
+			material.Textures[PBRMaterial::NORMAL] = getTexturePath(document, getMember(object, "normalTexture"));
+			material.Textures[PBRMaterial::AO] = getTexturePath(document, getMember(object, "occlusionTexture"));
+
+			const auto* pbr{ getMember(object, "pbrMetallicRoughness") };
+			if (pbr == nullptr)
+			{
+				continue;
+			}
+
+			const auto* baseColor{ getMember(*pbr, "baseColorFactor") };
+			if (baseColor && baseColor->IsArray() && baseColor->Size() == 4)
+			{
+				for (json::SizeType c = 0; c < 4; ++c)
+				{
+					material.BaseColor[c] = (*baseColor)[c].IsNumber() ? (*baseColor)[c].GetFloat() : 1.0f;
+				}
+			}
+			material.Metallic = getFloat(*pbr, "metallicFactor", 1.0f);
+			material.Roughness = getFloat(*pbr, "roughnessFactor", 1.0f);
+
+			material.Textures[PBRMaterial::ALBEDO] = getTexturePath(document, getMember(*pbr, "baseColorTexture"));
+			material.Textures[PBRMaterial::METALLIC] = getTexturePath(document, getMember(*pbr, "metallicRoughnessTexture"));
+			material.Textures[PBRMaterial::ROUGHNESS] = material.Textures[PBRMaterial::METALLIC];
+		}
+
+		return materials;
+	}
+
+	/***********************************************************************************/
+	// Meshes in the order the nodes of the default scene reference them, depth first. Every mesh once, in order,
+	// for files without scenes.
+	std::vector<std::uint32_t> collectMeshes(const Document& document)
+	{
+		std::vector<std::uint32_t> meshes;
+		const auto* scene{ getElement(document, "scenes", getUint(document.Root, "scene", 0)) };
+		const auto* roots{ scene ? getMember(*scene, "nodes") : nullptr };
+		if (roots == nullptr || !roots->IsArray())
+		{
+			const auto* objects{ getMember(document.Root, "meshes") };
+			for (json::SizeType i = 0; objects && objects->IsArray() && i < objects->Size(); ++i)
+			{
+				meshes.push_back(i);
+			}
+			return meshes;
+		}
+
+		// Children pushed in reverse so they come off the stack in order. Visited nodes are skipped, a cyclic
+		// hierarchy is invalid but must not hang the loader.
+		const auto* nodes{ getMember(document.Root, "nodes") };
+		std::vector<bool> visited(nodes && nodes->IsArray() ? nodes->Size() : 0);
+		std::vector<std::uint32_t> stack;
+		for (auto root{ roots->End() }; root != roots->Begin();)
+		{
+			--root;
+			stack.push_back(root->IsUint() ? root->GetUint() : None);
+		}
+
+		while (!stack.empty())
+		{
+			const auto index{ stack.back() };
+			stack.pop_back();
+			if (index >= visited.size() || visited[index])
+			{
+				continue;
+			}
+			visited[index] = true;
+
+			const auto& node{ (*nodes)[index] };
+			if (const auto mesh{ getUint(node, "mesh") }; mesh != None)
+			{
+				meshes.push_back(mesh);
+			}
+
+			const auto* children{ getMember(node, "children") };
+			for (auto child{ children && children->IsArray() ? children->End() : nullptr }; child && child != children->Begin();)
+			{
+				--child;
+				stack.push_back(child->IsUint() ? child->GetUint() : None);
+			}
+		}
+
+		return meshes;
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	std::optional<GLTFModel> LoadGLTF(const std::filesystem::path& path, const GLTFLoadOptions& options)
+	{
+		Document document;
+		document.Path = path;
+		if (!document.File.Open(path) || !parseDocument(document) || !loadBuffers(document))
+		{
+			return std::nullopt;
+		}
+
+		GLTFModel model;
+		if (options.LoadMaterials)
+		{
+			model.Materials = readMaterials(document);
+		}
+
+		// Meshes referenced by several nodes are converted once, copied, and moved out for the last reference
+		const auto meshIndices{ collectMeshes(document) };
+		std::vector<std::uint32_t> references;
+		for (const auto meshIndex : meshIndices)
+		{
+			references.resize(std::max<std::size_t>(references.size(), meshIndex + 1));
+			++references[meshIndex];
+		}
+
+		std::vector<std::optional<std::vector<GLTFPrimitive>>> converted(references.size());
+		for (const auto meshIndex : meshIndices)
+		{
+			const auto* mesh{ getElement(document, "meshes", meshIndex) };
+			const auto* primitives{ mesh ? getMember(*mesh, "primitives") : nullptr };
+			if (primitives == nullptr || !primitives->IsArray())
+			{
+				reportError(document, fmt::format("Mesh {} is missing or has no primitives", meshIndex));
+				return std::nullopt;
+			}
+
+			auto& meshPrimitives{ converted[meshIndex] };
+			if (!meshPrimitives)
+			{
+				meshPrimitives.emplace();
+				for (const auto& object : primitives->GetArray())
+				{
+					auto primitive{ convertPrimitive(document, object, options) };
+					if (!primitive)
+					{
+						return std::nullopt;
+					}
+					if (!primitive->Indices.empty())
+					{
+						if (primitive->Material >= static_cast<int>(model.Materials.size()))
+						{
+							primitive->Material = -1;
+						}
+						meshPrimitives->push_back(std::move(*primitive));
+					}
+				}
+			}
+
+			if (--references[meshIndex] == 0)
+			{
+				std::move(meshPrimitives->begin(), meshPrimitives->end(), std::back_inserter(model.Primitives));
+			} else
+			{
+				model.Primitives.insert(model.Primitives.end(), meshPrimitives->cbegin(), meshPrimitives->cend());
+			}
+		}
+
+		return model;
+	}
+}
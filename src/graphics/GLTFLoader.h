@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../Vertex.h"
+
+#include <glad/glad.h>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Native reader for glTF 2.0 models (.gltf with external or data: URI buffers, and .glb). The JSON is parsed once,
+// buffer files are mapped instead of read, and accessors are converted straight into Vertex and index arrays.
+// Only what the engine draws is read: triangle primitives (lists, strips and fans) with POSITION, NORMAL,
+// TEXCOORD_0 and TANGENT, and metallic-roughness materials. Like the Assimp path of Model, node transforms are
+// not applied; scenes place and scale their models themselves.
+namespace Graphics
+{
+	struct GLTFMaterial {
+		std::string Name;
+		// Image of each PBRMaterial::ParameterType, empty for none. METALLIC and ROUGHNESS are the same
+		// metallicRoughness image, which holds roughness in G and metallic in B. Images embedded in the file are
+		// written to Data/cache/gltf first.
+		std::array<std::filesystem::path, 5> Textures;
+		glm::vec4 BaseColor{ 1.0f };
+		float Metallic{ 1.0f };
+		float Roughness{ 1.0f };
+	};
+
+	struct GLTFPrimitive {
+		std::vector<Vertex> Vertices;
+		std::vector<GLuint> Indices;
+		// Bounds of the positions, from the accessor's min and max where the file has them
+		glm::vec3 Min{ 0.0f };
+		glm::vec3 Max{ 0.0f };
+		// Index into GLTFModel::Materials, -1 for none
+		int Material{ -1 };
+	};
+
+	struct GLTFModel {
+		// In the order the nodes of the default scene reference their meshes
+		std::vector<GLTFPrimitive> Primitives;
+		std::vector<GLTFMaterial> Materials;
+	};
+
+	struct GLTFLoadOptions {
+		// Reverses every triangle, as aiProcess_FlipWindingOrder does
+		bool FlipWindingOrder{ false };
+		// Without, texture coordinates stay 0 and no materials or images are read
+		bool LoadMaterials{ true };
+	};
+
+	// Normals and tangents the file leaves out are generated from the triangles. Empty if the file cannot be read
+	// or is malformed.
+	std::optional<GLTFModel> LoadGLTF(const std::filesystem::path& path, const GLTFLoadOptions& options = {});
+}
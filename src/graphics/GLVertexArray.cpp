@@ -1,4 +1,5 @@
 #include "GLVertexArray.h"
+#include "GPUMemory.h"
 
 void GLVertexArray::Init() noexcept
 {
@@ -12,6 +13,9 @@ void GLVertexArray::AttachBuffer(const BufferType type, const size_t size, const
 
 	glBindBuffer(type, buffer);
 	glBufferData(type, size, data, mode);
+
+	m_buffers.push_back(buffer);
+	Graphics::GPUMemoryTracker::GetInstance().Track(Graphics::GPUResourceType::Buffer, buffer, size);
 }
 
 void GLVertexArray::Bind() const noexcept
@@ -22,6 +26,13 @@ void GLVertexArray::Bind() const noexcept
 void GLVertexArray::Delete() noexcept
 {
 	glDeleteVertexArrays(1, &m_vao);
+
+	for (const auto buffer : m_buffers)
+	{
+		Graphics::GPUMemoryTracker::GetInstance().Untrack(Graphics::GPUResourceType::Buffer, buffer);
+	}
+	glDeleteBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
+	m_buffers.clear();
 }
 
 void GLVertexArray::EnableAttribute(const unsigned int index, const int size, const unsigned int offset, const void* data) noexcept
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include <vector>
+
 class GLVertexArray {
 public:
 	enum BufferType : int {
@@ -16,11 +18,16 @@ public:
 	};
 
 	void Init() noexcept;
+	// The buffer's memory is tracked under the current GPUMemoryScope
 	void AttachBuffer(const BufferType type, const size_t size, const DrawMode mode, const void* data) noexcept;
 	void Bind() const noexcept;
 	void EnableAttribute(const GLuint index, const int size, const GLuint offset, const void* data) noexcept;
+	// Deletes the vertex array and the buffers attached to it
 	void Delete() noexcept;
 
+	auto GetId() const noexcept { return m_vao; }
+
 private:
 	GLuint m_vao{ 0 };
+	std::vector<GLuint> m_buffers;
 };
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "GPUMemory.h"
+
+#include "RenderGraph.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	thread_local const Graphics::GPUMemoryScope* s_currentScope{ nullptr };
+
+	/***********************************************************************************/
+	// Bytes of a 4x4 block, 0 if format is not block compressed
+	std::size_t getBlockSize(const GLenum format) noexcept
+	{
+		switch (format)
+		{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RED_RGTC1:
+		case GL_COMPRESSED_SIGNED_RED_RGTC1:
+			return 8;
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_COMPRESSED_SIGNED_RG_RGTC2:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+		case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	const char* GetGPUMemoryCategoryName(const GPUMemoryCategory category) noexcept
+	{
+		switch (category)
+		{
+		case GPUMemoryCategory::Model: return "Model";
+		case GPUMemoryCategory::Material: return "Material";
+		case GPUMemoryCategory::Pass: return "Pass";
+		case GPUMemoryCategory::Skybox: return "Skybox";
+		case GPUMemoryCategory::Lighting: return "Lighting";
+		default: return "Other";
+		}
+	}
+
+	/***********************************************************************************/
+	const char* GetGPUResourceTypeName(const GPUResourceType type) noexcept
+	{
+		switch (type)
+		{
+		case GPUResourceType::Texture: return "Texture";
+		case GPUResourceType::Buffer: return "Buffer";
+		default: return "Renderbuffer";
+		}
+	}
+
+	/***********************************************************************************/
+	std::size_t GetTextureBytes(const GLenum format, const GLsizei width, const GLsizei height, const GLsizei depth, const GLsizei levels) noexcept
+	{
+		const auto blockSize{ getBlockSize(format) };
+		const auto texelSize{ blockSize > 0 ? 0 : GetTexelSize(format) };
+		if (blockSize == 0 && texelSize == 0)
+		{
+			std::cerr << fmt::format("GPU Memory Error: Unknown internal format 0x{:x}, its {}x{} texture is counted as 0 bytes\n", format, width, height);
+			assert(false && "GetTexelSize is missing an internal format");
+			return 0;
+		}
+
+		std::size_t bytes{ 0 };
+		for (GLsizei level = 0; level < levels; ++level)
+		{
+			const auto levelWidth{ static_cast<std::size_t>(std::max(width >> level, 1)) };
+			const auto levelHeight{ static_cast<std::size_t>(std::max(height >> level, 1)) };
+			const auto levelDepth{ static_cast<std::size_t>(std::max(depth, 1)) };
+
+			if (blockSize > 0)
+			{
+				bytes += ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize * levelDepth;
+			} else
+			{
+				bytes += levelWidth * levelHeight * texelSize * levelDepth;
+			}
+		}
+		return bytes;
+	}
+
+	/***********************************************************************************/
+	GLsizei GetNumMipLevels(const GLsizei width, const GLsizei height) noexcept
+	{
+		GLsizei levels{ 1 };
+		for (auto size{ std::max(width, height) }; size > 1; size >>= 1)
+		{
+			++levels;
+		}
+		return levels;
+	}
+
+	/***********************************************************************************/
+	void GPUMemoryTracker::Track(const GPUResourceType type, const GLuint name, const std::size_t bytes, const GPUMemoryCategory category, const std::string_view owner)
+	{
+		if (name == 0)
+		{
+			return;
+		}
+
+		std::scoped_lock lock(m_mutex);
+
+		const auto [it, inserted] { m_allocations.try_emplace(getKey(type, name)) };
+		if (!inserted)
+		{
+			updateTotals(it->second, false);
+		}
+		it->second = { type, name, category, bytes, std::string(owner) };
+		updateTotals(it->second, true);
+	}
+
+	/***********************************************************************************/
+	void GPUMemoryTracker::Track(const GPUResourceType type, const GLuint name, const std::size_t bytes)
+	{
+		Track(type, name, bytes, GPUMemoryScope::GetCategory(), GPUMemoryScope::GetOwner());
+	}
+
+	/***********************************************************************************/
+	void GPUMemoryTracker::Untrack(const GPUResourceType type, const GLuint name)
+	{
+		std::scoped_lock lock(m_mutex);
+
+		const auto it{ m_allocations.find(getKey(type, name)) };
+		if (it != m_allocations.end())
+		{
+			updateTotals(it->second, false);
+			m_allocations.erase(it);
+		}
+	}
+
+	/***********************************************************************************/
+	GPUMemoryTracker::Totals GPUMemoryTracker::GetTotals() const
+	{
+		std::scoped_lock lock(m_mutex);
+
+		Totals totals;
+		for (const auto& category : m_categoryTotals)
+		{
+			totals.Bytes += category.Bytes;
+			totals.Count += category.Count;
+		}
+		return totals;
+	}
+
+	/***********************************************************************************/
+	GPUMemoryTracker::Totals GPUMemoryTracker::GetTotals(const GPUMemoryCategory category) const
+	{
+		std::scoped_lock lock(m_mutex);
+		return m_categoryTotals[static_cast<std::size_t>(category)];
+	}
+
+	/***********************************************************************************/
+	GPUMemoryTracker::Totals GPUMemoryTracker::GetTotals(const GPUResourceType type) const
+	{
+		std::scoped_lock lock(m_mutex);
+		return m_typeTotals[static_cast<std::size_t>(type)];
+	}
+
+	/***********************************************************************************/
+	std::vector<GPUMemoryTracker::Allocation> GPUMemoryTracker::GetAllocations() const
+	{
+		std::vector<Allocation> allocations;
+		{
+			std::scoped_lock lock(m_mutex);
+			allocations.reserve(m_allocations.size());
+			for (const auto& [key, allocation] : m_allocations)
+			{
+				allocations.push_back(allocation);
+			}
+		}
+
+		std::sort(allocations.begin(), allocations.end(), [](const Allocation& a, const Allocation& b) {
+			return a.Bytes != b.Bytes ? a.Bytes > b.Bytes : a.Owner < b.Owner;
+		});
+		return allocations;
+	}
+
+	/***********************************************************************************/
+	bool GPUMemoryTracker::ExportReport(const std::filesystem::path& basePath) const
+	{
+		auto csvPath{ basePath };
+		csvPath += ".csv";
+		auto jsonPath{ basePath };
+		jsonPath += ".json";
+
+		std::error_code error;
+		if (basePath.has_parent_path())
+		{
+			std::filesystem::create_directories(basePath.parent_path(), error);
+		}
+
+		std::ofstream csv(csvPath);
+		std::ofstream json(jsonPath);
+		if (!csv || !json)
+		{
+			std::cerr << "GPUMemoryTracker Error: Failed to write " << basePath.string() << ".csv/.json" << std::endl;
+			return false;
+		}
+
+		const auto allocations{ GetAllocations() };
+		csv << "category,type,owner,gl_name,bytes\n";
+		for (const auto& allocation : allocations)
+		{
+			// Owners are paths and names, quoted in case they hold commas
+			csv << fmt::format("{},{},\"{}\",{},{}\n", GetGPUMemoryCategoryName(allocation.Category), GetGPUResourceTypeName(allocation.Type),
+				allocation.Owner, allocation.Name, allocation.Bytes);
+		}
+
+		const auto total{ GetTotals() };
+		json << "{\n";
+		json << fmt::format("  \"total\": {{\"bytes\": {}, \"objects\": {}}},\n", total.Bytes, total.Count);
+		json << "  \"categories\": {";
+		for (std::size_t i = 0; i < m_categoryTotals.size(); ++i)
+		{
+			const auto category{ static_cast<GPUMemoryCategory>(i) };
+			const auto totals{ GetTotals(category) };
+			json << fmt::format("{}\n    \"{}\": {{\"bytes\": {}, \"objects\": {}}}", i ? "," : "", GetGPUMemoryCategoryName(category), totals.Bytes, totals.Count);
+		}
+		json << "\n  },\n  \"types\": {";
+		for (std::size_t i = 0; i < m_typeTotals.size(); ++i)
+		{
+			const auto type{ static_cast<GPUResourceType>(i) };
+			const auto totals{ GetTotals(type) };
+			json << fmt::format("{}\n    \"{}\": {{\"bytes\": {}, \"objects\": {}}}", i ? "," : "", GetGPUResourceTypeName(type), totals.Bytes, totals.Count);
+		}
+		json << "\n  }\n}\n";
+
+		std::cout << "GPU memory report written to " << csvPath.string() << " and " << jsonPath.string() << '\n';
+
+		return true;
+	}
+
+	/***********************************************************************************/
+	void GPUMemoryTracker::updateTotals(const Allocation& allocation, const bool added)
+	{
+		for (auto* totals : { &m_categoryTotals[static_cast<std::size_t>(allocation.Category)], &m_typeTotals[static_cast<std::size_t>(allocation.Type)] })
+		{
+			totals->Bytes = added ? totals->Bytes + allocation.Bytes : totals->Bytes - allocation.Bytes;
+			totals->Count = added ? totals->Count + 1 : totals->Count - 1;
+		}
+	}
+
+	/***********************************************************************************/
+	GPUMemoryScope::GPUMemoryScope(const GPUMemoryCategory category, const std::string_view owner) noexcept :
+		m_category(category), m_owner(owner), m_parent(s_currentScope)
+	{
+		s_currentScope = this;
+	}
+
+	/***********************************************************************************/
+	GPUMemoryScope::~GPUMemoryScope()
+	{
+		s_currentScope = m_parent;
+	}
+
+	/***********************************************************************************/
+	GPUMemoryCategory GPUMemoryScope::GetCategory() noexcept
+	{
+		return s_currentScope != nullptr ? s_currentScope->m_category : GPUMemoryCategory::Other;
+	}
+
+	/***********************************************************************************/
+	std::string_view GPUMemoryScope::GetOwner() noexcept
+	{
+		return s_currentScope != nullptr ? s_currentScope->m_owner : std::string_view();
+	}
+}
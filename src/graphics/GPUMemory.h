@@ -0,0 +1,122 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Graphics
+{
+	// What a piece of GPU memory is for, the split budgets are decided on
+	enum class GPUMemoryCategory : std::uint8_t {
+		Model,
+		Material,
+		Pass,
+		Skybox,
+		Lighting,
+		Other,
+		Count
+	};
+
+	enum class GPUResourceType : std::uint8_t {
+		Texture,
+		Buffer,
+		Renderbuffer,
+		Count
+	};
+
+	const char* GetGPUMemoryCategoryName(const GPUMemoryCategory category) noexcept;
+	const char* GetGPUResourceTypeName(const GPUResourceType type) noexcept;
+
+	// Bytes of levels mip levels of a width x height x depth image, starting at the full size. Compressed formats
+	// count whole 4x4 blocks. Formats that are not known are reported and counted as 0.
+	std::size_t GetTextureBytes(const GLenum format, const GLsizei width, const GLsizei height, const GLsizei depth = 1, const GLsizei levels = 1) noexcept;
+	// Levels of a complete mip chain, as glGenerateMipmap creates
+	GLsizei GetNumMipLevels(const GLsizei width, const GLsizei height) noexcept;
+
+	// Keeps a record of every texture, buffer and renderbuffer the engine allocates, with its computed size and
+	// owner. Unlike vendor memory queries it works on every driver, and it says where the memory goes. Sizes are
+	// what the formats need, drivers add alignment and padding on top.
+	class GPUMemoryTracker {
+	public:
+		struct Allocation {
+			GPUResourceType Type;
+			GLuint Name;
+			GPUMemoryCategory Category;
+			std::size_t Bytes;
+			// Model name, texture path or pass that holds the object
+			std::string Owner;
+		};
+
+		struct Totals {
+			std::size_t Bytes{ 0 };
+			std::size_t Count{ 0 };
+		};
+
+		static auto& GetInstance()
+		{
+			static GPUMemoryTracker instance;
+			return instance;
+		}
+
+		GPUMemoryTracker(const GPUMemoryTracker&) = delete;
+		GPUMemoryTracker& operator=(const GPUMemoryTracker&) = delete;
+
+		// Records that the object now holds bytes. Storage allocated again for the same object replaces the record.
+		void Track(const GPUResourceType type, const GLuint name, const std::size_t bytes, const GPUMemoryCategory category, const std::string_view owner);
+		// Same, with the category and owner of the innermost GPUMemoryScope on this thread
+		void Track(const GPUResourceType type, const GLuint name, const std::size_t bytes);
+		// Call when the object is deleted. Unknown objects are ignored.
+		void Untrack(const GPUResourceType type, const GLuint name);
+
+		Totals GetTotals() const;
+		Totals GetTotals(const GPUMemoryCategory category) const;
+		Totals GetTotals(const GPUResourceType type) const;
+		// Every live allocation, largest first
+		std::vector<Allocation> GetAllocations() const;
+
+		// Writes basePath.csv (one row per allocation) and basePath.json (totals per category and type).
+		bool ExportReport(const std::filesystem::path& basePath) const;
+
+	private:
+		GPUMemoryTracker() = default;
+
+		static std::uint64_t getKey(const GPUResourceType type, const GLuint name) noexcept
+		{
+			return (static_cast<std::uint64_t>(type) << 32) | name;
+		}
+		// Adds allocation to (or removes it from) its category and type totals
+		void updateTotals(const Allocation& allocation, const bool added);
+
+		mutable std::mutex m_mutex;
+		std::unordered_map<std::uint64_t, Allocation> m_allocations;
+		std::array<Totals, static_cast<std::size_t>(GPUMemoryCategory::Count)> m_categoryTotals;
+		std::array<Totals, static_cast<std::size_t>(GPUResourceType::Count)> m_typeTotals;
+	};
+
+	// Objects tracked without an explicit owner while the scope lives on this thread belong to category and owner,
+	// e.g. the vertex buffers GLVertexArray creates while a model loads. Scopes nest.
+	class GPUMemoryScope {
+	public:
+		GPUMemoryScope(const GPUMemoryCategory category, const std::string_view owner) noexcept;
+		~GPUMemoryScope();
+
+		GPUMemoryScope(const GPUMemoryScope&) = delete;
+		GPUMemoryScope& operator=(const GPUMemoryScope&) = delete;
+
+		static GPUMemoryCategory GetCategory() noexcept;
+		static std::string_view GetOwner() noexcept;
+
+	private:
+		GPUMemoryCategory m_category;
+		std::string_view m_owner;
+		const GPUMemoryScope* m_parent;
+	};
+}
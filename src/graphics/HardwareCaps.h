@@ -15,6 +15,7 @@ namespace Graphics
 		int MaxFragmentUniformBlocks;
 		int MaxComputeWorkGroupSize;
 		int MaxComputeWorkGroupCount;
+		// 0 without GL_NVX_gpu_memory_info
 		int TotalVideoMemoryKB;
 	};
 
@@ -0,0 +1,422 @@
+#include "KTX2.h"
+
+#include <glad/glad.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string_view>
+
+namespace
+{
+	constexpr std::array<std::uint8_t, 12> KTX2_IDENTIFIER{ 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	constexpr std::uint32_t SUPERCOMPRESSION_NONE{ 0 };
+	constexpr std::uint32_t SUPERCOMPRESSION_ZSTD{ 2 };
+	constexpr int ZSTD_LEVEL{ 10 };
+
+	constexpr std::string_view KTX_WRITER{ "GraphicsEngine" };
+
+	// Data format descriptor color models and sample qualifiers (Khronos Data Format spec)
+	constexpr std::uint8_t DF_MODEL_RGBSDA{ 1 };
+	constexpr std::uint8_t DF_MODEL_BC1A{ 128 };
+	constexpr std::uint8_t DF_MODEL_BC2{ 129 };
+	constexpr std::uint8_t DF_MODEL_BC3{ 130 };
+	constexpr std::uint8_t DF_MODEL_BC4{ 131 };
+	constexpr std::uint8_t DF_MODEL_BC5{ 132 };
+	constexpr std::uint8_t DF_MODEL_BC6H{ 133 };
+	constexpr std::uint8_t DF_MODEL_BC7{ 134 };
+	constexpr std::uint8_t DF_SAMPLE_SIGNED{ 0x40 };
+	constexpr std::uint8_t DF_SAMPLE_FLOAT{ 0x80 };
+	constexpr std::uint8_t DF_CHANNEL_ALPHA{ 15 };
+
+	struct Header {
+		std::uint8_t Identifier[12];
+		std::uint32_t VkFormat;
+		std::uint32_t TypeSize;
+		std::uint32_t PixelWidth;
+		std::uint32_t PixelHeight;
+		std::uint32_t PixelDepth;
+		std::uint32_t LayerCount;
+		std::uint32_t FaceCount;
+		std::uint32_t LevelCount;
+		std::uint32_t SupercompressionScheme;
+		std::uint32_t DFDByteOffset;
+		std::uint32_t DFDByteLength;
+		std::uint32_t KVDByteOffset;
+		std::uint32_t KVDByteLength;
+		std::uint64_t SGDByteOffset;
+		std::uint64_t SGDByteLength;
+	};
+	static_assert(sizeof(Header) == 80, "KTX2 header must be 80 bytes");
+
+	struct LevelIndex {
+		std::uint64_t ByteOffset;
+		std::uint64_t ByteLength;
+		std::uint64_t UncompressedByteLength;
+	};
+
+	// Format table entry, with what the data format descriptor needs on top of the GL mapping.
+	struct FormatEntry {
+		Graphics::KTX2FormatInfo Info;
+		std::uint8_t ColorModel;
+		bool SRGB;
+		std::uint8_t Qualifiers;
+		std::uint8_t NumSamples;
+		std::array<std::uint8_t, 4> Channels;
+	};
+
+	/***********************************************************************************/
+	const auto& formatTable()
+	{
+		static const std::array<FormatEntry, 24> table{ {
+			{ { 9, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, 1, 1 }, DF_MODEL_RGBSDA, false, 0, 1, { 0 } },
+			{ { 16, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 1, 1, 2 }, DF_MODEL_RGBSDA, false, 0, 2, { 0, 1 } },
+			{ { 23, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 1, 1, 3 }, DF_MODEL_RGBSDA, false, 0, 3, { 0, 1, 2 } },
+			{ { 37, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 1, 1, 4 }, DF_MODEL_RGBSDA, false, 0, 4, { 0, 1, 2, DF_CHANNEL_ALPHA } },
+			{ { 43, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 1, 1, 4 }, DF_MODEL_RGBSDA, true, 0, 4, { 0, 1, 2, DF_CHANNEL_ALPHA } },
+			{ { 90, GL_RGB16F, GL_RGB, GL_HALF_FLOAT, 1, 1, 6 }, DF_MODEL_RGBSDA, false, DF_SAMPLE_FLOAT | DF_SAMPLE_SIGNED, 3, { 0, 1, 2 } },
+			{ { 97, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 1, 1, 8 }, DF_MODEL_RGBSDA, false, DF_SAMPLE_FLOAT | DF_SAMPLE_SIGNED, 4, { 0, 1, 2, DF_CHANNEL_ALPHA } },
+			{ { 109, GL_RGBA32F, GL_RGBA, GL_FLOAT, 1, 1, 16 }, DF_MODEL_RGBSDA, false, DF_SAMPLE_FLOAT | DF_SAMPLE_SIGNED, 4, { 0, 1, 2, DF_CHANNEL_ALPHA } },
+			{ { 131, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, 0, 4, 4, 8 }, DF_MODEL_BC1A, false, 0, 1, { 0 } },
+			{ { 132, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, 0, 4, 4, 8 }, DF_MODEL_BC1A, true, 0, 1, { 0 } },
+			{ { 133, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, 0, 4, 4, 8 }, DF_MODEL_BC1A, false, 0, 1, { 1 } },
+			{ { 134, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0, 0, 4, 4, 8 }, DF_MODEL_BC1A, true, 0, 1, { 1 } },
+			{ { 135, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 0, 0, 4, 4, 16 }, DF_MODEL_BC2, false, 0, 2, { DF_CHANNEL_ALPHA, 0 } },
+			{ { 136, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 0, 0, 4, 4, 16 }, DF_MODEL_BC2, true, 0, 2, { DF_CHANNEL_ALPHA, 0 } },
+			{ { 137, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0, 4, 4, 16 }, DF_MODEL_BC3, false, 0, 2, { DF_CHANNEL_ALPHA, 0 } },
+			{ { 138, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0, 4, 4, 16 }, DF_MODEL_BC3, true, 0, 2, { DF_CHANNEL_ALPHA, 0 } },
+			{ { 139, GL_COMPRESSED_RED_RGTC1, 0, 0, 4, 4, 8 }, DF_MODEL_BC4, false, 0, 1, { 0 } },
+			{ { 140, GL_COMPRESSED_SIGNED_RED_RGTC1, 0, 0, 4, 4, 8 }, DF_MODEL_BC4, false, DF_SAMPLE_SIGNED, 1, { 0 } },
+			{ { 141, GL_COMPRESSED_RG_RGTC2, 0, 0, 4, 4, 16 }, DF_MODEL_BC5, false, 0, 2, { 0, 1 } },
+			{ { 142, GL_COMPRESSED_SIGNED_RG_RGTC2, 0, 0, 4, 4, 16 }, DF_MODEL_BC5, false, DF_SAMPLE_SIGNED, 2, { 0, 1 } },
+			{ { 143, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 0, 0, 4, 4, 16 }, DF_MODEL_BC6H, false, DF_SAMPLE_FLOAT, 1, { 0 } },
+			{ { 144, GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, 0, 0, 4, 4, 16 }, DF_MODEL_BC6H, false, DF_SAMPLE_FLOAT | DF_SAMPLE_SIGNED, 1, { 0 } },
+			{ { 145, GL_COMPRESSED_RGBA_BPTC_UNORM, 0, 0, 4, 4, 16 }, DF_MODEL_BC7, false, 0, 1, { 0 } },
+			{ { 146, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, 0, 4, 4, 16 }, DF_MODEL_BC7, true, 0, 1, { 0 } }
+		} };
+
+		return table;
+	}
+
+	/***********************************************************************************/
+	const FormatEntry* findFormat(const std::uint32_t vkFormat) noexcept
+	{
+		const auto& table{ formatTable() };
+		const auto it{ std::find_if(table.begin(), table.end(), [vkFormat](const auto& entry) { return entry.Info.VkFormat == vkFormat; }) };
+		return it != table.end() ? &*it : nullptr;
+	}
+
+	/***********************************************************************************/
+	std::uint32_t vkFormatFromBlockFormat(const Graphics::BlockFormat format) noexcept
+	{
+		switch (format)
+		{
+		case Graphics::BlockFormat::BC1: return 131;
+		case Graphics::BlockFormat::BC3: return 137;
+		case Graphics::BlockFormat::BC4: return 139;
+		case Graphics::BlockFormat::BC5: return 141;
+		case Graphics::BlockFormat::BC7: return 145;
+		}
+		return 0;
+	}
+
+	/***********************************************************************************/
+	std::size_t levelSize(const Graphics::KTX2FormatInfo& info, const std::uint32_t width, const std::uint32_t height) noexcept
+	{
+		const std::size_t blocksX{ (width + info.BlockWidth - 1u) / info.BlockWidth };
+		const std::size_t blocksY{ (height + info.BlockHeight - 1u) / info.BlockHeight };
+		return blocksX * blocksY * info.BytesPerBlock;
+	}
+
+	/***********************************************************************************/
+	void appendU32(std::vector<std::uint8_t>& out, const std::uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			out.push_back(static_cast<std::uint8_t>(value >> (i * 8)));
+		}
+	}
+
+	/***********************************************************************************/
+	// Basic data format descriptor, prefixed by its total size.
+	std::vector<std::uint8_t> buildDFD(const FormatEntry& format)
+	{
+		const auto& info{ format.Info };
+		const std::uint32_t blockSize{ 24u + 16u * format.NumSamples };
+
+		std::vector<std::uint8_t> dfd;
+		appendU32(dfd, 4 + blockSize);
+		// vendorId = Khronos, descriptorType = basic
+		appendU32(dfd, 0);
+		// versionNumber = 1.3, descriptorBlockSize
+		appendU32(dfd, 2 | (blockSize << 16));
+		// colorModel, primaries = BT709, transfer = sRGB or linear, flags = straight alpha
+		appendU32(dfd, format.ColorModel | (1u << 8) | ((format.SRGB ? 2u : 1u) << 16));
+		// texelBlockDimension0..3 (stored minus one)
+		appendU32(dfd, (info.BlockWidth - 1u) | ((info.BlockHeight - 1u) << 8));
+		// bytesPlane0..7
+		appendU32(dfd, info.BytesPerBlock);
+		appendU32(dfd, 0);
+
+		const std::uint32_t bitsPerSample{ info.BytesPerBlock * 8u / format.NumSamples };
+		for (std::uint32_t sample = 0; sample < format.NumSamples; ++sample)
+		{
+			const auto channelType{ static_cast<std::uint32_t>(format.Channels[sample] | format.Qualifiers) };
+			appendU32(dfd, (sample * bitsPerSample) | ((bitsPerSample - 1u) << 16) | (channelType << 24));
+			// samplePosition0..3
+			appendU32(dfd, 0);
+
+			if (format.Qualifiers & DF_SAMPLE_FLOAT)
+			{
+				// -1.0f and 1.0f
+				appendU32(dfd, 0xBF800000u);
+				appendU32(dfd, 0x3F800000u);
+			}
+			else if (info.IsCompressed() || bitsPerSample >= 32)
+			{
+				appendU32(dfd, 0);
+				appendU32(dfd, 0xFFFFFFFFu);
+			}
+			else
+			{
+				appendU32(dfd, 0);
+				appendU32(dfd, (1u << bitsPerSample) - 1u);
+			}
+		}
+
+		return dfd;
+	}
+
+	/***********************************************************************************/
+	// Single KTXwriter entry.
+	std::vector<std::uint8_t> buildKeyValueData()
+	{
+		constexpr std::string_view key{ "KTXwriter" };
+
+		std::vector<std::uint8_t> kvd;
+		appendU32(kvd, static_cast<std::uint32_t>(key.size() + 1 + KTX_WRITER.size() + 1));
+		kvd.insert(kvd.end(), key.begin(), key.end());
+		kvd.push_back(0);
+		kvd.insert(kvd.end(), KTX_WRITER.begin(), KTX_WRITER.end());
+		kvd.push_back(0);
+
+		while (kvd.size() % 4 != 0)
+		{
+			kvd.push_back(0);
+		}
+
+		return kvd;
+	}
+
+	/***********************************************************************************/
+	constexpr std::uint64_t alignUp(const std::uint64_t value, const std::uint64_t alignment) noexcept
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	std::optional<KTX2FormatInfo> GetKTX2FormatInfo(const std::uint32_t vkFormat) noexcept
+	{
+		if (const auto* format{ findFormat(vkFormat) }; format)
+		{
+			return format->Info;
+		}
+		return std::nullopt;
+	}
+
+	/***********************************************************************************/
+	KTX2Texture ToKTX2(CompressedTexture texture)
+	{
+		return KTX2Texture{ vkFormatFromBlockFormat(texture.Format), std::move(texture.Mips) };
+	}
+
+	/***********************************************************************************/
+	bool WriteKTX2(const std::filesystem::path& target, const KTX2Texture& texture, const bool supercompress)
+	{
+		const auto* format{ findFormat(texture.VkFormat) };
+		if (!format || texture.Levels.empty())
+		{
+			std::cerr << "KTX2: Unsupported format " << texture.VkFormat << " for " << target << '\n';
+			return false;
+		}
+
+		const auto scheme{ supercompress ? SUPERCOMPRESSION_ZSTD : SUPERCOMPRESSION_NONE };
+
+		// Level payloads, each its own zstd frame when supercompressed
+		std::vector<std::vector<std::uint8_t>> payloads(texture.Levels.size());
+		for (std::size_t level = 0; level < texture.Levels.size(); ++level)
+		{
+			const auto& data{ texture.Levels[level].Data };
+			if (scheme == SUPERCOMPRESSION_ZSTD)
+			{
+				payloads[level].resize(ZSTD_compressBound(data.size()));
+				const auto size{ ZSTD_compress(payloads[level].data(), payloads[level].size(), data.data(), data.size(), ZSTD_LEVEL) };
+				if (ZSTD_isError(size))
+				{
+					std::cerr << "KTX2: zstd compression failed for " << target << ": " << ZSTD_getErrorName(size) << '\n';
+					return false;
+				}
+				payloads[level].resize(size);
+			} else
+			{
+				payloads[level] = data;
+			}
+		}
+
+		const auto dfd{ buildDFD(*format) };
+		const auto kvd{ buildKeyValueData() };
+
+		Header header{};
+		std::copy(KTX2_IDENTIFIER.begin(), KTX2_IDENTIFIER.end(), header.Identifier);
+		header.VkFormat = texture.VkFormat;
+		header.TypeSize = format->Info.IsCompressed() ? 1 : format->Info.BytesPerBlock / format->NumSamples;
+		header.PixelWidth = texture.Levels.front().Width;
+		header.PixelHeight = texture.Levels.front().Height;
+		header.FaceCount = 1;
+		header.LevelCount = static_cast<std::uint32_t>(texture.Levels.size());
+		header.SupercompressionScheme = scheme;
+		header.DFDByteOffset = static_cast<std::uint32_t>(sizeof(Header) + sizeof(LevelIndex) * texture.Levels.size());
+		header.DFDByteLength = static_cast<std::uint32_t>(dfd.size());
+		header.KVDByteOffset = header.DFDByteOffset + header.DFDByteLength;
+		header.KVDByteLength = static_cast<std::uint32_t>(kvd.size());
+
+		// Mip data goes smallest level first, each aligned to lcm(block size, 4) unless supercompressed.
+		const std::uint64_t alignment{ scheme == SUPERCOMPRESSION_NONE ? std::lcm<std::uint64_t>(format->Info.BytesPerBlock, 4) : 1 };
+		std::vector<LevelIndex> levelIndex(texture.Levels.size());
+		auto offset{ static_cast<std::uint64_t>(header.KVDByteOffset) + header.KVDByteLength };
+		for (auto level = texture.Levels.size(); level-- > 0;)
+		{
+			offset = alignUp(offset, alignment);
+			levelIndex[level] = { offset, payloads[level].size(), texture.Levels[level].Data.size() };
+			offset += payloads[level].size();
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(target.parent_path(), error);
+
+		std::ofstream out(target, std::ios::binary);
+		if (!out)
+		{
+			std::cerr << "KTX2: Failed to write " << target << '\n';
+			return false;
+		}
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(levelIndex.data()), sizeof(LevelIndex) * levelIndex.size());
+		out.write(reinterpret_cast<const char*>(dfd.data()), dfd.size());
+		out.write(reinterpret_cast<const char*>(kvd.data()), kvd.size());
+
+		auto position{ static_cast<std::uint64_t>(header.KVDByteOffset) + header.KVDByteLength };
+		for (auto level = texture.Levels.size(); level-- > 0;)
+		{
+			const std::array<char, 16> padding{};
+			out.write(padding.data(), levelIndex[level].ByteOffset - position);
+			out.write(reinterpret_cast<const char*>(payloads[level].data()), payloads[level].size());
+			position = levelIndex[level].ByteOffset + payloads[level].size();
+		}
+
+		return static_cast<bool>(out);
+	}
+
+	/***********************************************************************************/
+	std::optional<KTX2Texture> ReadKTX2(const std::filesystem::path& source)
+	{
+		std::ifstream in(source, std::ios::binary | std::ios::ate);
+		if (!in)
+		{
+			return std::nullopt;
+		}
+
+		const auto fileSize{ static_cast<std::uint64_t>(in.tellg()) };
+		in.seekg(0);
+
+		Header header;
+		in.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!in || !std::equal(KTX2_IDENTIFIER.begin(), KTX2_IDENTIFIER.end(), header.Identifier))
+		{
+			std::cerr << "KTX2: Not a KTX2 file: " << source << '\n';
+			return std::nullopt;
+		}
+
+		const auto* format{ findFormat(header.VkFormat) };
+		if (!format)
+		{
+			std::cerr << "KTX2: Unsupported VkFormat " << header.VkFormat << " in " << source << '\n';
+			return std::nullopt;
+		}
+
+		// Only plain 2D textures
+		if (header.PixelDepth > 1 || header.LayerCount > 1 || header.FaceCount != 1 || header.PixelWidth == 0 || header.PixelHeight == 0)
+		{
+			std::cerr << "KTX2: Only 2D textures are supported: " << source << '\n';
+			return std::nullopt;
+		}
+
+		if (header.SupercompressionScheme != SUPERCOMPRESSION_NONE && header.SupercompressionScheme != SUPERCOMPRESSION_ZSTD)
+		{
+			std::cerr << "KTX2: Unsupported supercompression scheme " << header.SupercompressionScheme << " in " << source << '\n';
+			return std::nullopt;
+		}
+
+		// A level count of 0 asks the loader to generate mips, which we do not do at load time.
+		const auto levelCount{ std::max(header.LevelCount, 1u) };
+		std::vector<LevelIndex> levelIndex(levelCount);
+		in.read(reinterpret_cast<char*>(levelIndex.data()), sizeof(LevelIndex) * levelIndex.size());
+		if (!in)
+		{
+			return std::nullopt;
+		}
+
+		KTX2Texture texture;
+		texture.VkFormat = header.VkFormat;
+		texture.Levels.resize(levelCount);
+
+		for (std::uint32_t level = 0; level < levelCount; ++level)
+		{
+			const auto& index{ levelIndex[level] };
+			auto& mip{ texture.Levels[level] };
+			mip.Width = std::max(header.PixelWidth >> level, 1u);
+			mip.Height = std::max(header.PixelHeight >> level, 1u);
+
+			// Supercompressed levels store fewer bytes, plain ones exactly the level
+			const auto expectedSize{ levelSize(format->Info, mip.Width, mip.Height) };
+			const auto supercompressed{ header.SupercompressionScheme == SUPERCOMPRESSION_ZSTD };
+			if (index.ByteOffset + index.ByteLength > fileSize || (!supercompressed && index.ByteLength != expectedSize) || index.UncompressedByteLength != expectedSize)
+			{
+				std::cerr << "KTX2: Corrupt level " << level << " in " << source << '\n';
+				return std::nullopt;
+			}
+
+			std::vector<std::uint8_t> payload(index.ByteLength);
+			in.seekg(static_cast<std::streamoff>(index.ByteOffset));
+			in.read(reinterpret_cast<char*>(payload.data()), payload.size());
+			if (!in)
+			{
+				return std::nullopt;
+			}
+
+			if (supercompressed)
+			{
+				mip.Data.resize(expectedSize);
+				const auto size{ ZSTD_decompress(mip.Data.data(), mip.Data.size(), payload.data(), payload.size()) };
+				if (ZSTD_isError(size) || size != expectedSize)
+				{
+					std::cerr << "KTX2: Failed to decompress level " << level << " in " << source << '\n';
+					return std::nullopt;
+				}
+				continue;
+			}
+			mip.Data = std::move(payload);
+		}
+
+		return std::make_optional(std::move(texture));
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "BlockCompression.h"
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+// Reading and writing of Khronos KTX2 containers (2D textures with mip chains), with or without Zstandard
+// supercompression.
+namespace Graphics
+{
+	struct KTX2Texture {
+		std::uint32_t VkFormat{ 0 };
+		// Largest level first, data exactly as uploaded to GL.
+		std::vector<CompressedMip> Levels;
+	};
+
+	// How a VkFormat maps to a GL upload.
+	struct KTX2FormatInfo {
+		std::uint32_t VkFormat{ 0 };
+		std::uint32_t GLInternalFormat{ 0 };
+		// Zero for block compressed formats
+		std::uint32_t GLFormat{ 0 };
+		std::uint32_t GLType{ 0 };
+		std::uint8_t BlockWidth{ 1 };
+		std::uint8_t BlockHeight{ 1 };
+		std::uint8_t BytesPerBlock{ 0 };
+
+		auto IsCompressed() const noexcept { return GLFormat == 0; }
+	};
+
+	// Empty for formats the engine cannot upload.
+	std::optional<KTX2FormatInfo> GetKTX2FormatInfo(const std::uint32_t vkFormat) noexcept;
+
+	KTX2Texture ToKTX2(CompressedTexture texture);
+
+	// Levels are stored smallest first as the spec requires. supercompress compresses each level with zstd.
+	bool WriteKTX2(const std::filesystem::path& target, const KTX2Texture& texture, const bool supercompress = true);
+	// Empty if the file is missing, malformed, or uses an unsupported format or supercompression scheme.
+	std::optional<KTX2Texture> ReadKTX2(const std::filesystem::path& source);
+}
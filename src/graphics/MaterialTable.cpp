@@ -0,0 +1,316 @@
+#include "MaterialTable.h"
+#include "GPUMemory.h"
+
+#include "../resourceManager.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+	// Color of meshes without a material, the same the shaders use with textures off
+	constexpr glm::vec4 DefaultColor{ 0.95f, 0.95f, 0.95f, 1.0f };
+
+	/***********************************************************************************/
+	// Frees what a mutable texture's levels hold by making them empty, its name stays valid. Immutable textures
+	// cannot be respecified and keep their storage.
+	void releaseStorage(const GLuint texture, const GLsizei levels)
+	{
+		GLint immutable{ GL_FALSE };
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+		if (immutable == GL_FALSE)
+		{
+			for (GLsizei level = 0; level < levels; ++level)
+			{
+				glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			}
+			Graphics::GPUMemoryTracker::GetInstance().Untrack(Graphics::GPUResourceType::Texture, texture);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	void MaterialTable::Build(const std::vector<RenderMaterial>& materials, const TextureMode mode)
+	{
+		deleteBuffer();
+		m_mode = mode;
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &m_maxLayers);
+
+		// Arrays are built anew, textures the last build already moved are copied over from their old layers
+		const auto previousArrays{ std::exchange(m_textureArrays, {}) };
+		const auto previousLayers{ std::exchange(m_textureLayers, {}) };
+
+		// Materials share textures, each one is moved into a layer or made resident once
+		std::unordered_map<GLuint, glm::uvec2> textureLocations;
+
+		std::vector<GPUMaterial> gpuMaterials;
+		gpuMaterials.reserve(materials.size() + 1);
+		for (const auto& material : materials)
+		{
+			GPUMaterial gpuMaterial;
+			for (std::size_t i = 0; i < material.Textures.size(); ++i)
+			{
+				gpuMaterial.Colors[i] = glm::vec4(material.Colors[i], 1.0f);
+				if (material.Textures[i] == 0)
+				{
+					continue;
+				}
+
+				const auto [location, inserted] { textureLocations.try_emplace(material.Textures[i]) };
+				if (inserted)
+				{
+					location->second = mode == TextureMode::Bindless ? makeResident(material.Textures[i]) :
+						addToTextureArray(material.Textures[i], previousArrays, previousLayers);
+				}
+				gpuMaterial.Textures[i] = location->second;
+			}
+			gpuMaterial.Alpha = material.Alpha;
+			gpuMaterials.push_back(gpuMaterial);
+		}
+
+		m_numMaterials = static_cast<std::uint32_t>(materials.size());
+		GPUMaterial defaultMaterial;
+		defaultMaterial.Colors.fill(DefaultColor);
+		gpuMaterials.push_back(defaultMaterial);
+
+		createTextureArrays(previousArrays, previousLayers);
+		deleteTextureArrays(previousArrays);
+		deleteUnusedTextures();
+
+		const auto bufferSize{ gpuMaterials.size() * sizeof(GPUMaterial) };
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, gpuMaterials.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		GPUMemoryTracker::GetInstance().Track(GPUResourceType::Buffer, m_buffer, bufferSize, GPUMemoryCategory::Material, "Material table");
+
+		std::cout << fmt::format("MaterialTable: {} materials, {} textures {}\n", m_numMaterials, textureLocations.size(),
+			mode == TextureMode::Bindless ? std::string("as bindless handles") : fmt::format("in {} texture arrays", m_textureArrays.size()));
+	}
+
+	/***********************************************************************************/
+	void MaterialTable::Bind() const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBinding, m_buffer);
+
+		std::array<GLuint, MaxTextureArrays> names{};
+		for (std::size_t i = 0; i < m_textureArrays.size(); ++i)
+		{
+			names[i] = m_textureArrays[i].Name;
+		}
+		if (!m_textureArrays.empty())
+		{
+			glBindTextures(FirstTextureUnit, static_cast<GLsizei>(m_textureArrays.size()), names.data());
+		}
+	}
+
+	/***********************************************************************************/
+	void MaterialTable::Delete()
+	{
+		deleteBuffer();
+
+		deleteTextureArrays(m_textureArrays);
+		m_textureArrays.clear();
+		m_textureLayers.clear();
+		deleteUnusedTextures();
+	}
+
+	/***********************************************************************************/
+	void MaterialTable::deleteTextureArrays(const std::vector<TextureArray>& textureArrays)
+	{
+		for (const auto& textureArray : textureArrays)
+		{
+			GPUMemoryTracker::GetInstance().Untrack(GPUResourceType::Texture, textureArray.Name);
+			glDeleteTextures(1, &textureArray.Name);
+		}
+	}
+
+	/***********************************************************************************/
+	void MaterialTable::deleteUnusedTextures()
+	{
+		// Owned textures are empty, nothing can use them once they have no layer
+		for (auto texture = m_ownedTextures.begin(); texture != m_ownedTextures.end();)
+		{
+			if (m_textureLayers.find(*texture) == m_textureLayers.end())
+			{
+				glDeleteTextures(1, &*texture);
+				texture = m_ownedTextures.erase(texture);
+			} else
+			{
+				++texture;
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	void MaterialTable::deleteBuffer()
+	{
+		for (const auto handle : m_residentHandles)
+		{
+			glMakeTextureHandleNonResidentARB(handle);
+		}
+		m_residentHandles.clear();
+
+		if (m_buffer != 0)
+		{
+			GPUMemoryTracker::GetInstance().Untrack(GPUResourceType::Buffer, m_buffer);
+			glDeleteBuffers(1, &m_buffer);
+			m_buffer = 0;
+		}
+		m_numMaterials = 0;
+	}
+
+	/***********************************************************************************/
+	glm::uvec2 MaterialTable::addToTextureArray(const GLuint texture, const std::vector<TextureArray>& previousArrays, const TextureLayers& previousLayers)
+	{
+		// A layer of the last build already has its description
+		if (const auto previous{ previousLayers.find(texture) }; previous != previousLayers.end())
+		{
+			const auto& previousArray{ previousArrays[previous->second.x - 1] };
+			return addToTextureArray(texture, previousArray.Format, previousArray.Width, previousArray.Height, previousArray.Levels, previousArray.Sampler);
+		}
+
+		GLint width{ 0 }, height{ 0 }, format{ 0 }, maxLevel{ 0 };
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+
+		SamplerState sampler;
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &sampler.WrapS);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, &sampler.WrapT);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &sampler.MinFilter);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, &sampler.MagFilter);
+		glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, &sampler.MinLod);
+		glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LOD, &sampler.MaxLod);
+		glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, &sampler.LodBias);
+		if (GLAD_GL_EXT_texture_filter_anisotropic)
+		{
+			glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, &sampler.MaxAnisotropy);
+		}
+
+		// Only the levels that were uploaded, GL_TEXTURE_MAX_LEVEL defaults to 1000
+		GLsizei levels{ 1 };
+		for (const auto maxLevels{ std::min(GetNumMipLevels(width, height), maxLevel + 1) }; levels < maxLevels; ++levels)
+		{
+			GLint levelWidth{ 0 };
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, levels, GL_TEXTURE_WIDTH, &levelWidth);
+			if (levelWidth == 0)
+			{
+				break;
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		if (width == 0 || height == 0)
+		{
+			return glm::uvec2(0);
+		}
+
+		return addToTextureArray(texture, static_cast<GLenum>(format), width, height, levels, sampler);
+	}
+
+	/***********************************************************************************/
+	glm::uvec2 MaterialTable::addToTextureArray(const GLuint texture, const GLenum format, const GLsizei width, const GLsizei height,
+		const GLsizei levels, const SamplerState& sampler)
+	{
+		const auto textureArray{ std::find_if(m_textureArrays.begin(), m_textureArrays.end(), [&](const TextureArray& candidate) {
+			return candidate.Format == format && candidate.Width == width && candidate.Height == height && candidate.Levels == levels &&
+				candidate.Sampler == sampler && static_cast<GLint>(candidate.Textures.size()) < m_maxLayers;
+		}) };
+
+		glm::uvec2 location;
+		if (textureArray != m_textureArrays.end())
+		{
+			textureArray->Textures.push_back(texture);
+			location = glm::uvec2(static_cast<std::uint32_t>(textureArray - m_textureArrays.begin()) + 1, static_cast<std::uint32_t>(textureArray->Textures.size() - 1));
+		} else
+		{
+			if (m_textureArrays.size() == MaxTextureArrays)
+			{
+				std::cerr << fmt::format("MaterialTable Error: No texture array left for {}x{} textures of format 0x{:x}, drawn without\n", width, height, format);
+				return glm::uvec2(0);
+			}
+
+			m_textureArrays.push_back({ format, width, height, levels, sampler, { texture } });
+			location = glm::uvec2(static_cast<std::uint32_t>(m_textureArrays.size()), 0);
+		}
+
+		m_textureLayers.emplace(texture, location);
+		return location;
+	}
+
+	/***********************************************************************************/
+	glm::uvec2 MaterialTable::makeResident(const GLuint texture)
+	{
+		const auto handle{ glGetTextureHandleARB(texture) };
+		glMakeTextureHandleResidentARB(handle);
+		m_residentHandles.push_back(handle);
+
+		return glm::uvec2(static_cast<std::uint32_t>(handle), static_cast<std::uint32_t>(handle >> 32));
+	}
+
+	/***********************************************************************************/
+	void MaterialTable::createTextureArrays(const std::vector<TextureArray>& previousArrays, const TextureLayers& previousLayers)
+	{
+		for (auto& textureArray : m_textureArrays)
+		{
+			const auto layers{ static_cast<GLsizei>(textureArray.Textures.size()) };
+			const auto& sampler{ textureArray.Sampler };
+
+			glGenTextures(1, &textureArray.Name);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.Name);
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, textureArray.Levels, textureArray.Format, textureArray.Width, textureArray.Height, layers);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, textureArray.Levels - 1);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, sampler.WrapS);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, sampler.WrapT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, sampler.MinFilter);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, sampler.MagFilter);
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_LOD, sampler.MinLod);
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LOD, sampler.MaxLod);
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_LOD_BIAS, sampler.LodBias);
+			if (GLAD_GL_EXT_texture_filter_anisotropic)
+			{
+				glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, sampler.MaxAnisotropy);
+			}
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+			// Copied on the GPU level by level, compressed blocks as they are
+			for (GLsizei layer = 0; layer < layers; ++layer)
+			{
+				const auto texture{ textureArray.Textures[layer] };
+				const auto previous{ previousLayers.find(texture) };
+				const auto fromPrevious{ previous != previousLayers.end() };
+				const auto source{ fromPrevious ? previousArrays[previous->second.x - 1].Name : texture };
+				const auto sourceLayer{ fromPrevious ? static_cast<GLint>(previous->second.y) : 0 };
+
+				for (GLsizei level = 0; level < textureArray.Levels; ++level)
+				{
+					glCopyImageSubData(source, fromPrevious ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, level, 0, 0, sourceLayer,
+						textureArray.Name, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+						std::max(textureArray.Width >> level, 1), std::max(textureArray.Height >> level, 1), 1);
+				}
+
+				// A texture the ResourceManager gives up is ours to empty, others are only copied
+				if (!fromPrevious && ResourceManager::GetInstance().ReleaseTexture(texture))
+				{
+					releaseStorage(texture, textureArray.Levels);
+					m_ownedTextures.insert(texture);
+				}
+			}
+
+			GPUMemoryTracker::GetInstance().Track(GPUResourceType::Texture, textureArray.Name,
+				GetTextureBytes(textureArray.Format, textureArray.Width, textureArray.Height, layers, textureArray.Levels), GPUMemoryCategory::Material,
+				fmt::format("Material texture array {}x{}", textureArray.Width, textureArray.Height));
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "RenderScene.h"
+
+#include <glad/glad.h>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Graphics
+{
+	// One entry of the material buffer, laid out as the std430 Material struct of material.glsl
+	struct GPUMaterial {
+		// Constant of each PBRMaterial parameter, used where it has no texture
+		std::array<glm::vec4, 5> Colors{};
+		// Texture of each parameter: texture array index + 1 and layer, or the halves of a bindless handle. 0 in
+		// both for none.
+		std::array<glm::uvec2, 5> Textures{};
+		float Alpha{ 1.0f };
+		float Padding{ 0.0f };
+	};
+	static_assert(sizeof(GPUMaterial) == 128, "GPUMaterial must match the std430 layout of the shader's Material");
+
+	// Parameters of every material of a scene in one shader storage buffer, indexed by a material's position in
+	// RenderScene::GetMaterials(). Their textures are moved into arrays grouped by size, format, mip count and
+	// sampler state, or made resident as bindless handles. Either way a draw only changes the materialIndex
+	// uniform, nothing is bound per draw.
+	class MaterialTable {
+	public:
+		enum class TextureMode {
+			Arrays,
+			// GL_ARB_bindless_texture, shaders need ENABLE_BINDLESS_TEXTURES
+			Bindless
+		};
+
+		// Binding point of the material buffer, units the texture arrays are bound to from FirstTextureUnit on
+		static constexpr GLuint StorageBinding{ 0 };
+		static constexpr GLuint FirstTextureUnit{ 3 };
+		// Array samplers material.glsl declares. Textures fitting none of them are left out with a warning.
+		static constexpr std::size_t MaxTextureArrays{ 8 };
+
+		// Replaces the table with materials. With arrays, the table takes over every source texture the
+		// ResourceManager gives up and releases its storage once it was copied into its layer: the texture keeps
+		// its name but is empty, only the table can draw with it. Other textures are copied and left as they are.
+		void Build(const std::vector<RenderMaterial>& materials, const TextureMode mode);
+		// Binds the buffer and the texture arrays for the next draws.
+		void Bind() const;
+		void Delete();
+
+		// Index the shader reads for the material at denseIndex in the materials Build was given. Meshes without
+		// a material (InvalidIndex) get a plain grey default.
+		std::uint32_t GetIndex(const std::uint32_t denseIndex) const noexcept
+		{
+			return denseIndex < m_numMaterials ? denseIndex : m_numMaterials;
+		}
+
+		auto GetMode() const noexcept { return m_mode; }
+		auto GetNumMaterials() const noexcept { return m_numMaterials; }
+		auto GetNumTextureArrays() const noexcept { return m_textureArrays.size(); }
+
+	private:
+		// Sampling parameters of a source texture, which every layer of its array shares
+		struct SamplerState {
+			GLint WrapS{ GL_REPEAT }, WrapT{ GL_REPEAT };
+			GLint MinFilter{ GL_LINEAR }, MagFilter{ GL_LINEAR };
+			GLfloat MinLod{ -1000.0f }, MaxLod{ 1000.0f }, LodBias{ 0.0f };
+			GLfloat MaxAnisotropy{ 1.0f };
+
+			bool operator==(const SamplerState& other) const noexcept
+			{
+				return WrapS == other.WrapS && WrapT == other.WrapT && MinFilter == other.MinFilter && MagFilter == other.MagFilter &&
+					MinLod == other.MinLod && MaxLod == other.MaxLod && LodBias == other.LodBias && MaxAnisotropy == other.MaxAnisotropy;
+			}
+		};
+
+		struct TextureArray {
+			GLenum Format;
+			GLsizei Width, Height, Levels;
+			SamplerState Sampler;
+			// Source texture of each layer
+			std::vector<GLuint> Textures;
+			// 0 until createTextureArrays
+			GLuint Name{ 0 };
+		};
+		// Location of each texture in the arrays
+		using TextureLayers = std::unordered_map<GLuint, glm::uvec2>;
+
+		// Location of texture in the arrays, assigned now and filled by createTextureArrays from the texture or
+		// its layer of the last build
+		glm::uvec2 addToTextureArray(const GLuint texture, const std::vector<TextureArray>& previousArrays, const TextureLayers& previousLayers);
+		glm::uvec2 addToTextureArray(const GLuint texture, const GLenum format, const GLsizei width, const GLsizei height,
+			const GLsizei levels, const SamplerState& sampler);
+		glm::uvec2 makeResident(const GLuint texture);
+		void createTextureArrays(const std::vector<TextureArray>& previousArrays, const TextureLayers& previousLayers);
+		void deleteTextureArrays(const std::vector<TextureArray>& textureArrays);
+		// Deletes the owned textures without a layer
+		void deleteUnusedTextures();
+		void deleteBuffer();
+
+		TextureMode m_mode{ TextureMode::Arrays };
+		GLuint m_buffer{ 0 };
+		std::uint32_t m_numMaterials{ 0 };
+		GLint m_maxLayers{ 0 };
+		std::vector<TextureArray> m_textureArrays;
+		// Textures of the current build given a layer
+		TextureLayers m_textureLayers;
+		// Textures taken over from the ResourceManager, emptied once copied. Their names stay reserved until no
+		// build uses them, so GL cannot hand them out again while m_textureLayers may refer to them.
+		std::unordered_set<GLuint> m_ownedTextures;
+		std::vector<GLuint64> m_residentHandles;
+	};
+}
@@ -0,0 +1,72 @@
+#include "MeshProcessing.h"
+
+#include <glm/geometric.hpp>
+
+#include <cmath>
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	void GenerateNormals(std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+	{
+		for (auto& vertex : vertices)
+		{
+			vertex.Normal = glm::vec3(0.0f);
+		}
+
+		for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			auto& a{ vertices[indices[i]] };
+			auto& b{ vertices[indices[i + 1]] };
+			auto& c{ vertices[indices[i + 2]] };
+			const auto normal{ glm::cross(b.Position - a.Position, c.Position - a.Position) };
+			a.Normal += normal;
+			b.Normal += normal;
+			c.Normal += normal;
+		}
+
+		for (auto& vertex : vertices)
+		{
+			const auto length{ glm::length(vertex.Normal) };
+			vertex.Normal = length > 0.0f ? vertex.Normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		}
+	}
+
+	/***********************************************************************************/
+	void GenerateTangents(std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+	{
+		for (auto& vertex : vertices)
+		{
+			vertex.Tangent = glm::vec3(0.0f);
+		}
+
+		for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			auto& a{ vertices[indices[i]] };
+			auto& b{ vertices[indices[i + 1]] };
+			auto& c{ vertices[indices[i + 2]] };
+
+			const auto edge1{ b.Position - a.Position };
+			const auto edge2{ c.Position - a.Position };
+			const auto deltaUV1{ b.TexCoords - a.TexCoords };
+			const auto deltaUV2{ c.TexCoords - a.TexCoords };
+			const auto determinant{ deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y };
+			if (std::abs(determinant) < 1e-12f)
+			{
+				continue;
+			}
+
+			const auto tangent{ (edge1 * deltaUV2.y - edge2 * deltaUV1.y) / determinant };
+			a.Tangent += tangent;
+			b.Tangent += tangent;
+			c.Tangent += tangent;
+		}
+
+		for (auto& vertex : vertices)
+		{
+			const auto tangent{ vertex.Tangent - vertex.Normal * glm::dot(vertex.Normal, vertex.Tangent) };
+			const auto length{ glm::length(tangent) };
+			vertex.Tangent = length > 0.0f ? tangent / length : glm::vec3(0.0f);
+		}
+	}
+}
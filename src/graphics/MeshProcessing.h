@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../Vertex.h"
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Vertex attributes model loaders fill in when a file leaves them out. Both expect an indexed triangle list in
+// counter-clockwise winding.
+namespace Graphics
+{
+	// Smooth normals, the area weighted average of the adjacent face normals
+	void GenerateNormals(std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+	// Tangents along increasing U, averaged over the adjacent faces and made orthogonal to the normal
+	void GenerateTangents(std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+}
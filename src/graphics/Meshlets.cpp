@@ -0,0 +1,496 @@
+#include "Meshlets.h"
+
+#include "../ViewFrustum.h"
+#include "../Platform/SIMD.h"
+
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr auto Unassigned{ std::numeric_limits<std::uint32_t>::max() };
+
+	// Triangles using each vertex, as compressed rows: those of vertex v are Triangles[Offsets[v], Offsets[v + 1])
+	struct VertexTriangles {
+		std::vector<std::uint32_t> Offsets;
+		std::vector<std::uint32_t> Triangles;
+	};
+
+	/***********************************************************************************/
+	VertexTriangles buildVertexTriangles(const std::size_t numVertices, const std::vector<GLuint>& indices)
+	{
+		VertexTriangles adjacency;
+		adjacency.Offsets.assign(numVertices + 1, 0);
+		for (const auto index : indices)
+		{
+			++adjacency.Offsets[index + 1];
+		}
+		for (std::size_t i = 0; i < numVertices; ++i)
+		{
+			adjacency.Offsets[i + 1] += adjacency.Offsets[i];
+		}
+
+		adjacency.Triangles.resize(indices.size());
+		auto cursors{ adjacency.Offsets };
+		for (std::size_t i = 0; i < indices.size(); ++i)
+		{
+			adjacency.Triangles[cursors[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+		}
+		return adjacency;
+	}
+
+	/***********************************************************************************/
+	// Unit geometric normal turned to the side the vertex normals point to, zero for degenerate triangles
+	glm::vec3 faceNormal(const std::vector<Vertex>& vertices, const GLuint* triangle)
+	{
+		const auto& a{ vertices[triangle[0]] };
+		const auto& b{ vertices[triangle[1]] };
+		const auto& c{ vertices[triangle[2]] };
+
+		const auto normal{ glm::cross(b.Position - a.Position, c.Position - a.Position) };
+		const auto length{ glm::length(normal) };
+		if (!(length > 0.0f))
+		{
+			return glm::vec3(0.0f);
+		}
+
+		const auto side{ glm::dot(normal, a.Normal + b.Normal + c.Normal) };
+		return normal * ((side < 0.0f ? -1.0f : 1.0f) / length);
+	}
+
+	/***********************************************************************************/
+	bool isOutside(const Graphics::MeshletView& view, const glm::vec3& center, const float radius)
+	{
+		for (const auto& plane : view.Planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/***********************************************************************************/
+	// Conservative: true only if the eye is behind every triangle whose normal lies in the cone, at any point of the
+	// sphere. Holds when the direction to each point is within 90 degrees minus the cone's half angle of the axis.
+	bool isBackFacing(const Graphics::MeshletView& view, const glm::vec3& center, const float radius, const glm::vec3& axis, const float cutoff)
+	{
+		const auto toCenter{ center - view.Eye };
+		return glm::dot(toCenter, axis) > cutoff * glm::length(toCenter) + radius * (1.0f + cutoff);
+	}
+
+	/***********************************************************************************/
+	// Appends the indices of meshlet to ranges, extending the last range if they follow it
+	void appendRange(const Graphics::MeshletBounds& bounds, const std::uint32_t meshlet, Graphics::IndexRange* ranges, std::uint32_t& numRanges,
+		Graphics::MeshletCullCounts& counts)
+	{
+		const auto first{ bounds.FirstIndex[meshlet] };
+		const auto count{ bounds.IndexCount[meshlet] };
+		counts.TrianglesAfter += count / 3;
+
+		if (numRanges > 0)
+		{
+			auto& last{ ranges[numRanges - 1] };
+			if (last.First + static_cast<GLuint>(last.Count) == first)
+			{
+				last.Count += static_cast<GLsizei>(count);
+				return;
+			}
+		}
+		ranges[numRanges++] = { first, static_cast<GLsizei>(count) };
+	}
+
+	/***********************************************************************************/
+	// Tests meshlet on its own, returns true if it is kept
+	bool cullScalar(const Graphics::MeshletBounds& bounds, const std::uint32_t meshlet, const Graphics::MeshletView& view, Graphics::MeshletCullCounts& counts)
+	{
+		const glm::vec3 center{ bounds.CenterX[meshlet], bounds.CenterY[meshlet], bounds.CenterZ[meshlet] };
+		const auto radius{ bounds.Radius[meshlet] };
+		if (isOutside(view, center, radius))
+		{
+			++counts.FrustumCulled;
+			return false;
+		}
+
+		const glm::vec3 axis{ bounds.AxisX[meshlet], bounds.AxisY[meshlet], bounds.AxisZ[meshlet] };
+		if (view.ConeCulling && isBackFacing(view, center, radius, axis, bounds.Cutoff[meshlet]))
+		{
+			++counts.ConeCulled;
+			return false;
+		}
+		return true;
+	}
+
+#ifdef GE_SSE2
+	/***********************************************************************************/
+	// The tests of cullScalar for the four meshlets from first. Bit i of the result is set if meshlet first + i is
+	// kept, frustumCulled gets the bits of those outside the frustum.
+	int cull4(const Graphics::MeshletBounds& bounds, const std::uint32_t first, const Graphics::MeshletView& view, int& frustumCulled)
+	{
+		const auto cx{ _mm_loadu_ps(bounds.CenterX.data() + first) };
+		const auto cy{ _mm_loadu_ps(bounds.CenterY.data() + first) };
+		const auto cz{ _mm_loadu_ps(bounds.CenterZ.data() + first) };
+		const auto radius{ _mm_loadu_ps(bounds.Radius.data() + first) };
+		const auto negativeRadius{ _mm_sub_ps(_mm_setzero_ps(), radius) };
+
+		auto inside{ _mm_castsi128_ps(_mm_set1_epi32(-1)) };
+		for (const auto& plane : view.Planes)
+		{
+			auto distance{ _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))) };
+			distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		frustumCulled = ~_mm_movemask_ps(inside) & 0xF;
+		if (!view.ConeCulling)
+		{
+			return _mm_movemask_ps(inside);
+		}
+
+		const auto dx{ _mm_sub_ps(cx, _mm_set1_ps(view.Eye.x)) };
+		const auto dy{ _mm_sub_ps(cy, _mm_set1_ps(view.Eye.y)) };
+		const auto dz{ _mm_sub_ps(cz, _mm_set1_ps(view.Eye.z)) };
+		const auto distance{ _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz))) };
+
+		auto alongAxis{ _mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(bounds.AxisX.data() + first)), _mm_mul_ps(dy, _mm_loadu_ps(bounds.AxisY.data() + first))) };
+		alongAxis = _mm_add_ps(alongAxis, _mm_mul_ps(dz, _mm_loadu_ps(bounds.AxisZ.data() + first)));
+
+		const auto cutoff{ _mm_loadu_ps(bounds.Cutoff.data() + first) };
+		const auto limit{ _mm_add_ps(_mm_mul_ps(cutoff, distance), _mm_mul_ps(radius, _mm_add_ps(cutoff, _mm_set1_ps(1.0f)))) };
+		const auto backFacing{ _mm_cmpgt_ps(alongAxis, limit) };
+
+		return _mm_movemask_ps(_mm_andnot_ps(backFacing, inside));
+	}
+#endif
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const MeshletBuildOptions& options)
+	{
+		const auto numTriangles{ indices.size() / 3 };
+		if (numTriangles == 0 || vertices.empty())
+		{
+			return {};
+		}
+
+		const auto maxVertices{ std::max<std::size_t>(options.MaxVertices, 3) };
+		const auto maxTriangles{ std::max<std::size_t>(options.MaxTriangles, 1) };
+
+		const auto adjacency{ buildVertexTriangles(vertices.size(), indices) };
+
+		std::vector<glm::vec3> normals(numTriangles);
+		for (std::size_t i = 0; i < numTriangles; ++i)
+		{
+			normals[i] = faceNormal(vertices, &indices[i * 3]);
+		}
+
+		// Triangles that are not adjacent to a meshlet only join it while it stays about as large as a meshlet would
+		// be if the triangles were spread evenly over the mesh's bounds
+		glm::vec3 meshMin{ std::numeric_limits<float>::max() }, meshMax{ std::numeric_limits<float>::lowest() };
+		for (const auto& vertex : vertices)
+		{
+			meshMin = glm::min(meshMin, vertex.Position);
+			meshMax = glm::max(meshMax, vertex.Position);
+		}
+		const auto expectedExtent{ 0.5f * glm::length(meshMax - meshMin) * std::sqrt(static_cast<float>(maxTriangles) / static_cast<float>(numTriangles)) };
+
+		// Stamped with the meshlet currently being built, so nothing needs to be cleared between meshlets
+		std::vector<std::uint32_t> vertexMeshlet(vertices.size(), Unassigned);
+		std::vector<std::uint32_t> candidateMeshlet(numTriangles, Unassigned);
+		std::vector<std::uint8_t> emitted(numTriangles, 0);
+
+		std::vector<GLuint> reordered;
+		reordered.reserve(indices.size());
+		std::vector<Meshlet> meshlets;
+		meshlets.reserve(numTriangles / maxTriangles + 1);
+
+		std::vector<std::uint32_t> candidates;
+		std::vector<GLuint> meshletVertices;
+		meshletVertices.reserve(maxVertices);
+
+		std::size_t seedCursor{ 0 };
+		for (std::size_t numEmitted = 0; numEmitted < numTriangles;)
+		{
+			const auto id{ static_cast<std::uint32_t>(meshlets.size()) };
+			candidates.clear();
+			meshletVertices.clear();
+
+			Meshlet meshlet;
+			meshlet.FirstIndex = static_cast<std::uint32_t>(reordered.size());
+			glm::vec3 min{ std::numeric_limits<float>::max() }, max{ std::numeric_limits<float>::lowest() };
+			glm::vec3 normalSum{ 0.0f };
+			std::size_t numMeshletTriangles{ 0 };
+
+			const auto addTriangle = [&](const std::uint32_t triangle) {
+				emitted[triangle] = 1;
+				++numEmitted;
+				++numMeshletTriangles;
+				normalSum += normals[triangle];
+
+				for (std::size_t corner = 0; corner < 3; ++corner)
+				{
+					const auto vertex{ indices[triangle * 3 + corner] };
+					reordered.push_back(vertex);
+					if (vertexMeshlet[vertex] != id)
+					{
+						vertexMeshlet[vertex] = id;
+						meshletVertices.push_back(vertex);
+						min = glm::min(min, vertices[vertex].Position);
+						max = glm::max(max, vertices[vertex].Position);
+					}
+
+					for (auto i = adjacency.Offsets[vertex]; i < adjacency.Offsets[vertex + 1]; ++i)
+					{
+						const auto neighbour{ adjacency.Triangles[i] };
+						if (!emitted[neighbour] && candidateMeshlet[neighbour] != id)
+						{
+							candidateMeshlet[neighbour] = id;
+							candidates.push_back(neighbour);
+						}
+					}
+				}
+			};
+
+			const auto newVertices = [&](const std::uint32_t triangle) {
+				std::size_t count{ 0 };
+				for (std::size_t corner = 0; corner < 3; ++corner)
+				{
+					count += vertexMeshlet[indices[triangle * 3 + corner]] != id;
+				}
+				return count;
+			};
+
+			while (emitted[seedCursor])
+			{
+				++seedCursor;
+			}
+			addTriangle(static_cast<std::uint32_t>(seedCursor));
+
+			while (numMeshletTriangles < maxTriangles)
+			{
+				// Fewest new vertices first, then the triangle closest to the meshlet's center, with distances
+				// stretched up to twice for normals turning away from the meshlet's. Keeps meshlets round and
+				// their cones narrow.
+				const auto center{ (min + max) * 0.5f };
+				const auto axisLength{ glm::length(normalSum) };
+				const auto axis{ axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f) };
+
+				auto best{ Unassigned };
+				std::size_t bestNewVertices{ 4 };
+				auto bestScore{ std::numeric_limits<float>::max() };
+				for (std::size_t i = 0; i < candidates.size();)
+				{
+					const auto candidate{ candidates[i] };
+					if (emitted[candidate])
+					{
+						candidates[i] = candidates.back();
+						candidates.pop_back();
+						continue;
+					}
+					++i;
+
+					const auto numNew{ newVertices(candidate) };
+					if (meshletVertices.size() + numNew > maxVertices || numNew > bestNewVertices)
+					{
+						continue;
+					}
+
+					const auto* triangle{ &indices[candidate * 3] };
+					const auto centroid{ (vertices[triangle[0]].Position + vertices[triangle[1]].Position + vertices[triangle[2]].Position) / 3.0f };
+					const auto score{ glm::length(centroid - center) * (2.0f - glm::dot(normals[candidate], axis)) };
+					if (numNew < bestNewVertices || score < bestScore)
+					{
+						best = candidate;
+						bestNewVertices = numNew;
+						bestScore = score;
+					}
+				}
+
+				if (best == Unassigned && candidates.empty() && numEmitted < numTriangles && meshletVertices.size() + 3 <= maxVertices)
+				{
+					// Nothing connected is left, continue with the next unused triangle if it is close
+					while (emitted[seedCursor])
+					{
+						++seedCursor;
+					}
+
+					auto grownMin{ min }, grownMax{ max };
+					for (std::size_t corner = 0; corner < 3; ++corner)
+					{
+						grownMin = glm::min(grownMin, vertices[indices[seedCursor * 3 + corner]].Position);
+						grownMax = glm::max(grownMax, vertices[indices[seedCursor * 3 + corner]].Position);
+					}
+					if (0.5f * glm::length(grownMax - grownMin) <= std::max(0.5f * glm::length(max - min), expectedExtent))
+					{
+						best = static_cast<std::uint32_t>(seedCursor);
+					}
+				}
+
+				if (best == Unassigned)
+				{
+					break;
+				}
+				addTriangle(best);
+			}
+
+			meshlet.IndexCount = static_cast<std::uint32_t>(reordered.size()) - meshlet.FirstIndex;
+
+			meshlet.Center = (min + max) * 0.5f;
+			for (const auto vertex : meshletVertices)
+			{
+				meshlet.Radius = std::max(meshlet.Radius, glm::length(vertices[vertex].Position - meshlet.Center));
+			}
+
+			// The cone must hold every triangle, degenerate ones face nowhere and are left out
+			const auto sumLength{ glm::length(normalSum) };
+			if (sumLength > 0.0f)
+			{
+				meshlet.ConeAxis = normalSum / sumLength;
+
+				auto minDot{ 1.0f };
+				for (auto i = meshlet.FirstIndex; i < meshlet.FirstIndex + meshlet.IndexCount; i += 3)
+				{
+					const auto normal{ faceNormal(vertices, &reordered[i]) };
+					if (normal != glm::vec3(0.0f))
+					{
+						minDot = std::min(minDot, glm::dot(normal, meshlet.ConeAxis));
+					}
+				}
+				meshlet.ConeCutoff = minDot > 0.0f ? std::sqrt(std::max(1.0f - minDot * minDot, 0.0f)) : 1.0f;
+			}
+
+			meshlets.push_back(meshlet);
+		}
+
+		indices = std::move(reordered);
+		return meshlets;
+	}
+
+	/***********************************************************************************/
+	std::uint32_t MeshletBounds::Append(const std::vector<Meshlet>& meshlets)
+	{
+		const auto first{ GetSize() };
+		for (const auto& meshlet : meshlets)
+		{
+			CenterX.push_back(meshlet.Center.x);
+			CenterY.push_back(meshlet.Center.y);
+			CenterZ.push_back(meshlet.Center.z);
+			Radius.push_back(meshlet.Radius);
+			AxisX.push_back(meshlet.ConeAxis.x);
+			AxisY.push_back(meshlet.ConeAxis.y);
+			AxisZ.push_back(meshlet.ConeAxis.z);
+			Cutoff.push_back(meshlet.ConeCutoff);
+			FirstIndex.push_back(meshlet.FirstIndex);
+			IndexCount.push_back(meshlet.IndexCount);
+		}
+		return first;
+	}
+
+	/***********************************************************************************/
+	void MeshletBounds::Erase(const std::uint32_t first, const std::uint32_t count)
+	{
+		const auto eraseRange = [first, count](auto& values) {
+			values.erase(values.begin() + first, values.begin() + first + count);
+		};
+
+		for (auto* values : { &CenterX, &CenterY, &CenterZ, &Radius, &AxisX, &AxisY, &AxisZ, &Cutoff })
+		{
+			eraseRange(*values);
+		}
+		eraseRange(FirstIndex);
+		eraseRange(IndexCount);
+	}
+
+	/***********************************************************************************/
+	void MeshletBounds::Clear()
+	{
+		for (auto* values : { &CenterX, &CenterY, &CenterZ, &Radius, &AxisX, &AxisY, &AxisZ, &Cutoff })
+		{
+			values->clear();
+		}
+		FirstIndex.clear();
+		IndexCount.clear();
+	}
+
+	/***********************************************************************************/
+	MeshletView::MeshletView(const ViewFrustum& frustum, const glm::vec3& eye, const glm::mat4& transform, const bool coneCulling) :
+		Eye(glm::vec3(glm::inverse(transform) * glm::vec4(eye, 1.0f))),
+		ConeCulling(coneCulling)
+	{
+		// A world plane P tests transformed points M * x as (P * M) * x. Spheres grow by the largest axis scale,
+		// which the planes are divided by instead.
+		const auto scale{ std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) }) };
+		const auto transposed{ glm::transpose(transform) };
+		for (std::size_t i = 0; i < Planes.size(); ++i)
+		{
+			Planes[i] = transposed * frustum.GetPlane(i) / scale;
+		}
+	}
+
+	/***********************************************************************************/
+	MeshletCullCounts& MeshletCullCounts::operator+=(const MeshletCullCounts& other) noexcept
+	{
+		Meshlets += other.Meshlets;
+		FrustumCulled += other.FrustumCulled;
+		ConeCulled += other.ConeCulled;
+		TrianglesBefore += other.TrianglesBefore;
+		TrianglesAfter += other.TrianglesAfter;
+		return *this;
+	}
+
+	/***********************************************************************************/
+	std::uint32_t CullMeshlets(const MeshletBounds& bounds, const std::uint32_t first, const std::uint32_t count, const MeshletView& view,
+		IndexRange* ranges, MeshletCullCounts& counts, const bool allowSIMD)
+	{
+		counts.Meshlets += count;
+		for (auto i = first; i < first + count; ++i)
+		{
+			counts.TrianglesBefore += bounds.IndexCount[i] / 3;
+		}
+
+		std::uint32_t numRanges{ 0 };
+		auto meshlet{ first };
+		const auto end{ first + count };
+
+#ifdef GE_SSE2
+		if (allowSIMD)
+		{
+			for (; meshlet + 4 <= end; meshlet += 4)
+			{
+				int frustumCulled;
+				const auto kept{ cull4(bounds, meshlet, view, frustumCulled) };
+
+				const auto numFrustumCulled{ ((frustumCulled >> 0) & 1) + ((frustumCulled >> 1) & 1) + ((frustumCulled >> 2) & 1) + ((frustumCulled >> 3) & 1) };
+				const auto numKept{ ((kept >> 0) & 1) + ((kept >> 1) & 1) + ((kept >> 2) & 1) + ((kept >> 3) & 1) };
+				counts.FrustumCulled += numFrustumCulled;
+				counts.ConeCulled += 4 - numFrustumCulled - numKept;
+
+				for (std::uint32_t lane = 0; lane < 4; ++lane)
+				{
+					if (kept & (1 << lane))
+					{
+						appendRange(bounds, meshlet + lane, ranges, numRanges, counts);
+					}
+				}
+			}
+		}
+#endif
+
+		for (; meshlet < end; ++meshlet)
+		{
+			if (cullScalar(bounds, meshlet, view, counts))
+			{
+				appendRange(bounds, meshlet, ranges, numRanges, counts);
+			}
+		}
+
+		return numRanges;
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include "../Vertex.h"
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ViewFrustum;
+
+// Meshlets are clusters of up to a few dozen vertices and about a hundred triangles, built when a mesh is imported.
+// Their triangles are moved next to each other in the index buffer, so whatever survives culling is drawn as a few
+// ranges of it. Each keeps a bounding sphere for frustum culling and a cone around its normals: when the eye sees
+// every triangle of a meshlet from behind, the whole meshlet is skipped. Everything here runs on the CPU.
+namespace Graphics
+{
+	struct Meshlet {
+		// Bounding sphere in model space
+		glm::vec3 Center{ 0.0f };
+		float Radius{ 0.0f };
+		// Every triangle's normal is within the cone around ConeAxis; ConeCutoff is the sine of its half angle,
+		// 1 for meshlets whose normals spread too far to ever face away
+		glm::vec3 ConeAxis{ 0.0f, 0.0f, 1.0f };
+		float ConeCutoff{ 1.0f };
+		// Triangles of the meshlet in the reordered index buffer
+		std::uint32_t FirstIndex{ 0 };
+		std::uint32_t IndexCount{ 0 };
+	};
+
+	struct MeshletBuildOptions {
+		// Vertices one meshlet may reference, 64 to 124 suit most GPUs
+		std::size_t MaxVertices{ 64 };
+		std::size_t MaxTriangles{ 126 };
+	};
+
+	// Splits the triangles of indices into meshlets, each grown from a seed triangle over shared edges while the
+	// limits allow, and reorders indices so every meshlet's triangles are contiguous (meshlets follow each other in
+	// the returned order). Triangles are facing the side their vertex normals point to, whatever the winding.
+	std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const MeshletBuildOptions& options = {});
+
+	// Meshlet bounds of many meshes as structure of arrays, for culling four at a time
+	struct MeshletBounds {
+		std::vector<float> CenterX, CenterY, CenterZ, Radius;
+		std::vector<float> AxisX, AxisY, AxisZ, Cutoff;
+		std::vector<std::uint32_t> FirstIndex, IndexCount;
+
+		// Returns the index of the first added meshlet
+		std::uint32_t Append(const std::vector<Meshlet>& meshlets);
+		// Removes meshlets [first, first + count), the ones after move down by count
+		void Erase(const std::uint32_t first, const std::uint32_t count);
+		void Clear();
+		auto GetSize() const noexcept { return static_cast<std::uint32_t>(Radius.size()); }
+	};
+
+	// A frustum and eye moved into the model space of one model, so its meshlets are tested without transforming
+	// them. Facing is invariant under the model's transform, scaling is covered by growing the spheres.
+	struct MeshletView {
+		MeshletView(const ViewFrustum& frustum, const glm::vec3& eye, const glm::mat4& transform, const bool coneCulling);
+
+		// Planes divided by the largest axis scale, a model space sphere is outside if its center is further than
+		// its radius behind one
+		std::array<glm::vec4, 6> Planes;
+		glm::vec3 Eye;
+		bool ConeCulling;
+	};
+
+	struct MeshletCullCounts {
+		std::size_t Meshlets{ 0 };
+		std::size_t FrustumCulled{ 0 };
+		std::size_t ConeCulled{ 0 };
+		// Triangles of the tested meshlets, and of those that were kept
+		std::size_t TrianglesBefore{ 0 };
+		std::size_t TrianglesAfter{ 0 };
+
+		MeshletCullCounts& operator+=(const MeshletCullCounts& other) noexcept;
+	};
+
+	// Tests meshlets [first, first + count) of bounds against view and writes the index ranges of the visible ones
+	// to ranges, neighbours merged into one. ranges needs room for count entries. Returns the number written.
+	std::uint32_t CullMeshlets(const MeshletBounds& bounds, const std::uint32_t first, const std::uint32_t count, const MeshletView& view,
+		IndexRange* ranges, MeshletCullCounts& counts, const bool allowSIMD = true);
+}
@@ -0,0 +1,534 @@
+#include "MipGenerator.h"
+
+#include "../core/ThreadPool.h"
+#include "../Platform/SIMD.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+	// Linear RGBA, 4 floats per pixel.
+	struct FloatImage {
+		std::uint32_t Width{ 0 };
+		std::uint32_t Height{ 0 };
+		std::vector<float> Pixels;
+	};
+
+	constexpr int KAISER_TAPS{ 8 };
+	constexpr float KAISER_ALPHA{ 4.0f };
+	constexpr float KAISER_RADIUS{ 2.0f };
+
+	// Resolution of the linear -> sRGB table.
+	constexpr int LINEAR_TO_SRGB_SIZE{ 16384 };
+
+	// Rows handed to a worker at once.
+	constexpr std::size_t ROW_GRAIN{ 8 };
+
+	/***********************************************************************************/
+	// Zeroth order modified Bessel function of the first kind.
+	double besselI0(const double x)
+	{
+		double sum{ 1.0 }, term{ 1.0 };
+		for (int k = 1; k < 32; ++k)
+		{
+			const auto f{ x / (2.0 * k) };
+			term *= f * f;
+			sum += term;
+		}
+		return sum;
+	}
+
+	/***********************************************************************************/
+	// Taps for a 2:1 reduction. Destination pixel x is centered between source pixels 2x and 2x+1,
+	// so tap k reads source pixel 2x - 3 + k.
+	const std::array<float, KAISER_TAPS>& kaiserWeights()
+	{
+		static const auto weights = [] {
+			constexpr double pi{ 3.14159265358979323846 };
+
+			std::array<float, KAISER_TAPS> w{};
+			double sum{ 0.0 };
+			std::array<double, KAISER_TAPS> unnormalized{};
+			for (int k = 0; k < KAISER_TAPS; ++k)
+			{
+				// Distance in destination pixels
+				const auto t{ (k - 3.5) * 0.5 };
+				const auto sinc{ std::sin(pi * t) / (pi * t) };
+				const auto r{ t / KAISER_RADIUS };
+				const auto window{ besselI0(KAISER_ALPHA * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(KAISER_ALPHA) };
+				unnormalized[k] = sinc * window;
+				sum += unnormalized[k];
+			}
+			for (int k = 0; k < KAISER_TAPS; ++k)
+			{
+				w[k] = static_cast<float>(unnormalized[k] / sum);
+			}
+			return w;
+		}();
+
+		return weights;
+	}
+
+	/***********************************************************************************/
+	const std::array<float, 256>& srgbToLinearTable()
+	{
+		static const auto table = [] {
+			std::array<float, 256> t{};
+			for (int i = 0; i < 256; ++i)
+			{
+				const auto c{ i / 255.0 };
+				t[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+			}
+			return t;
+		}();
+
+		return table;
+	}
+
+	/***********************************************************************************/
+	const std::vector<std::uint8_t>& linearToSRGBTable()
+	{
+		static const auto table = [] {
+			std::vector<std::uint8_t> t(LINEAR_TO_SRGB_SIZE);
+			for (int i = 0; i < LINEAR_TO_SRGB_SIZE; ++i)
+			{
+				const auto l{ static_cast<double>(i) / (LINEAR_TO_SRGB_SIZE - 1) };
+				const auto c{ l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055 };
+				t[i] = static_cast<std::uint8_t>(std::lround(std::clamp(c, 0.0, 1.0) * 255.0));
+			}
+			return t;
+		}();
+
+		return table;
+	}
+
+	/***********************************************************************************/
+	FloatImage toFloat(const std::uint8_t* rgba, const std::uint32_t width, const std::uint32_t height, const Graphics::MipSettings& settings)
+	{
+		FloatImage image{ width, height, std::vector<float>(static_cast<std::size_t>(width) * height * 4) };
+
+		const auto& toLinear{ srgbToLinearTable() };
+		ThreadPool::GetInstance().ParallelFor(height, ROW_GRAIN, [&](const std::size_t begin, const std::size_t end) {
+			for (auto i = begin * width * 4; i < end * width * 4; i += 4)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					image.Pixels[i + c] = settings.SRGB ? toLinear[rgba[i + c]] : rgba[i + c] / 255.0f;
+				}
+				image.Pixels[i + 3] = rgba[i + 3] / 255.0f;
+			}
+		});
+
+		return image;
+	}
+
+	/***********************************************************************************/
+	Graphics::MipLevel toRGBA8(const FloatImage& image, const Graphics::MipSettings& settings, const float alphaScale)
+	{
+		Graphics::MipLevel level{ image.Width, image.Height, std::vector<std::uint8_t>(image.Pixels.size()) };
+
+		const auto& toSRGB{ linearToSRGBTable() };
+		ThreadPool::GetInstance().ParallelFor(image.Height, ROW_GRAIN, [&](const std::size_t begin, const std::size_t end) {
+			for (auto i = begin * image.Width * 4; i < end * image.Width * 4; i += 4)
+			{
+				float rgb[3]{ image.Pixels[i], image.Pixels[i + 1], image.Pixels[i + 2] };
+
+				if (settings.NormalMap)
+				{
+					float n[3]{ rgb[0] * 2.0f - 1.0f, rgb[1] * 2.0f - 1.0f, rgb[2] * 2.0f - 1.0f };
+					const auto length{ std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) };
+					if (length > 1e-6f)
+					{
+						for (int c = 0; c < 3; ++c)
+						{
+							rgb[c] = n[c] / length * 0.5f + 0.5f;
+						}
+					}
+					else
+					{
+						rgb[0] = rgb[1] = 0.5f;
+						rgb[2] = 1.0f;
+					}
+				}
+
+				for (int c = 0; c < 3; ++c)
+				{
+					const auto v{ std::clamp(rgb[c], 0.0f, 1.0f) };
+					level.Data[i + c] = settings.SRGB ? toSRGB[static_cast<std::size_t>(v * (LINEAR_TO_SRGB_SIZE - 1) + 0.5f)] :
+						static_cast<std::uint8_t>(v * 255.0f + 0.5f);
+				}
+				level.Data[i + 3] = static_cast<std::uint8_t>(std::clamp(image.Pixels[i + 3] * alphaScale, 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+		});
+
+		return level;
+	}
+
+	/***********************************************************************************/
+	float alphaCoverage(const FloatImage& image, const float cutoff)
+	{
+		std::size_t covered{ 0 };
+		for (std::size_t i = 3; i < image.Pixels.size(); i += 4)
+		{
+			covered += image.Pixels[i] > cutoff;
+		}
+		return static_cast<float>(covered) / static_cast<float>(image.Pixels.size() / 4);
+	}
+
+	/***********************************************************************************/
+	// Finds the alpha scale that makes the level cover the same fraction of texels as level 0.
+	// Scaling by s passes the cutoff for alpha > cutoff / s, so we look for the alpha quantile.
+	float alphaCoverageScale(const FloatImage& image, const float cutoff, const float targetCoverage)
+	{
+		constexpr int numBins{ 4096 };
+		std::array<std::uint32_t, numBins> histogram{};
+		for (std::size_t i = 3; i < image.Pixels.size(); i += 4)
+		{
+			const auto bin{ std::clamp(static_cast<int>(image.Pixels[i] * (numBins - 1) + 0.5f), 0, numBins - 1) };
+			++histogram[bin];
+		}
+
+		const auto numPixels{ image.Pixels.size() / 4 };
+		const auto target{ static_cast<std::size_t>(targetCoverage * numPixels + 0.5f) };
+		if (target == 0)
+		{
+			return 1.0f;
+		}
+
+		std::size_t covered{ 0 };
+		for (int bin = numBins - 1; bin >= 0; --bin)
+		{
+			covered += histogram[bin];
+			if (covered >= target)
+			{
+				const auto threshold{ std::max(static_cast<float>(bin) / (numBins - 1), 1.0f / 255.0f) };
+				// Slightly below the threshold so texels at exactly this alpha pass the cutoff.
+				return std::min(cutoff / threshold * 1.001f, 255.0f);
+			}
+		}
+
+		return 1.0f;
+	}
+
+#ifdef GE_SSE2
+	/***********************************************************************************/
+	void kaiserHorizontalSSE(const float* src, const std::uint32_t srcWidth, float* dst, const std::uint32_t dstWidth, const float* weights)
+	{
+		for (std::uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const auto first{ static_cast<std::int64_t>(x) * 2 - 3 };
+			auto sum{ _mm_setzero_ps() };
+			if (first >= 0 && first + KAISER_TAPS <= srcWidth)
+			{
+				const auto* taps{ src + first * 4 };
+				for (int k = 0; k < KAISER_TAPS; ++k)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(taps + k * 4)));
+				}
+			}
+			else
+			{
+				for (int k = 0; k < KAISER_TAPS; ++k)
+				{
+					const auto sx{ std::clamp<std::int64_t>(first + k, 0, srcWidth - 1) };
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(src + sx * 4)));
+				}
+			}
+			_mm_storeu_ps(dst + x * 4, sum);
+		}
+	}
+
+	/***********************************************************************************/
+	void kaiserVerticalSSE(const float* const* rows, float* dst, const std::size_t numFloats, const float* weights)
+	{
+		const auto zero{ _mm_setzero_ps() };
+		const auto one{ _mm_set1_ps(1.0f) };
+		for (std::size_t i = 0; i < numFloats; i += 4)
+		{
+			auto sum{ _mm_setzero_ps() };
+			for (int k = 0; k < KAISER_TAPS; ++k)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+			}
+			// Negative lobes can overshoot.
+			_mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(sum, zero), one));
+		}
+	}
+
+	/***********************************************************************************/
+	void boxSSE(const float* row0, const float* row1, const std::uint32_t srcWidth, float* dst, const std::uint32_t dstWidth)
+	{
+		const auto quarter{ _mm_set1_ps(0.25f) };
+		for (std::uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const auto x0{ std::min(x * 2, srcWidth - 1) * 4 };
+			const auto x1{ std::min(x * 2 + 1, srcWidth - 1) * 4 };
+			const auto top{ _mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)) };
+			const auto bottom{ _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)) };
+			_mm_storeu_ps(dst + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+		}
+	}
+
+	/***********************************************************************************/
+	// Two destination pixels per iteration, one in each 128-bit lane.
+	GE_TARGET_AVX2 void kaiserHorizontalAVX2(const float* src, const std::uint32_t srcWidth, float* dst, const std::uint32_t dstWidth, const float* weights)
+	{
+		std::uint32_t x{ 0 };
+		for (; x + 1 < dstWidth; x += 2)
+		{
+			const auto first{ static_cast<std::int64_t>(x) * 2 - 3 };
+			auto sum{ _mm256_setzero_ps() };
+			if (first >= 0 && first + 2 + KAISER_TAPS <= srcWidth)
+			{
+				const auto* taps{ src + first * 4 };
+				for (int k = 0; k < KAISER_TAPS; ++k)
+				{
+					const auto pair{ _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(taps + k * 4)), _mm_loadu_ps(taps + (k + 2) * 4), 1) };
+					sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), pair, sum);
+				}
+			}
+			else
+			{
+				for (int k = 0; k < KAISER_TAPS; ++k)
+				{
+					const auto sx0{ std::clamp<std::int64_t>(first + k, 0, srcWidth - 1) };
+					const auto sx1{ std::clamp<std::int64_t>(first + k + 2, 0, srcWidth - 1) };
+					const auto pair{ _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + sx0 * 4)), _mm_loadu_ps(src + sx1 * 4), 1) };
+					sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), pair, sum);
+				}
+			}
+			_mm256_storeu_ps(dst + x * 4, sum);
+		}
+
+		if (x < dstWidth)
+		{
+			const auto first{ static_cast<std::int64_t>(x) * 2 - 3 };
+			auto sum{ _mm_setzero_ps() };
+			for (int k = 0; k < KAISER_TAPS; ++k)
+			{
+				const auto sx{ std::clamp<std::int64_t>(first + k, 0, srcWidth - 1) };
+				sum = _mm_fmadd_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(src + sx * 4), sum);
+			}
+			_mm_storeu_ps(dst + x * 4, sum);
+		}
+	}
+
+	/***********************************************************************************/
+	GE_TARGET_AVX2 void kaiserVerticalAVX2(const float* const* rows, float* dst, const std::size_t numFloats, const float* weights)
+	{
+		const auto zero{ _mm256_setzero_ps() };
+		const auto one{ _mm256_set1_ps(1.0f) };
+
+		std::size_t i{ 0 };
+		for (; i + 8 <= numFloats; i += 8)
+		{
+			auto sum{ _mm256_setzero_ps() };
+			for (int k = 0; k < KAISER_TAPS; ++k)
+			{
+				sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i), sum);
+			}
+			_mm256_storeu_ps(dst + i, _mm256_min_ps(_mm256_max_ps(sum, zero), one));
+		}
+
+		if (i < numFloats)
+		{
+			const float* tail[KAISER_TAPS];
+			for (int k = 0; k < KAISER_TAPS; ++k)
+			{
+				tail[k] = rows[k] + i;
+			}
+			kaiserVerticalSSE(tail, dst + i, numFloats - i, weights);
+		}
+	}
+
+	/***********************************************************************************/
+	GE_TARGET_AVX2 void boxAVX2(const float* row0, const float* row1, const std::uint32_t srcWidth, float* dst, const std::uint32_t dstWidth)
+	{
+		const auto quarter{ _mm256_set1_ps(0.25f) };
+
+		// Full pairs of source pixels, no clamping needed.
+		const auto numPairs{ std::min(dstWidth, srcWidth / 2) };
+		std::uint32_t x{ 0 };
+		for (; x + 1 < numPairs; x += 2)
+		{
+			// a = pixels 2x, 2x+1 and b = 2x+2, 2x+3; shuffle them into (2x, 2x+2) + (2x+1, 2x+3).
+			const auto a{ _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8)) };
+			const auto b{ _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8)) };
+			const auto even{ _mm256_permute2f128_ps(a, b, 0x20) };
+			const auto odd{ _mm256_permute2f128_ps(a, b, 0x31) };
+			_mm256_storeu_ps(dst + x * 4, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+		}
+
+		if (x < dstWidth)
+		{
+			const auto offset{ x * 2 * 4 };
+			boxSSE(row0 + offset, row1 + offset, srcWidth - x * 2, dst + x * 4, dstWidth - x);
+		}
+	}
+#else
+	/***********************************************************************************/
+	void kaiserHorizontalScalar(const float* src, const std::uint32_t srcWidth, float* dst, const std::uint32_t dstWidth, const float* weights)
+	{
+		for (std::uint32_t x = 0; x < dstWidth; ++x)
+		{
+			float sum[4]{};
+			for (int k = 0; k < KAISER_TAPS; ++k)
+			{
+				const auto sx{ std::clamp<std::int64_t>(static_cast<std::int64_t>(x) * 2 - 3 + k, 0, srcWidth - 1) };
+				for (int c = 0; c < 4; ++c)
+				{
+					sum[c] += weights[k] * src[sx * 4 + c];
+				}
+			}
+			std::copy_n(sum, 4, dst + x * 4);
+		}
+	}
+
+	/***********************************************************************************/
+	void kaiserVerticalScalar(const float* const* rows, float* dst, const std::size_t numFloats, const float* weights)
+	{
+		for (std::size_t i = 0; i < numFloats; ++i)
+		{
+			float sum{ 0.0f };
+			for (int k = 0; k < KAISER_TAPS; ++k)
+			{
+				sum += weights[k] * rows[k][i];
+			}
+			dst[i] = std::clamp(sum, 0.0f, 1.0f);
+		}
+	}
+
+	/***********************************************************************************/
+	void boxScalar(const float* row0, const float* row1, const std::uint32_t srcWidth, float* dst, const std::uint32_t dstWidth)
+	{
+		for (std::uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const auto x0{ std::min(x * 2, srcWidth - 1) * 4 };
+			const auto x1{ std::min(x * 2 + 1, srcWidth - 1) * 4 };
+			for (int c = 0; c < 4; ++c)
+			{
+				dst[x * 4 + c] = 0.25f * (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]);
+			}
+		}
+	}
+#endif
+
+	/***********************************************************************************/
+	FloatImage downsample(const FloatImage& source, const Graphics::MipSettings& settings)
+	{
+		FloatImage result;
+		result.Width = std::max(source.Width / 2, 1u);
+		result.Height = std::max(source.Height / 2, 1u);
+		result.Pixels.resize(static_cast<std::size_t>(result.Width) * result.Height * 4);
+
+		const auto srcStride{ static_cast<std::size_t>(source.Width) * 4 };
+		const auto dstStride{ static_cast<std::size_t>(result.Width) * 4 };
+
+#ifdef GE_SSE2
+		const auto useAVX2{ settings.AllowAVX2 && Platform::HasAVX2() };
+		const auto horizontal{ useAVX2 ? kaiserHorizontalAVX2 : kaiserHorizontalSSE };
+		const auto vertical{ useAVX2 ? kaiserVerticalAVX2 : kaiserVerticalSSE };
+		const auto box{ useAVX2 ? boxAVX2 : boxSSE };
+#else
+		const auto horizontal{ kaiserHorizontalScalar };
+		const auto vertical{ kaiserVerticalScalar };
+		const auto box{ boxScalar };
+#endif
+
+		auto& threadPool{ ThreadPool::GetInstance() };
+
+		if (settings.Filter == Graphics::MipFilter::Box)
+		{
+			threadPool.ParallelFor(result.Height, ROW_GRAIN, [&](const std::size_t begin, const std::size_t end) {
+				for (auto y = begin; y < end; ++y)
+				{
+					const auto y0{ std::min<std::size_t>(y * 2, source.Height - 1) };
+					const auto y1{ std::min<std::size_t>(y * 2 + 1, source.Height - 1) };
+					box(&source.Pixels[y0 * srcStride], &source.Pixels[y1 * srcStride], source.Width, &result.Pixels[y * dstStride], result.Width);
+				}
+			});
+
+			return result;
+		}
+
+		// Separable: filter the rows into a half width image, then the columns of that.
+		const auto* weights{ kaiserWeights().data() };
+		std::vector<float> halfWidth(dstStride * source.Height);
+
+		threadPool.ParallelFor(source.Height, ROW_GRAIN, [&](const std::size_t begin, const std::size_t end) {
+			for (auto y = begin; y < end; ++y)
+			{
+				horizontal(&source.Pixels[y * srcStride], source.Width, &halfWidth[y * dstStride], result.Width, weights);
+			}
+		});
+
+		threadPool.ParallelFor(result.Height, ROW_GRAIN, [&](const std::size_t begin, const std::size_t end) {
+			const float* rows[KAISER_TAPS];
+			for (auto y = begin; y < end; ++y)
+			{
+				for (int k = 0; k < KAISER_TAPS; ++k)
+				{
+					const auto sy{ std::clamp<std::int64_t>(static_cast<std::int64_t>(y) * 2 - 3 + k, 0, source.Height - 1) };
+					rows[k] = &halfWidth[sy * dstStride];
+				}
+				vertical(rows, &result.Pixels[y * dstStride], dstStride, weights);
+			}
+		});
+
+		return result;
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	MipSettings GetMipSettings(const TextureUsage usage, const bool hasAlpha) noexcept
+	{
+		MipSettings settings;
+
+		switch (usage)
+		{
+		case TextureUsage::Normal:
+			settings.SRGB = false;
+			settings.NormalMap = true;
+			break;
+		case TextureUsage::Roughness:
+		case TextureUsage::Metallic:
+		case TextureUsage::AmbientOcclusion:
+			settings.SRGB = false;
+			break;
+		case TextureUsage::AlphaMask:
+			// Masks are data, not color.
+			settings.SRGB = false;
+			break;
+		default:
+			settings.PreserveAlphaCoverage = hasAlpha;
+			break;
+		}
+
+		return settings;
+	}
+
+	/***********************************************************************************/
+	std::vector<MipLevel> GenerateMipChain(const std::uint8_t* rgba, const std::uint32_t width, const std::uint32_t height, const MipSettings& settings)
+	{
+		std::vector<MipLevel> chain;
+		chain.push_back({ width, height, std::vector<std::uint8_t>(rgba, rgba + static_cast<std::size_t>(width) * height * 4) });
+
+		auto level{ toFloat(rgba, width, height, settings) };
+		const auto targetCoverage{ settings.PreserveAlphaCoverage ? alphaCoverage(level, settings.AlphaCutoff) : 0.0f };
+
+		while (level.Width > 1 || level.Height > 1)
+		{
+			// Each level is filtered from the previous unscaled one, only the output gets the alpha scale.
+			level = downsample(level, settings);
+
+			const auto alphaScale{ settings.PreserveAlphaCoverage ? alphaCoverageScale(level, settings.AlphaCutoff, targetCoverage) : 1.0f };
+			chain.push_back(toRGBA8(level, settings, alphaScale));
+		}
+
+		return chain;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "BlockCompression.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Graphics
+{
+	enum class MipFilter {
+		Box,	// 2x2 average
+		Kaiser	// 8 tap Kaiser-windowed sinc, sharper and less aliasing
+	};
+
+	struct MipSettings {
+		MipFilter Filter{ MipFilter::Kaiser };
+		// RGB is sRGB encoded and gets filtered in linear space.
+		bool SRGB{ true };
+		// Scale alpha per level so the fraction of texels above AlphaCutoff stays the same as in level 0.
+		bool PreserveAlphaCoverage{ false };
+		float AlphaCutoff{ 0.5f };
+		// RGB holds a tangent space normal that is renormalized after filtering.
+		bool NormalMap{ false };
+		// Lets benchmarks compare against the SSE2 path on AVX2 machines.
+		bool AllowAVX2{ true };
+	};
+
+	// Uncompressed RGBA8 level.
+	struct MipLevel {
+		std::uint32_t Width{ 0 };
+		std::uint32_t Height{ 0 };
+		std::vector<std::uint8_t> Data;
+	};
+
+	// Settings matching how a texture of this usage is sampled.
+	MipSettings GetMipSettings(const TextureUsage usage, const bool hasAlpha) noexcept;
+
+	// Builds the complete chain down to 1x1, level 0 is a copy of the source. Rows are filtered in
+	// parallel with AVX2 when the CPU has it and SSE2 otherwise.
+	std::vector<MipLevel> GenerateMipChain(const std::uint8_t* rgba, const std::uint32_t width, const std::uint32_t height, const MipSettings& settings);
+}
@@ -0,0 +1,1014 @@
+#include "OBJLoader.h"
+#include "MeshProcessing.h"
+
+#include "../core/MappedFile.h"
+#include "../core/ThreadPool.h"
+
+#include <fmt/core.h>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+	// Smaller files are parsed as one chunk, splitting them costs more than it saves
+	constexpr std::size_t MinChunkSize{ 1 << 20 };
+	// Chunks per thread, so threads that finish early pick up the slack of slow chunks
+	constexpr std::size_t ChunksPerThread{ 4 };
+
+	constexpr std::int32_t Missing{ -1 };
+	constexpr std::int64_t MaxIndex{ std::numeric_limits<std::int32_t>::max() };
+
+	// Material of faces before the first usemtl or with a name no .mtl defines, named like Assimp's
+	constexpr std::string_view DefaultMaterialName{ "DefaultMaterial" };
+
+	// Attribute indices of a triangle corner, 0-based. A Normal below Missing stands for the flat normal of
+	// polygon -2 - Normal, for corners the file gives no normal.
+	struct Corner {
+		std::int32_t Position{ Missing };
+		std::int32_t TexCoord{ Missing };
+		std::int32_t Normal{ Missing };
+
+		bool operator==(const Corner& other) const noexcept
+		{
+			return Position == other.Position && TexCoord == other.TexCoord && Normal == other.Normal;
+		}
+	};
+
+	struct MaterialSwitch {
+		// First corner drawn with the material
+		std::size_t Corner{ 0 };
+		std::string_view Name;
+	};
+
+	struct Chunk {
+		const char* Begin{ nullptr };
+		const char* End{ nullptr };
+
+		std::vector<glm::vec3> Positions;
+		std::vector<glm::vec2> TexCoords;
+		std::vector<glm::vec3> Normals;
+		// Three per triangle
+		std::vector<Corner> Corners;
+		std::vector<MaterialSwitch> MaterialSwitches;
+		std::vector<std::string_view> Libraries;
+		// Polygons that get a flat normal, numbered from 0 within the chunk
+		std::int32_t NumFlatPolygons{ 0 };
+
+		// Negative indices count back from the end of the attributes read so far, which may lie in earlier chunks.
+		// Until the chunks are merged they are relative to the chunk's first attribute. Each entry is
+		// corner * 3 + attribute (0 position, 1 texture coordinate, 2 normal).
+		std::vector<std::size_t> RelativeIndices;
+
+		// Index of the chunk's first attribute and flat polygon in the whole file
+		std::size_t FirstPosition{ 0 };
+		std::size_t FirstTexCoord{ 0 };
+		std::size_t FirstNormal{ 0 };
+		std::size_t FirstFlatPolygon{ 0 };
+
+		// Start of the first line that could not be parsed
+		const char* Error{ nullptr };
+	};
+
+	// A range of corners drawn with one material
+	struct Run {
+		const Chunk* Source{ nullptr };
+		std::size_t Begin{ 0 };
+		std::size_t End{ 0 };
+	};
+
+	// All faces of one usemtl name, which become one mesh
+	struct Group {
+		std::string_view MaterialName;
+		std::vector<Run> Runs;
+		std::size_t NumCorners{ 0 };
+	};
+
+	struct Attributes {
+		std::vector<glm::vec3> Positions;
+		std::vector<glm::vec2> TexCoords;
+		std::vector<glm::vec3> Normals;
+	};
+
+	/***********************************************************************************/
+	void reportError(const std::filesystem::path& path, const std::string_view message)
+	{
+		std::cerr << "OBJ Error: " << path.string() << ": " << message << '\n';
+	}
+
+	/***********************************************************************************/
+	bool isDigit(const char c) noexcept
+	{
+		return static_cast<unsigned char>(c - '0') < 10;
+	}
+
+	/***********************************************************************************/
+	bool isSpace(const char c) noexcept
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	/***********************************************************************************/
+	const char* skipSpaces(const char* p, const char* end) noexcept
+	{
+		while (p < end && isSpace(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	/***********************************************************************************/
+	// The rest of the line after keyword and its separating blank, without surrounding blanks. Empty if the line
+	// does not start with keyword.
+	std::optional<std::string_view> readKeyword(const char* p, const char* end, const std::string_view keyword) noexcept
+	{
+		const auto size{ static_cast<std::size_t>(end - p) };
+		if (size <= keyword.size() || std::string_view(p, keyword.size()) != keyword || !isSpace(p[keyword.size()]))
+		{
+			return std::nullopt;
+		}
+
+		p = skipSpaces(p + keyword.size(), end);
+		while (end > p && (isSpace(end[-1]) || end[-1] == '\r'))
+		{
+			--end;
+		}
+		return std::string_view(p, static_cast<std::size_t>(end - p));
+	}
+
+	/***********************************************************************************/
+	// True if all eight bytes are ASCII digits
+	bool isEightDigits(const std::uint64_t chars) noexcept
+	{
+		return ((chars & 0xF0F0F0F0F0F0F0F0ull) | (((chars + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+	}
+
+	/***********************************************************************************/
+	// Value of eight ASCII digits loaded as a little endian word, with three multiplies instead of eight
+	std::uint32_t parseEightDigits(std::uint64_t chars) noexcept
+	{
+		constexpr std::uint64_t mask{ 0x000000FF000000FFull };
+		constexpr std::uint64_t multiplier1{ 100 + (1000000ull << 32) };
+		constexpr std::uint64_t multiplier2{ 1 + (10000ull << 32) };
+
+		chars -= 0x3030303030303030ull;
+		chars = chars * 10 + (chars >> 8);
+		chars = (((chars & mask) * multiplier1) + (((chars >> 16) & mask) * multiplier2)) >> 32;
+		return static_cast<std::uint32_t>(chars);
+	}
+
+	/***********************************************************************************/
+	// Appends the digits at p to mantissa while it stays below 10^19, and counts the digits that did not fit
+	const char* readDigits(const char* p, const char* end, std::uint64_t& mantissa, int& numDropped) noexcept
+	{
+		while (end - p >= 8 && mantissa < 100'000'000'000ull)
+		{
+			std::uint64_t chars;
+			std::memcpy(&chars, p, sizeof(chars));
+			if (!isEightDigits(chars))
+			{
+				break;
+			}
+			mantissa = mantissa * 100'000'000ull + parseEightDigits(chars);
+			p += 8;
+		}
+
+		for (; p < end && isDigit(*p); ++p)
+		{
+			if (mantissa < 1'000'000'000'000'000'000ull)
+			{
+				mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+			} else
+			{
+				++numDropped;
+			}
+		}
+		return p;
+	}
+
+	// 10^-64 to 10^64. Up to 19 digits times one of these in double is far more precise than the float result.
+	const auto PowersOfTen{ [] {
+		std::array<double, 129> powers{};
+		for (std::size_t i = 0; i < powers.size(); ++i)
+		{
+			powers[i] = std::pow(10.0, static_cast<double>(i) - 64.0);
+		}
+		return powers;
+	}() };
+
+	/***********************************************************************************/
+	// Decimal number with optional sign, fraction and exponent, without strtof's locale lookups. Returns the end of
+	// the number, or null if there is none at p.
+	const char* parseFloat(const char* p, const char* end, float& value) noexcept
+	{
+		const bool negative{ p < end && *p == '-' };
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			++p;
+		}
+
+		std::uint64_t mantissa{ 0 };
+		int numDropped{ 0 };
+		const auto* integerBegin{ p };
+		p = readDigits(p, end, mantissa, numDropped);
+		auto numDigits{ p - integerBegin };
+		auto exponent{ numDropped };
+
+		if (p < end && *p == '.')
+		{
+			const auto* fractionBegin{ ++p };
+			numDropped = 0;
+			p = readDigits(p, end, mantissa, numDropped);
+			numDigits += p - fractionBegin;
+			exponent -= static_cast<int>(p - fractionBegin) - numDropped;
+		}
+
+		if (numDigits == 0)
+		{
+			return nullptr;
+		}
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const auto* q{ p + 1 };
+			const bool negativeExponent{ q < end && *q == '-' };
+			if (q < end && (*q == '-' || *q == '+'))
+			{
+				++q;
+			}
+			if (q < end && isDigit(*q))
+			{
+				int explicitExponent{ 0 };
+				for (; q < end && isDigit(*q); ++q)
+				{
+					explicitExponent = std::min(explicitExponent * 10 + (*q - '0'), 100000);
+				}
+				exponent += negativeExponent ? -explicitExponent : explicitExponent;
+				p = q;
+			}
+		}
+
+		// Beyond the table the result is below the smallest or above the largest float anyway
+		double magnitude{ 0.0 };
+		if (mantissa != 0 && exponent >= -64)
+		{
+			magnitude = exponent <= 64 ? static_cast<double>(mantissa) * PowersOfTen[exponent + 64] : std::numeric_limits<double>::infinity();
+		}
+		value = static_cast<float>(negative ? -magnitude : magnitude);
+		return p;
+	}
+
+	/***********************************************************************************/
+	// Reads up to count blank separated floats into values, at least required of them
+	bool parseFloats(const char* p, const char* end, float* values, const int count, const int required) noexcept
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			const auto* next{ parseFloat(skipSpaces(p, end), end, values[i]) };
+			if (next == nullptr)
+			{
+				return i >= required;
+			}
+			p = next;
+		}
+		return true;
+	}
+
+	/***********************************************************************************/
+	// A 1-based index, or a negative one relative to the count attributes read so far, to 0-based. Relative ones
+	// are left relative to the chunk's first attribute.
+	const char* parseIndex(const char* p, const char* end, const std::size_t count, std::int32_t& index, bool& relative) noexcept
+	{
+		const bool negative{ p < end && *p == '-' };
+		if (negative)
+		{
+			++p;
+		}
+		if (p == end || !isDigit(*p))
+		{
+			return nullptr;
+		}
+
+		std::int64_t value{ 0 };
+		for (; p < end && isDigit(*p); ++p)
+		{
+			value = std::min(value * 10 + (*p - '0'), MaxIndex + 1);
+		}
+		if (value == 0 || value > MaxIndex)
+		{
+			return nullptr;
+		}
+
+		relative = negative;
+		index = static_cast<std::int32_t>(negative ? static_cast<std::int64_t>(count) - value : value - 1);
+		return p;
+	}
+
+	// Flags of a corner while its polygon is parsed
+	constexpr std::uint8_t RelativePosition{ 1 };
+	constexpr std::uint8_t RelativeTexCoord{ 2 };
+	constexpr std::uint8_t RelativeNormal{ 4 };
+	constexpr std::uint8_t NoNormal{ 8 };
+
+	/***********************************************************************************/
+	// A polygon as corners, fan triangulated
+	bool parseFace(Chunk& chunk, const char* p, const char* end, std::vector<std::pair<Corner, std::uint8_t>>& polygon)
+	{
+		polygon.clear();
+
+		bool flat{ false };
+		for (p = skipSpaces(p, end); p < end && *p != '\r'; p = skipSpaces(p, end))
+		{
+			// Until the flags are applied, a chunk relative index may equal Missing
+			auto& [corner, flags] { polygon.emplace_back(Corner{}, std::uint8_t{ 0 }) };
+			bool isRelative{ false };
+			bool hasNormal{ false };
+
+			p = parseIndex(p, end, chunk.Positions.size(), corner.Position, isRelative);
+			if (p == nullptr)
+			{
+				return false;
+			}
+			flags |= isRelative ? RelativePosition : 0;
+
+			// v, v/vt, v//vn or v/vt/vn
+			if (p < end && *p == '/')
+			{
+				if (++p < end && *p != '/')
+				{
+					p = parseIndex(p, end, chunk.TexCoords.size(), corner.TexCoord, isRelative);
+					if (p == nullptr)
+					{
+						return false;
+					}
+					flags |= isRelative ? RelativeTexCoord : 0;
+				}
+				if (p < end && *p == '/')
+				{
+					hasNormal = true;
+					p = parseIndex(p + 1, end, chunk.Normals.size(), corner.Normal, isRelative);
+					if (p == nullptr)
+					{
+						return false;
+					}
+					flags |= isRelative ? RelativeNormal : 0;
+				}
+			}
+
+			if (p < end && !isSpace(*p) && *p != '\r')
+			{
+				return false;
+			}
+			if (!hasNormal)
+			{
+				flags |= NoNormal;
+				flat = true;
+			}
+		}
+
+		// Faces with one or two corners are points and lines, which the renderer does not draw
+		if (polygon.size() < 3)
+		{
+			return true;
+		}
+
+		if (flat)
+		{
+			const auto polygonIndex{ chunk.NumFlatPolygons++ };
+			for (auto& [corner, flags] : polygon)
+			{
+				if (flags & NoNormal)
+				{
+					corner.Normal = -2 - polygonIndex;
+				}
+			}
+		}
+
+		const auto addCorner{ [&chunk](const std::pair<Corner, std::uint8_t>& corner) {
+			for (std::size_t attribute = 0; attribute < 3; ++attribute)
+			{
+				if (corner.second & (RelativePosition << attribute))
+				{
+					chunk.RelativeIndices.push_back(chunk.Corners.size() * 3 + attribute);
+				}
+			}
+			chunk.Corners.push_back(corner.first);
+		} };
+
+		for (std::size_t i = 2; i < polygon.size(); ++i)
+		{
+			addCorner(polygon[0]);
+			addCorner(polygon[i - 1]);
+			addCorner(polygon[i]);
+		}
+		return true;
+	}
+
+	/***********************************************************************************/
+	bool parseLine(Chunk& chunk, const char* p, const char* end, const bool loadTexCoords, std::vector<std::pair<Corner, std::uint8_t>>& polygon)
+	{
+		p = skipSpaces(p, end);
+		if (end - p < 2)
+		{
+			return true;
+		}
+
+		switch (p[0])
+		{
+		case 'v':
+			if (isSpace(p[1]))
+			{
+				auto& position{ chunk.Positions.emplace_back(0.0f) };
+				return parseFloats(p + 2, end, &position.x, 3, 3);
+			}
+			if (end - p > 2 && p[1] == 't' && isSpace(p[2]))
+			{
+				// Only the count matters without materials
+				auto& texCoord{ chunk.TexCoords.emplace_back(0.0f) };
+				return !loadTexCoords || parseFloats(p + 3, end, &texCoord.x, 2, 1);
+			}
+			if (end - p > 2 && p[1] == 'n' && isSpace(p[2]))
+			{
+				auto& normal{ chunk.Normals.emplace_back(0.0f) };
+				return parseFloats(p + 3, end, &normal.x, 3, 3);
+			}
+			return true;
+		case 'f':
+			return !isSpace(p[1]) || parseFace(chunk, p + 2, end, polygon);
+		case 'u':
+			if (const auto name{ readKeyword(p, end, "usemtl") })
+			{
+				chunk.MaterialSwitches.push_back({ chunk.Corners.size(), *name });
+			}
+			return true;
+		case 'm':
+			if (const auto library{ readKeyword(p, end, "mtllib") })
+			{
+				chunk.Libraries.push_back(*library);
+			}
+			return true;
+		default:
+			// Comments, objects, groups, smoothing groups, lines, points and free-form geometry
+			return true;
+		}
+	}
+
+	/***********************************************************************************/
+	void parseChunk(Chunk& chunk, const bool loadTexCoords)
+	{
+		std::vector<std::pair<Corner, std::uint8_t>> polygon;
+		for (const auto* line = chunk.Begin; line < chunk.End;)
+		{
+			const auto* newline{ static_cast<const char*>(std::memchr(line, '\n', static_cast<std::size_t>(chunk.End - line))) };
+			const auto* lineEnd{ newline ? newline : chunk.End };
+			if (!parseLine(chunk, line, lineEnd, loadTexCoords, polygon))
+			{
+				chunk.Error = line;
+				return;
+			}
+			line = newline ? newline + 1 : chunk.End;
+		}
+	}
+
+	/***********************************************************************************/
+	// Chunks of about equal size that start at the beginning of a line
+	std::vector<Chunk> splitIntoChunks(const char* data, const std::size_t size)
+	{
+		const auto numThreads{ ThreadPool::GetInstance().GetNumThreads() };
+		const auto chunkSize{ std::max(MinChunkSize, size / (numThreads * ChunksPerThread) + 1) };
+
+		std::vector<Chunk> chunks;
+		for (const auto* begin = data; begin < data + size;)
+		{
+			const auto* end{ data + size };
+			if (static_cast<std::size_t>(end - begin) > chunkSize)
+			{
+				const auto* newline{ static_cast<const char*>(std::memchr(begin + chunkSize, '\n', static_cast<std::size_t>(end - begin) - chunkSize)) };
+				end = newline ? newline + 1 : end;
+			}
+
+			auto& chunk{ chunks.emplace_back() };
+			chunk.Begin = begin;
+			chunk.End = end;
+			begin = end;
+		}
+		return chunks;
+	}
+
+	/***********************************************************************************/
+	// Numbers the attributes of all chunks through the file and resolves the indices that were chunk relative.
+	// Fails if an index points before the start of the file or the file has more attributes than indices can hold.
+	bool mergeChunks(std::vector<Chunk>& chunks, Attributes& attributes)
+	{
+		std::size_t numPositions{ 0 }, numTexCoords{ 0 }, numNormals{ 0 }, numFlatPolygons{ 0 };
+		for (auto& chunk : chunks)
+		{
+			chunk.FirstPosition = numPositions;
+			chunk.FirstTexCoord = numTexCoords;
+			chunk.FirstNormal = numNormals;
+			chunk.FirstFlatPolygon = numFlatPolygons;
+			numPositions += chunk.Positions.size();
+			numTexCoords += chunk.TexCoords.size();
+			numNormals += chunk.Normals.size();
+			numFlatPolygons += static_cast<std::size_t>(chunk.NumFlatPolygons);
+		}
+
+		const auto maxCount{ static_cast<std::size_t>(MaxIndex) };
+		if (numPositions > maxCount || numTexCoords > maxCount || numNormals > maxCount || numFlatPolygons > maxCount - 2)
+		{
+			return false;
+		}
+
+		attributes.Positions.resize(numPositions);
+		attributes.TexCoords.resize(numTexCoords);
+		attributes.Normals.resize(numNormals);
+
+		std::atomic<bool> valid{ true };
+		ThreadPool::GetInstance().ParallelFor(chunks.size(), 1, [&](const std::size_t begin, const std::size_t end) {
+			for (auto i = begin; i < end; ++i)
+			{
+				auto& chunk{ chunks[i] };
+
+				std::copy(chunk.Positions.cbegin(), chunk.Positions.cend(), attributes.Positions.begin() + chunk.FirstPosition);
+				std::copy(chunk.TexCoords.cbegin(), chunk.TexCoords.cend(), attributes.TexCoords.begin() + chunk.FirstTexCoord);
+				std::copy(chunk.Normals.cbegin(), chunk.Normals.cend(), attributes.Normals.begin() + chunk.FirstNormal);
+				std::vector<glm::vec3>().swap(chunk.Positions);
+				std::vector<glm::vec2>().swap(chunk.TexCoords);
+				std::vector<glm::vec3>().swap(chunk.Normals);
+
+				const std::array<std::int64_t, 3> firsts{ static_cast<std::int64_t>(chunk.FirstPosition),
+					static_cast<std::int64_t>(chunk.FirstTexCoord), static_cast<std::int64_t>(chunk.FirstNormal) };
+				for (const auto entry : chunk.RelativeIndices)
+				{
+					auto& corner{ chunk.Corners[entry / 3] };
+					auto& index{ entry % 3 == 0 ? corner.Position : entry % 3 == 1 ? corner.TexCoord : corner.Normal };
+					const auto resolved{ index + firsts[entry % 3] };
+					if (resolved < 0)
+					{
+						valid = false;
+						return;
+					}
+					index = static_cast<std::int32_t>(resolved);
+				}
+
+				if (chunk.NumFlatPolygons > 0 && chunk.FirstFlatPolygon > 0)
+				{
+					const auto firstFlatPolygon{ static_cast<std::int32_t>(chunk.FirstFlatPolygon) };
+					for (auto& corner : chunk.Corners)
+					{
+						if (corner.Normal < Missing)
+						{
+							corner.Normal -= firstFlatPolygon;
+						}
+					}
+				}
+			}
+		});
+		return valid;
+	}
+
+	/***********************************************************************************/
+	// Faces of each usemtl name, in the order the names are first used
+	std::vector<Group> groupByMaterial(const std::vector<Chunk>& chunks)
+	{
+		std::vector<Group> groups;
+		std::unordered_map<std::string_view, std::size_t> groupIndices;
+
+		std::string_view material;
+		const auto addRun{ [&](const Chunk& chunk, const std::size_t begin, const std::size_t end) {
+			if (begin == end)
+			{
+				return;
+			}
+
+			const auto [it, inserted] { groupIndices.try_emplace(material, groups.size()) };
+			if (inserted)
+			{
+				groups.emplace_back().MaterialName = material;
+			}
+
+			auto& group{ groups[it->second] };
+			group.Runs.push_back({ &chunk, begin, end });
+			group.NumCorners += end - begin;
+		} };
+
+		for (const auto& chunk : chunks)
+		{
+			std::size_t begin{ 0 };
+			for (const auto& materialSwitch : chunk.MaterialSwitches)
+			{
+				addRun(chunk, begin, materialSwitch.Corner);
+				begin = materialSwitch.Corner;
+				material = materialSwitch.Name;
+			}
+			addRun(chunk, begin, chunk.Corners.size());
+		}
+		return groups;
+	}
+
+	/***********************************************************************************/
+	// MurmurHash3's 64 bit finalizer over the packed indices. Corners next to each other in the file have
+	// neighbouring indices, which this spreads over the whole table.
+	std::uint64_t hashCorner(const Corner& corner) noexcept
+	{
+		auto hash{ ((static_cast<std::uint64_t>(static_cast<std::uint32_t>(corner.Position)) << 32) | static_cast<std::uint32_t>(corner.TexCoord)) ^
+			(static_cast<std::uint64_t>(static_cast<std::uint32_t>(corner.Normal)) * 0x9E3779B97F4A7C15ull) };
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	// Open addressing map from the attribute indices of a corner to its welded vertex
+	class VertexTable {
+	public:
+		explicit VertexTable(const std::size_t expectedSize)
+		{
+			std::size_t capacity{ 64 };
+			while (capacity < expectedSize * 2)
+			{
+				capacity *= 2;
+			}
+			m_entries.resize(capacity);
+		}
+
+		// The vertex of corner, or newVertex if the corner is new. The second member is true if it was added.
+		std::pair<GLuint, bool> Insert(const Corner& corner, const GLuint newVertex)
+		{
+			if ((m_size + 1) * 2 > m_entries.size())
+			{
+				grow();
+			}
+
+			const auto mask{ m_entries.size() - 1 };
+			for (auto slot = hashCorner(corner) & mask;; slot = (slot + 1) & mask)
+			{
+				auto& entry{ m_entries[slot] };
+				if (entry.Key.Position == Missing)
+				{
+					entry.Key = corner;
+					entry.Vertex = newVertex;
+					++m_size;
+					return { newVertex, true };
+				}
+				if (entry.Key == corner)
+				{
+					return { entry.Vertex, false };
+				}
+			}
+		}
+
+	private:
+		struct Entry {
+			// Position is Missing in empty slots
+			Corner Key;
+			GLuint Vertex{ 0 };
+		};
+
+		void grow()
+		{
+			std::vector<Entry> entries(m_entries.size() * 2);
+			std::swap(entries, m_entries);
+
+			const auto mask{ m_entries.size() - 1 };
+			for (const auto& entry : entries)
+			{
+				if (entry.Key.Position == Missing)
+				{
+					continue;
+				}
+
+				auto slot{ hashCorner(entry.Key) & mask };
+				while (m_entries[slot].Key.Position != Missing)
+				{
+					slot = (slot + 1) & mask;
+				}
+				m_entries[slot] = entry;
+			}
+		}
+
+		std::vector<Entry> m_entries;
+		std::size_t m_size{ 0 };
+	};
+
+	/***********************************************************************************/
+	// Welds the corners of a group into vertices. Fails on indices past the end of their attribute.
+	bool buildMesh(const Group& group, const Attributes& attributes, const Graphics::OBJLoadOptions& options, Graphics::OBJMesh& mesh)
+	{
+		const auto numPositions{ attributes.Positions.size() };
+		const auto numTexCoords{ attributes.TexCoords.size() };
+		const auto numNormals{ attributes.Normals.size() };
+
+		// Smooth meshes have about one vertex per four to six corners
+		VertexTable table(group.NumCorners / 4);
+		mesh.Indices.reserve(group.NumCorners);
+		mesh.Vertices.reserve(group.NumCorners / 4);
+
+		bool hasTexCoords{ false };
+		for (const auto& run : group.Runs)
+		{
+			for (auto i = run.Begin; i < run.End; i += 3)
+			{
+				const auto* triangle{ &run.Source->Corners[i] };
+
+				bool flat{ false };
+				for (std::size_t j = 0; j < 3; ++j)
+				{
+					const auto& corner{ triangle[j] };
+					if (static_cast<std::size_t>(corner.Position) >= numPositions ||
+						(corner.TexCoord != Missing && static_cast<std::size_t>(corner.TexCoord) >= numTexCoords) ||
+						(corner.Normal >= 0 && static_cast<std::size_t>(corner.Normal) >= numNormals))
+					{
+						return false;
+					}
+					flat |= corner.Normal < Missing;
+				}
+
+				// In the file's counter-clockwise winding, so it faces outwards
+				glm::vec3 flatNormal{ 0.0f, 1.0f, 0.0f };
+				if (flat)
+				{
+					const auto& a{ attributes.Positions[triangle[0].Position] };
+					const auto normal{ glm::cross(attributes.Positions[triangle[1].Position] - a, attributes.Positions[triangle[2].Position] - a) };
+					const auto length{ glm::length(normal) };
+					flatNormal = length > 0.0f ? normal / length : flatNormal;
+				}
+
+				for (std::size_t j = 0; j < 3; ++j)
+				{
+					auto key{ triangle[j] };
+					if (!options.LoadMaterials)
+					{
+						key.TexCoord = Missing;
+					}
+
+					const auto [index, added] { table.Insert(key, static_cast<GLuint>(mesh.Vertices.size())) };
+					if (added)
+					{
+						auto& vertex{ mesh.Vertices.emplace_back() };
+						vertex.Position = attributes.Positions[key.Position];
+						vertex.Normal = key.Normal >= 0 ? attributes.Normals[key.Normal] : flatNormal;
+						vertex.Tangent = glm::vec3(0.0f);
+						if (key.TexCoord != Missing)
+						{
+							const auto& texCoord{ attributes.TexCoords[key.TexCoord] };
+							vertex.TexCoords = glm::vec2(texCoord.x, 1.0f - texCoord.y);
+							hasTexCoords = true;
+						} else
+						{
+							vertex.TexCoords = glm::vec2(0.0f);
+						}
+					}
+					mesh.Indices.push_back(index);
+				}
+			}
+		}
+
+		if (hasTexCoords)
+		{
+			Graphics::GenerateTangents(mesh.Vertices, mesh.Indices);
+		}
+
+		if (options.FlipWindingOrder)
+		{
+			for (std::size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+			{
+				std::swap(mesh.Indices[i + 1], mesh.Indices[i + 2]);
+			}
+		}
+
+		if (!mesh.Vertices.empty())
+		{
+			mesh.Min = mesh.Max = mesh.Vertices[0].Position;
+			for (const auto& vertex : mesh.Vertices)
+			{
+				mesh.Min = glm::min(mesh.Min, vertex.Position);
+				mesh.Max = glm::max(mesh.Max, vertex.Position);
+			}
+		}
+		return true;
+	}
+
+	/***********************************************************************************/
+	// The file name of a map_ statement, after its options
+	std::string readTexturePath(std::string_view arguments)
+	{
+		// Options and the number of values they take at most
+		constexpr std::array<std::pair<std::string_view, int>, 13> options{ {
+			{ "-blendu", 1 }, { "-blendv", 1 }, { "-bm", 1 }, { "-boost", 1 }, { "-cc", 1 }, { "-clamp", 1 }, { "-imfchan", 1 },
+			{ "-mm", 2 }, { "-o", 3 }, { "-s", 3 }, { "-t", 3 }, { "-texres", 1 }, { "-type", 1 } } };
+
+		const auto nextToken{ [&arguments] {
+			const auto begin{ arguments.find_first_not_of(" \t") };
+			arguments.remove_prefix(std::min(begin, arguments.size()));
+			const auto token{ arguments.substr(0, arguments.find_first_of(" \t")) };
+			return token;
+		} };
+
+		for (auto token = nextToken(); !token.empty() && token[0] == '-'; token = nextToken())
+		{
+			const auto option{ std::find_if(options.cbegin(), options.cend(), [token](const auto& entry) { return entry.first == token; }) };
+			arguments.remove_prefix(token.size());
+			if (option == options.cend())
+			{
+				continue;
+			}
+
+			// The values of -o, -s and -t after the first are optional
+			for (int i = 0; i < option->second; ++i)
+			{
+				const auto value{ nextToken() };
+				float number;
+				if (value.empty() || (i > 0 && parseFloat(value.data(), value.data() + value.size(), number) != value.data() + value.size()))
+				{
+					break;
+				}
+				arguments.remove_prefix(value.size());
+			}
+		}
+
+		return std::string(arguments);
+	}
+
+	// The texture each map_ statement sets. Later statements for the same texture replace earlier ones.
+	constexpr std::array<std::pair<std::string_view, std::string Graphics::OBJMaterial::*>, 7> TextureStatements{ {
+		{ "map_Kd", &Graphics::OBJMaterial::Diffuse },
+		{ "map_Ka", &Graphics::OBJMaterial::Ambient },
+		{ "map_bump", &Graphics::OBJMaterial::Bump },
+		{ "map_Bump", &Graphics::OBJMaterial::Bump },
+		{ "bump", &Graphics::OBJMaterial::Bump },
+		{ "map_Ns", &Graphics::OBJMaterial::Shininess },
+		{ "map_d", &Graphics::OBJMaterial::Opacity } } };
+
+	/***********************************************************************************/
+	// Adds the materials of an .mtl file, keeping the first definition of each name
+	void readMaterialLibrary(const std::filesystem::path& path, std::vector<Graphics::OBJMaterial>& materials, std::unordered_map<std::string, std::size_t>& materialIndices)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			std::cerr << "OBJ Warning: Material library " << path.string() << " not found\n";
+			return;
+		}
+
+		Graphics::OBJMaterial* material{ nullptr };
+		std::string line;
+		while (std::getline(file, line))
+		{
+			const auto* begin{ line.data() };
+			const auto* end{ line.data() + line.size() };
+			begin = skipSpaces(begin, end);
+
+			if (const auto name{ readKeyword(begin, end, "newmtl") })
+			{
+				const auto [it, inserted] { materialIndices.try_emplace(std::string(*name), materials.size()) };
+				material = inserted ? &materials.emplace_back() : nullptr;
+				if (material)
+				{
+					material->Name = *name;
+				}
+				continue;
+			}
+
+			if (material == nullptr)
+			{
+				continue;
+			}
+
+			for (const auto& [keyword, texture] : TextureStatements)
+			{
+				if (const auto arguments{ readKeyword(begin, end, keyword) })
+				{
+					(*material).*texture = readTexturePath(*arguments);
+					break;
+				}
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	std::size_t lineNumber(const char* data, const char* position)
+	{
+		return 1 + static_cast<std::size_t>(std::count(data, position, '\n'));
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	std::optional<OBJModel> LoadOBJ(const std::filesystem::path& path, const OBJLoadOptions& options)
+	{
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			return std::nullopt;
+		}
+
+		const auto* data{ reinterpret_cast<const char*>(file.GetData()) };
+		auto chunks{ splitIntoChunks(data, file.GetSize()) };
+
+		auto& threadPool{ ThreadPool::GetInstance() };
+		threadPool.ParallelFor(chunks.size(), 1, [&chunks, &options](const std::size_t begin, const std::size_t end) {
+			for (auto i = begin; i < end; ++i)
+			{
+				parseChunk(chunks[i], options.LoadMaterials);
+			}
+		});
+
+		for (const auto& chunk : chunks)
+		{
+			if (chunk.Error != nullptr)
+			{
+				reportError(path, fmt::format("Malformed line {}", lineNumber(data, chunk.Error)));
+				return std::nullopt;
+			}
+		}
+
+		Attributes attributes;
+		if (!mergeChunks(chunks, attributes))
+		{
+			reportError(path, "Face index out of range");
+			return std::nullopt;
+		}
+
+		OBJModel model;
+		std::unordered_map<std::string, std::size_t> materialIndices;
+		if (options.LoadMaterials)
+		{
+			std::vector<std::string_view> libraries;
+			for (const auto& chunk : chunks)
+			{
+				for (const auto library : chunk.Libraries)
+				{
+					if (std::find(libraries.cbegin(), libraries.cend(), library) == libraries.cend())
+					{
+						libraries.push_back(library);
+						readMaterialLibrary(path.parent_path() / library, model.Materials, materialIndices);
+					}
+				}
+			}
+		}
+
+		const auto groups{ groupByMaterial(chunks) };
+		std::vector<OBJMesh> meshes(groups.size());
+		std::atomic<bool> valid{ true };
+		threadPool.ParallelFor(groups.size(), 1, [&](const std::size_t begin, const std::size_t end) {
+			for (auto i = begin; i < end; ++i)
+			{
+				if (!buildMesh(groups[i], attributes, options, meshes[i]))
+				{
+					valid = false;
+				}
+			}
+		});
+
+		if (!valid)
+		{
+			reportError(path, "Face index out of range");
+			return std::nullopt;
+		}
+
+		// Only the materials the meshes use are returned, in the order of the meshes
+		std::vector<OBJMaterial> materials;
+		std::vector<int> usedMaterials(model.Materials.size() + 1, -1);
+		for (std::size_t i = 0; i < groups.size(); ++i)
+		{
+			if (options.LoadMaterials)
+			{
+				const auto it{ materialIndices.find(std::string(groups[i].MaterialName)) };
+				const auto index{ it != materialIndices.cend() ? it->second : model.Materials.size() };
+				if (usedMaterials[index] == -1)
+				{
+					usedMaterials[index] = static_cast<int>(materials.size());
+					if (index < model.Materials.size())
+					{
+						materials.push_back(std::move(model.Materials[index]));
+					} else
+					{
+						OBJMaterial material;
+						material.Name = DefaultMaterialName;
+						materials.push_back(std::move(material));
+					}
+				}
+				meshes[i].Material = usedMaterials[index];
+			}
+			model.Meshes.push_back(std::move(meshes[i]));
+		}
+		model.Materials = std::move(materials);
+
+		return model;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../Vertex.h"
+
+#include <glad/glad.h>
+#include <glm/vec3.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Native reader for Wavefront OBJ models and their .mtl materials. The file is mapped and cut into line aligned
+// chunks that are parsed on the ThreadPool, then the faces of each material are welded into indexed triangles in
+// parallel. Reads what the Assimp path of Model keeps: v, vt, vn, polygonal f (fan triangulated), usemtl and
+// mtllib. Lines, points, groups and smoothing groups are skipped.
+namespace Graphics
+{
+	struct OBJMaterial {
+		std::string Name;
+		// Texture paths as written in the .mtl, relative to the model folder, empty for none
+		std::string Diffuse;	// map_Kd
+		std::string Ambient;	// map_Ka
+		std::string Bump;		// map_bump or bump
+		std::string Shininess;	// map_Ns
+		std::string Opacity;	// map_d
+	};
+
+	// The faces of one material
+	struct OBJMesh {
+		std::vector<Vertex> Vertices;
+		std::vector<GLuint> Indices;
+		glm::vec3 Min{ 0.0f };
+		glm::vec3 Max{ 0.0f };
+		// Index into OBJModel::Materials, -1 if materials were not loaded
+		int Material{ -1 };
+	};
+
+	struct OBJModel {
+		// In the order the file first uses their materials
+		std::vector<OBJMesh> Meshes;
+		std::vector<OBJMaterial> Materials;
+	};
+
+	struct OBJLoadOptions {
+		// Reverses every triangle, as aiProcess_FlipWindingOrder does
+		bool FlipWindingOrder{ false };
+		// Without, texture coordinates stay 0 and no .mtl files are read
+		bool LoadMaterials{ true };
+	};
+
+	// Texture coordinates are flipped to V down, as the Assimp path does with aiProcess_FlipUVs. Faces without
+	// normals get flat ones, faces without a known material use one named DefaultMaterial. Empty if the file cannot
+	// be read or is malformed.
+	std::optional<OBJModel> LoadOBJ(const std::filesystem::path& path, const OBJLoadOptions& options = {});
+}
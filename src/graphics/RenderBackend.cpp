@@ -0,0 +1,215 @@
+#include "RenderBackend.h"
+
+namespace
+{
+	/***********************************************************************************/
+	template<typename T>
+	const T& as(const Graphics::RenderCommand& command) noexcept
+	{
+		return static_cast<const T&>(command);
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	void GLRenderBackend::Execute(const CommandBuffer& commands)
+	{
+		constexpr auto unknown{ ~0u };
+		m_program = unknown;
+		m_vertexArray = unknown;
+		m_activeUnit = unknown;
+		m_textures.fill(unknown);
+
+		const auto bindVertexArray = [this](const GLuint vertexArray) {
+			if (vertexArray == m_vertexArray)
+			{
+				++m_numSkippedBinds;
+				return;
+			}
+			glBindVertexArray(vertexArray);
+			m_vertexArray = vertexArray;
+		};
+
+		commands.ForEach([&](const RenderCommand& command) {
+			switch (command.Type)
+			{
+			case RenderCommandType::BindProgram:
+			{
+				const auto& bind{ as<Commands::BindProgram>(command) };
+				if (bind.Program == m_program)
+				{
+					++m_numSkippedBinds;
+					break;
+				}
+				glUseProgram(bind.Program);
+				m_program = bind.Program;
+				break;
+			}
+			case RenderCommandType::BindTexture:
+			{
+				const auto& bind{ as<Commands::BindTexture>(command) };
+				const auto tracked{ bind.Unit < NumTrackedUnits };
+				if (tracked && m_textures[bind.Unit] == bind.Texture)
+				{
+					++m_numSkippedBinds;
+					break;
+				}
+				if (bind.Unit != m_activeUnit)
+				{
+					glActiveTexture(GL_TEXTURE0 + bind.Unit);
+					m_activeUnit = bind.Unit;
+				}
+				glBindTexture(bind.Target, bind.Texture);
+				if (tracked)
+				{
+					m_textures[bind.Unit] = bind.Texture;
+				}
+				break;
+			}
+			case RenderCommandType::UniformInt:
+			{
+				const auto& uniform{ as<Commands::UniformInt>(command) };
+				glUniform1i(uniform.Location, uniform.Value);
+				break;
+			}
+			case RenderCommandType::UniformFloat:
+			{
+				const auto& uniform{ as<Commands::UniformFloat>(command) };
+				glUniform1f(uniform.Location, uniform.Value);
+				break;
+			}
+			case RenderCommandType::UniformVec3:
+			{
+				const auto& uniform{ as<Commands::UniformVec3>(command) };
+				glUniform3f(uniform.Location, uniform.Value.x, uniform.Value.y, uniform.Value.z);
+				break;
+			}
+			case RenderCommandType::UniformMat4:
+			{
+				const auto& uniform{ as<Commands::UniformMat4>(command) };
+				glUniformMatrix4fv(uniform.Location, 1, GL_FALSE, &uniform.Value[0][0]);
+				break;
+			}
+			case RenderCommandType::DrawElements:
+			{
+				const auto& draw{ as<Commands::DrawElements>(command) };
+				bindVertexArray(draw.VertexArray);
+				glDrawElements(draw.Mode, draw.Count, GL_UNSIGNED_INT, reinterpret_cast<const void*>(draw.First * sizeof(GLuint)));
+				break;
+			}
+			case RenderCommandType::MultiDrawElements:
+			{
+				const auto& draw{ as<Commands::MultiDrawElements>(command) };
+				const auto* ranges{ draw.GetRanges() };
+				m_multiDrawCounts.resize(draw.DrawCount);
+				m_multiDrawOffsets.resize(draw.DrawCount);
+				for (GLsizei i = 0; i < draw.DrawCount; ++i)
+				{
+					m_multiDrawCounts[i] = ranges[i].Count;
+					m_multiDrawOffsets[i] = reinterpret_cast<const void*>(ranges[i].First * sizeof(GLuint));
+				}
+				bindVertexArray(draw.VertexArray);
+				glMultiDrawElements(draw.Mode, m_multiDrawCounts.data(), GL_UNSIGNED_INT, m_multiDrawOffsets.data(), draw.DrawCount);
+				break;
+			}
+			case RenderCommandType::DrawArrays:
+			{
+				const auto& draw{ as<Commands::DrawArrays>(command) };
+				bindVertexArray(draw.VertexArray);
+				glDrawArrays(draw.Mode, draw.First, draw.Count);
+				break;
+			}
+			default:
+				break;
+			}
+		});
+	}
+
+	/***********************************************************************************/
+	GLsync GLRenderBackend::InsertFence()
+	{
+		return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	/***********************************************************************************/
+	void GLRenderBackend::WaitFence(const GLsync fence)
+	{
+		if (fence == nullptr)
+		{
+			return;
+		}
+
+		// The first wait flushes, so the fence is sure to reach the GPU
+		constexpr GLuint64 timeout{ 1'000'000'000 };
+		auto flags{ GL_SYNC_FLUSH_COMMANDS_BIT };
+		for (;;)
+		{
+			const auto result{ glClientWaitSync(fence, flags, timeout) };
+			if (result != GL_TIMEOUT_EXPIRED)
+			{
+				break;
+			}
+			flags = 0;
+		}
+		glDeleteSync(fence);
+	}
+
+	/***********************************************************************************/
+	void NullRenderBackend::Execute(const CommandBuffer& commands)
+	{
+		commands.ForEach([this](const RenderCommand& command) {
+			++m_stats.Commands;
+			++m_stats.CommandsPerType[static_cast<std::size_t>(command.Type)];
+
+			switch (command.Type)
+			{
+			case RenderCommandType::UniformInt:
+				m_stats.Checksum += as<Commands::UniformInt>(command).Value;
+				break;
+			case RenderCommandType::UniformFloat:
+				m_stats.Checksum += as<Commands::UniformFloat>(command).Value;
+				break;
+			case RenderCommandType::UniformVec3:
+			{
+				const auto& value{ as<Commands::UniformVec3>(command).Value };
+				m_stats.Checksum += value.x + value.y + value.z;
+				break;
+			}
+			case RenderCommandType::UniformMat4:
+			{
+				const auto& value{ as<Commands::UniformMat4>(command).Value };
+				m_stats.Checksum += value[3][0] + value[3][1] + value[3][2];
+				break;
+			}
+			case RenderCommandType::DrawElements:
+				++m_stats.DrawCalls;
+				m_stats.Elements += as<Commands::DrawElements>(command).Count;
+				break;
+			case RenderCommandType::MultiDrawElements:
+			{
+				const auto& draw{ as<Commands::MultiDrawElements>(command) };
+				++m_stats.DrawCalls;
+				for (GLsizei i = 0; i < draw.DrawCount; ++i)
+				{
+					m_stats.Elements += draw.GetRanges()[i].Count;
+				}
+				break;
+			}
+			case RenderCommandType::DrawArrays:
+				++m_stats.DrawCalls;
+				m_stats.Elements += as<Commands::DrawArrays>(command).Count;
+				break;
+			default:
+				break;
+			}
+		});
+	}
+
+	/***********************************************************************************/
+	GLsync NullRenderBackend::InsertFence()
+	{
+		++m_stats.Frames;
+		return nullptr;
+	}
+}
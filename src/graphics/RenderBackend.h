@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CommandBuffer.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace Graphics
+{
+	// Replays recorded commands. Lives on the thread that owns the OpenGL context, or anywhere for the null
+	// backend.
+	class RenderBackend {
+	public:
+		virtual ~RenderBackend() = default;
+
+		virtual void Execute(const CommandBuffer& commands) = 0;
+
+		// Marks the end of a frame's commands. The returned fence (may be null) signals once the GPU finished them.
+		virtual GLsync InsertFence() = 0;
+		// Blocks until fence signaled and releases it. Null fences return right away.
+		virtual void WaitFence(const GLsync fence) = 0;
+	};
+
+	// Executes commands with OpenGL, skipping program, texture and vertex array binds that would not change
+	// anything. The bindings are assumed unknown at the start of every Execute, other code may have changed them.
+	class GLRenderBackend final : public RenderBackend {
+	public:
+		void Execute(const CommandBuffer& commands) override;
+		GLsync InsertFence() override;
+		void WaitFence(const GLsync fence) override;
+
+		// Binds Execute skipped since the backend was created
+		auto GetNumSkippedBinds() const noexcept { return m_numSkippedBinds; }
+
+	private:
+		static constexpr std::size_t NumTrackedUnits{ 16 };
+
+		GLuint m_program{ 0 };
+		GLuint m_vertexArray{ 0 };
+		GLuint m_activeUnit{ 0 };
+		std::array<GLuint, NumTrackedUnits> m_textures{};
+		std::size_t m_numSkippedBinds{ 0 };
+		// Arguments of glMultiDrawElements, kept to not allocate every frame
+		std::vector<GLsizei> m_multiDrawCounts;
+		std::vector<const void*> m_multiDrawOffsets;
+	};
+
+	// Does everything but call OpenGL: walks the commands and counts them, so recording, submission and pacing
+	// can be benchmarked and checked without a context.
+	class NullRenderBackend final : public RenderBackend {
+	public:
+		struct Stats {
+			std::size_t Frames{ 0 };
+			std::size_t Commands{ 0 };
+			// A multi draw counts once
+			std::size_t DrawCalls{ 0 };
+			// Indices or vertices drawn
+			std::size_t Elements{ 0 };
+			std::array<std::size_t, static_cast<std::size_t>(RenderCommandType::Count)> CommandsPerType{};
+			// Sum over the replayed uniform values, compares two replays of the same frames
+			double Checksum{ 0.0 };
+		};
+
+		void Execute(const CommandBuffer& commands) override;
+		GLsync InsertFence() override;
+		void WaitFence(const GLsync) override {}
+
+		const auto& GetStats() const noexcept { return m_stats; }
+		void ResetStats() noexcept { m_stats = {}; }
+
+	private:
+		Stats m_stats;
+	};
+}
@@ -0,0 +1,444 @@
+#include "RenderGraph.h"
+
+#include "TransientTexturePool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	/***********************************************************************************/
+	std::size_t getTextureSize(const Graphics::RenderGraphTextureDesc& desc) noexcept
+	{
+		return static_cast<std::size_t>(desc.Width) * static_cast<std::size_t>(desc.Height) * Graphics::GetTexelSize(desc.Format);
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	std::size_t GetTexelSize(const GLenum format) noexcept
+	{
+		switch (format)
+		{
+		case GL_R8:
+		case GL_R8_SNORM:
+		case GL_R8UI:
+		case GL_R8I:
+		case GL_RED:
+		case GL_STENCIL_INDEX8:
+			return 1;
+		case GL_RG8:
+		case GL_RG8_SNORM:
+		case GL_RG8UI:
+		case GL_RG8I:
+		case GL_RG:
+		case GL_R16:
+		case GL_R16_SNORM:
+		case GL_R16F:
+		case GL_R16UI:
+		case GL_R16I:
+		case GL_RGB565:
+		case GL_RGB5_A1:
+		case GL_RGBA4:
+		case GL_DEPTH_COMPONENT16:
+			return 2;
+		// Drivers pad three channel formats to four, unsized formats get 8 bits a channel
+		case GL_RGB8:
+		case GL_RGB8_SNORM:
+		case GL_RGB8UI:
+		case GL_RGB8I:
+		case GL_SRGB8:
+		case GL_RGB:
+		case GL_RGBA8:
+		case GL_RGBA8_SNORM:
+		case GL_RGBA8UI:
+		case GL_RGBA8I:
+		case GL_SRGB8_ALPHA8:
+		case GL_RGBA:
+		case GL_RGB10_A2:
+		case GL_RGB10_A2UI:
+		case GL_R11F_G11F_B10F:
+		case GL_RGB9_E5:
+		case GL_RG16:
+		case GL_RG16_SNORM:
+		case GL_RG16F:
+		case GL_RG16UI:
+		case GL_RG16I:
+		case GL_R32F:
+		case GL_R32UI:
+		case GL_R32I:
+		case GL_DEPTH_COMPONENT24:
+		case GL_DEPTH_COMPONENT32:
+		case GL_DEPTH_COMPONENT32F:
+		case GL_DEPTH_COMPONENT:
+		case GL_DEPTH24_STENCIL8:
+		case GL_DEPTH_STENCIL:
+			return 4;
+		case GL_RGB16:
+		case GL_RGB16_SNORM:
+		case GL_RGB16F:
+		case GL_RGB16UI:
+		case GL_RGB16I:
+		case GL_RGBA16:
+		case GL_RGBA16_SNORM:
+		case GL_RGBA16F:
+		case GL_RGBA16UI:
+		case GL_RGBA16I:
+		case GL_RG32F:
+		case GL_RG32UI:
+		case GL_RG32I:
+		case GL_DEPTH32F_STENCIL8:
+			return 8;
+		case GL_RGB32F:
+		case GL_RGB32UI:
+		case GL_RGB32I:
+		case GL_RGBA32F:
+		case GL_RGBA32UI:
+		case GL_RGBA32I:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	/***********************************************************************************/
+	bool IsDepthFormat(const GLenum format) noexcept
+	{
+		switch (format)
+		{
+		case GL_DEPTH_COMPONENT16:
+		case GL_DEPTH_COMPONENT24:
+		case GL_DEPTH_COMPONENT32:
+		case GL_DEPTH_COMPONENT32F:
+		case GL_DEPTH24_STENCIL8:
+		case GL_DEPTH32F_STENCIL8:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	/***********************************************************************************/
+	RenderGraph::ResourceHandle RenderGraph::PassBuilder::Create(const std::string_view name, const RenderGraphTextureDesc& desc)
+	{
+		const auto resource{ m_graph.addResource(name, ResourceType::Transient, desc, 0) };
+		Write(resource);
+		return resource;
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::PassBuilder::Read(const ResourceHandle resource)
+	{
+		if (resource >= m_graph.m_resources.size())
+		{
+			std::cerr << "RenderGraph Error: Pass " << m_graph.m_passes[m_pass].Name << " reads an invalid resource\n";
+			return;
+		}
+		m_graph.m_passes[m_pass].Reads.push_back(resource);
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::PassBuilder::Write(const ResourceHandle resource)
+	{
+		if (resource >= m_graph.m_resources.size())
+		{
+			std::cerr << "RenderGraph Error: Pass " << m_graph.m_passes[m_pass].Name << " writes an invalid resource\n";
+			return;
+		}
+		m_graph.m_passes[m_pass].Writes.push_back(resource);
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::PassBuilder::SetSideEffect() noexcept
+	{
+		m_graph.m_passes[m_pass].SideEffect = true;
+	}
+
+	/***********************************************************************************/
+	GLuint RenderGraph::PassResources::GetTexture(const ResourceHandle resource) const
+	{
+		if (resource >= m_graph.m_resources.size() || m_graph.m_resources[resource].Type == ResourceType::ImportedFramebuffer)
+		{
+			return 0;
+		}
+		return m_graph.m_resources[resource].Object;
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::Reset(const GLsizei width, const GLsizei height)
+	{
+		m_width = width;
+		m_height = height;
+
+		// Declaring the same passes every frame then allocates nothing
+		for (auto& pass : m_passes)
+		{
+			pass.Reads.clear();
+			pass.Writes.clear();
+			m_freePasses.push_back(std::move(pass));
+		}
+		m_passes.clear();
+		m_callables.Reset();
+		m_resources.clear();
+		m_physicalTextures.clear();
+		m_stats = {};
+	}
+
+	/***********************************************************************************/
+	RenderGraph::Pass& RenderGraph::addPass(const std::string_view name)
+	{
+		if (m_freePasses.empty())
+		{
+			m_passes.emplace_back();
+		} else
+		{
+			m_passes.push_back(std::move(m_freePasses.back()));
+			m_freePasses.pop_back();
+		}
+
+		auto& pass{ m_passes.back() };
+		pass.Name = name;
+		pass.SideEffect = false;
+		pass.Culled = false;
+		return pass;
+	}
+
+	/***********************************************************************************/
+	RenderGraph::ResourceHandle RenderGraph::ImportTexture(const std::string_view name, const GLuint texture, const RenderGraphTextureDesc& desc)
+	{
+		return addResource(name, ResourceType::ImportedTexture, desc, texture);
+	}
+
+	/***********************************************************************************/
+	RenderGraph::ResourceHandle RenderGraph::ImportFramebuffer(const std::string_view name, const GLuint framebuffer)
+	{
+		return addResource(name, ResourceType::ImportedFramebuffer, {}, framebuffer);
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::Compile()
+	{
+		cullPasses();
+		computeLifetimes();
+		assignPhysicalTextures();
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::Execute(TransientTexturePool& pool, const std::function<void(std::string_view)>& onPassBegin)
+	{
+		pool.BeginFrame();
+
+		for (auto& physical : m_physicalTextures)
+		{
+			physical.Texture = pool.Acquire(physical.Desc);
+		}
+		for (auto& resource : m_resources)
+		{
+			if (resource.Type == ResourceType::Transient)
+			{
+				resource.Object = resource.Physical >= 0 ? m_physicalTextures[resource.Physical].Texture : 0;
+			}
+		}
+
+		const PassResources resources(*this);
+		for (const auto& pass : m_passes)
+		{
+			if (pass.Culled)
+			{
+				continue;
+			}
+			if (onPassBegin)
+			{
+				onPassBegin(pass.Name);
+			}
+
+			bindRenderTargets(pool, pass);
+			if (pass.Invoke)
+			{
+				pass.Invoke(pass.Callable, resources);
+			}
+		}
+
+		pool.EndFrame();
+	}
+
+	/***********************************************************************************/
+	bool RenderGraph::IsCulled(const std::string_view pass) const noexcept
+	{
+		const auto it{ std::find_if(m_passes.cbegin(), m_passes.cend(), [pass](const Pass& p) { return p.Name == pass; }) };
+		return it == m_passes.cend() || it->Culled;
+	}
+
+	/***********************************************************************************/
+	int RenderGraph::GetPhysicalIndex(const ResourceHandle resource) const noexcept
+	{
+		return resource < m_resources.size() ? m_resources[resource].Physical : -1;
+	}
+
+	/***********************************************************************************/
+	std::pair<std::uint32_t, std::uint32_t> RenderGraph::GetLifetime(const ResourceHandle resource) const noexcept
+	{
+		if (resource >= m_resources.size())
+		{
+			return { 0, 0 };
+		}
+		return { m_resources[resource].FirstPass, m_resources[resource].LastPass };
+	}
+
+	/***********************************************************************************/
+	RenderGraph::ResourceHandle RenderGraph::addResource(const std::string_view name, const ResourceType type, const RenderGraphTextureDesc& desc, const GLuint object)
+	{
+		Resource resource{ name, type, desc, object };
+
+		// Backbuffer relative sizes are resolved once, so the pool and the aliasing compare real sizes
+		if (resource.Desc.Width == 0 || resource.Desc.Height == 0)
+		{
+			resource.Desc.Width = std::max(1, static_cast<GLsizei>(std::lround(m_width * desc.Scale)));
+			resource.Desc.Height = std::max(1, static_cast<GLsizei>(std::lround(m_height * desc.Scale)));
+		}
+		resource.Desc.Scale = 1.0f;
+
+		m_resources.push_back(resource);
+		return static_cast<ResourceHandle>(m_resources.size() - 1);
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::cullPasses()
+	{
+		m_needed.assign(m_resources.size(), 0);
+		for (std::size_t i = 0; i < m_resources.size(); ++i)
+		{
+			m_needed[i] = m_resources[i].Type != ResourceType::Transient;
+		}
+
+		// Passes only read what earlier passes wrote, so one backwards walk finds everything the output depends on
+		m_stats.Passes = m_passes.size();
+		m_stats.CulledPasses = 0;
+		for (auto pass = m_passes.rbegin(); pass != m_passes.rend(); ++pass)
+		{
+			pass->Culled = !pass->SideEffect &&
+				std::none_of(pass->Writes.cbegin(), pass->Writes.cend(), [this](const ResourceHandle resource) { return m_needed[resource] != 0; });
+
+			if (pass->Culled)
+			{
+				++m_stats.CulledPasses;
+				continue;
+			}
+			for (const auto resource : pass->Reads)
+			{
+				m_needed[resource] = 1;
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::computeLifetimes()
+	{
+		constexpr auto unused{ ~0u };
+		for (auto& resource : m_resources)
+		{
+			resource.FirstPass = unused;
+			resource.LastPass = 0;
+			resource.Physical = -1;
+		}
+
+		for (std::uint32_t i = 0; i < m_passes.size(); ++i)
+		{
+			const auto& pass{ m_passes[i] };
+			if (pass.Culled)
+			{
+				continue;
+			}
+
+			const auto extend = [this, i](const ResourceHandle handle) {
+				auto& resource{ m_resources[handle] };
+				resource.FirstPass = std::min(resource.FirstPass, i);
+				resource.LastPass = std::max(resource.LastPass, i);
+			};
+			std::for_each(pass.Reads.cbegin(), pass.Reads.cend(), extend);
+			std::for_each(pass.Writes.cbegin(), pass.Writes.cend(), extend);
+		}
+
+		m_order.clear();
+		for (ResourceHandle i = 0; i < m_resources.size(); ++i)
+		{
+			if (m_resources[i].Type == ResourceType::Transient && m_resources[i].FirstPass != unused)
+			{
+				m_order.push_back(i);
+			}
+		}
+		// Ties broken by handle give stable_sort's order without its temporary buffer allocation
+		std::sort(m_order.begin(), m_order.end(), [this](const ResourceHandle a, const ResourceHandle b) {
+			return m_resources[a].FirstPass != m_resources[b].FirstPass ? m_resources[a].FirstPass < m_resources[b].FirstPass : a < b;
+		});
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::assignPhysicalTextures()
+	{
+		m_physicalTextures.clear();
+		m_stats.TransientTextures = m_order.size();
+		m_stats.RequestedBytes = 0;
+		m_stats.AllocatedBytes = 0;
+
+		// Greedy interval allocation: in order of first use, take a texture of the same description that is
+		// free again, i.e. whose last user ran before this resource's first
+		for (const auto handle : m_order)
+		{
+			auto& resource{ m_resources[handle] };
+			m_stats.RequestedBytes += getTextureSize(resource.Desc);
+
+			const auto free{ std::find_if(m_physicalTextures.begin(), m_physicalTextures.end(), [&resource](const PhysicalTexture& physical) {
+				return physical.Desc == resource.Desc && physical.LastPass < resource.FirstPass;
+			}) };
+
+			if (free != m_physicalTextures.end())
+			{
+				free->LastPass = resource.LastPass;
+				resource.Physical = static_cast<int>(std::distance(m_physicalTextures.begin(), free));
+			} else
+			{
+				m_physicalTextures.push_back({ resource.Desc, resource.LastPass });
+				m_stats.AllocatedBytes += getTextureSize(resource.Desc);
+				resource.Physical = static_cast<int>(m_physicalTextures.size() - 1);
+			}
+		}
+
+		m_stats.PhysicalTextures = m_physicalTextures.size();
+	}
+
+	/***********************************************************************************/
+	void RenderGraph::bindRenderTargets(TransientTexturePool& pool, const Pass& pass)
+	{
+		m_colorAttachments.clear();
+		GLuint depthAttachment{ 0 };
+		GLsizei width{ 0 }, height{ 0 };
+
+		for (const auto handle : pass.Writes)
+		{
+			const auto& resource{ m_resources[handle] };
+			if (resource.Type == ResourceType::ImportedFramebuffer)
+			{
+				pool.BindFramebuffer(resource.Object, m_width, m_height);
+				return;
+			}
+
+			if (IsDepthFormat(resource.Desc.Format))
+			{
+				depthAttachment = resource.Object;
+			} else
+			{
+				m_colorAttachments.push_back(resource.Object);
+			}
+			width = resource.Desc.Width;
+			height = resource.Desc.Height;
+		}
+
+		if (!pass.Writes.empty())
+		{
+			pool.BindRenderTargets(m_colorAttachments, depthAttachment, width, height);
+		}
+	}
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "../core/LinearArena.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Graphics
+{
+	class TransientTexturePool;
+
+	// Size, format and sampling of a texture created by the render graph.
+	struct RenderGraphTextureDesc {
+		// Fixed size in texels, or 0 to follow the backbuffer multiplied by Scale
+		GLsizei Width{ 0 }, Height{ 0 };
+		float Scale{ 1.0f };
+		GLenum Format{ GL_RGBA8 };
+		GLenum Filter{ GL_NEAREST };
+		// GL_CLAMP_TO_BORDER samples white outside, which is what shadow maps want
+		GLenum Wrap{ GL_CLAMP_TO_EDGE };
+
+		bool operator==(const RenderGraphTextureDesc& other) const noexcept
+		{
+			return Width == other.Width && Height == other.Height && Scale == other.Scale && Format == other.Format &&
+				Filter == other.Filter && Wrap == other.Wrap;
+		}
+	};
+
+	// Bytes per texel of an uncompressed internal format as drivers store it, 0 if unknown.
+	std::size_t GetTexelSize(const GLenum format) noexcept;
+	bool IsDepthFormat(const GLenum format) noexcept;
+
+	// Frame graph: the renderer declares its passes every frame with the textures they read and write, and the
+	// graph works out the rest. Passes whose output nobody reads are culled, and transient textures whose
+	// lifetimes do not overlap share one physical texture from a TransientTexturePool, so a pass must clear or
+	// fully overwrite the textures it creates. Declaring and compiling never touch OpenGL, only Execute does.
+	class RenderGraph {
+	public:
+		using ResourceHandle = std::uint32_t;
+		static constexpr ResourceHandle InvalidResource{ ~0u };
+
+		// Declares what a pass uses, handed to the setup function of AddPass.
+		class PassBuilder {
+		public:
+			// New transient texture, written by this pass.
+			ResourceHandle Create(const std::string_view name, const RenderGraphTextureDesc& desc);
+			// Sampled by this pass. Keeps the passes writing it alive.
+			void Read(const ResourceHandle resource);
+			// Render target of this pass. Depth formats become the depth attachment.
+			void Write(const ResourceHandle resource);
+			// Never culled, e.g. for passes that only talk to the GPU through buffers.
+			void SetSideEffect() noexcept;
+
+		private:
+			friend class RenderGraph;
+			PassBuilder(RenderGraph& graph, const std::uint32_t pass) noexcept : m_graph(graph), m_pass(pass) {}
+
+			RenderGraph& m_graph;
+			std::uint32_t m_pass;
+		};
+
+		// Lets a pass look up the textures behind its resources while it executes.
+		class PassResources {
+		public:
+			GLuint GetTexture(const ResourceHandle resource) const;
+
+		private:
+			friend class RenderGraph;
+			explicit PassResources(const RenderGraph& graph) noexcept : m_graph(graph) {}
+
+			const RenderGraph& m_graph;
+		};
+
+		struct Stats {
+			std::size_t Passes{ 0 }, CulledPasses{ 0 };
+			// Transient textures used by passes that survived culling and the textures backing them
+			std::size_t TransientTextures{ 0 }, PhysicalTextures{ 0 };
+			std::size_t RequestedBytes{ 0 }, AllocatedBytes{ 0 };
+
+			auto GetSavedBytes() const noexcept { return RequestedBytes - AllocatedBytes; }
+		};
+
+		// Drops the passes and resources of the previous frame, keeping their storage. Textures that follow the
+		// backbuffer are sized against width x height.
+		void Reset(const GLsizei width, const GLsizei height);
+
+		// Texture owned elsewhere. Imported resources are never aliased and passes writing them are never culled.
+		ResourceHandle ImportTexture(const std::string_view name, const GLuint texture, const RenderGraphTextureDesc& desc);
+		// Framebuffer owned elsewhere (the default one or the offscreen target), written as a whole.
+		ResourceHandle ImportFramebuffer(const std::string_view name, const GLuint framebuffer);
+
+		// setup(PassBuilder&) runs right away; execute(const PassResources&) runs during Execute if the pass survives
+		// culling. Passes execute in the order they were added. execute is copied into an arena the next Reset
+		// recycles, so it must be trivially destructible: capture by reference or plain values.
+		template<typename Setup, typename ExecuteFunc>
+		void AddPass(const std::string_view name, Setup&& setup, ExecuteFunc&& execute)
+		{
+			using Callable = std::decay_t<ExecuteFunc>;
+
+			const auto pass{ static_cast<std::uint32_t>(m_passes.size()) };
+			auto& entry{ addPass(name) };
+			entry.Callable = m_callables.New<Callable>(std::forward<ExecuteFunc>(execute));
+			entry.Invoke = [](const void* callable, const PassResources& resources) {
+				(*static_cast<const Callable*>(callable))(resources);
+			};
+
+			PassBuilder builder(*this, pass);
+			setup(builder);
+		}
+
+		// Culls passes, computes the lifetime of every transient texture and assigns them physical textures.
+		void Compile();
+		// Acquires the physical textures from pool, then binds the render targets of every live pass and runs it.
+		// onPassBegin, if set, is called with the name of every pass before it runs.
+		void Execute(TransientTexturePool& pool, const std::function<void(std::string_view)>& onPassBegin = {});
+
+		const auto& GetStats() const noexcept { return m_stats; }
+		bool IsCulled(const std::string_view pass) const noexcept;
+		// Physical texture index of a transient resource after Compile, -1 for imported or unused ones.
+		int GetPhysicalIndex(const ResourceHandle resource) const noexcept;
+		// First and last pass of a transient resource after Compile.
+		std::pair<std::uint32_t, std::uint32_t> GetLifetime(const ResourceHandle resource) const noexcept;
+
+	private:
+		enum class ResourceType : std::uint8_t {
+			Transient,
+			ImportedTexture,
+			ImportedFramebuffer
+		};
+
+		struct Resource {
+			std::string_view Name;
+			ResourceType Type;
+			// Size resolved against the backbuffer
+			RenderGraphTextureDesc Desc;
+			// Texture or framebuffer name for imported resources, the physical texture for transient ones
+			GLuint Object{ 0 };
+			std::uint32_t FirstPass{ 0 }, LastPass{ 0 };
+			int Physical{ -1 };
+		};
+
+		struct Pass {
+			std::string_view Name;
+			// The execute function of AddPass, living in m_callables
+			const void* Callable{ nullptr };
+			void (*Invoke)(const void*, const PassResources&) { nullptr };
+			std::vector<ResourceHandle> Reads, Writes;
+			bool SideEffect{ false };
+			bool Culled{ false };
+		};
+
+		struct PhysicalTexture {
+			RenderGraphTextureDesc Desc;
+			std::uint32_t LastPass{ 0 };
+			GLuint Texture{ 0 };
+		};
+
+		// Appends a pass, reusing an entry of an earlier frame if there is one
+		Pass& addPass(const std::string_view name);
+		ResourceHandle addResource(const std::string_view name, const ResourceType type, const RenderGraphTextureDesc& desc, const GLuint object);
+		// Walks the passes backwards: a pass lives if it has side effects or writes something a live pass
+		// after it reads, or an imported resource
+		void cullPasses();
+		void computeLifetimes();
+		void assignPhysicalTextures();
+		// Binds the attachments pass writes, or the imported framebuffer it writes
+		void bindRenderTargets(TransientTexturePool& pool, const Pass& pass);
+
+		GLsizei m_width{ 0 }, m_height{ 0 };
+		std::vector<Pass> m_passes;
+		// Passes of earlier frames, kept with the storage of their read and write lists
+		std::vector<Pass> m_freePasses;
+		// Execute functions of the current frame's passes
+		LinearArena m_callables{ 4 * 1024 };
+		std::vector<Resource> m_resources;
+		std::vector<PhysicalTexture> m_physicalTextures;
+		Stats m_stats;
+		// Scratch for culling, aliasing and attachment lists
+		std::vector<std::uint8_t> m_needed;
+		std::vector<ResourceHandle> m_order;
+		std::vector<GLuint> m_colorAttachments;
+	};
+}
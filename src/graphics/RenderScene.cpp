@@ -0,0 +1,238 @@
+#include "RenderScene.h"
+
+#include "../Model.h"
+#include "../ViewFrustum.h"
+#include "../core/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	ModelHandle RenderScene::AddModel(const Model& model)
+	{
+		const auto handle{ AddModel(RenderModel{ model.GetModelMatrix(), model.GetBoundingBox(), model.GetSelected() }) };
+
+		for (const auto& mesh : model.GetMeshes())
+		{
+			RenderMesh renderMesh{ mesh.VAO.GetId(), static_cast<GLsizei>(mesh.IndexCount), handle, addMaterial(mesh.Material.get()) };
+			if (mesh.Meshlets)
+			{
+				renderMesh.FirstMeshlet = AddMeshlets(*mesh.Meshlets);
+				renderMesh.NumMeshlets = static_cast<std::uint32_t>(mesh.Meshlets->size());
+			}
+			AddMesh(renderMesh);
+		}
+
+		return handle;
+	}
+
+	/***********************************************************************************/
+	void RenderScene::RemoveModel(const ModelHandle handle)
+	{
+		if (!m_models.Erase(handle))
+		{
+			return;
+		}
+
+		// Erase moves the last mesh into the hole, so the same index is looked at again
+		std::vector<MaterialHandle> materials;
+		for (std::uint32_t i = 0; i < m_meshes.GetSize();)
+		{
+			const auto mesh{ m_meshes.GetValues()[i] };
+			if (mesh.Model == handle)
+			{
+				m_meshes.Erase(m_meshes.GetHandle(i));
+				eraseMeshlets(mesh);
+				materials.push_back(mesh.Material);
+			} else
+			{
+				++i;
+			}
+		}
+
+		for (const auto material : materials)
+		{
+			releaseMaterial(material);
+		}
+	}
+
+	/***********************************************************************************/
+	void RenderScene::UpdateModel(const ModelHandle handle, const Model& model)
+	{
+		if (auto* renderModel{ m_models.Get(handle) })
+		{
+			renderModel->Transform = model.GetModelMatrix();
+			renderModel->Bounds = model.GetBoundingBox();
+		}
+	}
+
+	/***********************************************************************************/
+	void RenderScene::SetSelected(const ModelHandle handle, const bool selected)
+	{
+		if (auto* renderModel{ m_models.Get(handle) })
+		{
+			renderModel->Selected = selected;
+		}
+	}
+
+	/***********************************************************************************/
+	void RenderScene::Clear()
+	{
+		m_models.Clear();
+		m_meshes.Clear();
+		m_materials.Clear();
+		m_meshletBounds.Clear();
+		m_materialHandles.clear();
+	}
+
+	/***********************************************************************************/
+	void RenderScene::Cull(const ViewFrustum& frustum, ArenaVector<std::uint32_t>& visibleMeshes)
+	{
+		const auto& models{ m_models.GetValues() };
+		m_visibleModels.resize(models.size());
+		for (std::size_t i = 0; i < models.size(); ++i)
+		{
+			m_visibleModels[i] = frustum.TestIntersection(models[i].Bounds) != BoundingVolume::TestResult::OUTSIDE;
+		}
+
+		// The list may live in an arena, whose memory is not reused before the next frame, so it must not grow
+		const auto& meshes{ m_meshes.GetValues() };
+		visibleMeshes.reserve(visibleMeshes.size() + meshes.size());
+		for (std::uint32_t i = 0; i < meshes.size(); ++i)
+		{
+			if (m_visibleModels[m_models.GetDenseIndex(meshes[i].Model)])
+			{
+				visibleMeshes.push_back(i);
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	MeshletCullCounts RenderScene::CullMeshlets(const ViewFrustum& frustum, const glm::vec3& eye, const ArenaVector<std::uint32_t>& visibleMeshes,
+		MeshletDrawList& drawList, const MeshletCullSettings& settings) const
+	{
+		// Every mesh gets a window of the range list as large as its meshlet count, the most it can need, so the
+		// workers write without coordinating. Like the mesh list, neither list may grow once filled.
+		const auto& meshes{ m_meshes.GetValues() };
+		drawList.Draws.resize(visibleMeshes.size());
+		std::uint32_t numRanges{ 0 };
+		for (std::size_t i = 0; i < visibleMeshes.size(); ++i)
+		{
+			drawList.Draws[i].FirstRange = numRanges;
+			numRanges += std::max(meshes[visibleMeshes[i]].NumMeshlets, 1u);
+		}
+		drawList.Ranges.resize(numRanges);
+
+		constexpr std::size_t MESH_GRAIN{ 16 };
+		std::atomic<std::size_t> meshlets{ 0 }, frustumCulled{ 0 }, coneCulled{ 0 }, trianglesBefore{ 0 }, trianglesAfter{ 0 };
+		ThreadPool::GetInstance().ParallelFor(visibleMeshes.size(), MESH_GRAIN, [&](const std::size_t begin, const std::size_t end) {
+			MeshletCullCounts counts;
+			auto lastModel{ SlotMap<RenderModel>::InvalidIndex };
+			std::optional<MeshletView> view;
+			for (auto i = begin; i < end; ++i)
+			{
+				const auto& mesh{ meshes[visibleMeshes[i]] };
+				auto& draw{ drawList.Draws[i] };
+				if (mesh.NumMeshlets == 0)
+				{
+					drawList.Ranges[draw.FirstRange] = { 0, mesh.IndexCount };
+					draw.NumRanges = 1;
+					counts.TrianglesBefore += mesh.IndexCount / 3;
+					counts.TrianglesAfter += mesh.IndexCount / 3;
+					continue;
+				}
+
+				// Meshes of a model are listed together and share its view
+				const auto modelIndex{ GetModelIndex(mesh) };
+				if (modelIndex != lastModel)
+				{
+					view.emplace(frustum, eye, m_models.GetValues()[modelIndex].Transform, settings.ConeCulling);
+					lastModel = modelIndex;
+				}
+				draw.NumRanges = Graphics::CullMeshlets(m_meshletBounds, mesh.FirstMeshlet, mesh.NumMeshlets, *view,
+					drawList.Ranges.data() + draw.FirstRange, counts, settings.AllowSIMD);
+			}
+
+			meshlets += counts.Meshlets;
+			frustumCulled += counts.FrustumCulled;
+			coneCulled += counts.ConeCulled;
+			trianglesBefore += counts.TrianglesBefore;
+			trianglesAfter += counts.TrianglesAfter;
+		});
+
+		return { meshlets, frustumCulled, coneCulled, trianglesBefore, trianglesAfter };
+	}
+
+	/***********************************************************************************/
+	void RenderScene::eraseMeshlets(const RenderMesh& mesh)
+	{
+		if (mesh.NumMeshlets == 0)
+		{
+			return;
+		}
+
+		m_meshletBounds.Erase(mesh.FirstMeshlet, mesh.NumMeshlets);
+		for (auto& other : m_meshes.GetValues())
+		{
+			if (other.NumMeshlets > 0 && other.FirstMeshlet > mesh.FirstMeshlet)
+			{
+				other.FirstMeshlet -= mesh.NumMeshlets;
+			}
+		}
+	}
+
+	/***********************************************************************************/
+	void RenderScene::releaseMaterial(const MaterialHandle handle)
+	{
+		const auto& meshes{ m_meshes.GetValues() };
+		if (std::any_of(meshes.cbegin(), meshes.cend(), [handle](const auto& mesh) { return mesh.Material == handle; }))
+		{
+			return;
+		}
+
+		// Materials added directly stay, whoever added them owns them
+		auto erased{ false };
+		for (auto it = m_materialHandles.begin(); it != m_materialHandles.end();)
+		{
+			if (it->second == handle)
+			{
+				it = m_materialHandles.erase(it);
+				erased = true;
+			} else
+			{
+				++it;
+			}
+		}
+		if (erased)
+		{
+			m_materials.Erase(handle);
+		}
+	}
+
+	/***********************************************************************************/
+	MaterialHandle RenderScene::addMaterial(const PBRMaterial* material)
+	{
+		if (material == nullptr)
+		{
+			return {};
+		}
+
+		const auto [it, inserted] { m_materialHandles.try_emplace(material) };
+		if (inserted)
+		{
+			RenderMaterial renderMaterial;
+			for (std::size_t i = 0; i < renderMaterial.Textures.size(); ++i)
+			{
+				const auto parameter{ static_cast<PBRMaterial::ParameterType>(i) };
+				renderMaterial.Textures[i] = material->GetParameterTexture(parameter);
+				renderMaterial.Colors[i] = material->GetParameterColor(parameter);
+			}
+			renderMaterial.Alpha = material->GetAlphaValue();
+			it->second = AddMaterial(renderMaterial);
+		}
+		return it->second;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Meshlets.h"
+#include "../core/LinearArena.h"
+#include "../core/SlotMap.h"
+#include "../AABB.h"
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Model;
+class PBRMaterial;
+class ViewFrustum;
+
+namespace Graphics
+{
+	// What the passes read of a PBRMaterial
+	struct RenderMaterial {
+		std::array<GLuint, 5> Textures{};
+		std::array<glm::vec3, 5> Colors{};
+		float Alpha{ 1.0f };
+	};
+
+	struct RenderModel {
+		glm::mat4 Transform{ 1.0f };
+		AABB Bounds;
+		bool Selected{ false };
+	};
+
+	struct RenderMesh {
+		GLuint VertexArray{ 0 };
+		GLsizei IndexCount{ 0 };
+		SlotHandle<RenderModel> Model;
+		SlotHandle<RenderMaterial> Material;
+		// Range of the mesh's meshlets in RenderScene::GetMeshletBounds(), empty if it has none
+		std::uint32_t FirstMeshlet{ 0 };
+		std::uint32_t NumMeshlets{ 0 };
+	};
+
+	using ModelHandle = SlotHandle<RenderModel>;
+	using MeshHandle = SlotHandle<RenderMesh>;
+	using MaterialHandle = SlotHandle<RenderMaterial>;
+
+	// What survived meshlet culling of one visible mesh: Ranges[FirstRange, FirstRange + NumRanges) of the draw list
+	struct MeshletDraw {
+		std::uint32_t FirstRange;
+		std::uint32_t NumRanges;
+	};
+
+	// Index ranges to draw of every visible mesh, allocated from a per-frame arena
+	struct MeshletDrawList {
+		explicit MeshletDrawList(LinearArena& arena) :
+			Draws(ArenaAllocator<MeshletDraw>(arena)),
+			Ranges(ArenaAllocator<IndexRange>(arena)) {}
+
+		// One per entry of the list of visible meshes, in its order
+		ArenaVector<MeshletDraw> Draws;
+		ArenaVector<IndexRange> Ranges;
+	};
+
+	struct MeshletCullSettings {
+		// Skips meshlets facing away from the eye. Only right for closed or single sided surfaces, the renderer
+		// draws both sides of a triangle.
+		bool ConeCulling{ true };
+		bool AllowSIMD{ true };
+	};
+
+	// Copy of the scene's models with just what drawing needs, in slot maps. Culling and command recording walk
+	// the packed arrays by index instead of following ModelPtrs to Model objects and their mesh vectors spread
+	// over the heap. The Models stay the editable originals: whoever changes one calls UpdateModel.
+	class RenderScene {
+	public:
+		// Adds model and its meshes. Meshes sharing a PBRMaterial share one RenderMaterial.
+		ModelHandle AddModel(const Model& model);
+		// Building blocks of the above, for draw data that does not come from a Model
+		ModelHandle AddModel(const RenderModel& model) { return m_models.Insert(model); }
+		MeshHandle AddMesh(const RenderMesh& mesh) { return m_meshes.Insert(mesh); }
+		MaterialHandle AddMaterial(const RenderMaterial& material) { return m_materials.Insert(material); }
+		// Returns the RenderMesh::FirstMeshlet of meshlets
+		std::uint32_t AddMeshlets(const std::vector<Meshlet>& meshlets) { return m_meshletBounds.Append(meshlets); }
+		// Removes the model, its meshes and their meshlets, and the materials added with it that no other mesh uses.
+		// Meshlets of other meshes move down, FirstMeshlet is updated.
+		void RemoveModel(const ModelHandle handle);
+		// Picks up the transform and bounds of model after it moved.
+		void UpdateModel(const ModelHandle handle, const Model& model);
+		void SetSelected(const ModelHandle handle, const bool selected);
+		void Clear();
+
+		// Appends the index into GetMeshes() of every mesh whose model intersects frustum. Meshes of a model stay
+		// next to each other unless models were removed.
+		void Cull(const ViewFrustum& frustum, ArenaVector<std::uint32_t>& visibleMeshes);
+		// Culls the meshlets of visibleMeshes (from Cull) in parallel and fills drawList with the index ranges to draw
+		// instead of the whole meshes. Meshes without meshlets get one range over all their indices, meshes whose
+		// meshlets were all culled none. eye is the camera position the frustum was made from.
+		MeshletCullCounts CullMeshlets(const ViewFrustum& frustum, const glm::vec3& eye, const ArenaVector<std::uint32_t>& visibleMeshes,
+			MeshletDrawList& drawList, const MeshletCullSettings& settings = {}) const;
+
+		const auto& GetModels() const noexcept { return m_models.GetValues(); }
+		const auto& GetMeshes() const noexcept { return m_meshes.GetValues(); }
+		const auto& GetMaterials() const noexcept { return m_materials.GetValues(); }
+		const auto& GetMeshletBounds() const noexcept { return m_meshletBounds; }
+
+		// Index of the mesh's model in GetModels(), from its handle
+		auto GetModelIndex(const RenderMesh& mesh) const noexcept { return m_models.GetDenseIndex(mesh.Model); }
+		auto GetMaterialIndex(const RenderMesh& mesh) const noexcept { return m_materials.GetDenseIndex(mesh.Material); }
+
+	private:
+		MaterialHandle addMaterial(const PBRMaterial* material);
+		void eraseMeshlets(const RenderMesh& mesh);
+		void releaseMaterial(const MaterialHandle handle);
+
+		SlotMap<RenderModel> m_models;
+		SlotMap<RenderMesh> m_meshes;
+		SlotMap<RenderMaterial> m_materials;
+		MeshletBounds m_meshletBounds;
+
+		// Materials added for a PBRMaterial, until the last mesh using one is removed
+		std::unordered_map<const PBRMaterial*, MaterialHandle> m_materialHandles;
+		// Cull's per model result, kept to not allocate every frame
+		std::vector<std::uint8_t> m_visibleModels;
+	};
+}
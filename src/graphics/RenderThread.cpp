@@ -0,0 +1,214 @@
+#include "RenderThread.h"
+
+#include "../core/Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	/***********************************************************************************/
+	template<typename Clock>
+	double millisecondsSince(const typename Clock::time_point start) noexcept
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	void RenderThread::Start(RenderBackend& backend, const std::uint32_t maxFramesInFlight, const std::size_t numPasses, Callbacks callbacks)
+	{
+		Stop();
+
+		m_backend = &backend;
+		m_maxFramesInFlight = std::clamp(maxFramesInFlight, 1u, 3u);
+		m_callbacks = std::move(callbacks);
+
+		// Arenas of frames recorded earlier keep their size, only the frame count and passes can change
+		m_frames.resize(m_maxFramesInFlight + 1);
+		for (std::size_t slot = 0; slot < m_frames.size(); ++slot)
+		{
+			m_frames[slot].Slot = slot;
+			m_frames[slot].Passes.resize(numPasses);
+		}
+		m_fences.assign(m_frames.size(), nullptr);
+
+		m_numBegun = m_numSubmitted = m_numReplayed = m_numRetired = 0;
+		m_task = nullptr;
+		m_stats = {};
+		m_stop = false;
+		m_thread = std::thread(&RenderThread::threadLoop, this);
+	}
+
+	/***********************************************************************************/
+	void RenderThread::Stop()
+	{
+		if (!m_thread.joinable())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_work.notify_one();
+		m_thread.join();
+	}
+
+	/***********************************************************************************/
+	RenderThread::Stats RenderThread::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+	/***********************************************************************************/
+	RenderThread::Frame& RenderThread::BeginFrame()
+	{
+		assert(IsRunning() && m_numBegun == m_numSubmitted);
+
+		const auto start{ Clock::now() };
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_frameRetired.wait(lock, [this]() { return m_numBegun < m_numRetired + m_frames.size(); });
+		m_stats.PacingMilliseconds += millisecondsSince<Clock>(start);
+
+		auto& frame{ m_frames[m_numBegun % m_frames.size()] };
+		frame.Index = m_numBegun++;
+		lock.unlock();
+
+		for (auto& pass : frame.Passes)
+		{
+			pass.Reset();
+		}
+		return frame;
+	}
+
+	/***********************************************************************************/
+	void RenderThread::Submit()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			assert(m_numSubmitted + 1 == m_numBegun);
+			++m_numSubmitted;
+		}
+		m_work.notify_one();
+	}
+
+	/***********************************************************************************/
+	void RenderThread::Invoke(const std::function<void()>& task)
+	{
+		assert(IsRunning());
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_work.notify_one();
+		m_frameReplayed.wait(lock, [this]() { return m_task == nullptr; });
+	}
+
+	/***********************************************************************************/
+	void RenderThread::WaitForReplay()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_frameReplayed.wait(lock, [this]() { return m_numReplayed == m_numSubmitted; });
+	}
+
+	/***********************************************************************************/
+	void RenderThread::threadLoop()
+	{
+		PROFILE_THREAD_NAME("Render");
+		if (m_callbacks.OnStart)
+		{
+			m_callbacks.OnStart();
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			m_work.wait(lock, [this]() { return m_numReplayed < m_numSubmitted || m_task || m_stop; });
+
+			// Tasks see the context as the frames submitted before them left it
+			if (m_numReplayed == m_numSubmitted && m_task)
+			{
+				lock.unlock();
+				(*m_task)();
+				lock.lock();
+				m_task = nullptr;
+				m_frameReplayed.notify_all();
+				continue;
+			}
+			if (m_numReplayed == m_numSubmitted)
+			{
+				break;
+			}
+
+			const auto slot{ m_numReplayed % m_frames.size() };
+			lock.unlock();
+
+			const auto start{ Clock::now() };
+			{
+				PROFILE_SCOPE("Replay");
+				if (m_callbacks.Replay)
+				{
+					m_callbacks.Replay(m_frames[slot]);
+				}
+				else
+				{
+					for (const auto& pass : m_frames[slot].Passes)
+					{
+						m_backend->Execute(pass);
+					}
+				}
+			}
+			const auto fence{ m_backend->InsertFence() };
+			const auto replayMilliseconds{ millisecondsSince<Clock>(start) };
+
+			if (m_callbacks.OnFrameEnd)
+			{
+				m_callbacks.OnFrameEnd();
+			}
+
+			lock.lock();
+			m_fences[slot] = fence;
+			++m_numReplayed;
+			++m_stats.Frames;
+			m_stats.ReplayMilliseconds += replayMilliseconds;
+			m_frameReplayed.notify_all();
+
+			while (m_numReplayed - m_numRetired > m_maxFramesInFlight)
+			{
+				retireFrame(lock);
+			}
+		}
+
+		while (m_numRetired < m_numReplayed)
+		{
+			retireFrame(lock);
+		}
+		lock.unlock();
+
+		if (m_callbacks.OnStop)
+		{
+			m_callbacks.OnStop();
+		}
+	}
+
+	/***********************************************************************************/
+	void RenderThread::retireFrame(std::unique_lock<std::mutex>& lock)
+	{
+		const auto slot{ m_numRetired % m_frames.size() };
+		const auto fence{ std::exchange(m_fences[slot], nullptr) };
+		lock.unlock();
+
+		const auto start{ Clock::now() };
+		m_backend->WaitFence(fence);
+		const auto fenceMilliseconds{ millisecondsSince<Clock>(start) };
+
+		lock.lock();
+		m_stats.FenceMilliseconds += fenceMilliseconds;
+		++m_numRetired;
+		m_frameRetired.notify_one();
+	}
+}
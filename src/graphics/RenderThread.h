@@ -0,0 +1,102 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Graphics
+{
+	// Replays recorded frames on a thread of its own, so recording the next frame overlaps with submitting the
+	// last one to the driver. A frame is a set of CommandBuffers, one per pass, which the producer may record
+	// in parallel; they are replayed in order. After each frame the backend inserts a fence, and no more than
+	// MaxFramesInFlight frames are replayed ahead of the GPU. The producer records into one of
+	// MaxFramesInFlight + 1 frames, so BeginFrame blocks when it runs further ahead.
+	//
+	// The thread owns the context while it runs. OpenGL work that is not a command (resource creation, shader
+	// builds, readbacks) goes through Invoke, which runs it there once the submitted frames are replayed.
+	class RenderThread {
+		using Clock = std::chrono::steady_clock;
+	public:
+		struct Frame {
+			std::uint64_t Index{ 0 };
+			// Index into the MaxFramesInFlight + 1 frames, for data the producer keeps alongside each one
+			std::size_t Slot{ 0 };
+			std::vector<CommandBuffer> Passes;
+		};
+
+		struct Stats {
+			std::uint64_t Frames{ 0 };
+			// Producer blocked in BeginFrame because too many frames were in flight
+			double PacingMilliseconds{ 0.0 };
+			// Render thread blocked on fences, i.e. waiting for the GPU
+			double FenceMilliseconds{ 0.0 };
+			double ReplayMilliseconds{ 0.0 };
+		};
+
+		// All of them run on the render thread.
+		struct Callbacks {
+			// First thing the thread does, makes the context current
+			std::function<void()> OnStart;
+			// Replays a frame. Executes its passes in order on the backend if empty.
+			std::function<void(const Frame&)> Replay;
+			// After every replayed frame and its fence, presents
+			std::function<void()> OnFrameEnd;
+			// Before the thread exits, releases the context
+			std::function<void()> OnStop;
+		};
+
+		RenderThread() = default;
+		~RenderThread() { Stop(); }
+
+		RenderThread(const RenderThread&) = delete;
+		RenderThread& operator=(const RenderThread&) = delete;
+
+		// backend is only used from the new thread.
+		void Start(RenderBackend& backend, const std::uint32_t maxFramesInFlight, const std::size_t numPasses, Callbacks callbacks = {});
+		// Replays what was submitted, waits for the GPU to finish it and joins the thread.
+		void Stop();
+
+		bool IsRunning() const noexcept { return m_thread.joinable(); }
+		auto GetMaxFramesInFlight() const noexcept { return m_maxFramesInFlight; }
+		auto GetNumFrames() const noexcept { return m_frames.size(); }
+		Stats GetStats();
+
+		// Producer. Waits for a free frame and returns it with its command buffers reset.
+		Frame& BeginFrame();
+		// Producer. Queues the frame returned by the last BeginFrame for replay.
+		void Submit();
+		// Producer. Runs task on the render thread after every submitted frame was replayed and blocks until it returns.
+		void Invoke(const std::function<void()>& task);
+		// Producer. Blocks until every submitted frame was replayed, the GPU may still be working on them.
+		void WaitForReplay();
+
+	private:
+		void threadLoop();
+		// Waits for the fence of the oldest replayed frame, which frees it for recording. Called with lock held.
+		void retireFrame(std::unique_lock<std::mutex>& lock);
+
+		RenderBackend* m_backend{ nullptr };
+		std::uint32_t m_maxFramesInFlight{ 2 };
+		Callbacks m_callbacks;
+
+		std::vector<Frame> m_frames;
+		std::vector<GLsync> m_fences;
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		// Render thread waits for frames, tasks or Stop; producer for a retired frame, a replay or a finished task
+		std::condition_variable m_work, m_frameRetired, m_frameReplayed;
+		// Frames begun by the producer, submitted, replayed and known to be finished by the GPU
+		std::uint64_t m_numBegun{ 0 }, m_numSubmitted{ 0 }, m_numReplayed{ 0 }, m_numRetired{ 0 };
+		const std::function<void()>* m_task{ nullptr };
+		bool m_stop{ false };
+
+		Stats m_stats;
+	};
+}
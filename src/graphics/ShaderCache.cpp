@@ -0,0 +1,170 @@
+#include "ShaderCache.h"
+
+#include "../Hash.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	// Bump when the file layout or shader preprocessing changes so stale cache entries get rebuilt.
+	constexpr std::uint64_t CACHE_VERSION{ 1 };
+
+	constexpr char FileMagic[8]{ 'G', 'E', 'P', 'R', 'O', 'G', '\0', '\0' };
+
+	struct FileHeader {
+		char Magic[8];
+		std::uint64_t Key;
+		std::uint32_t BinaryFormat;
+		std::uint32_t BinarySize;
+	};
+
+	/***********************************************************************************/
+	std::string getDriverString()
+	{
+		const auto getString = [](const GLenum name) {
+			const auto* str{ reinterpret_cast<const char*>(glGetString(name)) };
+			return std::string(str ? str : "");
+		};
+
+		return getString(GL_VENDOR) + '\n' + getString(GL_RENDERER) + '\n' + getString(GL_VERSION);
+	}
+
+	/***********************************************************************************/
+	bool isProgramBinarySupported()
+	{
+		GLint numFormats{ 0 };
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		return numFormats > 0;
+	}
+
+	/***********************************************************************************/
+	std::filesystem::path getCachePath(const std::uint64_t key)
+	{
+		return Graphics::GetShaderCacheDirectory() / (Hash::ToHex(key) + ".bin");
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	std::filesystem::path GetShaderCacheDirectory()
+	{
+		return std::filesystem::current_path() / "Data/cache/shaders";
+	}
+
+	/***********************************************************************************/
+	std::uint64_t BuildShaderCacheKey(const std::vector<ShaderStage>& stages, const std::vector<std::string>& sources)
+	{
+		// The driver does not change while running
+		static const auto driverHash{ Hash::Hash64(getDriverString()) };
+
+		auto hash{ Hash::Combine(driverHash, CACHE_VERSION) };
+		for (std::size_t i = 0; i < stages.size(); ++i)
+		{
+			hash = Hash::Combine(hash, Hash::Hash64(stages[i].type));
+			hash = Hash::Combine(hash, Hash::Hash64(sources[i]));
+		}
+
+		return hash;
+	}
+
+	/***********************************************************************************/
+	GLuint LoadCachedProgram(const std::uint64_t key)
+	{
+		static const auto supported{ isProgramBinarySupported() };
+		if (!supported)
+		{
+			return 0;
+		}
+
+		std::ifstream in(getCachePath(key), std::ios::binary);
+		if (!in)
+		{
+			return 0;
+		}
+
+		FileHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+			std::memcmp(header.Magic, FileMagic, sizeof(FileMagic)) != 0 || header.Key != key)
+		{
+			return 0;
+		}
+
+		std::vector<char> binary(header.BinarySize);
+		if (!in.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+		{
+			return 0;
+		}
+
+		const auto programID{ glCreateProgram() };
+		glProgramBinary(programID, header.BinaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+		// Drivers reject binaries after updates they did not notice in the version string
+		GLint success{ GL_FALSE };
+		glGetProgramiv(programID, GL_LINK_STATUS, &success);
+		if (success != GL_TRUE)
+		{
+			glDeleteProgram(programID);
+			return 0;
+		}
+
+		return programID;
+	}
+
+	/***********************************************************************************/
+	bool StoreCachedProgram(const std::uint64_t key, const GLuint programID)
+	{
+		static const auto supported{ isProgramBinarySupported() };
+		if (!supported)
+		{
+			return false;
+		}
+
+		GLint binarySize{ 0 };
+		glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+		if (binarySize <= 0)
+		{
+			return false;
+		}
+
+		std::vector<char> binary(static_cast<std::size_t>(binarySize));
+		GLenum binaryFormat{ 0 };
+		glGetProgramBinary(programID, binarySize, nullptr, &binaryFormat, binary.data());
+
+		std::error_code ec;
+		std::filesystem::create_directories(GetShaderCacheDirectory(), ec);
+
+		// Written next to the target and renamed, so a crash never leaves a truncated entry behind
+		const auto path{ getCachePath(key) };
+		auto tempPath{ path };
+		tempPath += ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary);
+			if (!out)
+			{
+				std::cerr << "Shader Cache: Failed to write " << path << '\n';
+				return false;
+			}
+
+			FileHeader header{};
+			std::memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+			header.Key = key;
+			header.BinaryFormat = binaryFormat;
+			header.BinarySize = static_cast<std::uint32_t>(binary.size());
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+		}
+
+		std::filesystem::rename(tempPath, path, ec);
+		if (ec)
+		{
+			std::filesystem::remove(tempPath, ec);
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "ShaderStage.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Graphics
+{
+	// Directory that holds linked program binaries.
+	std::filesystem::path GetShaderCacheDirectory();
+
+	// Covers the fully preprocessed source and type of every stage, and the driver vendor, renderer and
+	// version, since program binaries are only valid for the driver that produced them.
+	std::uint64_t BuildShaderCacheKey(const std::vector<ShaderStage>& stages, const std::vector<std::string>& sources);
+
+	// Program linked from the binary cached under key, 0 on a miss or if the driver rejects the binary.
+	GLuint LoadCachedProgram(const std::uint64_t key);
+
+	// Stores the binary of a linked program. Link with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+	bool StoreCachedProgram(const std::uint64_t key, const GLuint programID);
+}
@@ -0,0 +1,288 @@
+#include "ShaderPreprocessor.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+namespace Graphics
+{
+	namespace
+	{
+		/***********************************************************************************/
+		std::string_view trim(std::string_view text) noexcept
+		{
+			const auto first{ text.find_first_not_of(" \t") };
+			if (first == std::string_view::npos)
+			{
+				return {};
+			}
+
+			return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+		}
+
+		/***********************************************************************************/
+		// Name of the preprocessor directive on a line ("include", "pragma", ...), arguments go to rest.
+		std::string_view getDirective(std::string_view line, std::string_view& rest) noexcept
+		{
+			line = trim(line);
+			if (line.empty() || line.front() != '#')
+			{
+				return {};
+			}
+
+			line = trim(line.substr(1));
+			const auto end{ std::min(line.find_first_of(" \t"), line.size()) };
+			rest = trim(line.substr(end));
+
+			return line.substr(0, end);
+		}
+
+		/***********************************************************************************/
+		// First identifier of the arguments of a directive
+		std::string_view getIdentifier(const std::string_view rest) noexcept
+		{
+			return rest.substr(0, std::min(rest.find_first_of(" \t/"), rest.size()));
+		}
+
+		/***********************************************************************************/
+		bool isBlank(const std::string_view line) noexcept
+		{
+			const auto text{ trim(line) };
+			return text.empty() || text.substr(0, 2) == "//";
+		}
+	}
+
+	/***********************************************************************************/
+	std::filesystem::path ShaderPreprocessor::Normalize(const std::filesystem::path& path)
+	{
+		return path.lexically_normal();
+	}
+
+	/***********************************************************************************/
+	std::optional<ShaderPreprocessor::Result> ShaderPreprocessor::Process(const std::filesystem::path& path)
+	{
+		Context context;
+		if (!expand(Normalize(path), context))
+		{
+			return std::nullopt;
+		}
+
+		return std::move(context.Output);
+	}
+
+	/***********************************************************************************/
+	void ShaderPreprocessor::Invalidate(const std::filesystem::path& path)
+	{
+		m_files.erase(Normalize(path).generic_string());
+	}
+
+	/***********************************************************************************/
+	const ShaderPreprocessor::File* ShaderPreprocessor::loadFile(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		const auto modifiedTime{ std::filesystem::last_write_time(path, error) };
+		if (error)
+		{
+			std::cerr << "Shader Preprocessor Error: Cannot read " << path.generic_string() << ": " << error.message() << std::endl;
+			return nullptr;
+		}
+
+		auto& file{ m_files[path.generic_string()] };
+		if (!file.Lines.empty() && file.ModifiedTime == modifiedTime)
+		{
+			return &file;
+		}
+
+		std::ifstream in(path);
+		if (!in)
+		{
+			std::cerr << "Shader Preprocessor Error: Cannot read " << path.generic_string() << std::endl;
+			m_files.erase(path.generic_string());
+			return nullptr;
+		}
+
+		file = {};
+		file.ModifiedTime = modifiedTime;
+
+		// Nesting depth of conditionals and the line at which the first one opened at depth 0 closed
+		std::size_t depth{ 0 };
+		std::size_t firstBlockEnd{ 0 };
+		bool guardDefined{ false };
+		std::size_t numDirectives{ 0 };
+
+		std::string line;
+		while (std::getline(in, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.pop_back();
+			}
+
+			std::string_view rest;
+			const auto directive{ getDirective(line, rest) };
+
+			if (directive == "include")
+			{
+				const auto open{ rest.find_first_of("\"<") };
+				const auto close{ open == std::string_view::npos ? open : rest.find_first_of("\">", open + 1) };
+				if (close == std::string_view::npos)
+				{
+					std::cerr << fmt::format("Shader Preprocessor Error: {}:{}: malformed #include", path.generic_string(), file.Lines.size() + 1) << std::endl;
+					m_files.erase(path.generic_string());
+					return nullptr;
+				}
+
+				const std::filesystem::path includePath{ rest.substr(open + 1, close - open - 1) };
+
+				// Relative to the including file first, then to the working directory like stage paths
+				auto resolved{ Normalize(path.parent_path() / includePath) };
+				if (!std::filesystem::exists(resolved, error))
+				{
+					resolved = Normalize(includePath);
+				}
+
+				file.Includes.push_back({ file.Lines.size(), std::move(resolved) });
+				line.clear();
+			} else if (directive == "pragma" && getIdentifier(rest) == "once")
+			{
+				file.PragmaOnce = true;
+				line.clear();
+			}
+
+			// #ifndef X / #define X as the first directives and an #endif closing it on the last line
+			if (!directive.empty())
+			{
+				++numDirectives;
+				if (directive == "if" || directive == "ifdef" || directive == "ifndef")
+				{
+					if (numDirectives == 1 && directive == "ifndef")
+					{
+						file.Guard = std::string(getIdentifier(rest));
+					}
+					++depth;
+				} else if (directive == "endif" && depth > 0)
+				{
+					if (--depth == 0 && firstBlockEnd == 0)
+					{
+						firstBlockEnd = file.Lines.size() + 1;
+					}
+				} else if (numDirectives == 2 && directive == "define")
+				{
+					guardDefined = !file.Guard.empty() && getIdentifier(rest) == file.Guard;
+				}
+			}
+
+			file.Lines.push_back(std::move(line));
+		}
+
+		// The guard block has to end on the last line that is not blank
+		auto lastLine{ file.Lines.size() };
+		while (lastLine > 0 && isBlank(file.Lines[lastLine - 1]))
+		{
+			--lastLine;
+		}
+		if (!guardDefined || firstBlockEnd != lastLine)
+		{
+			file.Guard.clear();
+		}
+
+		// An empty file still has to count as cached
+		if (file.Lines.empty())
+		{
+			file.Lines.emplace_back();
+		}
+
+		return &file;
+	}
+
+	/***********************************************************************************/
+	bool ShaderPreprocessor::expand(const std::filesystem::path& path, Context& context)
+	{
+		const auto key{ path.generic_string() };
+
+		if (std::find(context.Stack.cbegin(), context.Stack.cend(), key) != context.Stack.cend())
+		{
+			std::cerr << "Shader Preprocessor Error: " << key << " includes itself through";
+			for (const auto& file : context.Stack)
+			{
+				std::cerr << ' ' << file;
+			}
+			std::cerr << std::endl;
+			return false;
+		}
+
+		const auto* file{ loadFile(path) };
+		if (!file)
+		{
+			return false;
+		}
+
+		auto& files{ context.Output.Files };
+		const auto index{ static_cast<std::size_t>(std::find(files.cbegin(), files.cend(), path) - files.cbegin()) };
+		if (index == files.size())
+		{
+			files.push_back(path);
+		}
+
+		if (file->PragmaOnce)
+		{
+			context.Once.insert(key);
+		}
+		if (!file->Guard.empty())
+		{
+			context.Guards.insert(file->Guard);
+		}
+
+		auto& source{ context.Output.Source };
+		// The stage file starts at line 1 of source string 0 anyway, and #version has to stay first
+		if (!context.Stack.empty())
+		{
+			source += fmt::format("#line 1 {}\n", index);
+		}
+
+		context.Stack.push_back(key);
+
+		auto include{ file->Includes.cbegin() };
+		for (std::size_t i = 0; i < file->Lines.size(); ++i)
+		{
+			if (include == file->Includes.cend() || include->Line != i)
+			{
+				source += file->Lines[i];
+				source += '\n';
+				continue;
+			}
+
+			const auto& includePath{ include->Path };
+			++include;
+
+			if (context.Once.count(includePath.generic_string()) != 0)
+			{
+				source += '\n';
+				continue;
+			}
+
+			// Skip guarded files before reading them again when their guard is already defined
+			if (const auto cached{ m_files.find(includePath.generic_string()) };
+				cached != m_files.cend() && !cached->second.Guard.empty() && context.Guards.count(cached->second.Guard) != 0)
+			{
+				source += '\n';
+				continue;
+			}
+
+			if (!expand(includePath, context))
+			{
+				return false;
+			}
+
+			// #line sets the number of the line that follows it
+			source += fmt::format("#line {} {}\n", i + 2, index);
+		}
+
+		context.Stack.pop_back();
+
+		return true;
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Graphics
+{
+	// Expands #include "file" directives in GLSL sources.
+	//
+	// Files are cached by path and modification time, so a header shared by many programs is read and parsed
+	// once. Every file is expanded at most once per source: files with #pragma once, or whose body sits in an
+	// #ifndef/#define/#endif guard, are skipped on repeated includes. #line directives keep compiler messages
+	// pointing at the original file and line.
+	class ShaderPreprocessor {
+		ShaderPreprocessor() = default;
+		~ShaderPreprocessor() = default;
+	public:
+
+		static auto& GetInstance()
+		{
+			static ShaderPreprocessor instance;
+			return instance;
+		}
+
+		ShaderPreprocessor(const ShaderPreprocessor&) = delete;
+		ShaderPreprocessor& operator=(const ShaderPreprocessor&) = delete;
+
+		struct Result {
+			std::string Source;
+			// Every file the source was built from, the stage file first. The index of a file is its source
+			// string number in #line directives, so "1:12" in a compiler message is line 12 of Files[1].
+			std::vector<std::filesystem::path> Files;
+		};
+
+		// Empty if a file cannot be read or includes form a cycle, errors are logged.
+		std::optional<Result> Process(const std::filesystem::path& path);
+
+		// Forces the next Process to read the file again, for changes within the file system's time resolution.
+		void Invalidate(const std::filesystem::path& path);
+		void Clear() noexcept { m_files.clear(); }
+
+		// Spelling of a path used by the cache and in Result::Files.
+		static std::filesystem::path Normalize(const std::filesystem::path& path);
+
+	private:
+		struct Include {
+			// Index of the #include line
+			std::size_t Line;
+			// Resolved relative to the including file, or to the working directory
+			std::filesystem::path Path;
+		};
+
+		struct File {
+			std::filesystem::file_time_type ModifiedTime;
+			// Lines without their line break. #include and #pragma once lines are blanked.
+			std::vector<std::string> Lines;
+			std::vector<Include> Includes;
+			bool PragmaOnce{ false };
+			// Macro of an include guard around the whole file, empty if there is none
+			std::string Guard;
+		};
+
+		// State of one Process call
+		struct Context {
+			Result Output;
+			// Files currently being expanded, to detect cycles
+			std::vector<std::string> Stack;
+			std::unordered_set<std::string> Once;
+			std::unordered_set<std::string> Guards;
+		};
+
+		// Cached file, read again if it changed on disk. nullptr if it cannot be read.
+		const File* loadFile(const std::filesystem::path& path);
+		bool expand(const std::filesystem::path& path, Context& context);
+
+		std::unordered_map<std::string, File> m_files;
+	};
+}
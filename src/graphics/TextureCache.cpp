@@ -0,0 +1,272 @@
+#include "TextureCache.h"
+
+#include "MipGenerator.h"
+#include "../Hash.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+	// Bump when encoder or mip generator output changes so stale cache entries get rebuilt.
+	constexpr std::uint64_t ENCODER_VERSION{ 3 };
+
+	// Content hash of a source image as of its size and write time, so cache hits skip reading the image
+	struct SourceStamp {
+		std::uintmax_t Size{ 0 };
+		std::int64_t WriteTime{ 0 };
+		std::uint64_t ContentHash{ 0 };
+	};
+
+	std::mutex sourceIndexMutex;
+	std::unordered_map<std::string, SourceStamp> sourceIndex;
+	bool sourceIndexLoaded{ false };
+
+	/***********************************************************************************/
+	std::filesystem::path getSourceIndexPath()
+	{
+		return Graphics::GetTextureCacheDirectory() / "sources.txt";
+	}
+
+	/***********************************************************************************/
+	// Replaces the index file with sourceIndex, written aside first so a crash never leaves half an index
+	void writeSourceIndex()
+	{
+		std::error_code error;
+		std::filesystem::create_directories(Graphics::GetTextureCacheDirectory(), error);
+
+		const auto path{ getSourceIndexPath() };
+		auto tempPath{ path };
+		tempPath += ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::trunc);
+			for (const auto& [source, stamp] : sourceIndex)
+			{
+				out << Hash::ToHex(stamp.ContentHash) << ' ' << stamp.Size << ' ' << stamp.WriteTime << ' ' << source << '\n';
+			}
+			if (!out)
+			{
+				std::cerr << "Texture Cache: Failed to write " << tempPath << '\n';
+				return;
+			}
+		}
+
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			std::cerr << "Texture Cache: Failed to replace " << path << ": " << error.message() << '\n';
+		}
+	}
+
+	/***********************************************************************************/
+	// One "<content hash> <size> <write time> <source path>" line per hashed source. Sources that are gone are
+	// dropped, and the file is compacted if that or a duplicate line left it with more lines than entries.
+	void loadSourceIndex()
+	{
+		std::ifstream in(getSourceIndexPath());
+		std::string line;
+		std::size_t numLines{ 0 };
+		while (std::getline(in, line))
+		{
+			++numLines;
+			std::istringstream fields(line);
+			std::string hash;
+			SourceStamp stamp;
+			std::string source;
+			if (!(fields >> hash >> stamp.Size >> stamp.WriteTime) || !std::getline(fields >> std::ws, source) || source.empty())
+			{
+				continue;
+			}
+
+			std::error_code error;
+			if (!std::filesystem::exists(source, error))
+			{
+				continue;
+			}
+
+			stamp.ContentHash = std::strtoull(hash.c_str(), nullptr, 16);
+			sourceIndex[source] = stamp;
+		}
+		in.close();
+
+		if (numLines != sourceIndex.size())
+		{
+			writeSourceIndex();
+		}
+	}
+
+	/***********************************************************************************/
+	std::optional<std::uint64_t> hashSourceContents(const std::filesystem::path& source)
+	{
+		std::error_code error;
+		const auto absolute{ std::filesystem::absolute(source, error) };
+		const auto size{ std::filesystem::file_size(source, error) };
+		const auto writeTime{ error ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(source, error) };
+
+		SourceStamp stamp;
+		stamp.Size = size;
+		stamp.WriteTime = static_cast<std::int64_t>(writeTime.time_since_epoch().count());
+		const auto key{ absolute.lexically_normal().generic_string() };
+
+		if (!error)
+		{
+			std::scoped_lock lock(sourceIndexMutex);
+			if (!sourceIndexLoaded)
+			{
+				loadSourceIndex();
+				sourceIndexLoaded = true;
+			}
+
+			if (const auto it{ sourceIndex.find(key) }; it != sourceIndex.end() && it->second.Size == stamp.Size && it->second.WriteTime == stamp.WriteTime)
+			{
+				return it->second.ContentHash;
+			}
+		}
+
+		std::ifstream in(source, std::ios::binary);
+		if (!in)
+		{
+			std::cerr << "Texture Cache: Failed to read " << source << '\n';
+			return std::nullopt;
+		}
+
+		const std::vector<char> contents(std::istreambuf_iterator<char>(in), (std::istreambuf_iterator<char>()));
+		stamp.ContentHash = Hash::Hash64(contents.data(), contents.size());
+
+		// Remembered only if the file did not change while it was read
+		if (!error && contents.size() == stamp.Size)
+		{
+			std::scoped_lock lock(sourceIndexMutex);
+			sourceIndex[key] = stamp;
+			writeSourceIndex();
+		}
+
+		return stamp.ContentHash;
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	std::filesystem::path GetTextureCacheDirectory()
+	{
+		return std::filesystem::current_path() / "Data/cache/textures";
+	}
+
+	/***********************************************************************************/
+	std::optional<std::filesystem::path> BuildTextureCachePath(const std::filesystem::path& source, const TextureUsage usage)
+	{
+		const auto contentHash{ hashSourceContents(source) };
+		if (!contentHash)
+		{
+			return std::nullopt;
+		}
+
+		auto hash{ Hash::Combine(*contentHash, static_cast<std::uint64_t>(usage)) };
+		hash = Hash::Combine(hash, ENCODER_VERSION);
+
+		return GetTextureCacheDirectory() / (Hash::ToHex(hash) + ".ktx2");
+	}
+
+	/***********************************************************************************/
+	std::optional<CompressedTexture> BakeTexture(const std::filesystem::path& source, const TextureUsage usage, const bool withMips)
+	{
+		int width = 0, height = 0, nrComponents = 0;
+		auto* data{ stbi_load(source.string().c_str(), &width, &height, &nrComponents, 4) };
+		if (!data)
+		{
+			std::cerr << "Texture Cache: Failed to load texture: " << source << '\n';
+			return std::nullopt;
+		}
+
+		bool hasAlpha{ false };
+		if (nrComponents == 2 || nrComponents == 4)
+		{
+			const auto numPixels{ static_cast<std::size_t>(width) * height };
+			for (std::size_t i = 0; i < numPixels && !hasAlpha; ++i)
+			{
+				hasAlpha = data[i * 4 + 3] != 255;
+			}
+		}
+
+		CompressedTexture texture;
+		texture.Format = ChooseBlockFormat(usage, hasAlpha);
+
+		if (withMips)
+		{
+			const auto mips{ GenerateMipChain(data, static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), GetMipSettings(usage, hasAlpha)) };
+			for (const auto& mip : mips)
+			{
+				texture.Mips.push_back({ mip.Width, mip.Height, CompressImage(mip.Data.data(), mip.Width, mip.Height, texture.Format) });
+			}
+		}
+		else
+		{
+			texture.Mips.push_back({ static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height),
+				CompressImage(data, static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), texture.Format) });
+		}
+
+		stbi_image_free(data);
+
+		return std::make_optional(std::move(texture));
+	}
+
+	/***********************************************************************************/
+	TextureUsage GuessTextureUsage(const std::filesystem::path& source)
+	{
+		auto name{ source.stem().string() };
+		std::transform(name.begin(), name.end(), name.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		const auto endsWith = [&name](const std::string_view suffix) {
+			return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+		};
+
+		constexpr std::array normalSuffixes{ "_normal", "_ddn", "_nrm", "_bump" };
+		constexpr std::array maskSuffixes{ "_mask", "_alpha" };
+
+		for (const auto* suffix : normalSuffixes)
+		{
+			if (endsWith(suffix))
+			{
+				return TextureUsage::Normal;
+			}
+		}
+		for (const auto* suffix : maskSuffixes)
+		{
+			if (endsWith(suffix))
+			{
+				return TextureUsage::AlphaMask;
+			}
+		}
+		if (endsWith("_roughness") || endsWith("_rough"))
+		{
+			return TextureUsage::Roughness;
+		}
+		if (endsWith("_metallic") || endsWith("_metalness"))
+		{
+			return TextureUsage::Metallic;
+		}
+		if (endsWith("_ao") || endsWith("_occlusion"))
+		{
+			return TextureUsage::AmbientOcclusion;
+		}
+		if (endsWith("_diff") || endsWith("_diffuse") || endsWith("_albedo") || endsWith("_basecolor"))
+		{
+			return TextureUsage::Albedo;
+		}
+
+		return TextureUsage::Generic;
+	}
+}
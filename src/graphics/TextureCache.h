@@ -0,0 +1,22 @@
+#pragma once
+
+#include "BlockCompression.h"
+
+#include <filesystem>
+#include <optional>
+
+namespace Graphics
+{
+	// Directory that holds baked textures.
+	std::filesystem::path GetTextureCacheDirectory();
+	// Data/cache/textures/<hash>.ktx2, where the hash covers the source file contents, the usage and the
+	// encoder version. Content hashes are remembered in Data/cache/textures/sources.txt and only recomputed when
+	// the source's size or write time changes. Empty if the source cannot be read.
+	std::optional<std::filesystem::path> BuildTextureCachePath(const std::filesystem::path& source, const TextureUsage usage);
+
+	// Loads a source image and compresses it (and its mip chain) in the format suited for usage.
+	std::optional<CompressedTexture> BakeTexture(const std::filesystem::path& source, const TextureUsage usage, const bool withMips = true);
+
+	// Usage from common file name suffixes (_normal, _ddn, _rough, ...), for baking outside a material.
+	TextureUsage GuessTextureUsage(const std::filesystem::path& source);
+}
@@ -0,0 +1,179 @@
+#include "TransientTexturePool.h"
+#include "GPUMemory.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	/***********************************************************************************/
+	// Pixel transfer format matching an internal format, only needed to allocate storage.
+	std::pair<GLenum, GLenum> getTransferFormat(const GLenum format) noexcept
+	{
+		switch (format)
+		{
+		case GL_DEPTH24_STENCIL8:
+			return { GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8 };
+		case GL_DEPTH32F_STENCIL8:
+			return { GL_DEPTH_STENCIL, GL_FLOAT_32_UNSIGNED_INT_24_8_REV };
+		default:
+			return Graphics::IsDepthFormat(format) ? std::pair<GLenum, GLenum>{ GL_DEPTH_COMPONENT, GL_FLOAT } : std::pair<GLenum, GLenum>{ GL_RGBA, GL_UNSIGNED_BYTE };
+		}
+	}
+}
+
+namespace Graphics
+{
+	/***********************************************************************************/
+	void TransientTexturePool::BeginFrame()
+	{
+		for (auto& texture : m_textures)
+		{
+			texture.InUse = false;
+		}
+	}
+
+	/***********************************************************************************/
+	void TransientTexturePool::EndFrame()
+	{
+		for (auto& texture : m_textures)
+		{
+			texture.UnusedFrames = texture.InUse ? 0 : texture.UnusedFrames + 1;
+			if (texture.UnusedFrames > MaxUnusedFrames)
+			{
+				deleteFramebuffersUsing(texture.Name);
+				GPUMemoryTracker::GetInstance().Untrack(GPUResourceType::Texture, texture.Name);
+				glDeleteTextures(1, &texture.Name);
+				m_allocatedBytes -= static_cast<std::size_t>(texture.Desc.Width) * texture.Desc.Height * GetTexelSize(texture.Desc.Format);
+				texture.Name = 0;
+			}
+		}
+
+		m_textures.erase(std::remove_if(m_textures.begin(), m_textures.end(), [](const Texture& texture) { return texture.Name == 0; }), m_textures.end());
+	}
+
+	/***********************************************************************************/
+	void TransientTexturePool::Shutdown()
+	{
+		for (auto& framebuffer : m_framebuffers)
+		{
+			glDeleteFramebuffers(1, &framebuffer.Name);
+		}
+		m_framebuffers.clear();
+
+		for (auto& texture : m_textures)
+		{
+			GPUMemoryTracker::GetInstance().Untrack(GPUResourceType::Texture, texture.Name);
+			glDeleteTextures(1, &texture.Name);
+		}
+		m_textures.clear();
+		m_allocatedBytes = 0;
+	}
+
+	/***********************************************************************************/
+	GLuint TransientTexturePool::Acquire(const RenderGraphTextureDesc& desc)
+	{
+		const auto it{ std::find_if(m_textures.begin(), m_textures.end(), [&desc](const Texture& texture) {
+			return !texture.InUse && texture.Desc == desc;
+		}) };
+		if (it != m_textures.end())
+		{
+			it->InUse = true;
+			return it->Name;
+		}
+
+		static constexpr float borderColor[]{ 1.0f, 1.0f, 1.0f, 1.0f };
+		const auto [format, type] { getTransferFormat(desc.Format) };
+
+		Texture texture{ desc };
+		glGenTextures(1, &texture.Name);
+		glBindTexture(GL_TEXTURE_2D, texture.Name);
+		glTexImage2D(GL_TEXTURE_2D, 0, desc.Format, desc.Width, desc.Height, 0, format, type, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.Filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.Filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, desc.Wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, desc.Wrap);
+		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		texture.InUse = true;
+		m_allocatedBytes += static_cast<std::size_t>(desc.Width) * desc.Height * GetTexelSize(desc.Format);
+		m_textures.push_back(texture);
+		// Pooled textures move between passes from frame to frame, so they belong to the graph as a whole
+		GPUMemoryTracker::GetInstance().Track(GPUResourceType::Texture, texture.Name, GetTextureBytes(desc.Format, desc.Width, desc.Height),
+			GPUMemoryCategory::Pass, "Render graph");
+		return texture.Name;
+	}
+
+	/***********************************************************************************/
+	void TransientTexturePool::BindRenderTargets(const std::vector<GLuint>& colorAttachments, const GLuint depthAttachment, const GLsizei width, const GLsizei height)
+	{
+		const auto it{ std::find_if(m_framebuffers.cbegin(), m_framebuffers.cend(), [&](const Framebuffer& framebuffer) {
+			return framebuffer.DepthAttachment == depthAttachment && framebuffer.ColorAttachments == colorAttachments;
+		}) };
+
+		if (it == m_framebuffers.cend())
+		{
+			Framebuffer framebuffer{ colorAttachments, depthAttachment };
+			glGenFramebuffers(1, &framebuffer.Name);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.Name);
+
+			std::vector<GLenum> drawBuffers;
+			for (std::size_t i = 0; i < colorAttachments.size(); ++i)
+			{
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i), GL_TEXTURE_2D, colorAttachments[i], 0);
+				drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i));
+			}
+			if (depthAttachment != 0)
+			{
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthAttachment, 0);
+			}
+
+			if (drawBuffers.empty())
+			{
+				glDrawBuffer(GL_NONE);
+				glReadBuffer(GL_NONE);
+			} else
+			{
+				glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+			}
+
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			{
+				std::cerr << "TransientTexturePool Error: Render target framebuffer not complete!\n";
+			}
+
+			m_framebuffers.push_back(std::move(framebuffer));
+		} else
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, it->Name);
+		}
+
+		glViewport(0, 0, width, height);
+	}
+
+	/***********************************************************************************/
+	void TransientTexturePool::BindFramebuffer(const GLuint framebuffer, const GLsizei width, const GLsizei height) const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, width, height);
+	}
+
+	/***********************************************************************************/
+	void TransientTexturePool::deleteFramebuffersUsing(const GLuint texture)
+	{
+		const auto uses = [texture](const Framebuffer& framebuffer) {
+			return framebuffer.DepthAttachment == texture ||
+				std::find(framebuffer.ColorAttachments.cbegin(), framebuffer.ColorAttachments.cend(), texture) != framebuffer.ColorAttachments.cend();
+		};
+
+		for (auto& framebuffer : m_framebuffers)
+		{
+			if (uses(framebuffer))
+			{
+				glDeleteFramebuffers(1, &framebuffer.Name);
+			}
+		}
+		m_framebuffers.erase(std::remove_if(m_framebuffers.begin(), m_framebuffers.end(), uses), m_framebuffers.end());
+	}
+}
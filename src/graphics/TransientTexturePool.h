@@ -0,0 +1,57 @@
+#pragma once
+
+#include "RenderGraph.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Graphics
+{
+	// Owns the textures behind the transient resources of a RenderGraph and the framebuffers they are attached
+	// to. Textures are kept across frames and handed out again to resources with the same description; those not
+	// asked for in a few frames, e.g. because the window was resized or a pass was turned off, are deleted.
+	class TransientTexturePool {
+	public:
+		void BeginFrame();
+		// Deletes textures that have not been acquired for MaxUnusedFrames frames.
+		void EndFrame();
+		void Shutdown();
+
+		// A texture of exactly desc (resolved to a size) that is not handed out yet this frame.
+		GLuint Acquire(const RenderGraphTextureDesc& desc);
+
+		// Binds a framebuffer with these attachments, creating it on first use, and sets the viewport.
+		void BindRenderTargets(const std::vector<GLuint>& colorAttachments, const GLuint depthAttachment, const GLsizei width, const GLsizei height);
+		// Binds a framebuffer owned elsewhere and sets the viewport.
+		void BindFramebuffer(const GLuint framebuffer, const GLsizei width, const GLsizei height) const;
+
+		auto GetNumTextures() const noexcept { return m_textures.size(); }
+		// Memory of all textures the pool holds, used or not
+		auto GetAllocatedBytes() const noexcept { return m_allocatedBytes; }
+
+	private:
+		static constexpr std::uint32_t MaxUnusedFrames{ 3 };
+
+		struct Texture {
+			RenderGraphTextureDesc Desc;
+			GLuint Name{ 0 };
+			std::uint32_t UnusedFrames{ 0 };
+			bool InUse{ false };
+		};
+
+		struct Framebuffer {
+			std::vector<GLuint> ColorAttachments;
+			GLuint DepthAttachment{ 0 };
+			GLuint Name{ 0 };
+		};
+
+		void deleteFramebuffersUsing(const GLuint texture);
+
+		std::vector<Texture> m_textures;
+		std::vector<Framebuffer> m_framebuffers;
+		std::size_t m_allocatedBytes{ 0 };
+	};
+}
@@ -1,5 +1,10 @@
-#include "ResourceManager.h"
+#include "resourceManager.h"
 
+#include "graphics/GPUMemory.h"
+#include "graphics/KTX2.h"
+#include "graphics/TextureCache.h"
+
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -9,18 +14,8 @@
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_FAILURE_USERMSG
 #include <stb_image.h>
-
-const static std::filesystem::path COMPRESSED_TEX_DIR{ std::filesystem::current_path() / "Data/cache/textures" };
-
-using ImageBuffer = std::unique_ptr<unsigned char[]>;
-
-struct CompressedImageDesc {
-	GLint width{ -1 };
-	GLint height{ -1 };
-	GLint size{ -1 };
-	GLint format{ -1 };
-	ImageBuffer data;
-};
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 
 /***********************************************************************************/
 void ResourceManager::ReleaseAllResources()
@@ -34,6 +29,7 @@ void ResourceManager::ReleaseAllResources()
 	// Deletes textures
 	for (auto& tex : m_textureCache)
 	{
+		Graphics::GPUMemoryTracker::GetInstance().Untrack(Graphics::GPUResourceType::Texture, tex.second);
 		glDeleteTextures(1, &tex.second);
 	}
 }
@@ -74,6 +70,8 @@ unsigned int ResourceManager::LoadHDRI(const std::string_view path) const
 	glGenTextures(1, &hdrTexture);
 	glBindTexture(GL_TEXTURE_2D, hdrTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
+	Graphics::GPUMemoryTracker::GetInstance().Track(Graphics::GPUResourceType::Texture, hdrTexture, Graphics::GetTextureBytes(GL_RGB16F, width, height),
+		Graphics::GPUMemoryCategory::Skybox, path);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -90,174 +88,115 @@ unsigned int ResourceManager::LoadHDRI(const std::string_view path) const
 }
 
 /***********************************************************************************/
-auto buildTextureCachePath(const std::filesystem::path& filenameNoExt)
-{
-	const std::filesystem::path filename{ filenameNoExt.string() + ".bin" };
-	return std::filesystem::path(COMPRESSED_TEX_DIR / filename);
-}
-
-/***********************************************************************************/
-void saveCompressedImageToDisk(const std::filesystem::path& target, const CompressedImageDesc& desc)
-{
-	if (!std::filesystem::exists(COMPRESSED_TEX_DIR))
-	{
-		if (!std::filesystem::create_directories(COMPRESSED_TEX_DIR))
-		{
-			std::cerr << "Failed to create texture cache directory: " << COMPRESSED_TEX_DIR << '\n';
-			return;
-		}
-	}
-
-	std::ofstream out(target, std::ios::binary);
-	if (out)
-	{
-		out.write((char*)(&desc.size), sizeof(CompressedImageDesc::size));
-		out.write((char*)(&desc.width), sizeof(CompressedImageDesc::width));
-		out.write((char*)(&desc.height), sizeof(CompressedImageDesc::height));
-		out.write((char*)(&desc.format), sizeof(CompressedImageDesc::format));
-		out.write((char*)(desc.data.get()), desc.size);
-	}
-}
-
-/***********************************************************************************/
-std::optional<CompressedImageDesc> loadCompressedImageFromDisk(const std::filesystem::path& target)
-{
-	CompressedImageDesc desc;
-
-	std::ifstream in(target, std::ios::binary);
-	if (!in)
-	{
-		return std::nullopt;
-	}
-
-	in.read(reinterpret_cast<char*>(&desc.size), sizeof(CompressedImageDesc::size));
-	in.read(reinterpret_cast<char*>(&desc.width), sizeof(CompressedImageDesc::width));
-	in.read(reinterpret_cast<char*>(&desc.height), sizeof(CompressedImageDesc::height));
-	in.read(reinterpret_cast<char*>(&desc.format), sizeof(CompressedImageDesc::format));
-
-	desc.data = std::make_unique<unsigned char[]>(desc.size);
-	in.read(reinterpret_cast<char*>(desc.data.get()), desc.size);
-
-	return std::make_optional(std::move(desc));
-}
-
-/***********************************************************************************/
-unsigned int ResourceManager::LoadTexture(const std::filesystem::path& path, const bool useMipMaps, const bool useUnalignedUnpack)
+unsigned int ResourceManager::LoadTexture(const std::filesystem::path& path, const Graphics::TextureUsage usage, const bool useMipMaps)
 {
 	if (path.filename().empty())
 	{
 		return 0;
 	}
 
-	const auto compressedFilePath{ buildTextureCachePath(path.stem()) };
-	const auto compressedImageExists{ std::filesystem::exists(compressedFilePath) };
-
-	const std::filesystem::path pathToLoad = compressedImageExists ? compressedFilePath : path;
-
-	// Check if texture is already loaded in memory
-	if (const auto val = m_textureCache.find(pathToLoad.string()); val != m_textureCache.end())
+	// Check if texture is already loaded in memory. The usage picks the block format and color space, so the
+	// same file loaded for another usage is another texture.
+	const auto cacheKey{ path.string() + '|' + std::to_string(static_cast<int>(usage)) + (useMipMaps ? "|mips" : "") };
+	if (const auto val = m_textureCache.find(cacheKey); val != m_textureCache.end())
 	{
 		// Found it
 		return val->second;
 	}
 
-	if (useUnalignedUnpack)
+	std::optional<Graphics::KTX2Texture> texture;
+	if (path.extension() == ".ktx2")
 	{
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		// Already in its final format, upload as is.
+		texture = Graphics::ReadKTX2(path);
 	}
-
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	if (compressedImageExists)
+	else
 	{
-
-		const auto desc{ loadCompressedImageFromDisk(compressedFilePath) };
-		if (!desc)
+		const auto compressedFilePath{ Graphics::BuildTextureCachePath(path, usage) };
+		if (!compressedFilePath)
 		{
 			return 0;
 		}
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glCompressedTexImage2D(
-			GL_TEXTURE_2D,
-			0,
-			desc.value().format,
-			desc.value().width,
-			desc.value().height,
-			0,
-			desc.value().size,
-			desc.value().data.get()
-		);
-
-	} else
-	{
-		
-		int width = 0, height = 0, nrComponents = 0;
-		unsigned char* data = stbi_load(pathToLoad.string().c_str(), &width, &height, &nrComponents, 0);
-		if (!data)
+		// Use the baked mip chain if there is one, otherwise compress on the CPU and bake it now.
+		texture = Graphics::ReadKTX2(*compressedFilePath);
+		if (texture && useMipMaps)
 		{
-			std::cerr << "Failed to load texture: " << path << std::endl;
-			glDeleteTextures(1, &textureID);
-			stbi_image_free(data);
-			return 0;
+			// Rebake a chain that was baked without mips, a 1x1 texture is complete with its one level
+			const auto& top{ texture->Levels.front() };
+			if (static_cast<GLsizei>(texture->Levels.size()) < Graphics::GetNumMipLevels(static_cast<GLsizei>(top.Width), static_cast<GLsizei>(top.Height)))
+			{
+				texture.reset();
+			}
 		}
 
-		GLenum format = 0;
-		GLenum internalFormat = 0;
-		switch (nrComponents)
+		if (!texture)
 		{
-		case 1:
-			format = GL_RED;
-			internalFormat = GL_COMPRESSED_RED;
-			break;
-		case 3:
-			format = GL_RGB;
-			internalFormat = GL_COMPRESSED_RGB;
-			break;
-		case 4:
-			format = GL_RGBA;
-			internalFormat = GL_COMPRESSED_RGBA;
-			break;
+			auto baked{ Graphics::BakeTexture(path, usage, useMipMaps) };
+			if (!baked)
+			{
+				return 0;
+			}
+
+			texture = Graphics::ToKTX2(std::move(*baked));
+			Graphics::WriteKTX2(*compressedFilePath, *texture);
 		}
+	}
+
+	if (!texture)
+	{
+		std::cerr << "Failed to load texture: " << path << std::endl;
+		return 0;
+	}
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+	const auto format{ Graphics::GetKTX2FormatInfo(texture->VkFormat) };
 
-		glHint(GL_TEXTURE_COMPRESSION_HINT, GL_DONT_CARE);
-		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
 
-		stbi_image_free(data);
+	// KTX2 rows are tightly packed.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-		GLint compressed = GL_FALSE;
-		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
-		if (compressed == GL_TRUE)
+	// Every level comes straight from the file, the driver never has to generate or compress anything.
+	const auto numLevels{ useMipMaps ? static_cast<GLint>(texture->Levels.size()) : 1 };
+	for (GLint level = 0; level < numLevels; ++level)
+	{
+		const auto& mip{ texture->Levels[level] };
+		if (format->IsCompressed())
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, format->GLInternalFormat, mip.Width, mip.Height, 0, static_cast<GLsizei>(mip.Data.size()), mip.Data.data());
+		}
+		else
 		{
-			CompressedImageDesc desc{
-				.width = width,
-				.height = height
-			};
+			glTexImage2D(GL_TEXTURE_2D, level, format->GLInternalFormat, mip.Width, mip.Height, 0, format->GLFormat, format->GLType, mip.Data.data());
+		}
+	}
 
-			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &desc.size);
-			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &desc.format);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-			desc.data = std::make_unique<unsigned char[]>(desc.size);
-			glGetCompressedTexImage(GL_TEXTURE_2D, 0, (GLvoid*)desc.data.get());
+	const auto& baseLevel{ texture->Levels.front() };
+	Graphics::GPUMemoryTracker::GetInstance().Track(Graphics::GPUResourceType::Texture, textureID,
+		Graphics::GetTextureBytes(format->GLInternalFormat, baseLevel.Width, baseLevel.Height, 1, numLevels), Graphics::GPUMemoryCategory::Material, path.string());
 
-			saveCompressedImageToDisk(compressedFilePath, desc);
-		}
-	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	if (useMipMaps)
-	{
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
+	return m_textureCache.try_emplace(cacheKey, textureID).first->second;
+}
 
-	if (useUnalignedUnpack)
+/***********************************************************************************/
+bool ResourceManager::ReleaseTexture(const unsigned int texture)
+{
+	const auto entry{ std::find_if(m_textureCache.cbegin(), m_textureCache.cend(), [texture](const auto& cached) { return cached.second == texture; }) };
+	if (entry == m_textureCache.cend())
 	{
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 0);
+		return false;
 	}
 
-	return m_textureCache.try_emplace(path.string(), textureID).first->second;
+	m_textureCache.erase(entry);
+	return true;
 }
 
 /***********************************************************************************/
@@ -340,6 +279,18 @@ PBRMaterialPtr ResourceManager::CacheMaterial(const std::string_view name, const
 	return m_materialCache.try_emplace(name.data(), std::make_shared<PBRMaterial>(mat)).first->second;
 }
 
+/***********************************************************************************/
+PBRMaterialPtr ResourceManager::CacheMaterial(const std::string_view name, const PBRMaterial& material)
+{
+	const auto [entry, inserted] { m_materialCache.try_emplace(std::string(name), nullptr) };
+	if (inserted)
+	{
+		entry->second = std::make_shared<PBRMaterial>(material);
+		entry->second->Name = entry->first;
+	}
+	return entry->second;
+}
+
 /***********************************************************************************/
 void ResourceManager::UnloadModel(const std::string_view modelName)
 {
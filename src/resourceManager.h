@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Model.h"
+#include "graphics/BlockCompression.h"
 
 #include <unordered_map>
 #include <optional>
@@ -26,8 +27,12 @@ public:
 	std::string LoadTextFile(const std::filesystem::path& path) const;
 	// Loads an HDR image and generates an OpenGL floating-point texture.
 	unsigned int LoadHDRI(const std::string_view path) const;
-	// Loads an image (if not cached) and generates an OpenGL texture.
-	unsigned int LoadTexture(const std::filesystem::path& path, const bool useMipMaps = true, const bool useUnalignedUnpack = false);
+	// Loads an image (if not cached) and generates an OpenGL texture. The block format is picked by usage
+	// and the compressed mip chain is read from (or baked into) Data/cache/textures. KTX2 files are uploaded as is.
+	unsigned int LoadTexture(const std::filesystem::path& path, const Graphics::TextureUsage usage = Graphics::TextureUsage::Generic, const bool useMipMaps = true);
+	// Hands a loaded texture over to the caller, who deletes it. A later LoadTexture of its path loads it again.
+	// False if the texture is not in the cache.
+	bool ReleaseTexture(const unsigned int texture);
 	// Loads a binary file into a vector and returns it
 	std::vector<char> LoadBinaryFile(const std::string_view path) const;
 
@@ -48,6 +53,8 @@ public:
 		const std::string_view normalPath,
 		const std::string_view roughnessPath,
 		const std::string_view alphaMaskPath);
+	// Caches a material set up by the caller. Its Name is pointed at the cache key.
+	PBRMaterialPtr CacheMaterial(const std::string_view name, const PBRMaterial& material);
 
 
 	// Removes a named model from cache.
@@ -59,6 +66,7 @@ public:
 private:
 	
 	std::unordered_map<std::string, ModelPtr> m_modelCache;
+	// Keyed by path, usage and whether mips were loaded
 	std::unordered_map<std::string, unsigned int> m_textureCache;
 	std::unordered_map<std::string, PBRMaterialPtr> m_materialCache;
 };